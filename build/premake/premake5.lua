@@ -54,6 +54,7 @@ newoption { category = "Pyrogenesis", trigger = "with-lto", description = "Enabl
 newoption { category = "Pyrogenesis", trigger = "with-system-mozjs", description = "Search standard paths for libmozjs128, instead of using bundled copy" }
 newoption { category = "Pyrogenesis", trigger = "with-system-nvtt", description = "Search standard paths for nvidia-texture-tools library, instead of using bundled copy" }
 newoption { category = "Pyrogenesis", trigger = "with-valgrind", description = "Enable Valgrind support (non-Windows only)" }
+newoption { category = "Pyrogenesis", trigger = "without-bench", description = "Disable generation of the replay benchmark project" }
 newoption { category = "Pyrogenesis", trigger = "without-audio", description = "Disable use of OpenAL/Ogg/Vorbis APIs" }
 newoption { category = "Pyrogenesis", trigger = "without-atlas", description = "Disable Atlas scenario/map editor and ActorEditor" }
 newoption { category = "Pyrogenesis", trigger = "without-dap-interface", description = "Disable Dap interface project" }
@@ -1564,6 +1565,96 @@ function setup_collada_projects()
 end
 
 
+--------------------------------------------------------------------------------
+-- replay benchmark
+--------------------------------------------------------------------------------
+
+-- Headless executable running a corpus of replays and reporting simulation timings.
+function setup_bench_exe()
+
+	project_create("pyrogenesis-bench", "ConsoleApp")
+
+	filter "system:not macosx"
+		linkgroups 'On'
+	filter {}
+
+	links { static_lib_names }
+	filter "Debug"
+		links { static_lib_names_debug }
+	filter "Release"
+		links { static_lib_names_release }
+	filter { }
+
+	links { "mocks_real" }
+
+	local extra_files = { "main_bench.cpp" }
+	if _OPTIONS["without-atlas"] then
+		table.insert(extra_files, "ps/AtlasGameLoopStub.cpp")
+	end
+
+	local extra_params = {
+		extra_files = extra_files,
+		no_pch = 1
+	}
+	project_add_contents(source_root, {}, {}, extra_params)
+	project_add_extern_libs(used_extern_libs, "ConsoleApp")
+
+	rtti "off"
+
+	if os.istarget("windows") then
+		-- from "lowlevel" static lib; must be added here to be linked in
+		files { source_root.."lib/sysdep/os/win/error_dialog.rc" }
+
+		links { "delayimp" }
+
+		project_add_manifest(arch)
+		if arch == "amd64" then
+			architecture("x86_64")
+		end
+
+	elseif os.istarget("linux") or os.istarget("bsd") then
+
+		if link_execinfo then
+			links {
+				"execinfo"
+			}
+		end
+		if not (os.getversion().description == "OpenBSD") then
+			links { "rt" }
+		end
+
+		if os.istarget("linux") or os.getversion().description == "GNU/kFreeBSD" then
+			links {
+				-- Dynamic libraries (needed for linking for gold)
+				"dl",
+			}
+		end
+
+		-- Threading support
+		buildoptions { "-pthread" }
+		linkoptions { "-pthread" }
+
+		-- For debug_resolve_symbol
+		filter "Debug"
+			linkoptions { "-rdynamic" }
+		filter { }
+
+	elseif os.istarget("macosx") then
+
+		links { "pthread" }
+		links { "ApplicationServices.framework", "Cocoa.framework", "CoreFoundation.framework" }
+
+		architecture(macos_arch)
+		buildoptions { "-arch " .. macos_arch }
+		linkoptions { "-arch " .. macos_arch }
+		xcodebuildsettings { ARCHS = macos_arch }
+		if _OPTIONS["macosx-version-min"] then
+			xcodebuildsettings { MACOSX_DEPLOYMENT_TARGET = _OPTIONS["macosx-version-min"] }
+		end
+	end
+end
+
+
 --------------------------------------------------------------------------------
 -- tests
 --------------------------------------------------------------------------------
@@ -1742,6 +1833,10 @@ if with_runtime_collada then
 	setup_collada_projects()
 end
 
+if not _OPTIONS["without-bench"] and not _OPTIONS["android"] then
+	setup_bench_exe()
+end
+
 if not _OPTIONS["without-tests"] then
 	setup_tests()
 end
@@ -1,4 +1,4 @@
-/* Copyright (C) 2025 Wildfire Games.
+/* Copyright (C) 2026 Wildfire Games.
  * This file is part of 0 A.D.
  *
  * 0 A.D. is free software: you can redistribute it and/or modify
@@ -21,19 +21,33 @@
 
 #include "lib/debug.h"
 #include "maths/Fixed.h"
+#include "ps/Future.h"
+#include "ps/Profiler2.h"
+#include "ps/TaskManager.h"
 #include "simulation2/components/ICmpTerritoryManager.h"
 #include "simulation2/helpers/Grid.h"
 #include "simulation2/helpers/Pathfinding.h"
 
+#include <algorithm>
+#include <array>
 #include <cmath>
+#include <iterator>
+#include <utility>
 
-std::vector<STerritoryBoundary> CTerritoryBoundaryCalculator::ComputeBoundaries(const Grid<u8>* territory)
+namespace
 {
-	std::vector<STerritoryBoundary> boundaries;
-
-	// Copy the territories grid so we can mess with it
-	Grid<u8> grid(*territory);
+/**
+ * A territory boundary, along with the index of the tile its trace started from.
+ */
+using IndexedBoundary = std::pair<size_t, STerritoryBoundary>;
 
+/**
+ * Traces the boundaries of the territories of @p owner, or of all territories if it's INVALID_PLAYER.
+ * @p grid is marked with the processed tiles. A trace only marks tiles of its own territory,
+ * so the territories of different owners can be traced concurrently on separate copies.
+ */
+void TraceBoundaries(Grid<u8>& grid, player_id_t owner, std::vector<IndexedBoundary>& boundaries)
+{
 	// Some constants for the border walk
 	CVector2D edgeOffsets[] = {
 		CVector2D(0.5f, 0.0f),
@@ -102,6 +116,9 @@ std::vector<STerritoryBoundary> CTerritoryBoundaryCalculator::ComputeBoundaries(
 			if (!tileDiscr)
 				continue;
 
+			if (owner != INVALID_PLAYER && (tileState & ICmpTerritoryManager::TERRITORY_PLAYER_MASK) != owner)
+				continue;
+
 			bool tileProcessed = ((tileState & ICmpTerritoryManager::TERRITORY_PROCESSED_MASK) != 0);
 			bool tileEligible = (j == 0 || tileDiscr != (grid.get(i, j-1) & TERRITORY_DISCR_MASK));
 
@@ -114,10 +131,10 @@ std::vector<STerritoryBoundary> CTerritoryBoundaryCalculator::ComputeBoundaries(
 
 			int curvature = 0; // +1 for every CCW 90 degree turn, -1 for every CW 90 degree turn; must be multiple of 4 at the end
 
-			boundaries.push_back(STerritoryBoundary());
-			boundaries.back().owner = (tileState & ICmpTerritoryManager::TERRITORY_PLAYER_MASK);
-			boundaries.back().blinking = (tileState & ICmpTerritoryManager::TERRITORY_BLINKING_MASK) != 0;
-			std::vector<CVector2D>& points = boundaries.back().points;
+			STerritoryBoundary& boundary = boundaries.emplace_back(j * grid.m_W + i, STerritoryBoundary()).second;
+			boundary.owner = (tileState & ICmpTerritoryManager::TERRITORY_PLAYER_MASK);
+			boundary.blinking = (tileState & ICmpTerritoryManager::TERRITORY_BLINKING_MASK) != 0;
+			std::vector<CVector2D>& points = boundary.points;
 
 			u8 dir = TILE_BOTTOM;
 
@@ -221,6 +238,61 @@ std::vector<STerritoryBoundary> CTerritoryBoundaryCalculator::ComputeBoundaries(
 			ENSURE(curvature != 0 && abs(curvature) % 4 == 0);
 		}
 	}
+}
+} // anonymous namespace
 
+std::vector<STerritoryBoundary> CTerritoryBoundaryCalculator::ComputeBoundaries(const Grid<u8>* territory)
+{
+	// Tiles without an owner only have a boundary if they're blinking.
+	std::array<bool, ICmpTerritoryManager::TERRITORY_PLAYER_MASK + 1> ownerPresent{};
+	for (size_t i = 0; i < static_cast<size_t>(territory->m_W) * territory->m_H; ++i)
+		if (territory->m_Data[i] & (ICmpTerritoryManager::TERRITORY_BLINKING_MASK | ICmpTerritoryManager::TERRITORY_PLAYER_MASK))
+			ownerPresent[territory->m_Data[i] & ICmpTerritoryManager::TERRITORY_PLAYER_MASK] = true;
+
+	std::vector<player_id_t> owners;
+	for (player_id_t owner = 0; owner < static_cast<player_id_t>(ownerPresent.size()); ++owner)
+		if (ownerPresent[owner])
+			owners.push_back(owner);
+
+	std::vector<IndexedBoundary> indexedBoundaries;
+	if (owners.size() <= 1)
+	{
+		// Copy the territories grid so we can mess with it
+		Grid<u8> grid(*territory);
+		TraceBoundaries(grid, INVALID_PLAYER, indexedBoundaries);
+	}
+	else
+	{
+		// Trace each owner on its own copy of the grid, the first one on this thread.
+		std::vector<std::vector<IndexedBoundary>> ownerBoundaries(owners.size());
+		const auto traceOwner = [territory, &owners, &ownerBoundaries](size_t index)
+		{
+			PROFILE2("Trace territory boundaries");
+			Grid<u8> grid(*territory);
+			TraceBoundaries(grid, owners[index], ownerBoundaries[index]);
+		};
+
+		std::vector<Future<void>> futures;
+		futures.reserve(owners.size() - 1);
+		for (size_t i = 1; i < owners.size(); ++i)
+			futures.push_back({g_TaskManager, [&traceOwner, i]() { traceOwner(i); }});
+		traceOwner(0);
+
+		for (size_t i = 0; i < owners.size(); ++i)
+		{
+			if (i > 0)
+				futures[i - 1].Get();
+			std::move(ownerBoundaries[i].begin(), ownerBoundaries[i].end(), std::back_inserter(indexedBoundaries));
+		}
+
+		// Return the boundaries in the order of a single scan of the grid.
+		std::sort(indexedBoundaries.begin(), indexedBoundaries.end(),
+			[](const IndexedBoundary& a, const IndexedBoundary& b) { return a.first < b.first; });
+	}
+
+	std::vector<STerritoryBoundary> boundaries;
+	boundaries.reserve(indexedBoundaries.size());
+	for (IndexedBoundary& boundary : indexedBoundaries)
+		boundaries.push_back(std::move(boundary.second));
 	return boundaries;
 }
@@ -0,0 +1,142 @@
+/* Copyright (C) 2026 Wildfire Games.
+ * This file is part of 0 A.D.
+ *
+ * 0 A.D. is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * 0 A.D. is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with 0 A.D.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+
+This module contains main() of pyrogenesis-bench, a headless tool which
+runs a corpus of recorded replays (commands.txt files) without graphics
+and writes per-turn and per-component simulation timings as JSON.
+
+Usage:
+	pyrogenesis-bench [-bench-output=FILE] [-bench-runs=N] [-mod=...] REPLAY...
+
+where each REPLAY is either a commands.txt file or a directory which is
+searched recursively for commands.txt files.
+
+*/
+
+// not for any PCH effort, but instead for the (common) definitions
+// included there.
+#define MINIMAL_PCH 2
+#include "lib/precompiled.h"
+
+#include "lib/debug.h"
+#include "lib/file/vfs/vfs.h"
+#include "lib/os_path.h"
+#include "lib/path.h"
+#include "ps/CStr.h"
+#include "ps/Filesystem.h"
+#include "ps/GameSetup/CmdLineArgs.h"
+#include "ps/GameSetup/GameSetup.h"
+#include "ps/GameSetup/Paths.h"
+#include "ps/Profiler2.h"
+#include "ps/ReplayBenchmark.h"
+#include "ps/TaskManager.h"
+#include "ps/XML/Xeromyces.h"
+#include "scriptinterface/ScriptEngine.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <fstream>
+#include <span>
+#include <vector>
+
+// usually defined by main.cpp, used by engine's scripting/ScriptFunctions.cpp,
+// must be defined here to placate linker.
+
+bool IsQuitRequested()
+{
+	return false;
+}
+
+void QuitEngine(int)
+{
+}
+
+void RestartEngine()
+{
+}
+
+static int RunBenchmark(const std::span<const char* const> argv)
+{
+	const CmdLineArgs args(argv);
+	g_CmdLineArgs = args;
+
+	std::vector<OsPath> replays;
+	for (const CStr& arg : args.GetArgsWithoutName())
+	{
+		const std::vector<OsPath> found = CReplayBenchmark::FindReplays(OsPath(arg));
+		if (found.empty())
+			debug_printf("ERROR: No replay found at '%s'!\n", arg.c_str());
+		replays.insert(replays.end(), found.begin(), found.end());
+	}
+
+	if (replays.empty())
+	{
+		debug_printf("Usage: pyrogenesis-bench [-bench-output=FILE] [-bench-runs=N] REPLAY...\n");
+		return EXIT_FAILURE;
+	}
+
+	const OsPath outputFile(args.Has("bench-output") ? args.Get("bench-output") : "benchmark.json");
+	const int runs = args.Has("bench-runs") ? std::max(1, args.Get("bench-runs").ToInt()) : 1;
+
+	// We need to initialize SpiderMonkey and libxml2 in the main thread before
+	// any thread uses them.
+	ScriptEngine scriptEngine;
+	CXeromycesEngine xeromycesEngine;
+
+	// Initialise the global task manager at this point (JS & Profiler2 are set up).
+	Threading::TaskManager taskManager;
+
+	const Paths paths(args);
+	CReplayBenchmark benchmark;
+	for (const OsPath& replay : replays)
+	{
+		// Every replay mounts its own mods, so start from a fresh VFS.
+		g_VFS = CreateVfs();
+		// Mount with highest priority, we don't want mods overwriting this.
+		g_VFS->Mount(L"cache/", paths.Cache(), VFS_MOUNT_ARCHIVABLE, VFS_MAX_PRIORITY);
+
+		benchmark.Run(replay, runs);
+
+		g_VFS.reset();
+	}
+
+	std::ofstream stream(OsString(outputFile), std::ofstream::out | std::ofstream::trunc);
+	if (!stream)
+	{
+		debug_printf("ERROR: Could not write benchmark results to '%s'!\n", outputFile.string8().c_str());
+		return EXIT_FAILURE;
+	}
+
+	benchmark.WriteJSON(stream);
+	debug_printf("Benchmark results written to '%s'\n", outputFile.string8().c_str());
+	return EXIT_SUCCESS;
+}
+
+int main(int argc, char* argv[])
+{
+	EarlyInit();	// must come at beginning of main
+
+	// static_cast is ok, argc is never negative.
+	const int exitStatus = RunBenchmark({argv, static_cast<std::size_t>(argc)});
+
+	// Shut down profiler initialised by EarlyInit
+	g_Profiler2.Shutdown();
+
+	return exitStatus;
+}
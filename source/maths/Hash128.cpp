@@ -0,0 +1,202 @@
+/* Copyright (C) 2026 Wildfire Games.
+ * This file is part of 0 A.D.
+ *
+ * 0 A.D. is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * 0 A.D. is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with 0 A.D.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "precompiled.h"
+
+#include "Hash128.h"
+
+#include "lib/byte_order.h"
+
+#include <array>
+
+namespace
+{
+constexpr u64 PRIME32_1 = 0x9E3779B1U;
+constexpr u64 PRIME32_2 = 0x85EBCA77U;
+constexpr u64 PRIME32_3 = 0xC2B2AE3DU;
+constexpr u64 PRIME64_1 = 0x9E3779B185EBCA87ULL;
+constexpr u64 PRIME64_2 = 0xC2B2AE3D27D4EB4FULL;
+constexpr u64 PRIME64_3 = 0x165667B19E3779F9ULL;
+constexpr u64 PRIME64_4 = 0x85EBCA77C2B2AE63ULL;
+constexpr u64 PRIME64_5 = 0x27D4EB2F165667C5ULL;
+
+/**
+ * Per-lane keys: the stripes of a block use consecutive windows of the secret,
+ * followed by the keys for the scrambling and for the two halves of the digest.
+ */
+constexpr size_t SECRET_SIZE = 8 + 16 + 8 + 16;
+constexpr std::array<u64, SECRET_SIZE> SECRET = []()
+{
+	// splitmix64, so that the keys have no structure.
+	std::array<u64, SECRET_SIZE> secret{};
+	u64 state = PRIME64_1;
+	for (u64& key : secret)
+	{
+		state += 0x9E3779B97F4A7C15ULL;
+		u64 z = state;
+		z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+		z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+		key = z ^ (z >> 31);
+	}
+	return secret;
+}();
+constexpr size_t SCRAMBLE_SECRET = 8 + 16;
+constexpr size_t DIGEST_SECRET = SCRAMBLE_SECRET + 8;
+
+u64 ReadLE64(const u8* data)
+{
+	u64 value;
+	memcpy(&value, data, sizeof(value));
+	return to_le64(value);
+}
+
+/**
+ * Multiplies to 128 bits and folds the halves together.
+ */
+u64 Mul128Fold64(u64 a, u64 b)
+{
+	const u64 aLo = a & 0xFFFFFFFF;
+	const u64 aHi = a >> 32;
+	const u64 bLo = b & 0xFFFFFFFF;
+	const u64 bHi = b >> 32;
+
+	const u64 loLo = aLo * bLo;
+	const u64 hiLo = aHi * bLo;
+	const u64 loHi = aLo * bHi;
+	const u64 hiHi = aHi * bHi;
+
+	const u64 cross = (loLo >> 32) + (hiLo & 0xFFFFFFFF) + loHi;
+	const u64 upper = (hiLo >> 32) + (cross >> 32) + hiHi;
+	const u64 lower = (cross << 32) | (loLo & 0xFFFFFFFF);
+	return lower ^ upper;
+}
+
+u64 Avalanche(u64 h)
+{
+	h ^= h >> 37;
+	h *= 0x165667919E3779F9ULL;
+	h ^= h >> 32;
+	return h;
+}
+} // anonymous namespace
+
+Hash128::Hash128()
+{
+	InitState();
+}
+
+void Hash128::InitState()
+{
+	m_Acc[0] = PRIME32_3;
+	m_Acc[1] = PRIME64_1;
+	m_Acc[2] = PRIME64_2;
+	m_Acc[3] = PRIME64_3;
+	m_Acc[4] = PRIME64_4;
+	m_Acc[5] = PRIME32_2;
+	m_Acc[6] = PRIME64_5;
+	m_Acc[7] = PRIME32_1;
+	m_BufLen = 0;
+	m_StripesInBlock = 0;
+	m_InputLen = 0;
+}
+
+void Hash128::ConsumeStripe(const u8* data)
+{
+	const u64* secret = SECRET.data() + m_StripesInBlock;
+
+	// Independent lanes, so that this loop is vectorized.
+	for (size_t i = 0; i < LANES; ++i)
+	{
+		const u64 value = ReadLE64(data + i * sizeof(u64));
+		const u64 key = value ^ secret[i];
+		m_Acc[i ^ 1] += value;
+		m_Acc[i] += (key & 0xFFFFFFFF) * (key >> 32);
+	}
+
+	if (++m_StripesInBlock < STRIPES_PER_BLOCK)
+		return;
+
+	// Scramble the accumulators at the end of each block, so that the
+	// products can't cancel out over long inputs.
+	for (size_t i = 0; i < LANES; ++i)
+	{
+		u64 acc = m_Acc[i];
+		acc ^= acc >> 47;
+		acc ^= SECRET[SCRAMBLE_SECRET + i];
+		m_Acc[i] = acc * PRIME32_1;
+	}
+	m_StripesInBlock = 0;
+}
+
+void Hash128::ConsumeStripes(const u8* data, size_t numStripes)
+{
+	for (size_t i = 0; i < numStripes; ++i)
+		ConsumeStripe(data + i * STRIPE_SIZE);
+}
+
+void Hash128::UpdateRest(const u8* data, size_t len)
+{
+	const size_t CHUNK_SIZE = sizeof(m_Buf);
+
+	// Fill the buffer and flush it
+	size_t n = CHUNK_SIZE - m_BufLen;
+	memcpy(m_Buf + m_BufLen, data, n);
+	data += n;
+	len -= n;
+	ConsumeStripes(m_Buf, CHUNK_SIZE / STRIPE_SIZE);
+
+	// Process whole stripes of the input directly
+	const size_t numStripes = len / STRIPE_SIZE;
+	ConsumeStripes(data, numStripes);
+	data += numStripes * STRIPE_SIZE;
+	len -= numStripes * STRIPE_SIZE;
+
+	// Add the remainder to the buffer
+	memcpy(m_Buf, data, len);
+	m_BufLen = len;
+}
+
+void Hash128::Final(u8* digest)
+{
+	// Consume the buffered stripes, and the last partial one padded with zeros
+	// (the input length is mixed in below, so the padding is unambiguous).
+	const size_t numStripes = m_BufLen / STRIPE_SIZE;
+	ConsumeStripes(m_Buf, numStripes);
+	const size_t rest = m_BufLen - numStripes * STRIPE_SIZE;
+	if (rest)
+	{
+		u8 lastStripe[STRIPE_SIZE] = {};
+		memcpy(lastStripe, m_Buf + numStripes * STRIPE_SIZE, rest);
+		ConsumeStripe(lastStripe);
+	}
+
+	u64 low = m_InputLen * PRIME64_1;
+	u64 high = ~(m_InputLen * PRIME64_2);
+	for (size_t i = 0; i < LANES; i += 2)
+	{
+		low += Mul128Fold64(m_Acc[i] ^ SECRET[DIGEST_SECRET + i], m_Acc[i + 1] ^ SECRET[DIGEST_SECRET + i + 1]);
+		high += Mul128Fold64(m_Acc[i] ^ SECRET[DIGEST_SECRET + LANES + i], m_Acc[i + 1] ^ SECRET[DIGEST_SECRET + LANES + i + 1]);
+	}
+
+	const u64 digestLow = to_le64(Avalanche(low));
+	const u64 digestHigh = to_le64(Avalanche(high));
+	memcpy(digest, &digestLow, sizeof(digestLow));
+	memcpy(digest + sizeof(digestLow), &digestHigh, sizeof(digestHigh));
+
+	// Reset
+	InitState();
+}
@@ -0,0 +1,83 @@
+/* Copyright (C) 2026 Wildfire Games.
+ * This file is part of 0 A.D.
+ *
+ * 0 A.D. is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * 0 A.D. is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with 0 A.D.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef INCLUDED_HASH128
+#define INCLUDED_HASH128
+
+#include "lib/code_annotation.h"
+#include "lib/types.h"
+
+#include <cstring>
+
+/**
+ * Fast non-cryptographic 128-bit hash, in the style of XXH3, meant to detect
+ * unintended changes in large amounts of data such as the serialized simulation state.
+ * The input is processed in 64-byte stripes by eight independent 64-bit lanes,
+ * which compilers vectorize with whatever SIMD instructions the target has.
+ * The digest doesn't depend on how the input is split between calls to Update.
+ */
+class Hash128
+{
+public:
+	static const size_t DIGESTSIZE = 16;
+
+	Hash128();
+
+	void Update(const u8* data, size_t len)
+	{
+		// (Defined inline for efficiency in the common fixed-length fits-in-buffer case)
+
+		const size_t CHUNK_SIZE = sizeof(m_Buf);
+
+		m_InputLen += len;
+
+		// Tell GCC that m_BufLen can't be out of bounds (see MD5::Update).
+		if (m_BufLen >= CHUNK_SIZE)
+			UNREACHABLE;
+
+		// If we have enough space in m_Buf and won't flush, simply append the input
+		if (m_BufLen + len < CHUNK_SIZE)
+		{
+			memcpy(m_Buf + m_BufLen, data, len);
+			m_BufLen += len;
+			return;
+		}
+
+		// Fall back to non-inline function if we have to do more work
+		UpdateRest(data, len);
+	}
+
+	void Final(u8* digest);
+
+private:
+	static const size_t LANES = 8;
+	static const size_t STRIPE_SIZE = LANES * sizeof(u64);
+	static const size_t STRIPES_PER_BLOCK = 16;
+
+	void InitState();
+	void UpdateRest(const u8* data, size_t len);
+	void ConsumeStripes(const u8* data, size_t numStripes);
+	void ConsumeStripe(const u8* data);
+
+	u64 m_Acc[LANES]; // internal state
+	u8 m_Buf[STRIPE_SIZE * 4]; // buffered input bytes
+	size_t m_BufLen; // bytes in m_Buf that are valid
+	size_t m_StripesInBlock; // stripes consumed since the last scramble
+	u64 m_InputLen; // bytes
+};
+
+#endif // INCLUDED_HASH128
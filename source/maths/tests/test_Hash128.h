@@ -0,0 +1,144 @@
+/* Copyright (C) 2026 Wildfire Games.
+ * This file is part of 0 A.D.
+ *
+ * 0 A.D. is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * 0 A.D. is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with 0 A.D.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "lib/self_test.h"
+
+#include "lib/types.h"
+#include "maths/Hash128.h"
+#include "ps/Util.h"
+
+#include <cstring>
+#include <set>
+#include <string>
+
+class TestHash128 : public CxxTest::TestSuite
+{
+public:
+	std::string decode(u8* digest)
+	{
+		return Hexify(digest, Hash128::DIGESTSIZE);
+	}
+
+	std::string hash(const u8* input, size_t len)
+	{
+		u8 digest[Hash128::DIGESTSIZE];
+
+		Hash128 h;
+		h.Update(input, len);
+		h.Final(digest);
+
+		return decode(digest);
+	}
+
+	void compare(const char* input, const char* expected)
+	{
+		TSM_ASSERT_STR_EQUALS(input, hash((const u8*)input, strlen(input)), expected);
+	}
+
+	void test_vectors()
+	{
+		// These values are specific to this implementation, they only guard
+		// against accidental changes which would break replay compatibility.
+		compare("", "f03e5185d173bb98972f5f184191f93d");
+		compare("a", "6d227d8162b0b0c99cd30a4e286062a2");
+		compare("abc", "bc66c1e37754f43afad19df78d2b397d");
+		compare("message digest", "325f654530d04defd6aea9f69ca09968");
+		compare("abcdefghijklmnopqrstuvwxyz", "cff97cfbe38935c642e208dd16f88289");
+		compare("ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789",
+			"c6ff2e7a75e19b1be582104a72986c57");
+		compare("12345678901234567890123456789012345678901234567890123456789012345678901234567890",
+			"4f97113a5724a137724446eade19fca1");
+	}
+
+	void test_align_long()
+	{
+		// Make sure it's not sensitive to alignment
+		// when processing long chunks (where it won't memcpy to an intermediate buffer)
+		std::string a0 (1000, 'a');
+		std::string a1 ("?" + a0);
+		std::string a2 ("??" + a0);
+		std::string a3 ("???" + a0);
+		compare(a0.c_str()+0, "19ff51359a373ef89315392e9e9b9437");
+		compare(a1.c_str()+1, "19ff51359a373ef89315392e9e9b9437");
+		compare(a2.c_str()+2, "19ff51359a373ef89315392e9e9b9437");
+		compare(a3.c_str()+3, "19ff51359a373ef89315392e9e9b9437");
+	}
+
+	void test_chunks()
+	{
+		// Long enough to cover several buffer flushes and scrambles
+		std::string input;
+		for (size_t i = 0; i < 5000; ++i)
+			input += static_cast<char>(i * 7 + i / 13);
+		const u8* in = (const u8*)input.data();
+		const size_t len = input.size();
+		const std::string expected = hash(in, len);
+
+		u8 digest[Hash128::DIGESTSIZE];
+
+		// Process one byte at a time
+		{
+			Hash128 h;
+			for (size_t i = 0; i < len; ++i)
+				h.Update(in+i, 1);
+			h.Final(digest);
+			TS_ASSERT_STR_EQUALS(decode(digest), expected);
+		}
+
+		// Split at various points
+		for (size_t i = 0; i <= len; i += 37)
+		{
+			Hash128 h;
+			h.Update(in, i);
+			h.Update(in+i, 0);
+			h.Update(in+i, len-i);
+			h.Final(digest);
+			TS_ASSERT_STR_EQUALS(decode(digest), expected);
+		}
+
+		// Final resets the state, so the object can be reused
+		{
+			Hash128 h;
+			h.Update(in, 10);
+			h.Final(digest);
+			h.Update(in, len);
+			h.Final(digest);
+			TS_ASSERT_STR_EQUALS(decode(digest), expected);
+		}
+	}
+
+	void test_lengths()
+	{
+		// Every length up to a few blocks, and every single bit flip of a long
+		// input, must give a distinct digest.
+		std::string input(1100, '\0');
+		std::set<std::string> digests;
+		for (size_t i = 0; i <= input.size(); ++i)
+			digests.insert(hash((const u8*)input.data(), i));
+		TS_ASSERT_EQUALS(digests.size(), input.size() + 1);
+
+		digests.clear();
+		for (size_t i = 0; i < input.size(); i += 11)
+		{
+			input[i] ^= 1;
+			digests.insert(hash((const u8*)input.data(), input.size()));
+			input[i] ^= 1;
+		}
+		digests.insert(hash((const u8*)input.data(), input.size()));
+		TS_ASSERT_EQUALS(digests.size(), input.size() / 11 + 1);
+	}
+};
@@ -1,4 +1,4 @@
-/* Copyright (C) 2025 Wildfire Games.
+/* Copyright (C) 2026 Wildfire Games.
  * This file is part of 0 A.D.
  *
  * 0 A.D. is free software: you can redistribute it and/or modify
@@ -47,12 +47,13 @@
 #include <SDL_timer.h>
 #include <algorithm>
 #include <functional>
+#include <istream>
 #include <iterator>
 #include <js/GCAPI.h>
 #include <js/TracingAPI.h>
 #include <map>
 #include <memory>
-#include <sstream>
+#include <ostream>
 #include <utility>
 
 /**
@@ -63,6 +64,13 @@
  */
 constexpr u32 NETWORK_BAD_PING = DEFAULT_TURN_LENGTH * COMMAND_DELAY_MP / 2;
 
+/**
+ * zlib level used to compress the game state sent to rejoining clients.
+ * The fastest level keeps the pause of the serializing client short,
+ * for a state only slightly larger than with the default level.
+ */
+constexpr int REJOIN_COMPRESSION_LEVEL = 1;
+
 CNetClient *g_NetClient = NULL;
 
 CNetClient::CNetClient(CGame* game, const CStrW& username, const CStr& hostJID) :
@@ -554,29 +562,30 @@ bool CNetClient::HandleMessage(CNetMessage* message)
 	{
 		CFileTransferRequestMessage* reqMessage = static_cast<CFileTransferRequestMessage*>(message);
 
-		std::string uncompressedGameState{[&]
-			{
-				if (static_cast<CNetFileTransferer::RequestType>(reqMessage->m_RequestType) ==
-					CNetFileTransferer::RequestType::LOADGAME)
-				{
-					return std::exchange(m_SavedState, {});
-				}
-
-				std::stringstream stream;
+		std::string compressedGameState;
+		if (static_cast<CNetFileTransferer::RequestType>(reqMessage->m_RequestType) ==
+			CNetFileTransferer::RequestType::LOADGAME)
+		{
+			// Compress the content with zlib to save bandwidth
+			CompressZLib(std::exchange(m_SavedState, {}), compressedGameState, true);
+		}
+		else
+		{
+			LOGMESSAGERENDER("Serializing game at turn %u for rejoining player", m_ClientTurnManager->GetCurrentTurn());
 
-				LOGMESSAGERENDER("Serializing game at turn %u for rejoining player", m_ClientTurnManager->GetCurrentTurn());
-				u32 turn = to_le32(m_ClientTurnManager->GetCurrentTurn());
-				stream.write((char*)&turn, sizeof(turn));
+			// Compress the state while serializing it, so that the whole uncompressed state
+			// is never held in memory. Favour speed over size since the game is paused meanwhile.
+			// (TODO: if this is still too large, compressing with e.g. LZMA works much better)
+			CZLibCompressStreamBuf compressor(compressedGameState, REJOIN_COMPRESSION_LEVEL);
+			std::ostream stream(&compressor);
 
-				bool ok = m_Game->GetSimulation2()->SerializeState(stream);
-				ENSURE(ok);
-				return stream.str();
-			}()};
+			u32 turn = to_le32(m_ClientTurnManager->GetCurrentTurn());
+			stream.write((char*)&turn, sizeof(turn));
 
-		// Compress the content with zlib to save bandwidth
-		// (TODO: if this is still too large, compressing with e.g. LZMA works much better)
-		std::string compressedGameState;
-		CompressZLib(std::move(uncompressedGameState), compressedGameState, true);
+			bool ok = m_Game->GetSimulation2()->SerializeState(stream);
+			ENSURE(ok);
+			compressor.Finish();
+		}
 
 		m_Session->GetFileTransferer().StartResponse(reqMessage->m_RequestID,
 			std::move(compressedGameState));
@@ -598,10 +607,9 @@ void CNetClient::LoadFinished()
 		// We're rejoining a game, and just finished loading the initial map,
 		// so deserialize the saved game state now
 
-		std::string state;
-		DecompressZLib(m_JoinSyncBuffer, state, true);
-
-		std::stringstream stream(state);
+		// Decompress the state while deserializing it
+		CZLibDecompressStreamBuf decompressor(m_JoinSyncBuffer);
+		std::istream stream(&decompressor);
 
 		u32 turn;
 		stream.read((char*)&turn, sizeof(turn));
@@ -125,6 +125,8 @@ void CNetClientTurnManager::OnSyncError(u32 turn, const CStr& expectedHash, cons
 	std::ofstream file (OsString(oosdumpPath), std::ofstream::out | std::ofstream::trunc);
 	file << "oos turn: " << turn << std::endl;
 	file << "net client turn: " << m_CurrentTurn << std::endl;
+	file << "state hash tree:" << std::endl;
+	m_Simulation2.DumpStateHashTree(file);
 	m_Simulation2.DumpDebugState(file);
 	file.close();
 
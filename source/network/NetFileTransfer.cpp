@@ -1,4 +1,4 @@
-/* Copyright (C) 2025 Wildfire Games.
+/* Copyright (C) 2026 Wildfire Games.
  * This file is part of 0 A.D.
  *
  * 0 A.D. is free software: you can redistribute it and/or modify
@@ -142,6 +142,10 @@ Status CNetFileTransferer::OnFileTransferAck(const CFileTransferAckMessage& mess
 
 	task.packetsInFlight -= message.m_NumPackets;
 
+	// Release the buffer once all of it has been received
+	if (task.packetsInFlight == 0 && task.offset == task.buffer.size())
+		m_FileSendTasks.erase(it);
+
 	return INFO::OK;
 
 }
@@ -158,19 +162,20 @@ void CNetFileTransferer::StartTask(RequestType requestType, std::function<void(s
 	m_Session->SendMessage(&request);
 }
 
-void CNetFileTransferer::StartResponse(u32 requestID, const std::string& data)
+void CNetFileTransferer::StartResponse(u32 requestID, std::string data)
 {
 	CNetFileSendTask task;
 	task.requestID = requestID;
-	task.buffer = data;
+	task.buffer = std::move(data);
 	task.offset = 0;
 	task.packetsInFlight = 0;
 	task.maxWindowSize = DEFAULT_FILE_TRANSFER_WINDOW_SIZE;
 
-	m_FileSendTasks[task.requestID] = task;
 	CFileTransferResponseMessage respMessage;
 	respMessage.m_RequestID = requestID;
 	respMessage.m_Length = task.buffer.size();
+
+	m_FileSendTasks[task.requestID] = std::move(task);
 	m_Session->SendMessage(&respMessage);
 }
 
@@ -193,6 +198,4 @@ void CNetFileTransferer::Poll()
 			m_Session->SendMessage(&dataMessage);
 		}
 	}
-
-	// TODO: need to garbage-collect finished tasks
 }
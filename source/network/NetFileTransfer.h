@@ -1,4 +1,4 @@
-/* Copyright (C) 2025 Wildfire Games.
+/* Copyright (C) 2026 Wildfire Games.
  * This file is part of 0 A.D.
  *
  * 0 A.D. is free software: you can redistribute it and/or modify
@@ -82,7 +82,7 @@ public:
 	 * (Callers are expected to have their own mechanism for receiving
 	 * requests and deciding what to respond with.)
 	 */
-	void StartResponse(u32 requestID, const std::string& data);
+	void StartResponse(u32 requestID, std::string data);
 
 	/**
 	 * Call frequently (e.g. once per frame) to trigger any necessary
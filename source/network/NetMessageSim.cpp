@@ -1,4 +1,4 @@
-/* Copyright (C) 2025 Wildfire Games.
+/* Copyright (C) 2026 Wildfire Games.
  * This file is part of 0 A.D.
  *
  * 0 A.D. is free software: you can redistribute it and/or modify
@@ -29,12 +29,26 @@
 #include "simulation2/serialization/StdDeserializer.h"
 #include "simulation2/serialization/StdSerializer.h"
 
+#include <algorithm>
+#include <array>
 #include <cstring>
+#include <js/Array.h>
+#include <js/Class.h>
+#include <js/Conversions.h>
+#include <js/GCVector.h>
+#include <js/Id.h>
+#include <js/Object.h>
+#include <js/PropertyAndElement.h>
+#include <js/Realm.h>
 #include <js/RootingAPI.h>
+#include <js/String.h>
 #include <js/TypeDecls.h>
 #include <js/Value.h>
+#include <jsapi.h>
+#include <span>
 #include <sstream>
 #include <string>
+#include <vector>
 
 class ScriptInterface;
 
@@ -116,6 +130,261 @@ public:
 	}
 };
 
+namespace
+{
+/**
+ * The most common commands are sent in a compact form: a schema gives the names
+ * (and order) of their properties, so that only the values are sent, and entity
+ * lists are packed as varints. Commands not matching a schema exactly, e.g. with
+ * other properties or a different property order, use the generic script value
+ * serialization, so that every command is received exactly as it was sent.
+ */
+enum class CommandFieldType
+{
+	VALUE,
+	ENTITIES
+};
+
+struct CommandField
+{
+	const char* name;
+	CommandFieldType type = CommandFieldType::VALUE;
+};
+
+struct CommandSchema
+{
+	const char* type;
+	std::vector<CommandField> fields;
+};
+
+const CommandField ENTITIES_FIELD{"entities", CommandFieldType::ENTITIES};
+
+const std::array<CommandSchema, 6> COMMAND_SCHEMAS{{
+	{"walk", {ENTITIES_FIELD, {"x"}, {"z"}, {"queued"}, {"pushFront"}, {"formation"}}},
+	{"gather", {ENTITIES_FIELD, {"target"}, {"queued"}, {"pushFront"}, {"formation"}}},
+	{"attack", {ENTITIES_FIELD, {"target"}, {"allowCapture"}, {"queued"}, {"pushFront"}, {"formation"}}},
+	{"train", {{"template"}, {"count"}, ENTITIES_FIELD, {"pushFront"}, {"metadata"}}},
+	{"construct", {{"template"}, {"x"}, {"z"}, {"angle"}, {"actorSeed"}, ENTITIES_FIELD,
+		{"autorepair"}, {"autocontinue"}, {"queued"}, {"pushFront"}, {"formation"}}},
+	{"formation", {ENTITIES_FIELD, {"formation"}}}
+}};
+
+constexpr u8 GENERIC_COMMAND_FORMAT = 0;
+
+void SerializeVarint(ISerializer& serializer, u32 value)
+{
+	while (value >= 0x80)
+	{
+		serializer.NumberU8_Unbounded("varint", static_cast<u8>(value | 0x80));
+		value >>= 7;
+	}
+	serializer.NumberU8_Unbounded("varint", static_cast<u8>(value));
+}
+
+u32 DeserializeVarint(IDeserializer& deserializer)
+{
+	u32 value = 0;
+	for (int shift = 0; shift < 35; shift += 7)
+	{
+		u8 byte;
+		deserializer.NumberU8_Unbounded("varint", byte);
+		value |= static_cast<u32>(byte & 0x7f) << shift;
+		if (!(byte & 0x80))
+			return value;
+	}
+	throw PSERROR_Deserialize_OutOfBounds("varint");
+}
+
+bool StringEquals(const ScriptRequest& rq, JSString* string, const char* ascii)
+{
+	bool match;
+	return JS_StringEqualsAscii(rq.cx, string, ascii, &match) && match;
+}
+
+/**
+ * Finds the schema @p command matches, with the mask of the schema fields it has
+ * and their values in order.
+ * @return the index of the schema in COMMAND_SCHEMAS plus one, or GENERIC_COMMAND_FORMAT.
+ */
+u8 MatchCommandSchema(const ScriptRequest& rq, JS::HandleValue command, u32& fieldMask, JS::MutableHandleValueVector values)
+{
+	if (!command.isObject())
+		return GENERIC_COMMAND_FORMAT;
+
+	// Only plain objects, since the receiver creates one.
+	JS::RootedObject obj(rq.cx, &command.toObject());
+	if (JSCLASS_CACHED_PROTO_KEY(JS::GetClass(obj)) != JSProto_Object)
+		return GENERIC_COMMAND_FORMAT;
+	JS::RootedObject proto(rq.cx);
+	if (!JS_GetPrototype(rq.cx, obj, &proto) || proto.get() != JS::GetRealmObjectPrototype(rq.cx))
+		return GENERIC_COMMAND_FORMAT;
+
+	JS::Rooted<JS::IdVector> ids(rq.cx, JS::IdVector(rq.cx));
+	if (!JS_Enumerate(rq.cx, obj, &ids) || ids.length() == 0)
+		return GENERIC_COMMAND_FORMAT;
+
+	// The first property must be the type, the others must be fields of its schema, in order.
+	const CommandSchema* schema = nullptr;
+	fieldMask = 0;
+	size_t field = 0;
+	JS::RootedId id(rq.cx);
+	JS::RootedValue name(rq.cx);
+	JS::RootedValue value(rq.cx);
+	for (size_t i = 0; i < ids.length(); ++i)
+	{
+		id = ids[i];
+		if (!JS_IdToValue(rq.cx, id, &name) || !name.isString() ||
+			!JS_GetPropertyById(rq.cx, obj, id, &value))
+			return GENERIC_COMMAND_FORMAT;
+
+		if (i == 0)
+		{
+			if (!StringEquals(rq, name.toString(), "type") || !value.isString())
+				return GENERIC_COMMAND_FORMAT;
+			const std::array<CommandSchema, 6>::const_iterator it = std::find_if(COMMAND_SCHEMAS.begin(), COMMAND_SCHEMAS.end(),
+				[&](const CommandSchema& candidate) { return StringEquals(rq, value.toString(), candidate.type); });
+			if (it == COMMAND_SCHEMAS.end())
+				return GENERIC_COMMAND_FORMAT;
+			schema = &*it;
+			continue;
+		}
+
+		while (field < schema->fields.size() && !StringEquals(rq, name.toString(), schema->fields[field].name))
+			++field;
+		if (field == schema->fields.size() || !values.append(value))
+			return GENERIC_COMMAND_FORMAT;
+		fieldMask |= 1u << field;
+		++field;
+	}
+
+	return static_cast<u8>(schema - COMMAND_SCHEMAS.data() + 1);
+}
+
+/**
+ * Returns whether @p value is an array of entity IDs, with no holes or other properties.
+ */
+bool IsEntityArray(const ScriptRequest& rq, JS::HandleValue value, JS::MutableHandleValueVector entities)
+{
+	bool isArray;
+	if (!value.isObject())
+		return false;
+	JS::RootedObject obj(rq.cx, &value.toObject());
+	if (!JS::IsArrayObject(rq.cx, obj, &isArray) || !isArray)
+		return false;
+
+	u32 length;
+	JS::Rooted<JS::IdVector> ids(rq.cx, JS::IdVector(rq.cx));
+	if (!JS::GetArrayLength(rq.cx, obj, &length) || !JS_Enumerate(rq.cx, obj, &ids) || ids.length() != length)
+		return false;
+
+	JS::RootedValue element(rq.cx);
+	for (u32 i = 0; i < length; ++i)
+	{
+		i32 id;
+		if (!JS_GetElement(rq.cx, obj, i, &element) || !element.isNumber() ||
+			!JS_DoubleIsInt32(element.toNumber(), &id) || id < 0 || !entities.append(JS::Int32Value(id)))
+			return false;
+	}
+	return true;
+}
+
+void SerializeCommand(ISerializer& serializer, const ScriptInterface& scriptInterface, const JS::PersistentRootedValue& data)
+{
+	ScriptRequest rq(scriptInterface);
+	JS::RootedValue command(rq.cx, data);
+
+	u32 fieldMask;
+	JS::RootedValueVector values(rq.cx);
+	const u8 format = MatchCommandSchema(rq, command, fieldMask, &values);
+	serializer.NumberU8_Unbounded("format", format);
+	if (format == GENERIC_COMMAND_FORMAT)
+	{
+		serializer.ScriptVal("command", &command);
+		return;
+	}
+
+	const CommandSchema& schema = COMMAND_SCHEMAS[format - 1];
+	SerializeVarint(serializer, fieldMask);
+
+	JS::RootedValue value(rq.cx);
+	JS::RootedValueVector entities(rq.cx);
+	size_t valueIndex = 0;
+	for (size_t field = 0; field < schema.fields.size(); ++field)
+	{
+		if (!(fieldMask & (1u << field)))
+			continue;
+
+		value.set(values[valueIndex++]);
+		if (schema.fields[field].type == CommandFieldType::ENTITIES)
+		{
+			// The length is offset by one, zero meaning the value isn't an entity list.
+			entities.clear();
+			if (IsEntityArray(rq, value, &entities))
+			{
+				SerializeVarint(serializer, entities.length() + 1);
+				for (const JS::Value& entity : entities)
+					SerializeVarint(serializer, entity.toInt32());
+				continue;
+			}
+			SerializeVarint(serializer, 0);
+		}
+		serializer.ScriptVal("value", &value);
+	}
+}
+
+void DeserializeCommand(IDeserializer& deserializer, const ScriptInterface& scriptInterface, JS::MutableHandleValue command)
+{
+	u8 format;
+	deserializer.NumberU8_Unbounded("format", format);
+	if (format == GENERIC_COMMAND_FORMAT)
+	{
+		deserializer.ScriptVal("command", command);
+		return;
+	}
+	if (format > COMMAND_SCHEMAS.size())
+		throw PSERROR_Deserialize_OutOfBounds("format");
+
+	const CommandSchema& schema = COMMAND_SCHEMAS[format - 1];
+	const u32 fieldMask = DeserializeVarint(deserializer);
+
+	ScriptRequest rq(scriptInterface);
+	JS::RootedObject obj(rq.cx, JS_NewPlainObject(rq.cx));
+	JS::RootedValue value(rq.cx, JS::StringValue(JS_NewStringCopyZ(rq.cx, schema.type)));
+	if (!obj || !JS_SetProperty(rq.cx, obj, "type", value))
+		throw PSERROR_Deserialize_ScriptError();
+
+	JS::RootedValueVector entities(rq.cx);
+	for (size_t field = 0; field < schema.fields.size(); ++field)
+	{
+		if (!(fieldMask & (1u << field)))
+			continue;
+
+		u32 length = 0;
+		if (schema.fields[field].type == CommandFieldType::ENTITIES)
+			length = DeserializeVarint(deserializer);
+
+		if (length == 0)
+			deserializer.ScriptVal("value", &value);
+		else
+		{
+			entities.clear();
+			for (u32 i = 0; i < length - 1; ++i)
+				if (!entities.append(JS::Int32Value(static_cast<i32>(DeserializeVarint(deserializer)))))
+					throw PSERROR_Deserialize_ScriptError();
+			JS::RootedObject array(rq.cx, JS::NewArrayObject(rq.cx, entities));
+			if (!array)
+				throw PSERROR_Deserialize_ScriptError();
+			value.setObject(*array);
+		}
+
+		if (!JS_SetProperty(rq.cx, obj, schema.fields[field].name, value))
+			throw PSERROR_Deserialize_ScriptError();
+	}
+
+	command.setObject(*obj);
+}
+} // anonymous namespace
+
 CSimulationMessage::CSimulationMessage(const ScriptInterface& scriptInterface) :
 	CNetMessage(NMT_SIMULATION_COMMAND), m_ScriptInterface(scriptInterface)
 {
@@ -145,28 +414,25 @@ CSimulationMessage::CSimulationMessage(const CSimulationMessage& orig) :
 u8* CSimulationMessage::Serialize(u8* pBuffer) const
 {
 	// TODO: ought to handle serialization exceptions
-	// TODO: ought to represent common commands more efficiently
 	u8* pos = CNetMessage::Serialize(pBuffer);
 	CBufferBinarySerializer serializer(m_ScriptInterface, pos);
 	serializer.NumberU32_Unbounded("client", m_Client);
 	serializer.NumberI32_Unbounded("player", m_Player);
 	serializer.NumberU32_Unbounded("turn", m_Turn);
 
-	serializer.ScriptVal("command", const_cast<JS::PersistentRootedValue*>(&m_Data));
+	SerializeCommand(serializer, m_ScriptInterface, m_Data);
 	return serializer.GetBuffer();
 }
 
 const u8* CSimulationMessage::Deserialize(const u8* pStart, const u8* pEnd)
 {
 	// TODO: ought to handle serialization exceptions
-	// TODO: ought to represent common commands more efficiently
 	const u8* pos = CNetMessage::Deserialize(pStart, pEnd);
-	std::istringstream stream(std::string(pos, pEnd));
-	CStdDeserializer deserializer(m_ScriptInterface, stream);
+	CStdDeserializer deserializer(m_ScriptInterface, std::as_bytes(std::span{pos, pEnd}));
 	deserializer.NumberU32_Unbounded("client", m_Client);
 	deserializer.NumberI32_Unbounded("player", m_Player);
 	deserializer.NumberU32_Unbounded("turn", m_Turn);
-	deserializer.ScriptVal("command", &m_Data);
+	DeserializeCommand(deserializer, m_ScriptInterface, &m_Data);
 	return pEnd;
 }
 
@@ -179,9 +445,7 @@ size_t CSimulationMessage::GetSerializedLength() const
 	serializer.NumberI32_Unbounded("player", m_Player);
 	serializer.NumberU32_Unbounded("turn", m_Turn);
 
-	// TODO: The cast can probably be removed if and when ScriptVal can take a JS::HandleValue instead of
-	// a JS::MutableHandleValue (relies on JSAPI change). Also search for other casts like this one in that case.
-	serializer.ScriptVal("command", const_cast<JS::PersistentRootedValue*>(&m_Data));
+	SerializeCommand(serializer, m_ScriptInterface, m_Data);
 	return CNetMessage::GetSerializedLength() + serializer.GetLength();
 }
 
@@ -222,8 +486,7 @@ const u8* CGameSetupMessage::Deserialize(const u8* pStart, const u8* pEnd)
 {
 	// TODO: ought to handle serialization exceptions
 	const u8* pos = CNetMessage::Deserialize(pStart, pEnd);
-	std::istringstream stream(std::string(pos, pEnd));
-	CStdDeserializer deserializer(m_ScriptInterface, stream);
+	CStdDeserializer deserializer(m_ScriptInterface, std::as_bytes(std::span{pos, pEnd}));
 	deserializer.ScriptVal("command", const_cast<JS::PersistentRootedValue*>(&m_Data));
 	return pEnd;
 }
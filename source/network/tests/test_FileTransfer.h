@@ -1,4 +1,4 @@
-/* Copyright (C) 2025 Wildfire Games.
+/* Copyright (C) 2026 Wildfire Games.
  * This file is part of 0 A.D.
  *
  * 0 A.D. is free software: you can redistribute it and/or modify
@@ -123,7 +123,7 @@ public:
 
 		TS_ASSERT(complete);
 
-		server.transferer.HandleMessageReceive(client.queues.acknowledgements.at(0));
+		TS_ASSERT_EQUALS(server.transferer.HandleMessageReceive(client.queues.acknowledgements.at(0)), INFO::OK);
 		CheckSizes(server.queues, 0, 1, 1, 0);
 	}
 
@@ -20,11 +20,13 @@
 #include "lib/types.h"
 #include "network/NetMessage.h"
 #include "ps/CStr.h"
+#include "scriptinterface/JSON.h"
 #include "scriptinterface/Object.h"
 #include "scriptinterface/ScriptInterface.h"
 #include "scriptinterface/ScriptRequest.h"
 
 #include <cstddef>
+#include <string>
 #include <js/RootingAPI.h>
 #include <js/TypeDecls.h>
 #include <js/Value.h>
@@ -54,4 +56,50 @@ public:
 		delete msg2;
 		delete[] buf;
 	}
+
+	/**
+	 * Sends the command given as JSON, checks it's received unchanged and returns the message length.
+	 */
+	size_t RoundTripCommand(const ScriptInterface& script, const std::string& json)
+	{
+		ScriptRequest rq(script);
+		JS::RootedValue command(rq.cx);
+		TS_ASSERT(Script::ParseJSON(rq, json, &command));
+		CSimulationMessage msg(script, 1, 2, 3, command);
+
+		const size_t len = msg.GetSerializedLength();
+		std::string buf(len, '\0');
+		TS_ASSERT_EQUALS(msg.Serialize(reinterpret_cast<u8*>(buf.data())) - reinterpret_cast<u8*>(buf.data()), static_cast<std::ptrdiff_t>(len));
+
+		CNetMessage* msg2 = CNetMessageFactory::CreateMessage(buf.data(), len, script);
+		TS_ASSERT_STR_EQUALS(static_cast<CSimulationMessage*>(msg2)->ToString(), msg.ToString());
+		JS::RootedValue received(rq.cx, static_cast<CSimulationMessage*>(msg2)->m_Data);
+		TS_ASSERT_STR_EQUALS(Script::StringifyJSON(rq, &received, false), Script::StringifyJSON(rq, &command, false));
+		delete msg2;
+		return len;
+	}
+
+	void test_sim_commands()
+	{
+		ScriptInterface script("Test", "Test", g_ScriptContext);
+
+		// Commands matching a compact encoding, with all or some of their properties.
+		const size_t compactLength = RoundTripCommand(script, "{\"type\":\"walk\",\"entities\":[1,2,300000],\"x\":100.5,\"z\":20,\"queued\":false,\"pushFront\":true,\"formation\":\"special/formations/null\"}");
+		RoundTripCommand(script, "{\"type\":\"gather\",\"entities\":[],\"target\":412}");
+		RoundTripCommand(script, "{\"type\":\"train\",\"template\":\"units/athen/infantry_spearman_b\",\"count\":5,\"entities\":[17],\"metadata\":{\"trainer\":17}}");
+		RoundTripCommand(script, "{\"type\":\"formation\",\"entities\":[5,6]}");
+
+		// Entity lists which can't be packed.
+		RoundTripCommand(script, "{\"type\":\"attack\",\"entities\":[1.5,-2],\"target\":3}");
+		RoundTripCommand(script, "{\"type\":\"attack\",\"entities\":null,\"target\":3}");
+
+		// Commands using the generic encoding: other properties, another order, other types.
+		RoundTripCommand(script, "{\"type\":\"walk\",\"entities\":[1],\"x\":1,\"z\":2,\"extra\":true}");
+		RoundTripCommand(script, "{\"entities\":[1],\"type\":\"walk\",\"x\":1,\"z\":2}");
+		RoundTripCommand(script, "{\"type\":\"delete-entities\",\"entities\":[1,2]}");
+		RoundTripCommand(script, "[\"walk\"]");
+
+		const size_t genericLength = RoundTripCommand(script, "{\"type\":\"walk\",\"x\":100.5,\"entities\":[1,2,300000],\"z\":20,\"queued\":false,\"pushFront\":true,\"formation\":\"special/formations/null\"}");
+		TS_ASSERT_LESS_THAN(compactLength, genericLength);
+	}
 };
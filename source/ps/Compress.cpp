@@ -1,4 +1,4 @@
-/* Copyright (C) 2025 Wildfire Games.
+/* Copyright (C) 2026 Wildfire Games.
  * This file is part of 0 A.D.
  *
  * 0 A.D. is free software: you can redistribute it and/or modify
@@ -22,6 +22,9 @@
 #include "lib/byte_order.h"
 #include "lib/debug.h"
 #include "lib/external_libraries/zlib.h"
+#include "ps/CLogger.h"
+
+#include <algorithm>
 
 void CompressZLib(const std::string& data, std::string& out, bool includeLengthHeader)
 {
@@ -62,3 +65,144 @@ void DecompressZLib(const std::string& data, std::string& out, bool includeLengt
 
 	// TODO: better error reporting might be nice
 }
+
+CZLibCompressStreamBuf::CZLibCompressStreamBuf(std::string& out, int level) :
+	m_Out(out), m_OutSize(4), m_ZStream(std::make_unique<z_stream>())
+{
+	// Leave room for the 4-byte uncompressed length header, written by Finish
+	m_Out.clear();
+	m_Out.resize(64*KiB);
+
+	int zok = deflateInit(m_ZStream.get(), level);
+	ENSURE(zok == Z_OK);
+
+	setp(m_Buffer, m_Buffer + ARRAY_SIZE(m_Buffer));
+}
+
+CZLibCompressStreamBuf::~CZLibCompressStreamBuf()
+{
+	deflateEnd(m_ZStream.get());
+}
+
+void CZLibCompressStreamBuf::Finish()
+{
+	sync();
+	Deflate(nullptr, 0, Z_FINISH);
+
+	write_le32(m_Out.data(), m_ZStream->total_in);
+	m_Out.resize(m_OutSize);
+}
+
+int CZLibCompressStreamBuf::overflow(int ch)
+{
+	sync();
+	if (ch != traits_type::eof())
+	{
+		*pptr() = ch;
+		pbump(1);
+	}
+	return traits_type::not_eof(ch);
+}
+
+int CZLibCompressStreamBuf::sync()
+{
+	// Only compress the buffered data: flushing zlib would hurt the compression ratio
+	Deflate(pbase(), pptr() - pbase(), Z_NO_FLUSH);
+	setp(m_Buffer, m_Buffer + ARRAY_SIZE(m_Buffer));
+	return 0;
+}
+
+std::streamsize CZLibCompressStreamBuf::xsputn(const char* s, std::streamsize n)
+{
+	// Buffer small writes, and hand large ones directly to zlib
+	if (n <= epptr() - pptr())
+	{
+		std::copy(s, s + n, pptr());
+		pbump(n);
+		return n;
+	}
+
+	sync();
+	Deflate(s, n, Z_NO_FLUSH);
+	return n;
+}
+
+void CZLibCompressStreamBuf::Deflate(const char* data, size_t size, int flush)
+{
+	if (size == 0 && flush == Z_NO_FLUSH)
+		return;
+
+	z_stream& stream = *m_ZStream;
+	stream.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(data));
+	stream.avail_in = size;
+
+	int zok;
+	do
+	{
+		if (m_OutSize == m_Out.size())
+			m_Out.resize(m_Out.size() * 2);
+
+		stream.next_out = reinterpret_cast<Bytef*>(m_Out.data()) + m_OutSize;
+		stream.avail_out = m_Out.size() - m_OutSize;
+		zok = deflate(&stream, flush);
+		ENSURE(zok == Z_OK || zok == Z_STREAM_END || zok == Z_BUF_ERROR);
+		m_OutSize = m_Out.size() - stream.avail_out;
+	}
+	while (stream.avail_in > 0 || (flush == Z_FINISH && zok != Z_STREAM_END));
+}
+
+CZLibDecompressStreamBuf::CZLibDecompressStreamBuf(const std::string& data) :
+	m_Length(0), m_Ended(false), m_ZStream(std::make_unique<z_stream>())
+{
+	int zok = inflateInit(m_ZStream.get());
+	ENSURE(zok == Z_OK);
+
+	if (data.size() < 4)
+	{
+		LOGERROR("Decompression failed: missing length header");
+		m_Ended = true;
+		return;
+	}
+
+	m_Length = read_le32(data.data());
+	m_ZStream->next_in = reinterpret_cast<Bytef*>(const_cast<char*>(data.data())) + 4;
+	m_ZStream->avail_in = data.size() - 4;
+}
+
+CZLibDecompressStreamBuf::~CZLibDecompressStreamBuf()
+{
+	inflateEnd(m_ZStream.get());
+}
+
+CZLibDecompressStreamBuf::int_type CZLibDecompressStreamBuf::underflow()
+{
+	if (gptr() < egptr())
+		return traits_type::to_int_type(*gptr());
+
+	if (m_Ended)
+		return traits_type::eof();
+
+	z_stream& stream = *m_ZStream;
+	stream.next_out = reinterpret_cast<Bytef*>(m_Buffer);
+	stream.avail_out = ARRAY_SIZE(m_Buffer);
+
+	int zok = inflate(&stream, Z_NO_FLUSH);
+	if (zok == Z_STREAM_END)
+	{
+		m_Ended = true;
+		if (stream.total_out != m_Length)
+			LOGERROR("Decompression failed: expected %u bytes, got %lu", m_Length, stream.total_out);
+	}
+	else if (zok != Z_OK)
+	{
+		m_Ended = true;
+		LOGERROR("Decompression failed: zlib error %d", zok);
+	}
+
+	const size_t size = ARRAY_SIZE(m_Buffer) - stream.avail_out;
+	if (size == 0)
+		return traits_type::eof();
+
+	setg(m_Buffer, m_Buffer, m_Buffer + size);
+	return traits_type::to_int_type(*gptr());
+}
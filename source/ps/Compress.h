@@ -1,4 +1,4 @@
-/* Copyright (C) 2020 Wildfire Games.
+/* Copyright (C) 2026 Wildfire Games.
  * This file is part of 0 A.D.
  *
  * 0 A.D. is free software: you can redistribute it and/or modify
@@ -18,15 +18,83 @@
 #ifndef INCLUDED_COMPRESS
 #define INCLUDED_COMPRESS
 
+#include "lib/alignment.h"
+#include "lib/code_annotation.h"
+#include "lib/types.h"
+
+#include <memory>
+#include <streambuf>
 #include <string>
 
+struct z_stream_s;
+
 /**
  * @file
- * Simple (non-streaming) compression functions.
+ * Simple (non-streaming) compression functions, and stream buffers to
+ * compress or decompress data of the same format incrementally.
  */
 
 void CompressZLib(const std::string& data, std::string& out, bool includeLengthHeader);
 
 void DecompressZLib(const std::string& data, std::string& out, bool includeLengthHeader);
 
+/**
+ * Output stream buffer which compresses everything written to it into @p out,
+ * in the format of CompressZLib with a length header, so the uncompressed data
+ * never has to be held in memory.
+ * Finish must be called after the last write.
+ */
+class CZLibCompressStreamBuf final : public std::streambuf
+{
+	NONCOPYABLE(CZLibCompressStreamBuf);
+public:
+	/**
+	 * @param level zlib compression level, from 1 (fastest) to 9 (smallest),
+	 * or -1 for zlib's default.
+	 */
+	CZLibCompressStreamBuf(std::string& out, int level = -1);
+	~CZLibCompressStreamBuf() override;
+
+	/**
+	 * Compresses the remaining data and writes the length header.
+	 */
+	void Finish();
+
+protected:
+	int overflow(int ch) override;
+	int sync() override;
+	std::streamsize xsputn(const char* s, std::streamsize n) override;
+
+private:
+	void Deflate(const char* data, size_t size, int flush);
+
+	std::string& m_Out;
+	size_t m_OutSize;
+	std::unique_ptr<z_stream_s> m_ZStream;
+	char m_Buffer[16*KiB];
+};
+
+/**
+ * Input stream buffer which decompresses data produced by CompressZLib with a
+ * length header (or by CZLibCompressStreamBuf) as it is read.
+ * @p data must outlive the stream buffer.
+ * Corrupted or truncated data is reported as an early end of stream.
+ */
+class CZLibDecompressStreamBuf final : public std::streambuf
+{
+	NONCOPYABLE(CZLibDecompressStreamBuf);
+public:
+	CZLibDecompressStreamBuf(const std::string& data);
+	~CZLibDecompressStreamBuf() override;
+
+protected:
+	int_type underflow() override;
+
+private:
+	u32 m_Length;
+	bool m_Ended;
+	std::unique_ptr<z_stream_s> m_ZStream;
+	char m_Buffer[16*KiB];
+};
+
 #endif // INCLUDED_COMPRESS
@@ -49,6 +49,7 @@
 #include "simulation2/Simulation2.h"
 #include "simulation2/components/ICmpPlayer.h"
 #include "simulation2/components/ICmpPlayerManager.h"
+#include "simulation2/serialization/StateHashType.h"
 #include "simulation2/system/Component.h"
 #include "simulation2/system/Entity.h"
 #include "simulation2/system/LocalTurnManager.h"
@@ -61,7 +62,7 @@
 #include <js/RootingAPI.h>
 #include <js/Value.h>
 #include <memory>
-#include <sstream>
+#include <span>
 #include <utility>
 
 extern GameLoopState* g_AtlasGameLoop;
@@ -169,6 +170,16 @@ int CGame::LoadVisualReplayData()
 			std::getline(*m_ReplayStream, line);
 			replayTurnMgr->StoreReplayCommand(currentTurn, player, line);
 		}
+		else if (type == "hash-type")
+		{
+			std::string hashTypeName;
+			*m_ReplayStream >> hashTypeName;
+			StateHashType hashType;
+			if (ParseStateHashType(hashTypeName, hashType))
+				m_Simulation2->SetStateHashType(hashType);
+			else
+				CancelLoad(L"Failed to load replay data (unknown hash type)");
+		}
 		else if (type == "hash" || type == "hash-quick")
 		{
 			bool quick = (type == "hash-quick");
@@ -211,6 +222,9 @@ bool CGame::StartVisualReplay(const OsPath& replayPath)
 	Script::ParseJSON(rq, line, &attribs);
 	StartGame(&attribs, "");
 
+	// Replays which don't specify the hash type were recorded with MD5.
+	m_Simulation2->SetStateHashType(StateHashType::MD5);
+
 	return true;
 }
 
@@ -305,9 +319,7 @@ int CGame::LoadInitialState(const std::string& savedState)
 {
 	ENSURE(m_IsSavedGame);
 
-	std::stringstream stream(savedState);
-
-	bool ok = m_Simulation2->DeserializeState(stream);
+	bool ok = m_Simulation2->DeserializeState(std::as_bytes(std::span{savedState}));
 	if (!ok)
 	{
 		CancelLoad(L"Failed to load saved game state. It might have been\nsaved with an incompatible version of the game.");
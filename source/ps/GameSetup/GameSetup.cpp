@@ -66,6 +66,7 @@
 #include "ps/ProfileViewer.h"
 #include "ps/Profiler2.h"
 #include "ps/Pyrogenesis.h"	// psSetLogDir
+#include "ps/SavedGame.h"
 #include "ps/TemplateLoader.h"
 #include "ps/ThreadUtil.h"
 #include "ps/TouchInput.h"
@@ -362,6 +363,8 @@ void EndGame()
 	SAFE_DELETE(g_NetServer);
 	SAFE_DELETE(g_Game);
 
+	SavedGames::WaitForPendingSave();
+
 	if (CRenderer::IsInitialised())
 	{
 		ISoundManager::CloseGame();
@@ -49,6 +49,7 @@
 #include "simulation2/components/ICmpGuiInterface.h"
 #include "simulation2/helpers/Player.h"
 #include "simulation2/helpers/SimulationCommand.h"
+#include "simulation2/serialization/StateHashType.h"
 #include "simulation2/system/Component.h"
 #include "simulation2/system/Entity.h"
 
@@ -90,6 +91,7 @@ void CReplayLogger::StartGame(JS::MutableHandleValue attribs)
 
 	m_Stream = new std::ofstream(OsString(m_Directory / L"commands.txt"), std::ofstream::out | std::ofstream::trunc);
 	*m_Stream << "start " << Script::StringifyJSON(rq, attribs, false) << "\n";
+	*m_Stream << "hash-type " << GetStateHashTypeName(DEFAULT_STATE_HASH_TYPE) << "\n";
 }
 
 void CReplayLogger::Turn(u32 n, u32 turnLength, std::vector<SimulationCommand>& commands)
@@ -261,6 +263,8 @@ void CReplayPlayer::Replay(const bool serializationtest, const int rejointesttur
 				debugOption.oosLog = true;
 
 			g_Game = new CGame(false, debugOption);
+			// Replays which don't specify the hash type were recorded with MD5.
+			g_Game->GetSimulation2()->SetStateHashType(StateHashType::MD5);
 
 			ScriptRequest rq(g_Game->GetSimulation2()->GetScriptInterface());
 			JS::RootedValue attribs(rq.cx);
@@ -272,6 +276,9 @@ void CReplayPlayer::Replay(const bool serializationtest, const int rejointesttur
 
 			PSRETURN ret = g_Game->ReallyStartGame();
 			ENSURE(ret == PSRETURN_OK);
+
+			if (m_Listener)
+				m_Listener->OnReplayStart(*g_Game->GetSimulation2());
 		}
 		else if (type == "turn")
 		{
@@ -291,6 +298,16 @@ void CReplayPlayer::Replay(const bool serializationtest, const int rejointesttur
 			Script::DeepFreezeObject(rq, data);
 			commands.emplace_back(SimulationCommand(player, rq.cx, data));
 		}
+		else if (type == "hash-type")
+		{
+			std::string hashTypeName;
+			*m_Stream >> hashTypeName;
+			StateHashType hashType;
+			if (ParseStateHashType(hashTypeName, hashType))
+				g_Game->GetSimulation2()->SetStateHashType(hashType);
+			else
+				LOGERROR("Unknown replay hash type '%s'", hashTypeName);
+		}
 		else if (type == "hash" || type == "hash-quick")
 		{
 			std::string replayHash;
@@ -305,8 +322,13 @@ void CReplayPlayer::Replay(const bool serializationtest, const int rejointesttur
 				g_Profiler2.IncrementFrameNumber();
 				PROFILE2_ATTR("%d", g_Profiler2.GetFrameNumber());
 
+				const double startTime = timer_Time();
 				g_Game->GetSimulation2()->Update(turnLength, commands);
+				const double updateTime = timer_Time() - startTime;
 				commands.clear();
+
+				if (m_Listener)
+					m_Listener->OnReplayTurn(turn, turnLength, updateTime, *g_Game->GetSimulation2());
 			}
 
 			g_Profiler.Frame();
@@ -329,6 +351,9 @@ void CReplayPlayer::Replay(const bool serializationtest, const int rejointesttur
 	debug_printf("# Final state: %s\n", Hexify(hash).c_str());
 	timer_DisplayClientTotals();
 
+	if (m_Listener)
+		m_Listener->OnReplayEnd(hash);
+
 	SAFE_DELETE(g_Game);
 
 	// Must be explicitly destructed here to avoid callbacks from the JSAPI trying to use g_Profiler2 when
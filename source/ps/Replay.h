@@ -1,4 +1,4 @@
-/* Copyright (C) 2025 Wildfire Games.
+/* Copyright (C) 2026 Wildfire Games.
  * This file is part of 0 A.D.
  *
  * 0 A.D. is free software: you can redistribute it and/or modify
@@ -104,6 +104,31 @@ private:
 	OsPath m_Directory;
 };
 
+/**
+ * Receives notifications from CReplayPlayer while a replay is being run,
+ * e.g. to collect timings for benchmarking.
+ */
+class IReplayListener
+{
+public:
+	virtual ~IReplayListener() { }
+
+	/**
+	 * Called once the game has been loaded and before the first turn is run.
+	 */
+	virtual void OnReplayStart(CSimulation2& simulation) = 0;
+
+	/**
+	 * Called after each simulation turn, with the wall-clock time the update took.
+	 */
+	virtual void OnReplayTurn(u32 turn, u32 turnLength, double seconds, CSimulation2& simulation) = 0;
+
+	/**
+	 * Called after the last turn with the (binary) hash of the final simulation state.
+	 */
+	virtual void OnReplayEnd(const std::string& finalStateHash) = 0;
+};
+
 /**
  * Replay log replayer. Runs the log with no graphics and dumps some info to stdout.
  */
@@ -116,8 +141,14 @@ public:
 	void Load(const OsPath& path);
 	void Replay(const bool serializationtest, const int rejointestturn, const bool ooslog, const bool testHashFull, const bool testHashQuick);
 
+	/**
+	 * Set a listener to be notified while the replay runs. The listener must outlive Replay().
+	 */
+	void SetListener(IReplayListener* listener) { m_Listener = listener; }
+
 private:
 	std::istream* m_Stream;
+	IReplayListener* m_Listener{nullptr};
 	void TestHash(const std::string& hashType, const std::string& replayHash, const bool testHashFull, const bool testHashQuick);
 };
 
@@ -0,0 +1,167 @@
+/* Copyright (C) 2026 Wildfire Games.
+ * This file is part of 0 A.D.
+ *
+ * 0 A.D. is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * 0 A.D. is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with 0 A.D.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "precompiled.h"
+
+#include "ReplayBenchmark.h"
+
+#include "lib/build_version.h"
+#include "lib/debug.h"
+#include "lib/file/file_system.h"
+#include "lib/path.h"
+#include "ps/CStr.h"
+#include "ps/Util.h"
+#include "simulation2/Simulation2.h"
+#include "simulation2/system/ComponentManager.h"
+#include "simulation2/system/SimContext.h"
+
+#include <algorithm>
+#include <cmath>
+#include <numeric>
+#include <ostream>
+
+namespace
+{
+/**
+ * Percentiles reported for every series, using the nearest-rank method.
+ */
+constexpr int PERCENTILES[] = { 50, 90, 95, 99 };
+
+void WriteStatistics(std::ostream& stream, std::vector<double> samples)
+{
+	std::sort(samples.begin(), samples.end());
+
+	const double total = std::accumulate(samples.begin(), samples.end(), 0.0);
+	stream << "{\"count\": " << samples.size();
+	stream << ", \"total\": " << total * 1000.0;
+	stream << ", \"mean\": " << (samples.empty() ? 0.0 : total * 1000.0 / samples.size());
+	for (int percentile : PERCENTILES)
+	{
+		double value = 0.0;
+		if (!samples.empty())
+		{
+			const size_t rank = static_cast<size_t>(std::ceil(percentile / 100.0 * samples.size()));
+			value = samples[std::max<size_t>(rank, 1) - 1];
+		}
+		stream << ", \"p" << percentile << "\": " << value * 1000.0;
+	}
+	stream << ", \"max\": " << (samples.empty() ? 0.0 : samples.back() * 1000.0) << "}";
+}
+
+void FindReplaysRecursive(const OsPath& directory, std::vector<OsPath>& replays)
+{
+	if (FileExists(directory / L"commands.txt"))
+		replays.push_back(directory / L"commands.txt");
+
+	DirectoryNames subdirectories;
+	if (GetDirectoryEntries(directory, nullptr, &subdirectories) != INFO::OK)
+		return;
+
+	std::sort(subdirectories.begin(), subdirectories.end());
+	for (const OsPath& subdirectory : subdirectories)
+		FindReplaysRecursive(directory / subdirectory, replays);
+}
+} // anonymous namespace
+
+std::vector<OsPath> CReplayBenchmark::FindReplays(const OsPath& path)
+{
+	std::vector<OsPath> replays;
+	if (DirectoryExists(path))
+		FindReplaysRecursive(path, replays);
+	else if (FileExists(path))
+		replays.push_back(path);
+	return replays;
+}
+
+void CReplayBenchmark::Run(const OsPath& replayFile, int runs)
+{
+	for (int run = 0; run < runs; ++run)
+	{
+		debug_printf("Benchmarking '%s' (run %d of %d)\n", replayFile.string8().c_str(), run + 1, runs);
+		m_Results.push_back({ replayFile, run, {}, {}, {} });
+
+		CReplayPlayer replay;
+		replay.SetListener(this);
+		replay.Load(replayFile);
+		replay.Replay(false, -1, false, false, false);
+	}
+}
+
+void CReplayBenchmark::OnReplayStart(CSimulation2& simulation)
+{
+	simulation.GetSimContext().GetComponentManager().SetComponentTimingsEnabled(true);
+}
+
+void CReplayBenchmark::OnReplayTurn(u32 /*turn*/, u32 /*turnLength*/, double seconds, CSimulation2& simulation)
+{
+	ENSURE(!m_Results.empty());
+	ReplayResult& result = m_Results.back();
+
+	CComponentManager& componentManager = simulation.GetSimContext().GetComponentManager();
+	for (const std::pair<const CComponentManager::ComponentTypeId, double>& timing : componentManager.TakeComponentTimings())
+	{
+		std::vector<double>& samples = result.componentTimes[componentManager.LookupComponentTypeName(timing.first)];
+		// Components which didn't run in earlier turns took no time there.
+		samples.resize(result.turnTimes.size(), 0.0);
+		samples.push_back(timing.second);
+	}
+
+	result.turnTimes.push_back(seconds);
+	for (std::pair<const std::string, std::vector<double>>& samples : result.componentTimes)
+		samples.second.resize(result.turnTimes.size(), 0.0);
+}
+
+void CReplayBenchmark::OnReplayEnd(const std::string& finalStateHash)
+{
+	ENSURE(!m_Results.empty());
+	m_Results.back().finalStateHash = Hexify(finalStateHash);
+}
+
+void CReplayBenchmark::WriteJSON(std::ostream& stream) const
+{
+	stream << "{\"engine_version\": \"" << CStr(PS_VERSION).EscapeToPrintableASCII() << "\",\n";
+	stream << "\"unit\": \"ms\",\n";
+	stream << "\"replays\": [";
+	bool firstResult = true;
+	for (const ReplayResult& result : m_Results)
+	{
+		if (!firstResult)
+			stream << ",";
+		firstResult = false;
+
+		stream << "\n{\"path\": \"" << CStr(result.path.string8()).EscapeToPrintableASCII() << "\",\n";
+		stream << "\"run\": " << result.run << ",\n";
+		stream << "\"final_state_hash\": \"" << result.finalStateHash << "\",\n";
+		stream << "\"turns\": ";
+		WriteStatistics(stream, result.turnTimes);
+		stream << ",\n\"components\": {";
+		bool firstComponent = true;
+		for (const std::pair<const std::string, std::vector<double>>& samples : result.componentTimes)
+		{
+			if (!firstComponent)
+				stream << ",";
+			firstComponent = false;
+			stream << "\n\t\"" << CStr(samples.first).EscapeToPrintableASCII() << "\": ";
+			WriteStatistics(stream, samples.second);
+		}
+		stream << "\n},\n\"per_turn\": [";
+		for (size_t i = 0; i < result.turnTimes.size(); ++i)
+			stream << (i ? ", " : "") << result.turnTimes[i] * 1000.0;
+		stream << "]}";
+	}
+	stream << "\n]}\n";
+}
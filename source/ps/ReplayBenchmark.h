@@ -0,0 +1,79 @@
+/* Copyright (C) 2026 Wildfire Games.
+ * This file is part of 0 A.D.
+ *
+ * 0 A.D. is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * 0 A.D. is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with 0 A.D.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef INCLUDED_REPLAYBENCHMARK
+#define INCLUDED_REPLAYBENCHMARK
+
+#include "lib/code_annotation.h"
+#include "lib/os_path.h"
+#include "lib/types.h"
+#include "ps/Replay.h"
+
+#include <iosfwd>
+#include <map>
+#include <string>
+#include <vector>
+
+class CSimulation2;
+
+/**
+ * Runs a corpus of replays non-visually at maximum speed and collects per-turn
+ * and per-component simulation timings, which can be written out as JSON to
+ * compare the performance of different builds.
+ */
+class CReplayBenchmark : public IReplayListener
+{
+	NONCOPYABLE(CReplayBenchmark);
+public:
+	CReplayBenchmark() = default;
+
+	/**
+	 * Returns the commands.txt files found at the given path. If @p path is a directory,
+	 * it is searched recursively.
+	 */
+	static std::vector<OsPath> FindReplays(const OsPath& path);
+
+	/**
+	 * Runs the given replay @p runs times, accumulating the results.
+	 * The VFS must have been set up as for CReplayPlayer.
+	 */
+	void Run(const OsPath& replayFile, int runs);
+
+	/**
+	 * Writes all results collected so far. Times are given in milliseconds.
+	 */
+	void WriteJSON(std::ostream& stream) const;
+
+	void OnReplayStart(CSimulation2& simulation) override;
+	void OnReplayTurn(u32 turn, u32 turnLength, double seconds, CSimulation2& simulation) override;
+	void OnReplayEnd(const std::string& finalStateHash) override;
+
+private:
+	struct ReplayResult
+	{
+		OsPath path;
+		int run;
+		std::string finalStateHash;
+		std::vector<double> turnTimes;
+		// Per-turn samples for each component type name, aligned with turnTimes.
+		std::map<std::string, std::vector<double>> componentTimes;
+	};
+
+	std::vector<ReplayResult> m_Results;
+};
+
+#endif // INCLUDED_REPLAYBENCHMARK
@@ -38,10 +38,12 @@
 #include "ps/CLogger.h"
 #include "ps/CStr.h"
 #include "ps/Filesystem.h"
+#include "ps/Future.h"
 #include "ps/Game.h"
 #include "ps/Mod.h"
 #include "ps/Profiler2.h"
 #include "ps/Pyrogenesis.h"
+#include "ps/TaskManager.h"
 #include "scriptinterface/JSON.h"
 #include "scriptinterface/Object.h"
 #include "scriptinterface/ScriptConversions.h"
@@ -54,15 +56,62 @@
 #include <js/RootingAPI.h>
 #include <js/TypeDecls.h>
 #include <memory>
-#include <sstream>
+#include <string>
 #include <utility>
 
 class ScriptInterface;
 
 // TODO: we ought to check version numbers when loading files
 
+namespace
+{
+/**
+ * Compressing and writing a saved game is done on a worker, so that only serializing
+ * the state stalls the game. Saves are written one at a time, since they share a
+ * temporary file and numbered saves need to see the previous ones.
+ */
+Future<void> g_PendingSave;
+
+Status WriteSavedGame(const OsPath& tempSaveFileRealPath, const VfsPath& filename, time_t now,
+	const std::string& metadataString, const std::string& simState)
+{
+	PROFILE2("write saved game");
+
+	// Write the saved game as zip file containing the various components
+	PIArchiveWriter archiveWriter = CreateArchiveWriter_Zip(tempSaveFileRealPath, false);
+	if (!archiveWriter)
+		WARN_RETURN(ERR::FAIL);
+
+	WARN_RETURN_STATUS_IF_ERR(archiveWriter->AddMemory((const u8*)metadataString.c_str(), metadataString.length(), now, "metadata.json"));
+	WARN_RETURN_STATUS_IF_ERR(archiveWriter->AddMemory((const u8*)simState.c_str(), simState.length(), now, "simulation.dat"));
+	archiveWriter.reset(); // close the file
+
+	WriteBuffer buffer;
+	CFileInfo tempSaveFile;
+	WARN_RETURN_STATUS_IF_ERR(GetFileInfo(tempSaveFileRealPath, &tempSaveFile));
+	buffer.Reserve(tempSaveFile.Size());
+	WARN_RETURN_STATUS_IF_ERR(io::Load(tempSaveFileRealPath, buffer.Data().get(), buffer.Size()));
+	WARN_RETURN_STATUS_IF_ERR(g_VFS->CreateFile(filename, buffer.Data(), buffer.Size()));
+
+	OsPath realPath;
+	WARN_RETURN_STATUS_IF_ERR(g_VFS->GetRealPath(filename, realPath));
+	LOGMESSAGERENDER("Saved game to '%s'", realPath.string8());
+	debug_printf("Saved game to '%s'\n", realPath.string8().c_str());
+
+	return INFO::OK;
+}
+} // anonymous namespace
+
+void SavedGames::WaitForPendingSave()
+{
+	if (g_PendingSave.Valid())
+		g_PendingSave.Get();
+}
+
 Status SavedGames::SavePrefix(const CStrW& prefix, const CStrW& description, CSimulation2& simulation, const Script::StructuredClone& guiMetadataClone)
 {
+	WaitForPendingSave();
+
 	// Determine the filename to save under
 	const VfsPath basenameFormat(L"saves/" + prefix + L"-%04d");
 	const VfsPath filenameFormat = basenameFormat.ChangeExtension(L".0adsave");
@@ -78,6 +127,8 @@ Status SavedGames::SavePrefix(const CStrW& prefix, const CStrW& description, CSi
 
 Status SavedGames::Save(const CStrW& name, const CStrW& description, CSimulation2& simulation, const Script::StructuredClone& guiMetadataClone)
 {
+	WaitForPendingSave();
+
 	ScriptRequest rq(simulation.GetScriptInterface());
 
 	// Determine the filename to save under
@@ -99,8 +150,8 @@ Status SavedGames::Save(const CStrW& name, const CStrW& description, CSimulation
 
 	// Construct the serialized state to be saved
 
-	std::stringstream simStateStream;
-	if (!simulation.SerializeState(simStateStream))
+	std::string simState;
+	if (!simulation.SerializeState(simState))
 		WARN_RETURN(ERR::FAIL);
 
 	JS::RootedValue initAttributes(rq.cx, simulation.GetInitAttributes());
@@ -145,26 +196,12 @@ Status SavedGames::Save(const CStrW& name, const CStrW& description, CSimulation
 
 	std::string metadataString = Script::StringifyJSON(rq, &metadata, true);
 
-	// Write the saved game as zip file containing the various components
-	PIArchiveWriter archiveWriter = CreateArchiveWriter_Zip(tempSaveFileRealPath, false);
-	if (!archiveWriter)
-		WARN_RETURN(ERR::FAIL);
-
-	WARN_RETURN_STATUS_IF_ERR(archiveWriter->AddMemory((const u8*)metadataString.c_str(), metadataString.length(), now, "metadata.json"));
-	WARN_RETURN_STATUS_IF_ERR(archiveWriter->AddMemory((const u8*)simStateStream.str().c_str(), simStateStream.str().length(), now, "simulation.dat"));
-	archiveWriter.reset(); // close the file
-
-	WriteBuffer buffer;
-	CFileInfo tempSaveFile;
-	WARN_RETURN_STATUS_IF_ERR(GetFileInfo(tempSaveFileRealPath, &tempSaveFile));
-	buffer.Reserve(tempSaveFile.Size());
-	WARN_RETURN_STATUS_IF_ERR(io::Load(tempSaveFileRealPath, buffer.Data().get(), buffer.Size()));
-	WARN_RETURN_STATUS_IF_ERR(g_VFS->CreateFile(filename, buffer.Data(), buffer.Size()));
-
-	OsPath realPath;
-	WARN_RETURN_STATUS_IF_ERR(g_VFS->GetRealPath(filename, realPath));
-	LOGMESSAGERENDER("Saved game to '%s'", realPath.string8());
-	debug_printf("Saved game to '%s'\n", realPath.string8().c_str());
+	g_PendingSave = Future{g_TaskManager,
+		[tempSaveFileRealPath, filename, now, metadataString = std::move(metadataString), simState = std::move(simState)]
+		{
+			if (WriteSavedGame(tempSaveFileRealPath, filename, now, metadataString, simState) < 0)
+				LOGERROR("Failed to write saved game '%s'", filename.string8());
+		}, Threading::TaskPriority::LOW};
 
 	return INFO::OK;
 }
@@ -235,6 +272,8 @@ std::optional<SavedGames::LoadResult> SavedGames::Load(const ScriptInterface& sc
 	const VfsPath basename(L"saves/" + name);
 	const VfsPath filename = basename.ChangeExtension(L".0adsave");
 
+	WaitForPendingSave();
+
 	// Don't crash just because file isn't found, this can happen if the file is deleted from the OS
 	if (!VfsFileExists(filename))
 		return std::nullopt;
@@ -279,6 +318,8 @@ JS::Value SavedGames::GetSavedGames(const ScriptInterface& scriptInterface)
 	PROFILE2("GetSavedGames");
 	ScriptRequest rq(scriptInterface);
 
+	WaitForPendingSave();
+
 	JS::RootedValueVector games{rq.cx};
 
 	Status err;
@@ -334,6 +375,8 @@ bool SavedGames::DeleteSavedGame(const std::wstring& name)
 	const VfsPath filename = basename.ChangeExtension(L".0adsave");
 	OsPath realpath;
 
+	WaitForPendingSave();
+
 	// Make sure it exists in VFS and find its path
 	if (!VfsFileExists(filename) || g_VFS->GetOriginalPath(filename, realpath) != INFO::OK)
 		return false; // Error
@@ -1,4 +1,4 @@
-/* Copyright (C) 2025 Wildfire Games.
+/* Copyright (C) 2026 Wildfire Games.
  * This file is part of 0 A.D.
  *
  * 0 A.D. is free software: you can redistribute it and/or modify
@@ -50,7 +50,8 @@ namespace SavedGames
 	 * @param description A user-given description of the save
 	 * @param simulation
 	 * @param guiMetadataClone if not NULL, store some UI-related data with the saved game
-	 * @return INFO::OK if successfully saved, else an error Status
+	 * @return INFO::OK if the state was successfully serialized, else an error Status.
+	 * The archive is compressed and written by a worker, errors there are logged.
 	 */
 	Status Save(const CStrW& name, const CStrW& description, CSimulation2& simulation, const Script::StructuredClone& guiMetadataClone);
 
@@ -61,10 +62,16 @@ namespace SavedGames
 	 * @param description A user-given description of the save
 	 * @param simulation
 	 * @param guiMetadataClone if not NULL, store some UI-related data with the saved game
-	 * @return INFO::OK if successfully saved, else an error Status
+	 * @return INFO::OK if the state was successfully serialized, else an error Status.
+	 * The archive is compressed and written by a worker, errors there are logged.
 	 */
 	Status SavePrefix(const CStrW& prefix, const CStrW& description, CSimulation2& simulation, const Script::StructuredClone& guiMetadataClone);
 
+	/**
+	 * Block until the saved game being written in the background (if any) is on disk.
+	 */
+	void WaitForPendingSave();
+
 	struct LoadResult
 	{
 		// Object containing metadata associated with saved game,
@@ -0,0 +1,91 @@
+/* Copyright (C) 2026 Wildfire Games.
+ * This file is part of 0 A.D.
+ *
+ * 0 A.D. is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * 0 A.D. is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with 0 A.D.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "lib/self_test.h"
+
+#include "ps/Compress.h"
+
+#include <istream>
+#include <ostream>
+#include <random>
+#include <string>
+
+class TestCompress : public CxxTest::TestSuite
+{
+	static std::string MakeData(size_t size)
+	{
+		// Somewhat compressible data, large enough to span several internal buffers
+		std::mt19937 rng;
+		std::string data(size, '\0');
+		for (char& c : data)
+			c = static_cast<char>('a' + rng() % 8);
+		return data;
+	}
+
+public:
+	void test_stream_compress()
+	{
+		const std::string data = MakeData(200000);
+
+		std::string compressed;
+		{
+			CZLibCompressStreamBuf compressor(compressed, 1);
+			std::ostream stream(&compressor);
+			// Mix single characters, small writes and large writes
+			stream.put(data[0]);
+			stream.write(data.data() + 1, 99);
+			stream.write(data.data() + 100, 100000);
+			for (size_t i = 100100; i < data.size(); i += 10)
+				stream.write(data.data() + i, 10);
+			compressor.Finish();
+		}
+		TS_ASSERT_LESS_THAN(compressed.size(), data.size());
+
+		std::string decompressed;
+		DecompressZLib(compressed, decompressed, true);
+		TS_ASSERT(decompressed == data);
+	}
+
+	void test_stream_decompress()
+	{
+		const std::string data = MakeData(200000);
+
+		std::string compressed;
+		CompressZLib(data, compressed, true);
+
+		CZLibDecompressStreamBuf decompressor(compressed);
+		std::istream stream(&decompressor);
+		std::string decompressed(data.size(), '\0');
+		stream.read(decompressed.data(), 1);
+		stream.read(decompressed.data() + 1, decompressed.size() - 1);
+		TS_ASSERT(stream.good());
+		TS_ASSERT(decompressed == data);
+		TS_ASSERT_EQUALS(stream.get(), std::istream::traits_type::eof());
+	}
+
+	void test_stream_empty()
+	{
+		std::string compressed;
+		{
+			CZLibCompressStreamBuf compressor(compressed);
+			compressor.Finish();
+		}
+
+		CZLibDecompressStreamBuf decompressor(compressed);
+		std::istream stream(&decompressor);
+		TS_ASSERT_EQUALS(stream.get(), std::istream::traits_type::eof());
+	}
+};
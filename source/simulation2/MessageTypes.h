@@ -1,4 +1,4 @@
-/* Copyright (C) 2025 Wildfire Games.
+/* Copyright (C) 2026 Wildfire Games.
  * This file is part of 0 A.D.
  *
  * 0 A.D. is free software: you can redistribute it and/or modify
@@ -287,6 +287,30 @@ public:
 	entity_angle_t a;
 };
 
+/**
+ * Broadcast by the component manager with the data of PositionChanged messages,
+ * for components which update their own structures for many entities at once.
+ *
+ * While a CComponentManager::ScopedPositionChangeBatch is alive, the changes are
+ * collected and sent together before any other message is sent. Otherwise each
+ * change is sent right after the entity's components handled the PositionChanged
+ * message, before the components which subscribed to it globally.
+ */
+class CMessagePositionsChanged final : public CMessage
+{
+public:
+	DEFAULT_MESSAGE_IMPL(PositionsChanged)
+
+	using Change = CComponentManager::PositionChange;
+
+	CMessagePositionsChanged(const std::vector<Change>& changes) :
+		changes(changes)
+	{
+	}
+
+	const std::vector<Change>& changes; // in the order the PositionChanged messages were sent
+};
+
 /**
  * Sent by CCmpPosition whenever anything has changed that will affect the
  * return value of GetInterpolatedTransform()
@@ -37,10 +37,12 @@
 #include "ps/ConfigDB.h"
 #include "ps/Errors.h"
 #include "ps/Filesystem.h"
+#include "ps/Future.h"
 #include "ps/Loader.h"
 #include "ps/Profile.h"
 #include "ps/Profiler2.h"
 #include "ps/Pyrogenesis.h"
+#include "ps/TaskManager.h"
 #include "ps/Util.h"
 #include "scriptinterface/FunctionWrapper.h"
 #include "scriptinterface/JSON.h"
@@ -68,9 +70,16 @@
 #include <js/Value.h>
 #include <memory>
 #include <optional>
+#include <queue>
 #include <set>
+#include <span>
 #include <sstream>
 
+/**
+ * Maximum number of turns of OOS logs which may wait to be written to disk.
+ */
+constexpr size_t MAX_PENDING_OOS_LOG_WRITES = 4;
+
 class CSimulation2Impl
 {
 public:
@@ -115,6 +124,9 @@ public:
 	~CSimulation2Impl()
 	{
 		UnregisterFileReloadFunc(ReloadChangedFileCB, this);
+
+		for (; !m_OOSLogWrites.empty(); m_OOSLogWrites.pop())
+			m_OOSLogWrites.front().Get();
 	}
 
 	void ResetState(bool skipScriptedComponents, bool skipAI)
@@ -159,8 +171,12 @@ public:
 
 	uint32_t m_TurnNumber;
 
+	StateHashType m_StateHashType{DEFAULT_STATE_HASH_TYPE};
+
 	bool m_EnableOOSLog{false};
 	OsPath m_OOSLogPath;
+	// The OOS log files are written by workers, oldest first.
+	std::queue<Future<void>> m_OOSLogWrites;
 
 	// Functions and data for the serialization test mode: (see Update() for relevant comments)
 
@@ -176,11 +192,15 @@ public:
 
 	struct SerializationTestState
 	{
-		std::stringstream state;
+		std::string state;
 		std::stringstream debug;
 		std::string hash;
 	};
 
+	// Only the secondary simulation's updates modify it, so in rejoin test mode its state
+	// after a turn is also its state before the next one.
+	std::optional<SerializationTestState> m_SecondaryStateAfter;
+
 	void DumpSerializationTestState(SerializationTestState& state, const OsPath& path, const OsPath::String& suffix);
 
 	void ReportSerializationFailure(
@@ -189,6 +209,7 @@ public:
 
 	void InitRNGSeedSimulation();
 	void InitRNGSeedAI();
+	void InitAICommandDelay();
 
 	static std::vector<SimulationCommand> CloneCommandsFromOtherCompartment(const ScriptInterface& newScript, const ScriptInterface& oldScript,
 		const std::vector<SimulationCommand>& commands)
@@ -301,10 +322,10 @@ void CSimulation2Impl::DumpSerializationTestState(SerializationTestState& state,
 		file << state.debug.str();
 	}
 
-	if (!state.state.str().empty())
+	if (!state.state.empty())
 	{
 		std::ofstream file (OsString(path / (L"state." + suffix)), std::ofstream::out | std::ofstream::trunc | std::ofstream::binary);
-		file << state.state.str();
+		file << state.state;
 	}
 }
 
@@ -365,6 +386,19 @@ void CSimulation2Impl::InitRNGSeedAI()
 		cmpAIManager->SetRNGSeed(seed);
 }
 
+void CSimulation2Impl::InitAICommandDelay()
+{
+	// Optional, a non-zero delay runs the AI players on their own threads.
+	u32 delay = 0;
+	ScriptRequest rq(m_ComponentManager.GetScriptInterface());
+	if (Script::HasProperty(rq, m_MapSettings, "AICommandDelay"))
+		Script::GetProperty(rq, m_MapSettings, "AICommandDelay", delay);
+
+	CmpPtr<ICmpAIManager> cmpAIManager(m_SimContext, SYSTEM_ENTITY);
+	if (cmpAIManager)
+		cmpAIManager->SetCommandDelay(delay);
+}
+
 void CSimulation2Impl::Update(int turnLength, const std::vector<SimulationCommand>& commands)
 {
 	PROFILE3("sim update");
@@ -413,6 +447,7 @@ void CSimulation2Impl::Update(int turnLength, const std::vector<SimulationComman
 		if (startRejoinTest)
 			debug_printf("Initializing the secondary simulation\n");
 
+		m_SecondaryStateAfter.reset();
 		m_SecondaryTerrain = std::make_unique<CTerrain>();
 
 		m_SecondaryContext = std::make_unique<CSimContext>(m_SecondaryTerrain.get());
@@ -466,19 +501,28 @@ void CSimulation2Impl::Update(int turnLength, const std::vector<SimulationComman
 
 		PS::Loader::EndRegistering();
 		ENSURE(PS::Loader::NonprogressiveLoad() == INFO::OK);
-		ENSURE(m_SecondaryComponentManager->DeserializeState(primaryStateBefore.state));
+		ENSURE(m_SecondaryComponentManager->DeserializeState(std::as_bytes(std::span{primaryStateBefore.state})));
 	}
 
 	if (m_EnableSerializationTest || m_TestingRejoin)
 	{
 		SerializationTestState secondaryStateBefore;
-		ENSURE(m_SecondaryComponentManager->SerializeState(secondaryStateBefore.state));
+		if (m_SecondaryStateAfter)
+		{
+			secondaryStateBefore.state = std::move(m_SecondaryStateAfter->state);
+			secondaryStateBefore.hash = std::move(m_SecondaryStateAfter->hash);
+			m_SecondaryStateAfter.reset();
+		}
+		else
+		{
+			ENSURE(m_SecondaryComponentManager->SerializeState(secondaryStateBefore.state));
+			if (serializationTestHash)
+				ENSURE(m_SecondaryComponentManager->ComputeStateHash(secondaryStateBefore.hash, false));
+		}
 		if (serializationTestDebugDump)
 			ENSURE(m_SecondaryComponentManager->DumpDebugState(secondaryStateBefore.debug, false));
-		if (serializationTestHash)
-			ENSURE(m_SecondaryComponentManager->ComputeStateHash(secondaryStateBefore.hash, false));
 
-		if (primaryStateBefore.state.str() != secondaryStateBefore.state.str() ||
+		if (primaryStateBefore.state != secondaryStateBefore.state ||
 			primaryStateBefore.hash != secondaryStateBefore.hash)
 		{
 			ReportSerializationFailure(&primaryStateBefore, NULL, &secondaryStateBefore, NULL);
@@ -496,7 +540,7 @@ void CSimulation2Impl::Update(int turnLength, const std::vector<SimulationComman
 		if (serializationTestHash)
 			ENSURE(m_SecondaryComponentManager->ComputeStateHash(secondaryStateAfter.hash, false));
 
-		if (primaryStateAfter.state.str() != secondaryStateAfter.state.str() ||
+		if (primaryStateAfter.state != secondaryStateAfter.state ||
 			primaryStateAfter.hash != secondaryStateAfter.hash)
 		{
 			// Only do the (slow) dumping now we know we're going to need to report it
@@ -505,6 +549,9 @@ void CSimulation2Impl::Update(int turnLength, const std::vector<SimulationComman
 
 			ReportSerializationFailure(&primaryStateBefore, &primaryStateAfter, &secondaryStateBefore, &secondaryStateAfter);
 		}
+
+		if (m_TestingRejoin)
+			m_SecondaryStateAfter = std::move(secondaryStateAfter);
 	}
 
 	// (TODO: we ought to schedule this for a frame where we're not
@@ -526,7 +573,10 @@ void CSimulation2Impl::UpdateComponents(CSimContext& simContext, fixed turnLengt
 
 	CmpPtr<ICmpPathfinder> cmpPathfinder(simContext, SYSTEM_ENTITY);
 	if (cmpPathfinder)
+	{
+		CComponentManager::ScopedComponentTiming timing(componentManager, CID_Pathfinder);
 		cmpPathfinder->SendRequestedPaths();
+	}
 
 	{
 		PROFILE2("Sim - Update Start");
@@ -542,6 +592,7 @@ void CSimulation2Impl::UpdateComponents(CSimContext& simContext, fixed turnLengt
 	// Process newly generated move commands so the UI feels snappy
 	if (cmpPathfinder)
 	{
+		CComponentManager::ScopedComponentTiming timing(componentManager, CID_Pathfinder);
 		cmpPathfinder->StartProcessingMoves(true);
 		cmpPathfinder->SendRequestedPaths();
 	}
@@ -560,6 +611,7 @@ void CSimulation2Impl::UpdateComponents(CSimContext& simContext, fixed turnLengt
 	// Process move commands for formations (group proxy)
 	if (cmpPathfinder)
 	{
+		CComponentManager::ScopedComponentTiming timing(componentManager, CID_Pathfinder);
 		cmpPathfinder->StartProcessingMoves(true);
 		cmpPathfinder->SendRequestedPaths();
 	}
@@ -582,6 +634,7 @@ void CSimulation2Impl::UpdateComponents(CSimContext& simContext, fixed turnLengt
 	CmpPtr<ICmpAIManager> cmpAIManager(simContext, SYSTEM_ENTITY);
 	if (cmpAIManager)
 	{
+		CComponentManager::ScopedComponentTiming timing(componentManager, CID_AIManager);
 		cmpAIManager->StartComputation();
 		cmpAIManager->PushCommands();
 	}
@@ -589,6 +642,7 @@ void CSimulation2Impl::UpdateComponents(CSimContext& simContext, fixed turnLengt
 	// Process all remaining moves
 	if (cmpPathfinder)
 	{
+		CComponentManager::ScopedComponentTiming timing(componentManager, CID_Pathfinder);
 		cmpPathfinder->UpdateGrid();
 		cmpPathfinder->StartProcessingMoves(false);
 	}
@@ -616,7 +670,6 @@ void CSimulation2Impl::DumpState()
 	std::stringstream name;\
 	name << std::setw(5) << std::setfill('0') << m_TurnNumber << ".txt";
 	const OsPath path = m_OOSLogPath / name.str();
-	std::ofstream file (OsString(path), std::ofstream::out | std::ofstream::trunc);
 
 	if (!DirectoryExists(m_OOSLogPath))
 	{
@@ -624,19 +677,38 @@ void CSimulation2Impl::DumpState()
 		CreateDirectories(m_OOSLogPath, 0700);
 	}
 
-	file << "State hash: " << std::hex;
+	std::stringstream text;
+	text << "State hash: " << std::hex;
 	std::string hashRaw;
-	m_ComponentManager.ComputeStateHash(hashRaw, false);
+	m_ComponentManager.ComputeStateHash(hashRaw, false, m_StateHashType);
 	for (size_t i = 0; i < hashRaw.size(); ++i)
-		file << std::setfill('0') << std::setw(2) << (int)(unsigned char)hashRaw[i];
-	file << std::dec << "\n";
+		text << std::setfill('0') << std::setw(2) << (int)(unsigned char)hashRaw[i];
+	text << std::dec << "\n";
+	m_ComponentManager.DumpStateHashTree(text);
+
+	text << "\n";
+
+	m_ComponentManager.DumpDebugState(text, true);
 
-	file << "\n";
+	std::string state;
+	m_ComponentManager.SerializeState(state);
+
+	// Writing the files is slow, so leave it to a worker. Don't let a slow disk pile up
+	// more than a few turns of logs in memory though.
+	while (!m_OOSLogWrites.empty() && (m_OOSLogWrites.front().IsDone() || m_OOSLogWrites.size() >= MAX_PENDING_OOS_LOG_WRITES))
+	{
+		m_OOSLogWrites.front().Get();
+		m_OOSLogWrites.pop();
+	}
 
-	m_ComponentManager.DumpDebugState(file, true);
+	m_OOSLogWrites.push(Future{g_TaskManager, [path, text = std::move(text).str(), state = std::move(state)]
+	{
+		std::ofstream file (OsString(path), std::ofstream::out | std::ofstream::trunc);
+		file << text;
 
-	std::ofstream binfile (OsString(path.ChangeExtension(L".dat")), std::ofstream::out | std::ofstream::trunc | std::ofstream::binary);
-	m_ComponentManager.SerializeState(binfile);
+		std::ofstream binfile (OsString(path.ChangeExtension(L".dat")), std::ofstream::out | std::ofstream::trunc | std::ofstream::binary);
+		binfile << state;
+	}, Threading::TaskPriority::LOW});
 }
 
 ////////////////////////////////////////////////////////////////
@@ -795,6 +867,7 @@ void CSimulation2::SetMapSettings(JS::HandleValue settings)
 
 	m->InitRNGSeedSimulation();
 	m->InitRNGSeedAI();
+	m->InitAICommandDelay();
 }
 
 std::string CSimulation2::GetMapSettingsString()
@@ -848,9 +921,19 @@ void CSimulation2::ResetState(bool skipScriptedComponents, bool skipAI)
 	m->ResetState(skipScriptedComponents, skipAI);
 }
 
+void CSimulation2::SetStateHashType(StateHashType type)
+{
+	m->m_StateHashType = type;
+}
+
 bool CSimulation2::ComputeStateHash(std::string& outHash, bool quick)
 {
-	return m->m_ComponentManager.ComputeStateHash(outHash, quick);
+	return m->m_ComponentManager.ComputeStateHash(outHash, quick, m->m_StateHashType);
+}
+
+void CSimulation2::DumpStateHashTree(std::ostream& stream)
+{
+	m->m_ComponentManager.DumpStateHashTree(stream);
 }
 
 bool CSimulation2::DumpDebugState(std::ostream& stream)
@@ -864,12 +947,22 @@ bool CSimulation2::SerializeState(std::ostream& stream)
 	return m->m_ComponentManager.SerializeState(stream);
 }
 
+bool CSimulation2::SerializeState(std::string& state)
+{
+	return m->m_ComponentManager.SerializeState(state);
+}
+
 bool CSimulation2::DeserializeState(std::istream& stream)
 {
 	// TODO: need to make sure the required SYSTEM_ENTITY components get constructed
 	return m->m_ComponentManager.DeserializeState(stream);
 }
 
+bool CSimulation2::DeserializeState(std::span<const std::byte> buffer)
+{
+	return m->m_ComponentManager.DeserializeState(buffer);
+}
+
 void CSimulation2::ActivateRejoinTest(int turn)
 {
 	if (m->m_RejoinTestTurn.has_value())
@@ -22,6 +22,7 @@
 #include "lib/file/vfs/vfs_path.h"
 #include "lib/status.h"
 #include "ps/Loader.h"
+#include "simulation2/serialization/StateHashType.h"
 #include "simulation2/system/DebugOptions.h"
 #include "simulation2/system/Entity.h"
 
@@ -232,10 +233,28 @@ public:
 	const CSimContext& GetSimContext() const;
 	ScriptInterface& GetScriptInterface() const;
 
+	/**
+	 * Set the hash function used by ComputeStateHash, e.g. to check a replay recorded with another one.
+	 */
+	void SetStateHashType(StateHashType type);
 	bool ComputeStateHash(std::string& outHash, bool quick);
+
+	/**
+	 * Write the hash of each component type from the last ComputeStateHash, to help finding
+	 * the components which went out of sync.
+	 */
+	void DumpStateHashTree(std::ostream& stream);
 	bool DumpDebugState(std::ostream& stream);
 	bool SerializeState(std::ostream& stream);
+	/**
+	 * Serialize into @p state, replacing its contents but reusing its allocation.
+	 */
+	bool SerializeState(std::string& state);
 	bool DeserializeState(std::istream& stream);
+	/**
+	 * Deserialize directly from @p buffer without copying it into a stream.
+	 */
+	bool DeserializeState(std::span<const std::byte> buffer);
 
 	/**
 	 * Activate the rejoin-test feature for turn @param turn.
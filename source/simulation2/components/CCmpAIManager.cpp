@@ -37,6 +37,7 @@
 #include "ps/Profile.h"
 #include "ps/Profiler2.h"
 #include "ps/TemplateLoader.h"
+#include "ps/Threading.h"
 #include "ps/Util.h"
 #include "ps/scripting/JSInterface_VFS.h"
 #include "scriptinterface/FunctionWrapper.h"
@@ -68,7 +69,11 @@
 #include "simulation2/system/Component.h"
 
 #include <boost/random/linear_congruential.hpp>
+#include <condition_variable>
 #include <cstring>
+#include <deque>
+#include <exception>
+#include <functional>
 #include <js/Array.h>
 #include <js/GCAPI.h>
 #include <js/GCVector.h>
@@ -80,9 +85,11 @@
 #include <js/experimental/TypedData.h>
 #include <map>
 #include <memory>
+#include <mutex>
 #include <set>
 #include <sstream>
 #include <string>
+#include <thread>
 #include <tuple>
 #include <utility>
 #include <vector>
@@ -102,9 +109,10 @@ extern void QuitEngine(int exitStatus);
  * The AI can therefore directly use the simulation data via the 'Sim' & 'SimEngine' globals.
  * As a result, a lof of the code is still designed to be "thread-ready", but this no longer matters.
  *
- * TODO: despite the above, it would still be useful to allow the AI to run tasks asynchronously (and off-thread).
- * This could be implemented by having a separate JS runtime in a different thread,
- * that runs tasks and returns after a distinct # of simulation turns (to maintain determinism).
+ * Optionally (see ICmpAIManager::SetCommandDelay), every AI player can instead run on its own
+ * thread, in a separate JS runtime, which gets a copy of the game state each turn.
+ * The commands are then returned after a fixed number of simulation turns (to maintain determinism),
+ * and the 'Sim' & 'SimEngine' globals aren't available.
  *
  * Note also that the RL Interface, by default, uses the 'AI representation'.
  * This representation, alimented by the JS AIInterface/AIProxy tandem, is likely to grow smaller over time
@@ -157,7 +165,7 @@ private:
 			auto result = m_ScriptInterface->GetModuleLoader().LoadModule(rq,
 				"simulation/ai/" + utf8_from_wstring(m_AIName) + "/" + filename);
 
-			g_ScriptContext->RunJobs();
+			m_ScriptInterface->GetContext().RunJobs();
 			JS::RootedValue objectWithConstructor(rq.cx, JS::ObjectValue(*result.begin()->Get()));
 
 			if (!Script::GetProperty(rq, metadata, "constructor", constructor))
@@ -264,53 +272,17 @@ public:
 	{
 		// Create the script interface in the same compartment as the simulation interface.
 		// This will allow us to directly share data from the sim to the AI (and vice versa, should the need arise).
-		m_ScriptInterface = std::make_shared<ScriptInterface>("Engine", "AI", simInterface,
-			[](const VfsPath& path)
-			{
-				return path.string().find(L"simulation/ai/") == 0;
-			});
-
-		ScriptRequest rq(m_ScriptInterface);
-
-		m_EntityTemplates.init(rq.cx);
-		m_SharedAIObj.init(rq.cx);
-		m_PassabilityMapVal.init(rq.cx);
-		m_TerritoryMapVal.init(rq.cx);
-
-
-		m_ScriptInterface->ReplaceNondeterministicRNG(m_RNG);
-
-		m_ScriptInterface->SetCallbackData(static_cast<void*> (this));
-
-		JS_AddExtraGCRootsTracer(m_ScriptInterface->GetGeneralJSContext(), Trace, this);
-
-		{
-			ScriptRequest simrq(simInterface);
-			// Register the sim globals for easy & explicit access. Mark it replaceable for hotloading.
-			JS::RootedValue global(rq.cx, simrq.globalValue());
-			m_ScriptInterface->SetGlobal("Sim", global, true);
-			JS::RootedValue scope(rq.cx, JS::ObjectValue(*simrq.nativeScope.get()));
-			m_ScriptInterface->SetGlobal("SimEngine", scope, true);
-		}
-
-#define REGISTER_FUNC_NAME(func, name) \
-	ScriptFunction::Register<&CAIWorker::func, ScriptInterface::ObjectFromCBData<CAIWorker>>(rq, name);
-
-		REGISTER_FUNC_NAME(PostCommand, "PostCommand");
-		ScriptFunction::Register<QuitEngine>(rq, "Exit");
-
-		REGISTER_FUNC_NAME(ComputePathScript, "ComputePath");
-
-		REGISTER_FUNC_NAME(DumpImage, "DumpImage");
-		REGISTER_FUNC_NAME(GetTemplate, "GetTemplate");
-
-#undef REGISTER_FUNC_NAME
-
-		JSI_VFS::RegisterScriptFunctions_ReadOnlySimulation(rq);
-
-		// Globalscripts may use VFS script functions
-		m_ScriptInterface->LoadGlobalScripts();
+		m_ScriptInterface = std::make_shared<ScriptInterface>("Engine", "AI", simInterface, AllowModule);
+		InitScriptInterface(&simInterface);
+	}
 
+	/**
+	 * Set up the worker in its own context, to be used from a single thread other than the simulation's.
+	 */
+	void Init(ScriptContext& context)
+	{
+		m_ScriptInterface = std::make_shared<ScriptInterface>("Engine", "AI", context, AllowModule);
+		InitScriptInterface(nullptr);
 	}
 
 	bool HasLoadedEntityTemplates() const { return m_HasLoadedEntityTemplates; }
@@ -418,7 +390,7 @@ public:
 		auto result = m_ScriptInterface->GetModuleLoader().LoadModule(rq,
 			"simulation/ai/common-api/shared.js");
 
-		g_ScriptContext->RunJobs();
+		m_ScriptInterface->GetContext().RunJobs();
 
 		// mainly here for the error messages
 		OsPath path = L"simulation/ai/common-api/";
@@ -526,6 +498,14 @@ public:
 		m_GameState.init(ScriptRequest(m_ScriptInterface).cx, gameState);
 	}
 
+	void UpdateGameState(const Script::StructuredClone& gameState)
+	{
+		ScriptRequest rq(m_ScriptInterface);
+		JS::RootedValue state(rq.cx);
+		Script::ReadStructuredClone(rq, gameState, &state);
+		UpdateGameState(state);
+	}
+
 	void UpdatePathfinder(const Grid<NavcellData>& passabilityMap, bool globallyDirty, const Grid<u8>& dirtinessGrid, bool justDeserialized,
 		const std::map<std::string, pass_class_t>& nonPathfindingPassClassMasks, const std::map<std::string, pass_class_t>& pathfindingPassClassMasks)
 	{
@@ -540,7 +520,7 @@ public:
 		}
 		else
 		{
-			m_LongPathfinder.Update(&m_PassabilityMap);
+			m_LongPathfinder.Update(&m_PassabilityMap, dirtinessGrid);
 			m_HierarchicalPathfinder.Update(&m_PassabilityMap, dirtinessGrid);
 		}
 
@@ -768,7 +748,64 @@ public:
 		return m_Players.size();
 	}
 
+	player_id_t getPlayerID(size_t i) const
+	{
+		return m_Players[i]->m_Player;
+	}
+
 private:
+	static bool AllowModule(const VfsPath& path)
+	{
+		return path.string().find(L"simulation/ai/") == 0;
+	}
+
+	/**
+	 * @param simInterface If not null, the simulation globals are made available to the AI scripts.
+	 */
+	void InitScriptInterface(const ScriptInterface* simInterface)
+	{
+		ScriptRequest rq(m_ScriptInterface);
+
+		m_EntityTemplates.init(rq.cx);
+		m_SharedAIObj.init(rq.cx);
+		m_PassabilityMapVal.init(rq.cx);
+		m_TerritoryMapVal.init(rq.cx);
+
+		m_ScriptInterface->ReplaceNondeterministicRNG(m_RNG);
+
+		m_ScriptInterface->SetCallbackData(static_cast<void*> (this));
+
+		JS_AddExtraGCRootsTracer(m_ScriptInterface->GetGeneralJSContext(), Trace, this);
+
+		if (simInterface)
+		{
+			ScriptRequest simrq(*simInterface);
+			// Register the sim globals for easy & explicit access. Mark it replaceable for hotloading.
+			JS::RootedValue global(rq.cx, simrq.globalValue());
+			m_ScriptInterface->SetGlobal("Sim", global, true);
+			JS::RootedValue scope(rq.cx, JS::ObjectValue(*simrq.nativeScope.get()));
+			m_ScriptInterface->SetGlobal("SimEngine", scope, true);
+		}
+
+#define REGISTER_FUNC_NAME(func, name) \
+	ScriptFunction::Register<&CAIWorker::func, ScriptInterface::ObjectFromCBData<CAIWorker>>(rq, name);
+
+		REGISTER_FUNC_NAME(PostCommand, "PostCommand");
+		ScriptFunction::Register<QuitEngine>(rq, "Exit");
+
+		REGISTER_FUNC_NAME(ComputePathScript, "ComputePath");
+
+		REGISTER_FUNC_NAME(DumpImage, "DumpImage");
+		REGISTER_FUNC_NAME(GetTemplate, "GetTemplate");
+
+#undef REGISTER_FUNC_NAME
+
+		JSI_VFS::RegisterScriptFunctions_ReadOnlySimulation(rq);
+
+		// Globalscripts may use VFS script functions
+		m_ScriptInterface->LoadGlobalScripts();
+	}
+
 	static void Trace(JSTracer *trc, void *data)
 	{
 		reinterpret_cast<CAIWorker*>(data)->TraceMember(trc);
@@ -860,6 +897,141 @@ private:
 	CTemplateLoader m_TemplateLoader;
 };
 
+/**
+ * Runs a CAIWorker in its own script context on a dedicated thread, so that AI players
+ * compute in parallel with the simulation and with each other.
+ * The worker is only ever used from that thread: tasks are queued and run in order.
+ */
+class CAIWorkerThread
+{
+	NONCOPYABLE(CAIWorkerThread);
+public:
+	using Task = std::function<void(CAIWorker&)>;
+
+	CAIWorkerThread()
+	{
+		m_Thread = std::thread(Threading::HandleExceptions<RunThread>::Wrapper, this);
+	}
+
+	~CAIWorkerThread()
+	{
+		{
+			std::lock_guard<std::mutex> lock(m_Mutex);
+			m_Shutdown = true;
+		}
+		m_ConditionVariable.notify_all();
+		m_Thread.join();
+	}
+
+	/**
+	 * Queue a task, and return a ticket which can be passed to Wait().
+	 */
+	u64 Post(Task task)
+	{
+		std::lock_guard<std::mutex> lock(m_Mutex);
+		m_Tasks.push_back(std::move(task));
+		m_ConditionVariable.notify_all();
+		return ++m_Posted;
+	}
+
+	/**
+	 * Wait until the task with the given ticket, and thus all the tasks queued before it, has run.
+	 * An exception thrown by one of these tasks is rethrown here.
+	 */
+	void Wait(u64 ticket)
+	{
+		std::unique_lock<std::mutex> lock(m_Mutex);
+		m_ConditionVariable.wait(lock, [&]() { return m_Finished >= ticket; });
+		if (m_Exception && m_ExceptionTicket <= ticket)
+			std::rethrow_exception(std::exchange(m_Exception, nullptr));
+	}
+
+	/**
+	 * Run a task on the worker thread and wait for it. Exceptions thrown by the task are rethrown here.
+	 */
+	void Run(const Task& task)
+	{
+		std::exception_ptr exception;
+		Wait(Post([&task, &exception](CAIWorker& worker)
+		{
+			try
+			{
+				task(worker);
+			}
+			catch (...)
+			{
+				exception = std::current_exception();
+			}
+		}));
+		if (exception)
+			std::rethrow_exception(exception);
+	}
+
+private:
+	static void RunThread(CAIWorkerThread* data)
+	{
+		debug_SetThreadName("AI worker");
+		// The script context uses the profiler and therefore the thread must be registered before the context is created
+		g_Profiler2.RegisterCurrentThread("AI worker");
+
+		ScriptContext context(AI_CONTEXT_SIZE, AI_HEAP_GROWTH_BYTES_GCTRIGGER);
+		CAIWorker worker;
+		worker.Init(context);
+		data->Loop(context, worker);
+	}
+
+	void Loop(ScriptContext& context, CAIWorker& worker)
+	{
+		std::unique_lock<std::mutex> lock(m_Mutex);
+		while (true)
+		{
+			m_ConditionVariable.wait(lock, [this]() { return m_Shutdown || !m_Tasks.empty(); });
+			// Tasks which are still queued are dropped, nobody waits for them anymore.
+			if (m_Shutdown)
+				return;
+
+			Task task = std::move(m_Tasks.front());
+			m_Tasks.pop_front();
+			lock.unlock();
+
+			std::exception_ptr exception;
+			try
+			{
+				task(worker);
+			}
+			catch (...)
+			{
+				exception = std::current_exception();
+			}
+			context.MaybeIncrementalGC();
+
+			lock.lock();
+			++m_Finished;
+			// Only the first exception is kept, until somebody waits for its task.
+			if (exception && !m_Exception)
+			{
+				m_Exception = exception;
+				m_ExceptionTicket = m_Finished;
+			}
+			m_ConditionVariable.notify_all();
+		}
+	}
+
+	static constexpr int AI_CONTEXT_SIZE = 256 * MiB;
+	static constexpr u32 AI_HEAP_GROWTH_BYTES_GCTRIGGER = 12 * MiB;
+
+	std::mutex m_Mutex;
+	std::condition_variable m_ConditionVariable;
+	std::deque<Task> m_Tasks;
+	u64 m_Posted = 0;
+	u64 m_Finished = 0;
+	std::exception_ptr m_Exception;
+	u64 m_ExceptionTicket = 0;
+	bool m_Shutdown = false;
+
+	std::thread m_Thread;
+};
+
 
 /**
  * Implementation of ICmpAIManager.
@@ -885,6 +1057,8 @@ public:
 		m_TerritoriesDirtyID = 0;
 		m_TerritoriesDirtyBlinkingID = 0;
 		m_JustDeserialized = false;
+		m_CommandDelay = 0;
+		m_RNGSeed = 0;
 	}
 
 	void Deinit() override
@@ -893,14 +1067,51 @@ public:
 
 	void Serialize(ISerializer& serialize) override
 	{
-		serialize.NumberU32_Unbounded("num ais", m_Worker.getPlayerSize());
+		serialize.NumberU32_Unbounded("num ais", GetNumPlayers());
+		serialize.NumberU32_Unbounded("command delay", m_CommandDelay);
 
 		// Because the AI worker uses its own ScriptInterface, we can't use the
 		// ISerializer (which was initialised with the simulation ScriptInterface)
 		// directly. So we'll just grab the ISerializer's stream and write to it
 		// with an independent serializer.
 
-		m_Worker.Serialize(serialize.GetStream(), serialize.IsDebug());
+		if (!m_CommandDelay)
+		{
+			m_Worker.Serialize(serialize.GetStream(), serialize.IsDebug());
+			return;
+		}
+
+		// This waits for all the queued computations, so the AI state and the
+		// pending commands only depend on the turns simulated so far.
+		for (const std::unique_ptr<CAIWorkerThread>& thread : m_WorkerThreads)
+		{
+			std::stringstream stream;
+			thread->Run([&stream, &serialize](CAIWorker& worker) { worker.Serialize(stream, serialize.IsDebug()); });
+			const std::string data = stream.str();
+			serialize.GetStream().write(data.data(), data.size());
+		}
+
+		ScriptRequest rq(GetSimContext().GetScriptInterface());
+		serialize.NumberU32_Unbounded("num pending turns", static_cast<u32>(m_PendingCommands.size()));
+		for (const PendingCommands& pending : m_PendingCommands)
+		{
+			serialize.NumberU32_Unbounded("turns left", pending.turnsLeft);
+			for (const std::vector<CAIWorker::SCommandSets>& commandSets : pending.commands)
+			{
+				serialize.NumberU32_Unbounded("num command sets", static_cast<u32>(commandSets.size()));
+				for (const CAIWorker::SCommandSets& commandSet : commandSets)
+				{
+					serialize.NumberI32_Unbounded("player", commandSet.player);
+					serialize.NumberU32_Unbounded("num commands", static_cast<u32>(commandSet.commands.size()));
+					for (const Script::StructuredClone& command : commandSet.commands)
+					{
+						JS::RootedValue val(rq.cx);
+						Script::ReadStructuredClone(rq, command, &val);
+						serialize.ScriptVal("command", &val);
+					}
+				}
+			}
+		}
 	}
 
 	void Deserialize(const CParamNode& paramNode, IDeserializer& deserialize) override
@@ -909,19 +1120,99 @@ public:
 
 		u32 numAis;
 		deserialize.NumberU32_Unbounded("num ais", numAis);
-		if (numAis > 0)
-			LoadUsedEntityTemplates();
+		deserialize.NumberU32_Unbounded("command delay", m_CommandDelay);
 
-		m_Worker.Deserialize(deserialize.GetStream(), numAis);
+		if (!m_CommandDelay)
+		{
+			if (numAis > 0)
+				LoadUsedEntityTemplates();
+
+			m_Worker.Deserialize(deserialize.GetStream(), numAis);
+		}
+		else
+		{
+			const std::vector<std::pair<std::string, const CParamNode*>> templates = GetUsedEntityTemplates();
+			for (u32 i = 0; i < numAis; ++i)
+			{
+				std::unique_ptr<CAIWorkerThread> thread = std::make_unique<CAIWorkerThread>();
+				thread->Run([&templates, &deserialize](CAIWorker& worker)
+				{
+					worker.LoadEntityTemplates(templates);
+					worker.Deserialize(deserialize.GetStream(), 1);
+				});
+				m_WorkerThreads.push_back(std::move(thread));
+			}
+
+			ScriptRequest rq(GetSimContext().GetScriptInterface());
+			u32 numPendingTurns;
+			deserialize.NumberU32_Unbounded("num pending turns", numPendingTurns);
+			for (u32 i = 0; i < numPendingTurns; ++i)
+			{
+				PendingCommands& pending = m_PendingCommands.emplace_back();
+				deserialize.NumberU32_Unbounded("turns left", pending.turnsLeft);
+				pending.tickets.resize(m_WorkerThreads.size(), 0);
+				pending.commands.resize(m_WorkerThreads.size());
+				for (std::vector<CAIWorker::SCommandSets>& commandSets : pending.commands)
+				{
+					u32 numCommandSets;
+					deserialize.NumberU32_Unbounded("num command sets", numCommandSets);
+					commandSets.resize(numCommandSets);
+					for (CAIWorker::SCommandSets& commandSet : commandSets)
+					{
+						deserialize.NumberI32_Unbounded("player", commandSet.player);
+						u32 numCommands;
+						deserialize.NumberU32_Unbounded("num commands", numCommands);
+						commandSet.commands.reserve(numCommands);
+						for (u32 j = 0; j < numCommands; ++j)
+						{
+							JS::RootedValue val(rq.cx);
+							deserialize.ScriptVal("command", &val);
+							commandSet.commands.push_back(Script::WriteStructuredClone(rq, val));
+						}
+					}
+				}
+			}
+		}
 
 		m_JustDeserialized = true;
 	}
 
+	void SetCommandDelay(u32 turns) override
+	{
+		if (turns == m_CommandDelay)
+			return;
+
+		if (GetNumPlayers() > 0)
+		{
+			LOGERROR("AI command delay can't be changed once AI players have been added");
+			return;
+		}
+
+		m_CommandDelay = turns;
+	}
+
 	void AddPlayer(const std::wstring& id, player_id_t player, u8 difficulty, const std::wstring& behavior) override
 	{
-		LoadUsedEntityTemplates();
+		if (m_CommandDelay)
+		{
+			const std::vector<std::pair<std::string, const CParamNode*>> templates = GetUsedEntityTemplates();
+			std::unique_ptr<CAIWorkerThread> thread = std::make_unique<CAIWorkerThread>();
+			bool added = false;
+			thread->Run([&](CAIWorker& worker)
+			{
+				worker.SetRNGSeed(GetPlayerRNGSeed(m_RNGSeed, player));
+				worker.LoadEntityTemplates(templates);
+				added = worker.AddPlayer(id, player, difficulty, behavior);
+			});
+			if (added)
+				m_WorkerThreads.push_back(std::move(thread));
+		}
+		else
+		{
+			LoadUsedEntityTemplates();
 
-		m_Worker.AddPlayer(id, player, difficulty, behavior);
+			m_Worker.AddPlayer(id, player, difficulty, behavior);
+		}
 
 		// AI players can cheat and see through FoW/SoD, since that greatly simplifies
 		// their implementation.
@@ -933,12 +1224,17 @@ public:
 
 	void SetRNGSeed(u32 seed) override
 	{
+		m_RNGSeed = seed;
 		m_Worker.SetRNGSeed(seed);
+		for (const std::unique_ptr<CAIWorkerThread>& thread : m_WorkerThreads)
+			thread->Run([seed](CAIWorker& worker) { worker.SetRNGSeed(GetPlayerRNGSeed(seed, worker.getPlayerID(0))); });
 	}
 
 	void TryLoadSharedComponent() override
 	{
 		m_Worker.TryLoadSharedComponent();
+		for (const std::unique_ptr<CAIWorkerThread>& thread : m_WorkerThreads)
+			thread->Run([](CAIWorker& worker) { worker.TryLoadSharedComponent(); });
 	}
 
 	void RunGamestateInit() override
@@ -974,8 +1270,18 @@ public:
 		if (cmpPathfinder)
 			cmpPathfinder->GetPassabilityClasses(nonPathfindingPassClassMasks, pathfindingPassClassMasks);
 
-		m_Worker.RunGamestateInit(Script::WriteStructuredClone(rq, state),
-			*passabilityMap, *territoryMap, nonPathfindingPassClassMasks, pathfindingPassClassMasks);
+		const Script::StructuredClone gameState = Script::WriteStructuredClone(rq, state);
+		if (!m_CommandDelay)
+		{
+			m_Worker.RunGamestateInit(gameState, *passabilityMap, *territoryMap, nonPathfindingPassClassMasks, pathfindingPassClassMasks);
+			return;
+		}
+
+		for (const std::unique_ptr<CAIWorkerThread>& thread : m_WorkerThreads)
+			thread->Run([&](CAIWorker& worker)
+			{
+				worker.RunGamestateInit(gameState, *passabilityMap, *territoryMap, nonPathfindingPassClassMasks, pathfindingPassClassMasks);
+			});
 	}
 
 	void StartComputation() override
@@ -985,7 +1291,7 @@ public:
 		const ScriptInterface& scriptInterface = GetSimContext().GetScriptInterface();
 		ScriptRequest rq(scriptInterface);
 
-		if (m_Worker.getPlayerSize() == 0)
+		if (GetNumPlayers() == 0)
 			return;
 
 		CmpPtr<ICmpAIInterface> cmpAIInterface(GetSystemEntity());
@@ -999,8 +1305,12 @@ public:
 			cmpAIInterface->GetRepresentation(&state);
 		LoadPathfinderClasses(state); // add the pathfinding classes to it
 
+		// In threaded mode, the updates are copied and queued for every AI thread.
+		std::vector<CAIWorkerThread::Task> updates;
+
 		// Update the game state
-		m_Worker.UpdateGameState(state);
+		if (!m_CommandDelay)
+			m_Worker.UpdateGameState(state);
 
 		// Update the pathfinding data
 		CmpPtr<ICmpPathfinder> cmpPathfinder(GetSystemEntity());
@@ -1015,9 +1325,20 @@ public:
 				std::map<std::string, pass_class_t> nonPathfindingPassClassMasks, pathfindingPassClassMasks;
 				cmpPathfinder->GetPassabilityClasses(nonPathfindingPassClassMasks, pathfindingPassClassMasks);
 
-				m_Worker.UpdatePathfinder(passabilityMap,
-					dirtinessInformations.globallyDirty, dirtinessInformations.dirtinessGrid, m_JustDeserialized,
-					nonPathfindingPassClassMasks, pathfindingPassClassMasks);
+				if (m_CommandDelay)
+					updates.emplace_back([
+						passabilityMap = std::make_shared<const Grid<NavcellData>>(passabilityMap),
+						globallyDirty = dirtinessInformations.globallyDirty,
+						dirtinessGrid = std::make_shared<const Grid<u8>>(dirtinessInformations.dirtinessGrid),
+						justDeserialized = m_JustDeserialized, nonPathfindingPassClassMasks, pathfindingPassClassMasks](CAIWorker& worker)
+					{
+						worker.UpdatePathfinder(*passabilityMap, globallyDirty, *dirtinessGrid, justDeserialized,
+							nonPathfindingPassClassMasks, pathfindingPassClassMasks);
+					});
+				else
+					m_Worker.UpdatePathfinder(passabilityMap,
+						dirtinessInformations.globallyDirty, dirtinessInformations.dirtinessGrid, m_JustDeserialized,
+						nonPathfindingPassClassMasks, pathfindingPassClassMasks);
 			}
 
 			cmpPathfinder->FlushAIPathfinderDirtinessInformation();
@@ -1029,10 +1350,19 @@ public:
 		if (cmpTerritoryManager && (cmpTerritoryManager->NeedUpdateAI(&m_TerritoriesDirtyID, &m_TerritoriesDirtyBlinkingID) || m_JustDeserialized))
 		{
 			const Grid<u8>& territoryMap = cmpTerritoryManager->GetTerritoryGrid();
-			m_Worker.UpdateTerritoryMap(territoryMap);
+			if (m_CommandDelay)
+				updates.emplace_back([territoryMap = std::make_shared<const Grid<u8>>(territoryMap)](CAIWorker& worker)
+				{
+					worker.UpdateTerritoryMap(*territoryMap);
+				});
+			else
+				m_Worker.UpdateTerritoryMap(territoryMap);
 		}
 
-		m_Worker.StartComputation();
+		if (m_CommandDelay)
+			QueueComputation(Script::WriteStructuredClone(rq, state), updates);
+		else
+			m_Worker.StartComputation();
 
 		m_JustDeserialized = false;
 	}
@@ -1040,7 +1370,24 @@ public:
 	void PushCommands() override
 	{
 		std::vector<CAIWorker::SCommandSets> commands;
-		m_Worker.GetCommands(commands);
+		if (!m_CommandDelay)
+			m_Worker.GetCommands(commands);
+		else
+		{
+			// Push the commands computed m_CommandDelay turns ago, waiting for the AI threads if needed.
+			while (!m_PendingCommands.empty() && m_PendingCommands.front().turnsLeft == 0)
+			{
+				PendingCommands& pending = m_PendingCommands.front();
+				for (size_t i = 0; i < m_WorkerThreads.size(); ++i)
+				{
+					m_WorkerThreads[i]->Wait(pending.tickets[i]);
+					commands.insert(commands.end(), pending.commands[i].begin(), pending.commands[i].end());
+				}
+				m_PendingCommands.pop_front();
+			}
+			for (PendingCommands& pending : m_PendingCommands)
+				--pending.turnsLeft;
+		}
 
 		CmpPtr<ICmpCommandQueue> cmpCommandQueue(GetSystemEntity());
 		if (!cmpCommandQueue)
@@ -1061,11 +1408,65 @@ public:
 	}
 
 private:
+	/**
+	 * Commands computed by the AI threads, to be pushed once turnsLeft reaches zero.
+	 */
+	struct PendingCommands
+	{
+		u32 turnsLeft;
+		// Per AI thread: the ticket of the computation, and its result.
+		std::vector<u64> tickets;
+		std::vector<std::vector<CAIWorker::SCommandSets>> commands;
+	};
+
 	size_t m_TerritoriesDirtyID;
 	size_t m_TerritoriesDirtyBlinkingID;
 
 	bool m_JustDeserialized;
 
+	// Number of turns after which the AI commands are pushed. If not zero, every
+	// AI player runs in one of m_WorkerThreads instead of m_Worker.
+	u32 m_CommandDelay;
+	u32 m_RNGSeed;
+	std::deque<PendingCommands> m_PendingCommands;
+
+	/**
+	 * Each AI thread has its own RNG, so derive a distinct seed per player: otherwise
+	 * all the AI players on a map would make the same random choices.
+	 */
+	static u32 GetPlayerRNGSeed(u32 seed, player_id_t player)
+	{
+		return seed ^ (static_cast<u32>(player) * 0x9E3779B9u);
+	}
+
+	size_t GetNumPlayers()
+	{
+		return m_CommandDelay ? m_WorkerThreads.size() : m_Worker.getPlayerSize();
+	}
+
+	/**
+	 * Queue the computation of the next commands on every AI thread, after applying the given updates.
+	 */
+	void QueueComputation(const Script::StructuredClone& gameState, const std::vector<CAIWorkerThread::Task>& updates)
+	{
+		PendingCommands& pending = m_PendingCommands.emplace_back();
+		pending.turnsLeft = m_CommandDelay;
+		pending.commands.resize(m_WorkerThreads.size());
+		for (size_t i = 0; i < m_WorkerThreads.size(); ++i)
+		{
+			// The deque and the vector of results are not resized while the computation runs.
+			std::vector<CAIWorker::SCommandSets>* commands = &pending.commands[i];
+			pending.tickets.push_back(m_WorkerThreads[i]->Post([gameState, updates, commands](CAIWorker& worker)
+			{
+				for (const CAIWorkerThread::Task& update : updates)
+					update(worker);
+				worker.UpdateGameState(gameState);
+				worker.StartComputation();
+				worker.GetCommands(*commands);
+			}));
+		}
+	}
+
 	/**
 	 * Load the templates of all entities on the map (called when adding a new AI player for a new game
 	 * or when deserializing)
@@ -1075,6 +1476,12 @@ private:
 		if (m_Worker.HasLoadedEntityTemplates())
 			return;
 
+		// Send the data to the worker
+		m_Worker.LoadEntityTemplates(GetUsedEntityTemplates());
+	}
+
+	std::vector<std::pair<std::string, const CParamNode*>> GetUsedEntityTemplates()
+	{
 		CmpPtr<ICmpTemplateManager> cmpTemplateManager(GetSystemEntity());
 		ENSURE(cmpTemplateManager);
 
@@ -1087,8 +1494,7 @@ private:
 			if (node)
 				usedTemplates.emplace_back(name, node);
 		}
-		// Send the data to the worker
-		m_Worker.LoadEntityTemplates(usedTemplates);
+		return usedTemplates;
 	}
 
 	void LoadPathfinderClasses(JS::HandleValue state)
@@ -1112,6 +1518,8 @@ private:
 	}
 
 	CAIWorker m_Worker;
+	// Declared last, so that the threads stop before the results they write to are destroyed.
+	std::vector<std::unique_ptr<CAIWorkerThread>> m_WorkerThreads;
 };
 
 REGISTER_COMPONENT_TYPE(AIManager)
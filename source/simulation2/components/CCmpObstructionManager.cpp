@@ -1,4 +1,4 @@
-/* Copyright (C) 2025 Wildfire Games.
+/* Copyright (C) 2026 Wildfire Games.
  * This file is part of 0 A.D.
  *
  * 0 A.D. is free software: you can redistribute it and/or modify
@@ -49,6 +49,7 @@
 #include <algorithm>
 #include <cmath>
 #include <cstddef>
+#include <functional>
 #include <map>
 #include <string>
 #include <type_traits>
@@ -98,6 +99,180 @@ struct StaticShape
 	entity_id_t group;
 	entity_id_t group2;
 };
+
+/**
+ * World-space axis-aligned bounds of each kind of shape, as used by the subdivisions.
+ */
+void GetShapeBounds(const UnitShape& shape, CFixedVector2D& min, CFixedVector2D& max)
+{
+	min = CFixedVector2D(shape.x - shape.clearance, shape.z - shape.clearance);
+	max = CFixedVector2D(shape.x + shape.clearance, shape.z + shape.clearance);
+}
+
+void GetShapeBounds(const StaticShape& shape, CFixedVector2D& min, CFixedVector2D& max)
+{
+	CFixedVector2D center(shape.x, shape.z);
+	CFixedVector2D bbHalfSize = Geometry::GetHalfBoundingBox(shape.u, shape.v, CFixedVector2D(shape.hw, shape.hh));
+	min = center - bbHalfSize;
+	max = center + bbHalfSize;
+}
+
+/**
+ * Dense storage of shapes indexed by the index part of their tag.
+ * Index 0 is never used, since tags must be non-zero.
+ *
+ * Removed indexes are reused lowest first, so the allocation only depends on
+ * which indexes are in use and does not need to be serialized.
+ * The bounds of the shapes are kept in separate arrays so the broad phase
+ * of queries can reject shapes without loading the whole shape.
+ */
+template<typename T>
+class ShapeSlots
+{
+public:
+	u32 Insert(const T& shape)
+	{
+		u32 index;
+		if (m_FreeIndexes.empty())
+			index = std::max<u32>(m_Shapes.size(), 1);
+		else
+		{
+			std::pop_heap(m_FreeIndexes.begin(), m_FreeIndexes.end(), std::greater<u32>());
+			index = m_FreeIndexes.back();
+			m_FreeIndexes.pop_back();
+		}
+		InsertAt(index, shape);
+		return index;
+	}
+
+	/**
+	 * Insert a shape at a given unused index. Call RebuildFreeIndexes once done.
+	 */
+	void InsertAt(u32 index, const T& shape)
+	{
+		ENSURE(index != 0);
+		if (index >= m_Shapes.size())
+		{
+			m_Shapes.resize(index + 1);
+			m_Used.resize(index + 1, 0);
+			m_MinX.resize(index + 1);
+			m_MinZ.resize(index + 1);
+			m_MaxX.resize(index + 1);
+			m_MaxZ.resize(index + 1);
+		}
+		ENSURE(!m_Used[index]);
+		m_Shapes[index] = shape;
+		m_Used[index] = 1;
+		++m_Count;
+		UpdateBounds(index);
+	}
+
+	void Erase(u32 index)
+	{
+		ENSURE(Contains(index));
+		m_Used[index] = 0;
+		--m_Count;
+		m_FreeIndexes.push_back(index);
+		std::push_heap(m_FreeIndexes.begin(), m_FreeIndexes.end(), std::greater<u32>());
+	}
+
+	void Clear()
+	{
+		m_Shapes.clear();
+		m_Used.clear();
+		m_MinX.clear();
+		m_MinZ.clear();
+		m_MaxX.clear();
+		m_MaxZ.clear();
+		m_FreeIndexes.clear();
+		m_Count = 0;
+	}
+
+	void RebuildFreeIndexes()
+	{
+		m_FreeIndexes.clear();
+		for (u32 index = 1; index < m_Used.size(); ++index)
+			if (!m_Used[index])
+				m_FreeIndexes.push_back(index);
+		std::make_heap(m_FreeIndexes.begin(), m_FreeIndexes.end(), std::greater<u32>());
+	}
+
+	bool Contains(u32 index) const
+	{
+		return index < m_Used.size() && m_Used[index];
+	}
+
+	size_t size() const
+	{
+		return m_Count;
+	}
+
+	T& operator[](u32 index)
+	{
+		ENSURE(Contains(index));
+		return m_Shapes[index];
+	}
+
+	const T& operator[](u32 index) const
+	{
+		ENSURE(Contains(index));
+		return m_Shapes[index];
+	}
+
+	/**
+	 * Must be called after modifying the shape at the given index.
+	 */
+	void UpdateBounds(u32 index)
+	{
+		CFixedVector2D min, max;
+		GetShapeBounds(m_Shapes[index], min, max);
+		m_MinX[index] = min.X;
+		m_MinZ[index] = min.Y;
+		m_MaxX[index] = max.X;
+		m_MaxZ[index] = max.Y;
+	}
+
+	CFixedVector2D GetMin(u32 index) const { return CFixedVector2D(m_MinX[index], m_MinZ[index]); }
+	CFixedVector2D GetMax(u32 index) const { return CFixedVector2D(m_MaxX[index], m_MaxZ[index]); }
+
+	/**
+	 * Returns whether the bounds of the shape intersect the given box (inclusively).
+	 */
+	bool BoundsIntersect(u32 index, const CFixedVector2D& min, const CFixedVector2D& max) const
+	{
+		return !(m_MaxX[index] < min.X || m_MinX[index] > max.X || m_MaxZ[index] < min.Y || m_MinZ[index] > max.Y);
+	}
+
+	/**
+	 * Call f(index, shape) for each shape, by increasing index.
+	 */
+	template<typename F>
+	void ForEach(F f) const
+	{
+		for (u32 index = 1; index < m_Used.size(); ++index)
+			if (m_Used[index])
+				f(index, m_Shapes[index]);
+	}
+
+	template<typename F>
+	void ForEach(F f)
+	{
+		for (u32 index = 1; index < m_Used.size(); ++index)
+			if (m_Used[index])
+				f(index, m_Shapes[index]);
+	}
+
+private:
+	std::vector<T> m_Shapes;
+	std::vector<u8> m_Used;
+	std::vector<entity_pos_t> m_MinX;
+	std::vector<entity_pos_t> m_MinZ;
+	std::vector<entity_pos_t> m_MaxX;
+	std::vector<entity_pos_t> m_MaxZ;
+	// Min-heap of the unused indexes below m_Shapes.size().
+	std::vector<u32> m_FreeIndexes;
+	size_t m_Count = 0;
+};
 } // anonymous namespace
 /**
  * Serialization helper template for UnitShape
@@ -141,6 +316,38 @@ struct SerializeHelper<StaticShape>
 	}
 };
 
+/**
+ * Serialization helper template for ShapeSlots, laid out like a map from index to shape.
+ */
+template<typename T>
+struct SerializeHelper<ShapeSlots<T>>
+{
+	void operator()(ISerializer& serialize, const char* /*name*/, ShapeSlots<T>& value) const
+	{
+		serialize.NumberU32_Unbounded("length", static_cast<u32>(value.size()));
+		value.ForEach([&](u32 index, T& shape) {
+			serialize.NumberU32_Unbounded("key", index);
+			Serializer(serialize, "value", shape);
+		});
+	}
+
+	void operator()(IDeserializer& deserialize, const char* /*name*/, ShapeSlots<T>& value) const
+	{
+		value.Clear();
+		u32 length;
+		deserialize.NumberU32_Unbounded("length", length);
+		for (u32 i = 0; i < length; ++i)
+		{
+			u32 index;
+			T shape;
+			deserialize.NumberU32_Unbounded("key", index);
+			Serializer(deserialize, "value", shape);
+			value.InsertAt(index, shape);
+		}
+		value.RebuildFreeIndexes();
+	}
+};
+
 class CCmpObstructionManager final : public ICmpObstructionManager
 {
 public:
@@ -158,11 +365,8 @@ public:
 	SpatialSubdivision m_UnitSubdivision;
 	SpatialSubdivision m_StaticSubdivision;
 
-	// TODO: using std::map is a bit inefficient; is there a better way to store these?
-	std::map<u32, UnitShape> m_UnitShapes;
-	std::map<u32, StaticShape> m_StaticShapes;
-	u32 m_UnitShapeNext; // next allocated id
-	u32 m_StaticShapeNext;
+	ShapeSlots<UnitShape> m_UnitShapes;
+	ShapeSlots<StaticShape> m_StaticShapes;
 
 	entity_pos_t m_MaxClearance;
 
@@ -183,9 +387,6 @@ public:
 		m_DebugOverlayEnabled = false;
 		m_DebugOverlayDirty = true;
 
-		m_UnitShapeNext = 1;
-		m_StaticShapeNext = 1;
-
 		m_UpdateInformations.dirty = true;
 		m_UpdateInformations.globallyDirty = true;
 
@@ -212,8 +413,6 @@ public:
 
 		Serializer(serialize, "unit shapes", m_UnitShapes);
 		Serializer(serialize, "static shapes", m_StaticShapes);
-		serialize.NumberU32_Unbounded("unit shape next", m_UnitShapeNext);
-		serialize.NumberU32_Unbounded("static shape next", m_StaticShapeNext);
 
 		serialize.Bool("circular", m_PassabilityCircular);
 
@@ -281,28 +480,21 @@ public:
 		m_UnitSubdivision.Reset(x1, z1, OBSTRUCTION_SUBDIVISION_SIZE);
 		m_StaticSubdivision.Reset(x1, z1, OBSTRUCTION_SUBDIVISION_SIZE);
 
-		for (std::map<u32, UnitShape>::iterator it = m_UnitShapes.begin(); it != m_UnitShapes.end(); ++it)
-		{
-			CFixedVector2D center(it->second.x, it->second.z);
-			CFixedVector2D halfSize(it->second.clearance, it->second.clearance);
-			m_UnitSubdivision.Add(it->first, center - halfSize, center + halfSize);
-		}
+		m_UnitShapes.ForEach([this](u32 index, const UnitShape&) {
+			m_UnitSubdivision.Add(index, m_UnitShapes.GetMin(index), m_UnitShapes.GetMax(index));
+		});
 
-		for (std::map<u32, StaticShape>::iterator it = m_StaticShapes.begin(); it != m_StaticShapes.end(); ++it)
-		{
-			CFixedVector2D center(it->second.x, it->second.z);
-			CFixedVector2D bbHalfSize = Geometry::GetHalfBoundingBox(it->second.u, it->second.v, CFixedVector2D(it->second.hw, it->second.hh));
-			m_StaticSubdivision.Add(it->first, center - bbHalfSize, center + bbHalfSize);
-		}
+		m_StaticShapes.ForEach([this](u32 index, const StaticShape&) {
+			m_StaticSubdivision.Add(index, m_StaticShapes.GetMin(index), m_StaticShapes.GetMax(index));
+		});
 	}
 
 	tag_t AddUnitShape(entity_id_t ent, entity_pos_t x, entity_pos_t z, entity_pos_t clearance, flags_t flags, entity_id_t group) override
 	{
 		UnitShape shape = { ent, x, z, clearance, flags, group };
-		u32 id = m_UnitShapeNext++;
-		m_UnitShapes[id] = shape;
+		u32 id = m_UnitShapes.Insert(shape);
 
-		m_UnitSubdivision.Add(id, CFixedVector2D(x - clearance, z - clearance), CFixedVector2D(x + clearance, z + clearance));
+		m_UnitSubdivision.Add(id, m_UnitShapes.GetMin(id), m_UnitShapes.GetMax(id));
 
 		MakeDirtyUnit(flags, id, shape);
 
@@ -317,12 +509,9 @@ public:
 		CFixedVector2D v(s, c);
 
 		StaticShape shape = { ent, x, z, u, v, w/2, h/2, flags, group, group2 };
-		u32 id = m_StaticShapeNext++;
-		m_StaticShapes[id] = shape;
+		u32 id = m_StaticShapes.Insert(shape);
 
-		CFixedVector2D center(x, z);
-		CFixedVector2D bbHalfSize = Geometry::GetHalfBoundingBox(u, v, CFixedVector2D(w/2, h/2));
-		m_StaticSubdivision.Add(id, center - bbHalfSize, center + bbHalfSize);
+		m_StaticSubdivision.Add(id, m_StaticShapes.GetMin(id), m_StaticShapes.GetMax(id));
 
 		MakeDirtyStatic(flags, id, shape);
 
@@ -358,14 +547,15 @@ public:
 
 			MakeDirtyUnit(shape.flags, TAG_TO_INDEX(tag), shape); // dirty the old shape region
 
-			m_UnitSubdivision.Move(TAG_TO_INDEX(tag),
-				CFixedVector2D(shape.x - shape.clearance, shape.z - shape.clearance),
-				CFixedVector2D(shape.x + shape.clearance, shape.z + shape.clearance),
-				CFixedVector2D(x - shape.clearance, z - shape.clearance),
-				CFixedVector2D(x + shape.clearance, z + shape.clearance));
+			const CFixedVector2D fromMin = m_UnitShapes.GetMin(TAG_TO_INDEX(tag));
+			const CFixedVector2D fromMax = m_UnitShapes.GetMax(TAG_TO_INDEX(tag));
 
 			shape.x = x;
 			shape.z = z;
+			m_UnitShapes.UpdateBounds(TAG_TO_INDEX(tag));
+
+			m_UnitSubdivision.Move(TAG_TO_INDEX(tag), fromMin, fromMax,
+				m_UnitShapes.GetMin(TAG_TO_INDEX(tag)), m_UnitShapes.GetMax(TAG_TO_INDEX(tag)));
 
 			MakeDirtyUnit(shape.flags, TAG_TO_INDEX(tag), shape); // dirty the new shape region
 		}
@@ -380,18 +570,17 @@ public:
 
 			MakeDirtyStatic(shape.flags, TAG_TO_INDEX(tag), shape); // dirty the old shape region
 
-			CFixedVector2D fromBbHalfSize = Geometry::GetHalfBoundingBox(shape.u, shape.v, CFixedVector2D(shape.hw, shape.hh));
-			CFixedVector2D toBbHalfSize = Geometry::GetHalfBoundingBox(u, v, CFixedVector2D(shape.hw, shape.hh));
-			m_StaticSubdivision.Move(TAG_TO_INDEX(tag),
-				CFixedVector2D(shape.x, shape.z) - fromBbHalfSize,
-				CFixedVector2D(shape.x, shape.z) + fromBbHalfSize,
-				CFixedVector2D(x, z) - toBbHalfSize,
-				CFixedVector2D(x, z) + toBbHalfSize);
+			const CFixedVector2D fromMin = m_StaticShapes.GetMin(TAG_TO_INDEX(tag));
+			const CFixedVector2D fromMax = m_StaticShapes.GetMax(TAG_TO_INDEX(tag));
 
 			shape.x = x;
 			shape.z = z;
 			shape.u = u;
 			shape.v = v;
+			m_StaticShapes.UpdateBounds(TAG_TO_INDEX(tag));
+
+			m_StaticSubdivision.Move(TAG_TO_INDEX(tag), fromMin, fromMax,
+				m_StaticShapes.GetMin(TAG_TO_INDEX(tag)), m_StaticShapes.GetMax(TAG_TO_INDEX(tag)));
 
 			MakeDirtyStatic(shape.flags, TAG_TO_INDEX(tag), shape); // dirty the new shape region
 		}
@@ -443,25 +632,20 @@ public:
 		if (TAG_IS_UNIT(tag))
 		{
 			UnitShape& shape = m_UnitShapes[TAG_TO_INDEX(tag)];
-			m_UnitSubdivision.Remove(TAG_TO_INDEX(tag),
-				CFixedVector2D(shape.x - shape.clearance, shape.z - shape.clearance),
-				CFixedVector2D(shape.x + shape.clearance, shape.z + shape.clearance));
+			m_UnitSubdivision.Remove(TAG_TO_INDEX(tag), m_UnitShapes.GetMin(TAG_TO_INDEX(tag)), m_UnitShapes.GetMax(TAG_TO_INDEX(tag)));
 
 			MakeDirtyUnit(shape.flags, TAG_TO_INDEX(tag), shape);
 
-			m_UnitShapes.erase(TAG_TO_INDEX(tag));
+			m_UnitShapes.Erase(TAG_TO_INDEX(tag));
 		}
 		else
 		{
 			StaticShape& shape = m_StaticShapes[TAG_TO_INDEX(tag)];
-
-			CFixedVector2D center(shape.x, shape.z);
-			CFixedVector2D bbHalfSize = Geometry::GetHalfBoundingBox(shape.u, shape.v, CFixedVector2D(shape.hw, shape.hh));
-			m_StaticSubdivision.Remove(TAG_TO_INDEX(tag), center - bbHalfSize, center + bbHalfSize);
+			m_StaticSubdivision.Remove(TAG_TO_INDEX(tag), m_StaticShapes.GetMin(TAG_TO_INDEX(tag)), m_StaticShapes.GetMax(TAG_TO_INDEX(tag)));
 
 			MakeDirtyStatic(shape.flags, TAG_TO_INDEX(tag), shape);
 
-			m_StaticShapes.erase(TAG_TO_INDEX(tag));
+			m_StaticShapes.Erase(TAG_TO_INDEX(tag));
 		}
 	}
 
@@ -471,7 +655,7 @@ public:
 
 		if (TAG_IS_UNIT(tag))
 		{
-			const UnitShape& shape = m_UnitShapes.at(TAG_TO_INDEX(tag));
+			const UnitShape& shape = m_UnitShapes[TAG_TO_INDEX(tag)];
 			CFixedVector2D u(entity_pos_t::FromInt(1), entity_pos_t::Zero());
 			CFixedVector2D v(entity_pos_t::Zero(), entity_pos_t::FromInt(1));
 			ObstructionSquare o = { shape.x, shape.z, u, v, shape.clearance, shape.clearance };
@@ -479,7 +663,7 @@ public:
 		}
 		else
 		{
-			const StaticShape& shape = m_StaticShapes.at(TAG_TO_INDEX(tag));
+			const StaticShape& shape = m_StaticShapes[TAG_TO_INDEX(tag)];
 			ObstructionSquare o = { shape.x, shape.z, shape.u, shape.v, shape.hw, shape.hh };
 			return o;
 		}
@@ -543,7 +727,8 @@ public:
 private:
 	// Dynamic updates for the long-range pathfinder
 	GridUpdateInformation m_UpdateInformations;
-	// These vectors might contain shapes that were deleted
+	// These vectors might contain shapes that were deleted, and duplicates
+	// until SortDirtyShapes is called.
 	std::vector<u32> m_DirtyStaticShapes;
 	std::vector<u32> m_DirtyUnitShapes;
 
@@ -604,8 +789,7 @@ private:
 		{
 			m_UpdateInformations.dirty = true;
 
-			if (std::find(m_DirtyStaticShapes.begin(), m_DirtyStaticShapes.end(), index) == m_DirtyStaticShapes.end())
-				m_DirtyStaticShapes.push_back(index);
+			m_DirtyStaticShapes.push_back(index);
 
 			// All shapes overlapping the updated part of the grid should be dirtied too.
 			// We are going to invalidate the region of the grid corresponding to the modified shape plus its clearance,
@@ -618,15 +802,13 @@ private:
 
 			std::vector<u32> staticsNear;
 			m_StaticSubdivision.GetInRange(staticsNear, center - hbox - expand*2, center + hbox + expand*2);
-			for (u32& staticId : staticsNear)
-				if (std::find(m_DirtyStaticShapes.begin(), m_DirtyStaticShapes.end(), staticId) == m_DirtyStaticShapes.end())
-					m_DirtyStaticShapes.push_back(staticId);
+			m_DirtyStaticShapes.insert(m_DirtyStaticShapes.end(), staticsNear.begin(), staticsNear.end());
 
 			std::vector<u32> unitsNear;
 			m_UnitSubdivision.GetInRange(unitsNear, center - hbox - expand*2, center + hbox + expand*2);
-			for (u32& unitId : unitsNear)
-				if (std::find(m_DirtyUnitShapes.begin(), m_DirtyUnitShapes.end(), unitId) == m_DirtyUnitShapes.end())
-					m_DirtyUnitShapes.push_back(unitId);
+			m_DirtyUnitShapes.insert(m_DirtyUnitShapes.end(), unitsNear.begin(), unitsNear.end());
+
+			CompactDirtyShapes();
 
 			MarkDirtinessGrid(shape.x, shape.z, hbox + expand);
 		}
@@ -648,8 +830,7 @@ private:
 		{
 			m_UpdateInformations.dirty = true;
 
-			if (std::find(m_DirtyUnitShapes.begin(), m_DirtyUnitShapes.end(), index) == m_DirtyUnitShapes.end())
-				m_DirtyUnitShapes.push_back(index);
+			m_DirtyUnitShapes.push_back(index);
 
 			// All shapes overlapping the updated part of the grid should be dirtied too.
 			// We are going to invalidate the region of the grid corresponding to the modified shape plus its clearance,
@@ -660,20 +841,40 @@ private:
 
 			std::vector<u32> staticsNear;
 			m_StaticSubdivision.GetNear(staticsNear, center, shape.clearance + m_MaxClearance*2);
-			for (u32& staticId : staticsNear)
-				if (std::find(m_DirtyStaticShapes.begin(), m_DirtyStaticShapes.end(), staticId) == m_DirtyStaticShapes.end())
-					m_DirtyStaticShapes.push_back(staticId);
+			m_DirtyStaticShapes.insert(m_DirtyStaticShapes.end(), staticsNear.begin(), staticsNear.end());
 
 			std::vector<u32> unitsNear;
 			m_UnitSubdivision.GetNear(unitsNear, center, shape.clearance + m_MaxClearance*2);
-			for (u32& unitId : unitsNear)
-				if (std::find(m_DirtyUnitShapes.begin(), m_DirtyUnitShapes.end(), unitId) == m_DirtyUnitShapes.end())
-					m_DirtyUnitShapes.push_back(unitId);
+			m_DirtyUnitShapes.insert(m_DirtyUnitShapes.end(), unitsNear.begin(), unitsNear.end());
+
+			CompactDirtyShapes();
 
 			MarkDirtinessGrid(shape.x, shape.z, shape.clearance + m_MaxClearance);
 		}
 	}
 
+	/**
+	 * Sort the dirty shape lists and remove their duplicates.
+	 */
+	void SortDirtyShapes()
+	{
+		std::sort(m_DirtyStaticShapes.begin(), m_DirtyStaticShapes.end());
+		m_DirtyStaticShapes.erase(std::unique(m_DirtyStaticShapes.begin(), m_DirtyStaticShapes.end()), m_DirtyStaticShapes.end());
+		std::sort(m_DirtyUnitShapes.begin(), m_DirtyUnitShapes.end());
+		m_DirtyUnitShapes.erase(std::unique(m_DirtyUnitShapes.begin(), m_DirtyUnitShapes.end()), m_DirtyUnitShapes.end());
+	}
+
+	/**
+	 * Duplicates are only removed when rasterizing, keep the lists bounded
+	 * if many shapes change in between.
+	 */
+	void CompactDirtyShapes()
+	{
+		if (m_DirtyStaticShapes.size() > 2 * m_StaticShapes.size() + 64 ||
+		    m_DirtyUnitShapes.size() > 2 * m_UnitShapes.size() + 64)
+			SortDirtyShapes();
+	}
+
 	/**
 	 * Return whether the given point is within the world bounds by at least r
 	 */
@@ -691,6 +892,8 @@ private:
 	}
 
 	void RasterizeHelper(Grid<NavcellData>& grid, ICmpObstructionManager::flags_t requireMask, bool fullUpdate, pass_class_t appliedMask, entity_pos_t clearance = fixed::Zero()) const;
+	static void RasterizeStaticShape(Grid<NavcellData>& grid, const StaticShape& shape, pass_class_t appliedMask, entity_pos_t clearance);
+	static void RasterizeUnitShape(Grid<NavcellData>& grid, const UnitShape& shape, pass_class_t appliedMask, entity_pos_t clearance);
 };
 
 REGISTER_COMPONENT_TYPE(ObstructionManager)
@@ -901,33 +1104,35 @@ bool CCmpObstructionManager::TestLine(const IObstructionTestFilter& filter, enti
 
 	std::vector<entity_id_t> unitShapes;
 	m_UnitSubdivision.GetInRange(unitShapes, posMin, posMax);
-	for (const entity_id_t& shape : unitShapes)
+	for (const u32 index : unitShapes)
 	{
-		std::map<u32, UnitShape>::const_iterator it = m_UnitShapes.find(shape);
-		ENSURE(it != m_UnitShapes.end());
+		// The line can only hit shapes whose bounds reach its own expanded bounds.
+		if (!m_UnitShapes.BoundsIntersect(index, posMin, posMax))
+			continue;
+
+		const UnitShape& shape = m_UnitShapes[index];
 
-		if (!filter.TestShape(UNIT_INDEX_TO_TAG(it->first), it->second.flags, it->second.group, INVALID_ENTITY))
+		if (!filter.TestShape(UNIT_INDEX_TO_TAG(index), shape.flags, shape.group, INVALID_ENTITY))
 			continue;
 
-		CFixedVector2D center(it->second.x, it->second.z);
-		CFixedVector2D halfSize(it->second.clearance + unitUnitRadius, it->second.clearance + unitUnitRadius);
+		CFixedVector2D center(shape.x, shape.z);
+		CFixedVector2D halfSize(shape.clearance + unitUnitRadius, shape.clearance + unitUnitRadius);
 		if (Geometry::TestRayAASquare(CFixedVector2D(x0, z0) - center, CFixedVector2D(x1, z1) - center, halfSize))
 			return true;
 	}
 
 	std::vector<entity_id_t> staticShapes;
 	m_StaticSubdivision.GetInRange(staticShapes, posMin, posMax);
-	for (const entity_id_t& shape : staticShapes)
+	for (const u32 index : staticShapes)
 	{
-		std::map<u32, StaticShape>::const_iterator it = m_StaticShapes.find(shape);
-		ENSURE(it != m_StaticShapes.end());
+		const StaticShape& shape = m_StaticShapes[index];
 
-		if (!filter.TestShape(STATIC_INDEX_TO_TAG(it->first), it->second.flags, it->second.group, it->second.group2))
+		if (!filter.TestShape(STATIC_INDEX_TO_TAG(index), shape.flags, shape.group, shape.group2))
 			continue;
 
-		CFixedVector2D center(it->second.x, it->second.z);
-		CFixedVector2D halfSize(it->second.hw + r, it->second.hh + r);
-		if (Geometry::TestRaySquare(CFixedVector2D(x0, z0) - center, CFixedVector2D(x1, z1) - center, it->second.u, it->second.v, halfSize))
+		CFixedVector2D center(shape.x, shape.z);
+		CFixedVector2D halfSize(shape.hw + r, shape.hh + r);
+		if (Geometry::TestRaySquare(CFixedVector2D(x0, z0) - center, CFixedVector2D(x1, z1) - center, shape.u, shape.v, halfSize))
 			return true;
 	}
 
@@ -950,16 +1155,19 @@ bool CCmpObstructionManager::TestUnitLine(const IObstructionTestFilter& filter,
 
 	std::vector<entity_id_t> unitShapes;
 	m_UnitSubdivision.GetInRange(unitShapes, posMin, posMax);
-	for (const entity_id_t& shape : unitShapes)
+	for (const u32 index : unitShapes)
 	{
-		std::map<u32, UnitShape>::const_iterator it = m_UnitShapes.find(shape);
-		ENSURE(it != m_UnitShapes.end());
+		// The line can only hit shapes whose bounds reach its own expanded bounds.
+		if (!m_UnitShapes.BoundsIntersect(index, posMin, posMax))
+			continue;
+
+		const UnitShape& shape = m_UnitShapes[index];
 
-		if (!filter.TestShape(UNIT_INDEX_TO_TAG(it->first), it->second.flags, it->second.group, INVALID_ENTITY))
+		if (!filter.TestShape(UNIT_INDEX_TO_TAG(index), shape.flags, shape.group, INVALID_ENTITY))
 			continue;
 
-		CFixedVector2D center(it->second.x, it->second.z);
-		CFixedVector2D halfSize(it->second.clearance + unitUnitRadius, it->second.clearance + unitUnitRadius);
+		CFixedVector2D center(shape.x, shape.z);
+		CFixedVector2D halfSize(shape.clearance + unitUnitRadius, shape.clearance + unitUnitRadius);
 		if (Geometry::TestRayAASquare(CFixedVector2D(x0, z0) - center, CFixedVector2D(x1, z1) - center, halfSize))
 			return true;
 	}
@@ -1002,20 +1210,19 @@ bool CCmpObstructionManager::TestStaticShape(const IObstructionTestFilter& filte
 
 	std::vector<entity_id_t> unitShapes;
 	m_UnitSubdivision.GetInRange(unitShapes, posMin, posMax);
-	for (entity_id_t& shape : unitShapes)
+	for (const u32 index : unitShapes)
 	{
-		std::map<u32, UnitShape>::const_iterator it = m_UnitShapes.find(shape);
-		ENSURE(it != m_UnitShapes.end());
+		const UnitShape& shape = m_UnitShapes[index];
 
-		if (!filter.TestShape(UNIT_INDEX_TO_TAG(it->first), it->second.flags, it->second.group, INVALID_ENTITY))
+		if (!filter.TestShape(UNIT_INDEX_TO_TAG(index), shape.flags, shape.group, INVALID_ENTITY))
 			continue;
 
-		CFixedVector2D center1(it->second.x, it->second.z);
+		CFixedVector2D center1(shape.x, shape.z);
 
-		if (Geometry::PointIsInSquare(center1 - center, u, v, CFixedVector2D(halfSize.X + it->second.clearance, halfSize.Y + it->second.clearance)))
+		if (Geometry::PointIsInSquare(center1 - center, u, v, CFixedVector2D(halfSize.X + shape.clearance, halfSize.Y + shape.clearance)))
 		{
 			if (out)
-				out->push_back(it->second.entity);
+				out->push_back(shape.entity);
 			else
 				return true;
 		}
@@ -1023,20 +1230,19 @@ bool CCmpObstructionManager::TestStaticShape(const IObstructionTestFilter& filte
 
 	std::vector<entity_id_t> staticShapes;
 	m_StaticSubdivision.GetInRange(staticShapes, posMin, posMax);
-	for (entity_id_t& shape : staticShapes)
+	for (const u32 index : staticShapes)
 	{
-		std::map<u32, StaticShape>::const_iterator it = m_StaticShapes.find(shape);
-		ENSURE(it != m_StaticShapes.end());
+		const StaticShape& shape = m_StaticShapes[index];
 
-		if (!filter.TestShape(STATIC_INDEX_TO_TAG(it->first), it->second.flags, it->second.group, it->second.group2))
+		if (!filter.TestShape(STATIC_INDEX_TO_TAG(index), shape.flags, shape.group, shape.group2))
 			continue;
 
-		CFixedVector2D center1(it->second.x, it->second.z);
-		CFixedVector2D halfSize1(it->second.hw, it->second.hh);
-		if (Geometry::TestSquareSquare(center, u, v, halfSize, center1, it->second.u, it->second.v, halfSize1))
+		CFixedVector2D center1(shape.x, shape.z);
+		CFixedVector2D halfSize1(shape.hw, shape.hh);
+		if (Geometry::TestSquareSquare(center, u, v, halfSize, center1, shape.u, shape.v, halfSize1))
 		{
 			if (out)
-				out->push_back(it->second.entity);
+				out->push_back(shape.entity);
 			else
 				return true;
 		}
@@ -1069,44 +1275,36 @@ bool CCmpObstructionManager::TestUnitShape(const IObstructionTestFilter& filter,
 
 	std::vector<entity_id_t> unitShapes;
 	m_UnitSubdivision.GetInRange(unitShapes, posMin, posMax);
-	for (const entity_id_t& shape : unitShapes)
+	for (const u32 index : unitShapes)
 	{
-		std::map<u32, UnitShape>::const_iterator it = m_UnitShapes.find(shape);
-		ENSURE(it != m_UnitShapes.end());
-
-		if (!filter.TestShape(UNIT_INDEX_TO_TAG(it->first), it->second.flags, it->second.group, INVALID_ENTITY))
+		if (!m_UnitShapes.BoundsIntersect(index, posMin, posMax))
 			continue;
 
-		entity_pos_t c1 = it->second.clearance;
+		const UnitShape& shape = m_UnitShapes[index];
 
-		if (!(
-			it->second.x + c1 < x - clearance ||
-			it->second.x - c1 > x + clearance ||
-			it->second.z + c1 < z - clearance ||
-			it->second.z - c1 > z + clearance))
-		{
-			if (out)
-				out->push_back(it->second.entity);
-			else
-				return true;
-		}
+		if (!filter.TestShape(UNIT_INDEX_TO_TAG(index), shape.flags, shape.group, INVALID_ENTITY))
+			continue;
+
+		if (out)
+			out->push_back(shape.entity);
+		else
+			return true;
 	}
 
 	std::vector<entity_id_t> staticShapes;
 	m_StaticSubdivision.GetInRange(staticShapes, posMin, posMax);
-	for (const entity_id_t& shape : staticShapes)
+	for (const u32 index : staticShapes)
 	{
-		std::map<u32, StaticShape>::const_iterator it = m_StaticShapes.find(shape);
-		ENSURE(it != m_StaticShapes.end());
+		const StaticShape& shape = m_StaticShapes[index];
 
-		if (!filter.TestShape(STATIC_INDEX_TO_TAG(it->first), it->second.flags, it->second.group, it->second.group2))
+		if (!filter.TestShape(STATIC_INDEX_TO_TAG(index), shape.flags, shape.group, shape.group2))
 			continue;
 
-		CFixedVector2D center1(it->second.x, it->second.z);
-		if (Geometry::PointIsInSquare(center1 - center, it->second.u, it->second.v, CFixedVector2D(it->second.hw + clearance, it->second.hh + clearance)))
+		CFixedVector2D center1(shape.x, shape.z);
+		if (Geometry::PointIsInSquare(center1 - center, shape.u, shape.v, CFixedVector2D(shape.hw + clearance, shape.hh + clearance)))
 		{
 			if (out)
-				out->push_back(it->second.entity);
+				out->push_back(shape.entity);
 			else
 				return true;
 		}
@@ -1154,6 +1352,9 @@ void CCmpObstructionManager::Rasterize(Grid<NavcellData>& grid, const std::vecto
 	// FLAG_BLOCK_PATHFINDING and FLAG_BLOCK_FOUNDATION are the only flags taken into account by MakeDirty* functions,
 	// so they should be the only ones rasterized using with the help of m_Dirty*Shapes vectors.
 
+	if (!fullUpdate)
+		SortDirtyShapes();
+
 	for (auto& maskPair : pathfindingMasks)
 		RasterizeHelper(grid, FLAG_BLOCK_PATHFINDING, fullUpdate, maskPair.second, maskPair.first);
 
@@ -1165,50 +1366,67 @@ void CCmpObstructionManager::Rasterize(Grid<NavcellData>& grid, const std::vecto
 
 void CCmpObstructionManager::RasterizeHelper(Grid<NavcellData>& grid, ICmpObstructionManager::flags_t requireMask, bool fullUpdate, pass_class_t appliedMask, entity_pos_t clearance) const
 {
-	for (auto& pair : m_StaticShapes)
+	if (fullUpdate)
 	{
-		const StaticShape& shape = pair.second;
-		if (!(shape.flags & requireMask))
-			continue;
-
-		if (!fullUpdate && std::find(m_DirtyStaticShapes.begin(), m_DirtyStaticShapes.end(), pair.first) == m_DirtyStaticShapes.end())
-			continue;
-
-		// TODO: it might be nice to rasterize with rounded corners for large 'expand' values.
-		ObstructionSquare square = { shape.x, shape.z, shape.u, shape.v, shape.hw, shape.hh };
-		SimRasterize::Spans spans;
-		SimRasterize::RasterizeRectWithClearance(spans, square, clearance, Pathfinding::NAVCELL_SIZE);
-		for (SimRasterize::Span& span : spans)
-		{
-			i16 j = Clamp(span.j, (i16)0, (i16)(grid.m_H-1));
-			i16 i0 = std::max(span.i0, (i16)0);
-			i16 i1 = std::min(span.i1, (i16)grid.m_W);
-
-			for (i16 i = i0; i < i1; ++i)
-				grid.set(i, j, grid.get(i, j) | appliedMask);
-		}
+		m_StaticShapes.ForEach([&](u32, const StaticShape& shape) {
+			if (shape.flags & requireMask)
+				RasterizeStaticShape(grid, shape, appliedMask, clearance);
+		});
+
+		m_UnitShapes.ForEach([&](u32, const UnitShape& shape) {
+			if (shape.flags & requireMask)
+				RasterizeUnitShape(grid, shape, appliedMask, clearance);
+		});
+		return;
 	}
 
-	for (auto& pair : m_UnitShapes)
+	// Only visit the shapes touching the dirty part of the grid, so that the cost
+	// depends on what changed rather than on the total number of shapes.
+	// Shapes that were deleted since they were marked dirty are skipped, and
+	// shapes that reused their index are dirty anyway.
+	for (u32 index : m_DirtyStaticShapes)
 	{
-		if (!(pair.second.flags & requireMask))
-			continue;
+		if (m_StaticShapes.Contains(index) && (m_StaticShapes[index].flags & requireMask))
+			RasterizeStaticShape(grid, m_StaticShapes[index], appliedMask, clearance);
+	}
 
-		if (!fullUpdate && std::find(m_DirtyUnitShapes.begin(), m_DirtyUnitShapes.end(), pair.first) == m_DirtyUnitShapes.end())
-			continue;
+	for (u32 index : m_DirtyUnitShapes)
+	{
+		if (m_UnitShapes.Contains(index) && (m_UnitShapes[index].flags & requireMask))
+			RasterizeUnitShape(grid, m_UnitShapes[index], appliedMask, clearance);
+	}
+}
 
-		CFixedVector2D center(pair.second.x, pair.second.z);
-		entity_pos_t r = pair.second.clearance + clearance;
+void CCmpObstructionManager::RasterizeStaticShape(Grid<NavcellData>& grid, const StaticShape& shape, pass_class_t appliedMask, entity_pos_t clearance)
+{
+	// TODO: it might be nice to rasterize with rounded corners for large 'expand' values.
+	ObstructionSquare square = { shape.x, shape.z, shape.u, shape.v, shape.hw, shape.hh };
+	SimRasterize::Spans spans;
+	SimRasterize::RasterizeRectWithClearance(spans, square, clearance, Pathfinding::NAVCELL_SIZE);
+	for (SimRasterize::Span& span : spans)
+	{
+		i16 j = Clamp(span.j, (i16)0, (i16)(grid.m_H-1));
+		i16 i0 = std::max(span.i0, (i16)0);
+		i16 i1 = std::min(span.i1, (i16)grid.m_W);
 
-		u16 i0, j0, i1, j1;
-		Pathfinding::NearestNavcell(center.X - r, center.Y - r, i0, j0, grid.m_W, grid.m_H);
-		Pathfinding::NearestNavcell(center.X + r, center.Y + r, i1, j1, grid.m_W, grid.m_H);
-		for (u16 j = j0+1; j < j1; ++j)
-			for (u16 i = i0+1; i < i1; ++i)
-				grid.set(i, j, grid.get(i, j) | appliedMask);
+		for (i16 i = i0; i < i1; ++i)
+			grid.set(i, j, grid.get(i, j) | appliedMask);
 	}
 }
 
+void CCmpObstructionManager::RasterizeUnitShape(Grid<NavcellData>& grid, const UnitShape& shape, pass_class_t appliedMask, entity_pos_t clearance)
+{
+	CFixedVector2D center(shape.x, shape.z);
+	entity_pos_t r = shape.clearance + clearance;
+
+	u16 i0, j0, i1, j1;
+	Pathfinding::NearestNavcell(center.X - r, center.Y - r, i0, j0, grid.m_W, grid.m_H);
+	Pathfinding::NearestNavcell(center.X + r, center.Y + r, i1, j1, grid.m_W, grid.m_H);
+	for (u16 j = j0+1; j < j1; ++j)
+		for (u16 i = i0+1; i < i1; ++i)
+			grid.set(i, j, grid.get(i, j) | appliedMask);
+}
+
 void CCmpObstructionManager::GetObstructionsInRange(const IObstructionTestFilter& filter, entity_pos_t x0, entity_pos_t z0, entity_pos_t x1, entity_pos_t z1, std::vector<ObstructionSquare>& squares) const
 {
 	GetUnitObstructionsInRange(filter, x0, z0, x1, z1, squares);
@@ -1223,23 +1441,20 @@ void CCmpObstructionManager::GetUnitObstructionsInRange(const IObstructionTestFi
 
 	std::vector<entity_id_t> unitShapes;
 	m_UnitSubdivision.GetInRange(unitShapes, CFixedVector2D(x0, z0), CFixedVector2D(x1, z1));
-	for (entity_id_t& unitShape : unitShapes)
+	for (const u32 index : unitShapes)
 	{
-		std::map<u32, UnitShape>::const_iterator it = m_UnitShapes.find(unitShape);
-		ENSURE(it != m_UnitShapes.end());
-
-		if (!filter.TestShape(UNIT_INDEX_TO_TAG(it->first), it->second.flags, it->second.group, INVALID_ENTITY))
+		// Skip this object if it's completely outside the requested range
+		if (!m_UnitShapes.BoundsIntersect(index, CFixedVector2D(x0, z0), CFixedVector2D(x1, z1)))
 			continue;
 
-		entity_pos_t c = it->second.clearance;
+		const UnitShape& shape = m_UnitShapes[index];
 
-		// Skip this object if it's completely outside the requested range
-		if (it->second.x + c < x0 || it->second.x - c > x1 || it->second.z + c < z0 || it->second.z - c > z1)
+		if (!filter.TestShape(UNIT_INDEX_TO_TAG(index), shape.flags, shape.group, INVALID_ENTITY))
 			continue;
 
 		CFixedVector2D u(entity_pos_t::FromInt(1), entity_pos_t::Zero());
 		CFixedVector2D v(entity_pos_t::Zero(), entity_pos_t::FromInt(1));
-		squares.emplace_back(ObstructionSquare{ it->second.x, it->second.z, u, v, c, c });
+		squares.emplace_back(ObstructionSquare{ shape.x, shape.z, u, v, shape.clearance, shape.clearance });
 	}
 }
 
@@ -1251,23 +1466,22 @@ void CCmpObstructionManager::GetStaticObstructionsInRange(const IObstructionTest
 
 	std::vector<entity_id_t> staticShapes;
 	m_StaticSubdivision.GetInRange(staticShapes, CFixedVector2D(x0, z0), CFixedVector2D(x1, z1));
-	for (entity_id_t& staticShape : staticShapes)
+	for (const u32 index : staticShapes)
 	{
-		std::map<u32, StaticShape>::const_iterator it = m_StaticShapes.find(staticShape);
-		ENSURE(it != m_StaticShapes.end());
+		const StaticShape& shape = m_StaticShapes[index];
 
-		if (!filter.TestShape(STATIC_INDEX_TO_TAG(it->first), it->second.flags, it->second.group, it->second.group2))
+		if (!filter.TestShape(STATIC_INDEX_TO_TAG(index), shape.flags, shape.group, shape.group2))
 			continue;
 
-		entity_pos_t r = it->second.hw + it->second.hh; // overestimate the max dist of an edge from the center
+		entity_pos_t r = shape.hw + shape.hh; // overestimate the max dist of an edge from the center
 
 		// Skip this object if its overestimated bounding box is completely outside the requested range
-		if (it->second.x + r < x0 || it->second.x - r > x1 || it->second.z + r < z0 || it->second.z - r > z1)
+		if (shape.x + r < x0 || shape.x - r > x1 || shape.z + r < z0 || shape.z - r > z1)
 			continue;
 
 		// TODO: maybe we should use Geometry::GetHalfBoundingBox to be more precise?
 
-		squares.emplace_back(ObstructionSquare{ it->second.x, it->second.z, it->second.u, it->second.v, it->second.hw, it->second.hh });
+		squares.emplace_back(ObstructionSquare{ shape.x, shape.z, shape.u, shape.v, shape.hw, shape.hh });
 	}
 }
 
@@ -1290,10 +1504,7 @@ void CCmpObstructionManager::GetUnitsOnObstruction(const ObstructionSquare& squa
 
 	for (const u32& unitShape : unitShapes)
 	{
-		std::map<u32, UnitShape>::const_iterator it = m_UnitShapes.find(unitShape);
-		ENSURE(it != m_UnitShapes.end());
-
-		const UnitShape& shape = it->second;
+		const UnitShape& shape = m_UnitShapes[unitShape];
 
 		if (!filter.TestShape(UNIT_INDEX_TO_TAG(unitShape), shape.flags, shape.group, INVALID_ENTITY))
 			continue;
@@ -1343,10 +1554,7 @@ void CCmpObstructionManager::GetStaticObstructionsOnObstruction(const Obstructio
 
 	for (const u32& staticShape : staticShapes)
 	{
-		std::map<u32, StaticShape>::const_iterator it = m_StaticShapes.find(staticShape);
-		ENSURE(it != m_StaticShapes.end());
-
-		const StaticShape& shape = it->second;
+		const StaticShape& shape = m_StaticShapes[staticShape];
 
 		if (!filter.TestShape(STATIC_INDEX_TO_TAG(staticShape), shape.flags, shape.group, shape.group2))
 			continue;
@@ -1387,20 +1595,18 @@ void CCmpObstructionManager::RenderSubmit(SceneCollector& collector)
 				(m_WorldX1-m_WorldX0).ToFloat(), (m_WorldZ1-m_WorldZ0).ToFloat(),
 				0, m_DebugOverlayLines.back(), true);
 
-		for (std::map<u32, UnitShape>::iterator it = m_UnitShapes.begin(); it != m_UnitShapes.end(); ++it)
-		{
+		m_UnitShapes.ForEach([&](u32, const UnitShape& shape) {
 			m_DebugOverlayLines.push_back(SOverlayLine());
-			m_DebugOverlayLines.back().m_Color = ((it->second.flags & FLAG_MOVING) ? movingColor : defaultColor);
-			SimRender::ConstructSquareOnGround(GetSimContext(), it->second.x.ToFloat(), it->second.z.ToFloat(), it->second.clearance.ToFloat(), it->second.clearance.ToFloat(), 0, m_DebugOverlayLines.back(), true);
-		}
+			m_DebugOverlayLines.back().m_Color = ((shape.flags & FLAG_MOVING) ? movingColor : defaultColor);
+			SimRender::ConstructSquareOnGround(GetSimContext(), shape.x.ToFloat(), shape.z.ToFloat(), shape.clearance.ToFloat(), shape.clearance.ToFloat(), 0, m_DebugOverlayLines.back(), true);
+		});
 
-		for (std::map<u32, StaticShape>::iterator it = m_StaticShapes.begin(); it != m_StaticShapes.end(); ++it)
-		{
+		m_StaticShapes.ForEach([&](u32, const StaticShape& shape) {
 			m_DebugOverlayLines.push_back(SOverlayLine());
 			m_DebugOverlayLines.back().m_Color = defaultColor;
-			float a = atan2f(it->second.v.X.ToFloat(), it->second.v.Y.ToFloat());
-			SimRender::ConstructSquareOnGround(GetSimContext(), it->second.x.ToFloat(), it->second.z.ToFloat(), it->second.hw.ToFloat()*2, it->second.hh.ToFloat()*2, a, m_DebugOverlayLines.back(), true);
-		}
+			float a = atan2f(shape.v.X.ToFloat(), shape.v.Y.ToFloat());
+			SimRender::ConstructSquareOnGround(GetSimContext(), shape.x.ToFloat(), shape.z.ToFloat(), shape.hw.ToFloat()*2, shape.hh.ToFloat()*2, a, m_DebugOverlayLines.back(), true);
+		});
 
 		m_DebugOverlayDirty = false;
 	}
@@ -1,4 +1,4 @@
-/* Copyright (C) 2025 Wildfire Games.
+/* Copyright (C) 2026 Wildfire Games.
  * This file is part of 0 A.D.
  *
  * 0 A.D. is free software: you can redistribute it and/or modify
@@ -40,6 +40,7 @@ public:
 	DEFAULT_COMPONENT_ALLOCATOR(Ownership)
 
 	player_id_t m_Owner;
+	u32 m_StateGeneration;
 
 	static std::string GetSchema()
 	{
@@ -52,6 +53,7 @@ public:
 	void Init(const CParamNode&) override
 	{
 		m_Owner = INVALID_PLAYER;
+		m_StateGeneration = 1;
 	}
 
 	void Deinit() override
@@ -66,6 +68,12 @@ public:
 	void Deserialize(const CParamNode&, IDeserializer& deserialize) override
 	{
 		deserialize.NumberI32_Unbounded("owner", m_Owner);
+		m_StateGeneration = 1;
+	}
+
+	u32 GetStateGeneration() const override
+	{
+		return m_StateGeneration;
 	}
 
 	void HandleMessage(const CMessage& msg, bool /*global*/) override
@@ -93,6 +101,7 @@ public:
 
 		player_id_t old = m_Owner;
 		m_Owner = playerID;
+		++m_StateGeneration;
 
 		CMessageOwnershipChanged msg(GetEntityId(), old, playerID);
 		GetSimContext().GetComponentManager().PostMessage(GetEntityId(), msg);
@@ -101,7 +110,10 @@ public:
 	void SetOwnerQuiet(player_id_t playerID) override
 	{
 		if (playerID != m_Owner)
+		{
 			m_Owner = playerID;
+			++m_StateGeneration;
+		}
 	}
 };
 
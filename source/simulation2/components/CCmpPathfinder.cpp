@@ -1,4 +1,4 @@
-/* Copyright (C) 2025 Wildfire Games.
+/* Copyright (C) 2026 Wildfire Games.
  * This file is part of 0 A.D.
  *
  * 0 A.D. is free software: you can redistribute it and/or modify
@@ -91,7 +91,7 @@ void CCmpPathfinder::Init(const CParamNode&)
 	size_t workerThreads = g_TaskManager.GetNumberOfWorkers();
 	// Store one vertex pathfinder for each thread (including the main thread).
 	while (m_VertexPathfinders.size() < workerThreads + 1)
-		m_VertexPathfinders.emplace_back(m_GridSize, m_TerrainOnlyGrid);
+		m_VertexPathfinders.emplace_back(m_GridSize, m_TerrainOnlyGrid, m_VertexPathfinderTerrainCache);
 	m_LongPathfinder = std::make_unique<LongPathfinder>();
 	m_PathfinderHier = std::make_unique<HierarchicalPathfinder>();
 
@@ -116,6 +116,13 @@ void CCmpPathfinder::Init(const CParamNode&)
 	// This loads that maximum number (note that it's per computation call, not per turn for now).
 	const CParamNode pathingSettings = externalParamNode.GetChild("Pathfinder");
 	m_MaxSameTurnMoves = (u16)pathingSettings.GetChild("MaxSameTurnMoves").ToInt();
+	// Optionally, long paths can instead be computed in the background over several turns.
+	// This must be the same for all players, so it's read from the simulation data too.
+	const CParamNode longPathDelay = pathingSettings.GetChild("LongPathDelayTurns");
+	m_LongPathDelayTurns = longPathDelay.IsOk() ? std::max(0, longPathDelay.ToInt()) : 0;
+	// Long paths can be restricted to the chunks along a route through the hierarchical
+	// pathfinder's region graph, which is much cheaper on large maps but may give slightly longer paths.
+	m_LongPathfinder->SetUseCorridors(pathingSettings.GetChild("LongPathCorridors").ToBool());
 
 	const CParamNode::ChildrenMap& passClasses = externalParamNode.GetChild("Pathfinder").GetChild("PassabilityClasses").GetChildren();
 	for (CParamNode::ChildrenMap::const_iterator it = passClasses.begin(); it != passClasses.end(); ++it)
@@ -135,6 +142,7 @@ void CCmpPathfinder::Deinit()
 	SetDebugOverlay(false); // cleans up memory
 
 	m_Futures.clear();
+	m_DeferredLongPaths.clear();
 
 	SAFE_DELETE(m_AtlasOverlay);
 
@@ -176,6 +184,18 @@ struct SerializeHelper<ShortPathRequest>
 	}
 };
 
+template<>
+struct SerializeHelper<PathResult>
+{
+	template<typename S>
+	void operator()(S& serialize, const char* /*name*/, Serialize::qualify<S, PathResult> value)
+	{
+		serialize.NumberU32_Unbounded("ticket", value.ticket);
+		serialize.NumberU32_Unbounded("notify", value.notify);
+		Serializer(serialize, "waypoints", value.path.m_Waypoints);
+	}
+};
+
 template<typename S>
 void CCmpPathfinder::SerializeCommon(S& serialize)
 {
@@ -188,6 +208,20 @@ void CCmpPathfinder::SerializeCommon(S& serialize)
 void CCmpPathfinder::Serialize(ISerializer& serialize)
 {
 	SerializeCommon(serialize);
+
+	serialize.NumberU32_Unbounded("long path delay turns", m_LongPathDelayTurns);
+	if (!m_LongPathDelayTurns)
+		return;
+
+	// The results of deferred paths depend on the grid at the time they were scheduled,
+	// so store them instead of recomputing them after deserialization.
+	WaitForDeferredLongPaths();
+	serialize.NumberU32_Unbounded("deferred batches", static_cast<u32>(m_DeferredLongPaths.size()));
+	for (DeferredLongPaths& batch : m_DeferredLongPaths)
+	{
+		serialize.NumberU32_Unbounded("turns left", batch.m_TurnsLeft);
+		Serializer(serialize, "results", batch.m_Paths.m_Results);
+	}
 }
 
 void CCmpPathfinder::Deserialize(const CParamNode& paramNode, IDeserializer& deserialize)
@@ -195,6 +229,20 @@ void CCmpPathfinder::Deserialize(const CParamNode& paramNode, IDeserializer& des
 	Init(paramNode);
 
 	SerializeCommon(deserialize);
+
+	// The pending batches must be delivered with the delay they were scheduled with.
+	deserialize.NumberU32_Unbounded("long path delay turns", m_LongPathDelayTurns);
+	if (!m_LongPathDelayTurns)
+		return;
+
+	u32 batches;
+	deserialize.NumberU32_Unbounded("deferred batches", batches);
+	for (u32 i = 0; i < batches; ++i)
+	{
+		DeferredLongPaths& batch = m_DeferredLongPaths.emplace_back();
+		deserialize.NumberU32_Unbounded("turns left", batch.m_TurnsLeft);
+		Serializer(deserialize, "results", batch.m_Paths.m_Results);
+	}
 }
 
 void CCmpPathfinder::HandleMessage(const CMessage& msg, bool /*global*/)
@@ -222,10 +270,12 @@ void CCmpPathfinder::HandleMessage(const CMessage& msg, bool /*global*/)
 	case MT_Deserialized:
 		UpdateGrid();
 		// In case we were serialised with requests pending, we need to process them.
-		if (!m_ShortPathRequests.m_Requests.empty() || !m_LongPathRequests.m_Requests.empty())
+		// Deferred long paths were serialized with their results, and the pending long
+		// requests will only be deferred at the end of the turn.
+		if (!m_ShortPathRequests.m_Requests.empty() || (!m_LongPathDelayTurns && !m_LongPathRequests.m_Requests.empty()))
 		{
 			ENSURE(CmpPtr<ICmpObstructionManager>(GetSystemEntity()));
-			StartProcessingMoves(false);
+			StartComputingPaths(false);
 		}
 		break;
 	}
@@ -522,6 +572,7 @@ void CCmpPathfinder::UpdateGrid()
 	// If the terrain was resized then delete the old grid data
 	if (m_Grid && m_GridSize != gridSize)
 	{
+		WaitForDeferredLongPaths();
 		SAFE_DELETE(m_Grid);
 		SAFE_DELETE(m_TerrainOnlyGrid);
 	}
@@ -553,6 +604,9 @@ void CCmpPathfinder::UpdateGrid()
 	if (!m_DirtinessInformation.dirty && !m_TerrainDirty)
 		return;
 
+	// Background long paths must see the grid they were scheduled with.
+	WaitForDeferredLongPaths();
+
 	// If the terrain has changed, recompute m_Grid
 	// Else, use data from m_TerrainOnlyGrid and add obstructions
 	if (m_TerrainDirty)
@@ -573,10 +627,18 @@ void CCmpPathfinder::UpdateGrid()
 	{
 		ENSURE(m_Grid->compare_sizes(m_TerrainOnlyGrid));
 
-		for (u16 j = 0; j < m_DirtinessInformation.dirtinessGrid.m_H; ++j)
-			for (u16 i = 0; i < m_DirtinessInformation.dirtinessGrid.m_W; ++i)
-				if (m_DirtinessInformation.dirtinessGrid.get(i, j) == 1)
-					m_Grid->set(i, j, m_TerrainOnlyGrid->get(i, j));
+		// Restore the terrain passability of each run of dirty navcells, obstructions
+		// are rasterized again on top below.
+		const Grid<u8>& dirtinessGrid = m_DirtinessInformation.dirtinessGrid;
+		const u8* const dirtyBegin = dirtinessGrid.m_Data;
+		const u8* const dirtyEnd = dirtyBegin + dirtinessGrid.m_W * dirtinessGrid.m_H;
+		const u8* runBegin = std::find(dirtyBegin, dirtyEnd, 1);
+		while (runBegin != dirtyEnd)
+		{
+			const u8* runEnd = std::find(runBegin, dirtyEnd, 0);
+			std::copy(m_TerrainOnlyGrid->m_Data + (runBegin - dirtyBegin), m_TerrainOnlyGrid->m_Data + (runEnd - dirtyBegin), m_Grid->m_Data + (runBegin - dirtyBegin));
+			runBegin = std::find(runEnd, dirtyEnd, 1);
+		}
 	}
 
 	// Add obstructions onto the grid
@@ -592,7 +654,7 @@ void CCmpPathfinder::UpdateGrid()
 	}
 	else
 	{
-		m_LongPathfinder->Update(m_Grid);
+		m_LongPathfinder->Update(m_Grid, m_DirtinessInformation.dirtinessGrid);
 		m_PathfinderHier->Update(m_Grid, m_DirtinessInformation.dirtinessGrid);
 	}
 
@@ -621,6 +683,9 @@ void CCmpPathfinder::TerrainUpdateHelper(bool expandPassability, int itile0, int
 	if (gridSize == 0)
 		return;
 
+	// The terrain-only grid is about to change.
+	m_VertexPathfinderTerrainCache.Clear();
+
 	const bool needsNewTerrainGrid = !m_TerrainOnlyGrid || m_GridSize != gridSize;
 	if (needsNewTerrainGrid)
 	{
@@ -831,6 +896,21 @@ void CCmpPathfinder::SendRequestedPaths()
 		if (future.Valid())
 			future.Get();
 
+	// Batches which are due are sent at the start of the turn, even if they were done earlier.
+	// Later batches can't be due before earlier ones, so this only needs to check the front.
+	size_t dueBatches = 0;
+	for (DeferredLongPaths& batch : m_DeferredLongPaths)
+	{
+		if (batch.m_TurnsLeft)
+			break;
+		if (!batch.m_Paths.m_ComputeDone)
+			batch.m_Paths.Compute(*this, *m_LongPathfinder);
+		for (Future<void>& future : batch.m_Futures)
+			if (future.Valid())
+				future.Get();
+		++dueBatches;
+	}
+
 	{
 		PROFILE2("PostMessages");
 		for (PathResult& path : m_ShortPathRequests.m_Results)
@@ -844,18 +924,38 @@ void CCmpPathfinder::SendRequestedPaths()
 			CMessagePathResult msg(path.ticket, path.path);
 			GetSimContext().GetComponentManager().PostMessage(path.notify, msg);
 		}
+
+		for (size_t i = 0; i < dueBatches; ++i)
+			for (PathResult& path : m_DeferredLongPaths[i].m_Paths.m_Results)
+			{
+				CMessagePathResult msg(path.ticket, path.path);
+				GetSimContext().GetComponentManager().PostMessage(path.notify, msg);
+			}
 	}
 	m_ShortPathRequests.ClearComputed();
 	m_LongPathRequests.ClearComputed();
+	for (size_t i = 0; i < dueBatches; ++i)
+		m_DeferredLongPaths.pop_front();
 }
 
 void CCmpPathfinder::StartProcessingMoves(bool useMax)
+{
+	// This is the last call of the turn, so it ages the deferred batches.
+	if (!useMax && m_LongPathDelayTurns)
+		DeferLongPathRequests();
+
+	StartComputingPaths(useMax);
+}
+
+void CCmpPathfinder::StartComputingPaths(bool useMax)
 {
 	m_ShortPathRequests.PrepareForComputation(useMax ? m_MaxSameTurnMoves : 0);
-	m_LongPathRequests.PrepareForComputation(useMax ? m_MaxSameTurnMoves : 0);
+	// Deferred long requests are only computed in their batch.
+	if (!m_LongPathDelayTurns)
+		m_LongPathRequests.PrepareForComputation(useMax ? m_MaxSameTurnMoves : 0);
 
 	// There's some overhead to waking threads, so don't do it unless we need to.
-	const size_t m = std::min(m_Futures.size(), m_ShortPathRequests.m_Requests.size() + m_LongPathRequests.m_Requests.size());
+	const size_t m = std::min(m_Futures.size(), m_ShortPathRequests.m_Results.size() + m_LongPathRequests.m_Results.size());
 	for (size_t i = 0; i < m; ++i)
 	{
 		ENSURE(!m_Futures[i].Valid());
@@ -871,6 +971,49 @@ void CCmpPathfinder::StartProcessingMoves(bool useMax)
 	}
 }
 
+void CCmpPathfinder::DeferLongPathRequests()
+{
+	for (DeferredLongPaths& batch : m_DeferredLongPaths)
+		if (batch.m_TurnsLeft)
+			--batch.m_TurnsLeft;
+
+	if (m_LongPathRequests.m_Requests.empty())
+		return;
+
+	DeferredLongPaths& batch = m_DeferredLongPaths.emplace_back();
+	batch.m_TurnsLeft = m_LongPathDelayTurns - 1;
+	batch.m_Paths.m_Requests.swap(m_LongPathRequests.m_Requests);
+	batch.m_Paths.PrepareForComputation(0);
+
+	// Use a low priority, the requests of the current turn are more urgent.
+	const size_t m = std::min(m_Futures.size(), batch.m_Paths.m_Requests.size());
+	batch.m_Futures.reserve(m);
+	for (size_t i = 0; i < m; ++i)
+		batch.m_Futures.emplace_back(g_TaskManager,
+			[&pathfinder=*this, &paths=batch.m_Paths]()
+			{
+				PROFILE2("Deferred pathfinding");
+				paths.Compute(pathfinder, *pathfinder.m_LongPathfinder);
+			}, Threading::TaskPriority::LOW);
+}
+
+void CCmpPathfinder::WaitForDeferredLongPaths()
+{
+	if (m_DeferredLongPaths.empty())
+		return;
+
+	PROFILE2("WaitForDeferredLongPaths");
+	for (DeferredLongPaths& batch : m_DeferredLongPaths)
+	{
+		if (!batch.m_Paths.m_ComputeDone)
+			batch.m_Paths.Compute(*this, *m_LongPathfinder);
+		for (Future<void>& future : batch.m_Futures)
+			if (future.Valid())
+				future.Get();
+		batch.m_Futures.clear();
+	}
+}
+
 
 //////////////////////////////////////////////////////////
 
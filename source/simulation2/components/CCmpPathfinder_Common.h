@@ -1,4 +1,4 @@
-/* Copyright (C) 2025 Wildfire Games.
+/* Copyright (C) 2026 Wildfire Games.
  * This file is part of 0 A.D.
  *
  * 0 A.D. is free software: you can redistribute it and/or modify
@@ -46,6 +46,7 @@
 
 #include <atomic>
 #include <cstddef>
+#include <deque>
 #include <map>
 #include <memory>
 #include <string>
@@ -84,6 +85,9 @@ public:
 	std::map<std::string, pass_class_t> m_PassClassMasks;
 	std::vector<PathfinderPassability> m_PassClasses;
 	u16 m_MaxSameTurnMoves; // Compute only this many paths when useMax is true in StartProcessingMoves.
+	// If non-zero, long paths requested during turn N are computed in the background
+	// and delivered at the start of turn N + m_LongPathDelayTurns.
+	u32 m_LongPathDelayTurns;
 
 	// Dynamic state:
 
@@ -100,6 +104,7 @@ public:
 	GridUpdateInformation m_AIPathfinderDirtinessInformation;
 	bool m_TerrainDirty;
 
+	VertexPathfinderTerrainCache m_VertexPathfinderTerrainCache;
 	std::vector<VertexPathfinder> m_VertexPathfinders;
 	std::unique_ptr<HierarchicalPathfinder> m_PathfinderHier;
 	std::unique_ptr<LongPathfinder> m_LongPathfinder;
@@ -145,6 +150,23 @@ public:
 	PathRequests<LongPathRequest> m_LongPathRequests;
 	PathRequests<ShortPathRequest> m_ShortPathRequests;
 
+	/**
+	 * A batch of long path requests, scheduled at the end of a turn when m_LongPathDelayTurns
+	 * is set, which is computed in the background over the following turns.
+	 * Its results only depend on the state of the grid when it was scheduled (UpdateGrid
+	 * waits for pending batches before changing it), and they are sent at the start of
+	 * a fixed turn no matter how early they were finished, which keeps them deterministic.
+	 */
+	struct DeferredLongPaths
+	{
+		PathRequests<LongPathRequest> m_Paths;
+		// Number of turn ends before the results are sent.
+		u32 m_TurnsLeft = 0;
+		std::vector<Future<void>> m_Futures;
+	};
+	// Pending batches, oldest first. A deque keeps the batches in place for the async tasks.
+	std::deque<DeferredLongPaths> m_DeferredLongPaths;
+
 	u32 m_NextAsyncTicket; // Unique IDs for asynchronous path requests.
 
 	AtlasOverlay* m_AtlasOverlay;
@@ -244,12 +266,30 @@ public:
 
 	void StartProcessingMoves(bool useMax) override;
 
+	/**
+	 * Starts computing the pending requests on the worker threads,
+	 * without the end of turn bookkeeping of StartProcessingMoves.
+	 */
+	void StartComputingPaths(bool useMax);
+
 	template <typename T>
 	std::vector<T> GetMovesToProcess(std::vector<T>& requests, bool useMax = false, size_t maxMoves = 0);
 
 	template <typename T>
 	void PushRequestsToWorkers(std::vector<T>& from);
 
+	/**
+	 * Moves the long path requests of this turn into a new deferred batch
+	 * and starts computing it in the background.
+	 */
+	void DeferLongPathRequests();
+
+	/**
+	 * Finishes computing every deferred batch, on the main thread if need be.
+	 * Must be called before anything the long-range pathfinder depends on changes.
+	 */
+	void WaitForDeferredLongPaths();
+
 	/**
 	 * Regenerates the grid based on the current obstruction list, if necessary
 	 */
@@ -1,4 +1,4 @@
-/* Copyright (C) 2025 Wildfire Games.
+/* Copyright (C) 2026 Wildfire Games.
  * This file is part of 0 A.D.
  *
  * 0 A.D. is free software: you can redistribute it and/or modify
@@ -65,6 +65,7 @@
 #include <array>
 #include <cstdint>
 #include <cstdlib>
+#include <cstring>
 #include <iterator>
 #include <limits>
 #include <map>
@@ -84,6 +85,20 @@ namespace
  */
 constexpr int LOS_REGION_RATIO = 8;
 
+/**
+ * LOS counts are updated four at a time, as the u16 lanes of a 64-bit word.
+ */
+constexpr u64 LOS_COUNT_LANES_ONE = 0x0001000100010001ull;
+constexpr u64 LOS_COUNT_LANES_HIGH = 0x8000800080008000ull;
+
+/**
+ * Returns whether any of the four u16 lanes of @p lanes is zero.
+ */
+constexpr bool HasZeroLane(u64 lanes)
+{
+	return ((lanes - LOS_COUNT_LANES_ONE) & ~lanes & LOS_COUNT_LANES_HIGH) != 0;
+}
+
 /**
  * Tolerance for parabolic range calculations.
  * TODO C++20: change this to constexpr by fixing CFixed with std::is_constant_evaluated
@@ -195,6 +210,10 @@ struct Query
 	bool enabled;
 	bool parabolic;
 	bool accountForSize; // If true, the query accounts for unit sizes, otherwise it treats all entities as points.
+
+	// Not serialized, used to update active queries incrementally:
+	u32 generation = 0; // the subdivision generation of lastMatch, or 0 if unknown
+	CFixedVector2D lastPosition; // the source position of lastMatch
 };
 
 /**
@@ -277,6 +296,86 @@ struct EntityData
 
 static_assert(sizeof(EntityData) == 24);
 
+/**
+ * Structure-of-arrays copy of the EntityData fields that range queries filter on,
+ * indexed by entity ID (like EntityMap, so there is no lookup).
+ * Queries test many more entities than they return, so this keeps the tested data
+ * dense, and the tests branch-free so that they can be vectorized.
+ * Untracked IDs have an empty owner mask, so they never match.
+ */
+struct EntityQueryData
+{
+	std::vector<entity_pos_t> x, z;
+	std::vector<u32> size;
+	std::vector<u32> ownerMask; // CalcOwnerMask(owner)
+	std::vector<u8> queryFlags; // the FlagMasks::AllQuery flags, or 0 if not in world
+
+	void Set(entity_id_t id, const EntityData& data)
+	{
+		if (id >= ownerMask.size())
+		{
+			// Grow like EntityMap does, entity IDs are mostly allocated in order.
+			const size_t newSize = (id / 4096 + 1) * 4096;
+			x.resize(newSize);
+			z.resize(newSize);
+			size.resize(newSize);
+			ownerMask.resize(newSize);
+			queryFlags.resize(newSize);
+		}
+		x[id] = data.x;
+		z[id] = data.z;
+		size[id] = data.size;
+		ownerMask[id] = CalcOwnerMask(data.owner);
+		queryFlags[id] = data.HasFlag<FlagMasks::InWorld>() ? (data.flags & FlagMasks::AllQuery) : 0;
+	}
+
+	void Remove(entity_id_t id)
+	{
+		if (id >= ownerMask.size())
+			return;
+		ownerMask[id] = 0;
+		queryFlags[id] = 0;
+	}
+
+	void Reset(const EntityMap<EntityData>& entities)
+	{
+		std::fill(ownerMask.begin(), ownerMask.end(), 0);
+		std::fill(queryFlags.begin(), queryFlags.end(), 0);
+		for (EntityMap<EntityData>::const_iterator it = entities.begin(); it != entities.end(); ++it)
+			Set(it->first, it->second);
+	}
+
+	/**
+	 * Keeps in @p ids (in the same order) only the entities with a matching owner
+	 * and flags that are in the world, and aren't @p source.
+	 */
+	void Filter(std::vector<entity_id_t>& ids, u32 ownersMask, u8 flagsMask, entity_id_t source) const
+	{
+		size_t count = 0;
+		for (entity_id_t id : ids)
+		{
+			ids[count] = id;
+			count += ((ownerMask[id] & ownersMask) != 0) & ((queryFlags[id] & flagsMask) != 0) & (id != source);
+		}
+		ids.resize(count);
+	}
+
+	/**
+	 * Same as Filter, but appends every matching entity to @p ids.
+	 */
+	void FilterAll(std::vector<entity_id_t>& ids, u32 ownersMask, u8 flagsMask, entity_id_t source) const
+	{
+		size_t count = ids.size();
+		ids.resize(count + ownerMask.size());
+		for (entity_id_t id = 0; id < ownerMask.size(); ++id)
+		{
+			ids[count] = id;
+			count += ((ownerMask[id] & ownersMask) != 0) & ((queryFlags[id] & flagsMask) != 0) & (id != source);
+		}
+		ids.resize(count);
+	}
+};
+
 /**
  * Functor for sorting entities by distance from a source point.
  * It must only be passed entities that are in 'entities'
@@ -385,12 +484,12 @@ public:
 	static void ClassInit(CComponentManager& componentManager)
 	{
 		componentManager.SubscribeGloballyToMessageType(MT_Create);
-		componentManager.SubscribeGloballyToMessageType(MT_PositionChanged);
 		componentManager.SubscribeGloballyToMessageType(MT_OwnershipChanged);
 		componentManager.SubscribeGloballyToMessageType(MT_Destroy);
 		componentManager.SubscribeGloballyToMessageType(MT_VisionRangeChanged);
 		componentManager.SubscribeGloballyToMessageType(MT_VisionSharingChanged);
 
+		componentManager.SubscribeToMessageType(MT_PositionsChanged);
 		componentManager.SubscribeToMessageType(MT_Deserialized);
 		componentManager.SubscribeToMessageType(MT_Update);
 		componentManager.SubscribeToMessageType(MT_RenderSubmit); // for debug overlays
@@ -416,6 +515,12 @@ public:
 	tag_t m_QueryNext; // next allocated id
 	std::map<tag_t, Query> m_Queries;
 	EntityMap<EntityData> m_EntityData;
+	EntityQueryData m_QueryData; // kept in sync with m_EntityData, not serialized
+
+	// While executing the active queries, bitsets (indexed by entity ID) of the
+	// interfaces required by those queries, to avoid a QueryInterface per entity tested.
+	std::vector<u32> m_QueryInterfaces;
+	std::vector<int> m_QueryInterfaceIds; // the interface of each bit
 
 	using RangeUpdateMessage = std::pair<entity_id_t, CMessageRangeUpdate>;
 
@@ -440,6 +545,9 @@ public:
 	bool m_GlobalVisibilityUpdate;
 	std::array<bool, MAX_LOS_PLAYER_ID> m_GlobalPlayerVisibilityUpdate;
 	Grid<u16> m_DirtyVisibility;
+	// Regions with a non-zero m_DirtyVisibility mask (not serialized). Regions marked again while their
+	// own visibility is updated can be listed several times, or with a zero mask.
+	std::vector<LosRegion> m_DirtyVisibilityRegions;
 	Grid<std::set<entity_id_t>> m_LosRegions;
 	// List of entities that must be updated, regardless of the status of their tile
 	std::vector<entity_id_t> m_ModifiedEntities;
@@ -467,6 +575,19 @@ public:
 	u32 m_TotalInworldVertices;
 	std::vector<u32> m_ExploredVertices;
 
+	// LOS updates made while handling a batch of position changes, per player in the order they were made.
+	// They are applied once the batch is handled (not serialized).
+	struct LosUpdate
+	{
+		enum class Type : u8 { ADD, REMOVE, MOVE };
+		Type type;
+		entity_pos_t visionRange;
+		CFixedVector2D from;
+		CFixedVector2D to;
+	};
+	std::array<std::vector<LosUpdate>, MAX_LOS_PLAYER_ID+1> m_PendingLosUpdates;
+	bool m_BatchingLosUpdates;
+
 	static std::string GetSchema()
 	{
 		return "<a:component type='system'/><empty/>";
@@ -480,6 +601,7 @@ public:
 		m_DebugOverlayDirty = true;
 
 		m_Deserializing = false;
+		m_BatchingLosUpdates = false;
 		m_WorldX0 = m_WorldZ0 = m_WorldX1 = m_WorldZ1 = entity_pos_t::Zero();
 
 		// Initialise with bogus values (these will get replaced when
@@ -545,6 +667,8 @@ public:
 		Init(paramNode);
 
 		SerializeCommon(deserialize);
+
+		m_QueryData.Reset(m_EntityData);
 	}
 
 	void HandleMessage(const CMessage& msg, bool /*global*/) override
@@ -597,73 +721,18 @@ public:
 
 			// Remember this entity
 			m_EntityData.insert(ent, entdata);
+			m_QueryData.Set(ent, entdata);
 			break;
 		}
-		case MT_PositionChanged:
+		case MT_PositionsChanged:
 		{
-			const CMessagePositionChanged& msgData = static_cast<const CMessagePositionChanged&> (msg);
-			entity_id_t ent = msgData.entity;
-
-			EntityMap<EntityData>::iterator it = m_EntityData.find(ent);
-
-			// Ignore if we're not already tracking this entity
-			if (it == m_EntityData.end())
-				break;
-
-			if (msgData.inWorld)
-			{
-				if (it->second.HasFlag<FlagMasks::InWorld>())
-				{
-					CFixedVector2D from(it->second.x, it->second.z);
-					CFixedVector2D to(msgData.x, msgData.z);
-					m_Subdivision.Move(ent, from, to, it->second.size);
-					if (it->second.HasFlag<FlagMasks::SharedVision>())
-						SharingLosMove(it->second.visionSharing, it->second.visionRange, from, to);
-					else
-						LosMove(it->second.owner, it->second.visionRange, from, to);
-					LosRegion oldLosRegion = PosToLosRegionsHelper(it->second.x, it->second.z);
-					LosRegion newLosRegion = PosToLosRegionsHelper(msgData.x, msgData.z);
-					if (oldLosRegion != newLosRegion)
-					{
-						RemoveFromRegion(oldLosRegion, ent);
-						AddToRegion(newLosRegion, ent);
-					}
-				}
-				else
-				{
-					CFixedVector2D to(msgData.x, msgData.z);
-					m_Subdivision.Add(ent, to, it->second.size);
-					if (it->second.HasFlag<FlagMasks::SharedVision>())
-						SharingLosAdd(it->second.visionSharing, it->second.visionRange, to);
-					else
-						LosAdd(it->second.owner, it->second.visionRange, to);
-					AddToRegion(PosToLosRegionsHelper(msgData.x, msgData.z), ent);
-				}
-
-				it->second.SetFlag<FlagMasks::InWorld>(true);
-				it->second.x = msgData.x;
-				it->second.z = msgData.z;
-			}
-			else
-			{
-				if (it->second.HasFlag<FlagMasks::InWorld>())
-				{
-					CFixedVector2D from(it->second.x, it->second.z);
-					m_Subdivision.Remove(ent, from, it->second.size);
-					if (it->second.HasFlag<FlagMasks::SharedVision>())
-						SharingLosRemove(it->second.visionSharing, it->second.visionRange, from);
-					else
-						LosRemove(it->second.owner, it->second.visionRange, from);
-					RemoveFromRegion(PosToLosRegionsHelper(it->second.x, it->second.z), ent);
-				}
-
-				it->second.SetFlag<FlagMasks::InWorld>(false);
-				it->second.x = entity_pos_t::Zero();
-				it->second.z = entity_pos_t::Zero();
-			}
-
-			RequestVisibilityUpdate(ent);
-
+			const CMessagePositionsChanged& msgData = static_cast<const CMessagePositionsChanged&> (msg);
+			// Apply the LOS updates of the whole batch per player, nothing reads the LOS in between.
+			m_BatchingLosUpdates = true;
+			for (const CMessagePositionsChanged::Change& change : msgData.changes)
+				PositionChanged(change.entity, change.inWorld, change.x, change.z);
+			m_BatchingLosUpdates = false;
+			FlushLosUpdates();
 			break;
 		}
 		case MT_OwnershipChanged:
@@ -697,6 +766,9 @@ public:
 
 			ENSURE(-128 <= msgData.to && msgData.to <= 127);
 			it->second.owner = (i8)msgData.to;
+			m_QueryData.Set(ent, it->second);
+			if (it->second.HasFlag<FlagMasks::InWorld>())
+				m_Subdivision.MarkChanged(CFixedVector2D(it->second.x, it->second.z), it->second.size);
 
 			break;
 		}
@@ -722,6 +794,7 @@ public:
 			ENSURE(it->second.owner == -1);
 
 			m_EntityData.erase(it);
+			m_QueryData.Remove(ent);
 
 			break;
 		}
@@ -820,6 +893,70 @@ public:
 		}
 	}
 
+	void PositionChanged(entity_id_t ent, bool inWorld, entity_pos_t x, entity_pos_t z)
+	{
+		EntityMap<EntityData>::iterator it = m_EntityData.find(ent);
+
+		// Ignore if we're not already tracking this entity
+		if (it == m_EntityData.end())
+			return;
+
+		if (inWorld)
+		{
+			if (it->second.HasFlag<FlagMasks::InWorld>())
+			{
+				CFixedVector2D from(it->second.x, it->second.z);
+				CFixedVector2D to(x, z);
+				m_Subdivision.Move(ent, from, to, it->second.size);
+				if (it->second.HasFlag<FlagMasks::SharedVision>())
+					SharingLosMove(it->second.visionSharing, it->second.visionRange, from, to);
+				else
+					LosMove(it->second.owner, it->second.visionRange, from, to);
+				LosRegion oldLosRegion = PosToLosRegionsHelper(it->second.x, it->second.z);
+				LosRegion newLosRegion = PosToLosRegionsHelper(x, z);
+				if (oldLosRegion != newLosRegion)
+				{
+					RemoveFromRegion(oldLosRegion, ent);
+					AddToRegion(newLosRegion, ent);
+				}
+			}
+			else
+			{
+				CFixedVector2D to(x, z);
+				m_Subdivision.Add(ent, to, it->second.size);
+				if (it->second.HasFlag<FlagMasks::SharedVision>())
+					SharingLosAdd(it->second.visionSharing, it->second.visionRange, to);
+				else
+					LosAdd(it->second.owner, it->second.visionRange, to);
+				AddToRegion(PosToLosRegionsHelper(x, z), ent);
+			}
+
+			it->second.SetFlag<FlagMasks::InWorld>(true);
+			it->second.x = x;
+			it->second.z = z;
+		}
+		else
+		{
+			if (it->second.HasFlag<FlagMasks::InWorld>())
+			{
+				CFixedVector2D from(it->second.x, it->second.z);
+				m_Subdivision.Remove(ent, from, it->second.size);
+				if (it->second.HasFlag<FlagMasks::SharedVision>())
+					SharingLosRemove(it->second.visionSharing, it->second.visionRange, from);
+				else
+					LosRemove(it->second.owner, it->second.visionRange, from);
+				RemoveFromRegion(PosToLosRegionsHelper(it->second.x, it->second.z), ent);
+			}
+
+			it->second.SetFlag<FlagMasks::InWorld>(false);
+			it->second.x = entity_pos_t::Zero();
+			it->second.z = entity_pos_t::Zero();
+		}
+		m_QueryData.Set(ent, it->second);
+
+		RequestVisibilityUpdate(ent);
+	}
+
 	void SetBounds(entity_pos_t x0, entity_pos_t z0, entity_pos_t x1, entity_pos_t z1) override
 	{
 		// Don't support rectangular looking maps.
@@ -839,6 +976,22 @@ public:
 		if (m_WorldX1.IsZero())
 			return;
 
+		// Check that the incremental updates of the active queries give the full results.
+		for (const std::pair<const tag_t, Query>& query : m_Queries)
+		{
+			CmpPtr<ICmpPosition> cmpSourcePosition(query.second.source);
+			if (!query.second.enabled || !cmpSourcePosition || !cmpSourcePosition->IsInWorld() ||
+			    !CanUpdateQueryIncrementally(query.second, cmpSourcePosition->GetPosition2D()))
+				continue;
+
+			std::vector<entity_id_t> incremental, full;
+			if (!UpdateQueryIncrementally(query.second, incremental, cmpSourcePosition->GetPosition2D(), m_SubdivisionResultBuffers[0], 0))
+				incremental = query.second.lastMatch;
+			PerformQuery(query.second, full, cmpSourcePosition->GetPosition2D(), m_SubdivisionResultBuffers[0]);
+			if (incremental != full)
+				debug_warn(L"inconsistent incremental query");
+		}
+
 		// Check that calling ResetDerivedData (i.e. recomputing all the state from scratch)
 		// does not affect the incrementally-computed state
 
@@ -881,6 +1034,18 @@ public:
 			debug_warn(L"inconsistent subdivs");
 		if (oldLosRegions != m_LosRegions)
 			debug_warn(L"inconsistent los regions");
+
+		EntityQueryData queryData;
+		queryData.Reset(m_EntityData);
+		for (EntityMap<EntityData>::const_iterator it = m_EntityData.begin(); it != m_EntityData.end(); ++it)
+			if (queryData.ownerMask[it->first] != m_QueryData.ownerMask[it->first] ||
+			    queryData.queryFlags[it->first] != m_QueryData.queryFlags[it->first] ||
+			    queryData.x[it->first] != m_QueryData.x[it->first] ||
+			    queryData.z[it->first] != m_QueryData.z[it->first])
+				debug_warn(L"inconsistent query data");
+		if (static_cast<size_t>(std::count_if(m_QueryData.queryFlags.begin(), m_QueryData.queryFlags.end(), [](u8 flags) { return flags != 0; })) !=
+		    static_cast<size_t>(std::count_if(queryData.queryFlags.begin(), queryData.queryFlags.end(), [](u8 flags) { return flags != 0; })))
+			debug_warn(L"inconsistent query data");
 	}
 
 	FastSpatialSubdivision* GetSubdivision() override
@@ -922,6 +1087,12 @@ public:
 		ENSURE(m_DirtyVisibility.width() == m_LosRegionsPerSide);
 		ENSURE(m_DirtyVisibility.height() == m_LosRegionsPerSide);
 
+		m_DirtyVisibilityRegions.clear();
+		for (u16 i = 0; i < m_LosRegionsPerSide; ++i)
+			for (u16 j = 0; j < m_LosRegionsPerSide; ++j)
+				if (m_DirtyVisibility[LosRegion{i, j}])
+					m_DirtyVisibilityRegions.emplace_back(i, j);
+
 		m_LosRegions.resize(m_LosRegionsPerSide, m_LosRegionsPerSide);
 
 		for (EntityMap<EntityData>::const_iterator it = m_EntityData.begin(); it != m_EntityData.end(); ++it)
@@ -1091,6 +1262,7 @@ public:
 		{
 			// If the source doesn't have a position, then the result is just the empty list
 			q.lastMatch = r;
+			q.generation = 0;
 			return r;
 		}
 
@@ -1098,6 +1270,7 @@ public:
 		PerformQuery(q, r, pos, m_SubdivisionResultBuffers[0]);
 
 		q.lastMatch = r;
+		q.generation = 0;
 
 		// Return the list sorted by distance from the entity
 		std::stable_sort(r.begin(), r.end(), EntityDistanceOrdering(m_EntityData, pos));
@@ -1149,6 +1322,12 @@ public:
 	{
 		PROFILE3("ExecuteActiveQueries");
 
+		// The components can't change while the queries run, so look up the interfaces once.
+		UpdateQueryInterfaces();
+
+		// The queries see every change to the subdivision up to this generation.
+		const u32 generation = m_Subdivision.NextGeneration();
+
 		std::mutex mtx;
 
 		// Points to the first unexecuted query (to be processed next).
@@ -1196,9 +1375,22 @@ public:
 					CmpPtr<ICmpPosition> cmpSourcePosition(query.source);
 					if (cmpSourcePosition && cmpSourcePosition->IsInWorld())
 					{
+						const CFixedVector2D pos = cmpSourcePosition->GetPosition2D();
+						const u32 interfaceMask = GetQueryInterfaceMask(query);
 						results.reserve(query.lastMatch.size());
-						PerformQuery(query, results, cmpSourcePosition->GetPosition2D(), subdivisionResultsBuffer);
+						if (!CanUpdateQueryIncrementally(query, pos))
+							PerformQuery(query, results, pos, subdivisionResultsBuffer, interfaceMask);
+						else if (!UpdateQueryIncrementally(query, results, pos, subdivisionResultsBuffer, interfaceMask))
+						{
+							// Nothing changed near the query, so neither did its result.
+							query.generation = generation;
+							continue;
+						}
+						query.generation = generation;
+						query.lastPosition = pos;
 					}
+					else
+						query.generation = 0;
 
 					// Compute the changes vs the last match
 					added.clear();
@@ -1247,49 +1439,120 @@ public:
 	}
 
 	/**
-	 * Returns whether the given entity matches the given query (ignoring maxRange)
+	 * Returns whether the given entity, which passed EntityQueryData::Filter, has the interface
+	 * required by the query. @p interfaceMask is the bit of that interface in m_QueryInterfaces,
+	 * or 0 to query the component manager.
 	 */
-	bool TestEntityQuery(const Query& q, entity_id_t id, const EntityData& entity) const
+	bool TestEntityInterface(const Query& q, entity_id_t id, u32 interfaceMask) const
 	{
-		// Quick filter to ignore entities with the wrong owner
-		if (!(CalcOwnerMask(entity.owner) & q.ownersMask))
-			return false;
+		if (!q.interface)
+			return true;
 
-		// Ignore entities not present in the world
-		if (!entity.HasFlag<FlagMasks::InWorld>())
-			return false;
+		if (interfaceMask)
+			return (m_QueryInterfaces[id] & interfaceMask) != 0;
 
-		// Ignore entities that don't match the current flags
-		if (!((entity.flags & FlagMasks::AllQuery) & q.flagsMask))
-			return false;
+		return GetSimContext().GetComponentManager().QueryInterface(id, q.interface);
+	}
 
-		// Ignore self
-		if (id == q.source.GetId())
-			return false;
+	/**
+	 * Fills m_QueryInterfaces with the interfaces required by the enabled active queries.
+	 */
+	void UpdateQueryInterfaces()
+	{
+		PROFILE2("UpdateQueryInterfaces");
+
+		m_QueryInterfaceIds.clear();
+		for (const std::pair<const tag_t, Query>& query : m_Queries)
+			if (query.second.enabled && query.second.interface &&
+			    std::find(m_QueryInterfaceIds.begin(), m_QueryInterfaceIds.end(), query.second.interface) == m_QueryInterfaceIds.end() &&
+			    m_QueryInterfaceIds.size() < 32)
+				m_QueryInterfaceIds.push_back(query.second.interface);
+
+		m_QueryInterfaces.assign(m_QueryData.ownerMask.size(), 0);
+		const CComponentManager& componentManager = GetSimContext().GetComponentManager();
+		for (size_t i = 0; i < m_QueryInterfaceIds.size(); ++i)
+			for (const std::pair<const entity_id_t, IComponent*>& entity : componentManager.GetEntitiesWithInterfaceUnordered(m_QueryInterfaceIds[i]))
+				if (entity.first < m_QueryInterfaces.size())
+					m_QueryInterfaces[entity.first] |= 1u << i;
+	}
+
+	/**
+	 * Returns the bit of the interface of @p q in m_QueryInterfaces, or 0 if it isn't there.
+	 */
+	u32 GetQueryInterfaceMask(const Query& q) const
+	{
+		std::vector<int>::const_iterator it = std::find(m_QueryInterfaceIds.begin(), m_QueryInterfaceIds.end(), q.interface);
+		if (!q.interface || it == m_QueryInterfaceIds.end())
+			return 0;
+		return 1u << (it - m_QueryInterfaceIds.begin());
+	}
 
-		// Ignore if it's missing the required interface
-		if (q.interface && !GetSimContext().GetComponentManager().QueryInterface(id, q.interface))
+	/**
+	 * Returns whether the result of @p q can be computed from its last match.
+	 * That requires a stationary source, and distance tests that only depend on
+	 * the data tracked by the subdivision (which excludes the heights of parabolic queries).
+	 */
+	bool CanUpdateQueryIncrementally(const Query& q, CFixedVector2D pos) const
+	{
+		return q.generation && q.lastPosition == pos && !q.parabolic && q.maxRange != ALWAYS_IN_RANGE;
+	}
+
+	/**
+	 * Computes the result of the query in @p r like PerformQuery, but only tests the entities
+	 * of the subdivisions which changed since the last match. The other matches are unchanged.
+	 * @return false if nothing changed (then @p r is not filled).
+	 */
+	bool UpdateQueryIncrementally(const Query& q, std::vector<entity_id_t>& r, CFixedVector2D pos, std::vector<uint32_t>& subdivisionResultsBuffer, u32 interfaceMask) const
+	{
+		subdivisionResultsBuffer.clear();
+		if (!m_Subdivision.GetNearChanged(subdivisionResultsBuffer, pos, q.maxRange, q.generation))
 			return false;
 
+		// Keep the previous matches which didn't change.
+		for (const entity_id_t id : q.lastMatch)
+			if (m_QueryData.queryFlags[id] &&
+			    !m_Subdivision.HasChangedSince(CFixedVector2D(m_QueryData.x[id], m_QueryData.z[id]), m_QueryData.size[id], q.generation))
+				r.push_back(id);
+
+		// Test the entities that changed, like PerformQuery.
+		m_QueryData.Filter(subdivisionResultsBuffer, q.ownersMask, q.flagsMask, q.source.GetId());
+		for (const entity_id_t id : subdivisionResultsBuffer)
+		{
+			const CFixedVector2D offset = CFixedVector2D(m_QueryData.x[id], m_QueryData.z[id]) - pos;
+
+			entity_pos_t range = q.maxRange + (q.accountForSize ? fixed::FromInt(m_QueryData.size[id]) : fixed::Zero());
+			if (offset.CompareLength(range) > 0)
+				continue;
+
+			if (!q.minRange.IsZero())
+				if (offset.CompareLength(q.minRange) < 0)
+					continue;
+
+			if (!TestEntityInterface(q, id, interfaceMask))
+				continue;
+
+			r.push_back(id);
+		}
+		std::sort(r.begin(), r.end());
 		return true;
 	}
 
 	/**
 	 * Returns a list of distinct entity IDs that match the given query, sorted by ID.
 	 */
-	void PerformQuery(const Query& q, std::vector<entity_id_t>& r, CFixedVector2D pos, std::vector<uint32_t>& subdivisionResultsBuffer)
+	void PerformQuery(const Query& q, std::vector<entity_id_t>& r, CFixedVector2D pos, std::vector<uint32_t>& subdivisionResultsBuffer, u32 interfaceMask = 0)
 	{
+		const entity_id_t source = q.source.GetId();
 
 		// Special case: range is ALWAYS_IN_RANGE means check all entities ignoring distance.
 		if (q.maxRange == ALWAYS_IN_RANGE)
 		{
-			for (EntityMap<EntityData>::const_iterator it = m_EntityData.begin(); it != m_EntityData.end(); ++it)
-			{
-				if (!TestEntityQuery(q, it->first, it->second))
-					continue;
-
-				r.push_back(it->first);
-			}
+			const size_t start = r.size();
+			m_QueryData.FilterAll(r, q.ownersMask, q.flagsMask, source);
+			if (q.interface)
+				r.erase(std::remove_if(r.begin() + start, r.end(), [&](entity_id_t id) {
+					return !TestEntityInterface(q, id, interfaceMask);
+				}), r.end());
 		}
 		// Not the entire world, so check a parabolic range, or a regular range.
 		else if (q.parabolic)
@@ -1301,16 +1564,14 @@ public:
 			// Get a quick list of entities that are potentially in range, with a cutoff of 2*maxRange.
 			subdivisionResultsBuffer.clear();
 			m_Subdivision.GetNear(subdivisionResultsBuffer, pos, q.maxRange * 2);
+			m_QueryData.Filter(subdivisionResultsBuffer, q.ownersMask, q.flagsMask, source);
 
-			for (size_t i = 0; i < subdivisionResultsBuffer.size(); ++i)
+			for (const entity_id_t id : subdivisionResultsBuffer)
 			{
-				EntityMap<EntityData>::const_iterator it = m_EntityData.find(subdivisionResultsBuffer[i]);
-				ENSURE(it != m_EntityData.end());
+				const entity_pos_t x = m_QueryData.x[id];
+				const entity_pos_t z = m_QueryData.z[id];
 
-				if (!TestEntityQuery(q, it->first, it->second))
-					continue;
-
-				CmpPtr<ICmpPosition> cmpSecondPosition(GetSimContext(), subdivisionResultsBuffer[i]);
+				CmpPtr<ICmpPosition> cmpSecondPosition(GetSimContext(), id);
 				if (!cmpSecondPosition || !cmpSecondPosition->IsInWorld())
 					continue;
 				CFixedVector3D secondPosition = cmpSecondPosition->GetPosition();
@@ -1322,15 +1583,18 @@ public:
 				// they have an intersection after which the former grows slower, and then use that to prove the above.
 				// Note that this is only true because we do not account for vertical size here,
 				// if we did, we would also need to artificially 'raise' the source over the target.
-				entity_pos_t range = q.maxRange + (q.accountForSize ? fixed::FromInt(it->second.size) : fixed::Zero());
-				if (!InParabolicRange(CFixedVector3D(it->second.x, secondPosition.Y, it->second.z) - pos3d, range))
+				entity_pos_t range = q.maxRange + (q.accountForSize ? fixed::FromInt(m_QueryData.size[id]) : fixed::Zero());
+				if (!InParabolicRange(CFixedVector3D(x, secondPosition.Y, z) - pos3d, range))
 					continue;
 
 				if (!q.minRange.IsZero())
-					if ((CFixedVector2D(it->second.x, it->second.z) - pos).CompareLength(q.minRange) < 0)
+					if ((CFixedVector2D(x, z) - pos).CompareLength(q.minRange) < 0)
 						continue;
 
-				r.push_back(it->first);
+				if (!TestEntityInterface(q, id, interfaceMask))
+					continue;
+
+				r.push_back(id);
 			}
 			std::sort(r.begin(), r.end());
 		}
@@ -1340,25 +1604,26 @@ public:
 			// Get a quick list of entities that are potentially in range
 			subdivisionResultsBuffer.clear();
 			m_Subdivision.GetNear(subdivisionResultsBuffer, pos, q.maxRange);
+			m_QueryData.Filter(subdivisionResultsBuffer, q.ownersMask, q.flagsMask, source);
 
-			for (size_t i = 0; i < subdivisionResultsBuffer.size(); ++i)
+			for (const entity_id_t id : subdivisionResultsBuffer)
 			{
-				EntityMap<EntityData>::const_iterator it = m_EntityData.find(subdivisionResultsBuffer[i]);
-				ENSURE(it != m_EntityData.end());
-
-				if (!TestEntityQuery(q, it->first, it->second))
-					continue;
+				const CFixedVector2D offset = CFixedVector2D(m_QueryData.x[id], m_QueryData.z[id]) - pos;
 
 				// Restrict based on approximate circle-circle distance.
-				entity_pos_t range = q.maxRange + (q.accountForSize ? fixed::FromInt(it->second.size) : fixed::Zero());
-				if ((CFixedVector2D(it->second.x, it->second.z) - pos).CompareLength(range) > 0)
+				entity_pos_t range = q.maxRange + (q.accountForSize ? fixed::FromInt(m_QueryData.size[id]) : fixed::Zero());
+				if (offset.CompareLength(range) > 0)
 					continue;
 
 				if (!q.minRange.IsZero())
-					if ((CFixedVector2D(it->second.x, it->second.z) - pos).CompareLength(q.minRange) < 0)
+					if (offset.CompareLength(q.minRange) < 0)
 						continue;
 
-				r.push_back(it->first);
+				// The interface is tested last, since it is the most expensive test.
+				if (!TestEntityInterface(q, id, interfaceMask))
+					continue;
+
+				r.push_back(id);
 			}
 			std::sort(r.begin(), r.end());
 		}
@@ -1713,7 +1978,12 @@ public:
 		if (flag == FlagMasks::None)
 			LOGWARNING("CCmpRangeManager: Invalid flag identifier %s for entity %u", identifier.c_str(), ent);
 		else
+		{
 			it->second.SetFlag(flag, value);
+			m_QueryData.Set(ent, it->second);
+			if (it->second.HasFlag<FlagMasks::InWorld>())
+				m_Subdivision.MarkChanged(CFixedVector2D(it->second.x, it->second.z), it->second.size);
+		}
 	}
 
 	// ****************************************************************
@@ -1941,17 +2211,64 @@ public:
 	{
 		PROFILE("UpdateVisibilityData");
 
-		for (u16 i = 0; i < m_LosRegionsPerSide; ++i)
-			for (u16 j = 0; j < m_LosRegionsPerSide; ++j)
-			{
-				LosRegion pos{i, j};
+		u16 globalMask = 0;
+		for (player_id_t player = 1; player < MAX_LOS_PLAYER_ID + 1; ++player)
+			if (m_GlobalPlayerVisibilityUpdate[player-1] || m_GlobalVisibilityUpdate)
+				globalMask |= 0x1 << (player - 1);
+
+		// Only the regions marked by LOS changes need to be visited, unless some player
+		// needs a global update. Regions are handled in (i, j) order, as they would be by
+		// a scan of the whole grid, so that visibility messages are sent in the same order.
+		std::vector<LosRegion> regions;
+		if (globalMask)
+		{
+			regions.reserve(m_LosRegionsPerSide * m_LosRegionsPerSide);
+			for (u16 i = 0; i < m_LosRegionsPerSide; ++i)
+				for (u16 j = 0; j < m_LosRegionsPerSide; ++j)
+					regions.emplace_back(i, j);
+			m_DirtyVisibilityRegions.clear();
+		}
+		else
+		{
+			regions.swap(m_DirtyVisibilityRegions);
+			std::sort(regions.begin(), regions.end());
+			regions.erase(std::unique(regions.begin(), regions.end()), regions.end());
+		}
+
+		// Regions dirtied while sending visibility messages which come before the current
+		// one are kept for the next update.
+		std::vector<LosRegion> deferred;
+		for (size_t k = 0; k < regions.size(); ++k)
+		{
+			const LosRegion pos = regions[k];
+			if (!m_LosRegions[pos].empty())
 				for (player_id_t player = 1; player < MAX_LOS_PLAYER_ID + 1; ++player)
-					if (IsVisibilityDirty(m_DirtyVisibility[pos], player) || m_GlobalPlayerVisibilityUpdate[player-1] == 1 || m_GlobalVisibilityUpdate)
+				{
+					// Re-read the mask each time, since messages may mark more players dirty.
+					u16 dirty = m_DirtyVisibility[pos] | globalMask;
+					if (!(dirty >> (player - 1)))
+						break;
+					if (IsVisibilityDirty(dirty, player))
 						for (const entity_id_t& ent : m_LosRegions[pos])
 							UpdateVisibility(ent, player);
+				}
 
-				m_DirtyVisibility[pos] = 0;
+			m_DirtyVisibility[pos] = 0;
+
+			for (const LosRegion& region : m_DirtyVisibilityRegions)
+			{
+				if (region <= pos)
+				{
+					deferred.push_back(region);
+					continue;
+				}
+				std::vector<LosRegion>::iterator it = std::lower_bound(regions.begin() + k + 1, regions.end(), region);
+				if (it == regions.end() || *it != region)
+					regions.insert(it, region);
 			}
+			m_DirtyVisibilityRegions.clear();
+		}
+		m_DirtyVisibilityRegions.swap(deferred);
 
 		std::fill(m_GlobalPlayerVisibilityUpdate.begin(), m_GlobalPlayerVisibilityUpdate.end(), false);
 		m_GlobalVisibilityUpdate = false;
@@ -2233,23 +2550,42 @@ public:
 			return;
 
 		u32 &explored = m_ExploredVertices.at(owner);
-		for (i32 i = i0; i <= i1; ++i)
+		u16* const row = &counts.get(0, j);
+		i32 i = i0;
+		// Increment four counts at once, unless one of them becomes visible (or would overflow).
+		for (; i + 3 <= i1; i += 4)
 		{
-			// Increasing from zero to non-zero - move from unexplored/explored to visible+explored
-			if (counts.get(i, j) == 0)
+			u64 lanes;
+			std::memcpy(&lanes, row + i, sizeof(lanes));
+			if (HasZeroLane(lanes) || HasZeroLane(~lanes))
 			{
-				if (!LosIsOffWorld(i, j))
-				{
-					explored += !(m_LosState.get(i, j) & ((u32)LosState::EXPLORED << (2*(owner-1))));
-					m_LosState.get(i, j) |= (((int)LosState::VISIBLE | (u32)LosState::EXPLORED) << (2*(owner-1)));
-				}
+				for (i32 k = i; k < i + 4; ++k)
+					LosAddVertexHelper(owner, k, j, counts, explored);
+				continue;
+			}
+			lanes += LOS_COUNT_LANES_ONE;
+			std::memcpy(row + i, &lanes, sizeof(lanes));
+		}
+		for (; i <= i1; ++i)
+			LosAddVertexHelper(owner, i, j, counts, explored);
+	}
 
-				MarkVisibilityDirtyAroundTile(owner, i, j);
+	inline void LosAddVertexHelper(u8 owner, i32 i, i32 j, Grid<u16>& counts, u32& explored)
+	{
+		// Increasing from zero to non-zero - move from unexplored/explored to visible+explored
+		if (counts.get(i, j) == 0)
+		{
+			if (!LosIsOffWorld(i, j))
+			{
+				explored += !(m_LosState.get(i, j) & ((u32)LosState::EXPLORED << (2*(owner-1))));
+				m_LosState.get(i, j) |= (((int)LosState::VISIBLE | (u32)LosState::EXPLORED) << (2*(owner-1)));
 			}
 
-			ENSURE(counts.get(i, j) < std::numeric_limits<u16>::max());
-			counts.get(i, j) = (u16)(counts.get(i, j) + 1); // ignore overflow; the player should never have 64K units
+			MarkVisibilityDirtyAroundTile(owner, i, j);
 		}
+
+		ENSURE(counts.get(i, j) < std::numeric_limits<u16>::max());
+		counts.get(i, j) = (u16)(counts.get(i, j) + 1); // ignore overflow; the player should never have 64K units
 	}
 
 	/**
@@ -2260,19 +2596,38 @@ public:
 		if (i1 < i0)
 			return;
 
-		for (i32 i = i0; i <= i1; ++i)
+		u16* const row = &counts.get(0, j);
+		i32 i = i0;
+		// Decrement four counts at once, unless one of them stops being visible.
+		for (; i + 3 <= i1; i += 4)
 		{
-			ASSERT(counts.get(i, j) > 0);
-			counts.get(i, j) = (u16)(counts.get(i, j) - 1);
-
-			// Decreasing from non-zero to zero - move from visible+explored to explored
-			if (counts.get(i, j) == 0)
+			u64 lanes;
+			std::memcpy(&lanes, row + i, sizeof(lanes));
+			if (HasZeroLane(lanes & ~LOS_COUNT_LANES_ONE))
 			{
-				// (If LosIsOffWorld then this is a no-op, so don't bother doing the check)
-				m_LosState.get(i, j) &= ~((int)LosState::VISIBLE << (2*(owner-1)));
-
-				MarkVisibilityDirtyAroundTile(owner, i, j);
+				for (i32 k = i; k < i + 4; ++k)
+					LosRemoveVertexHelper(owner, k, j, counts);
+				continue;
 			}
+			lanes -= LOS_COUNT_LANES_ONE;
+			std::memcpy(row + i, &lanes, sizeof(lanes));
+		}
+		for (; i <= i1; ++i)
+			LosRemoveVertexHelper(owner, i, j, counts);
+	}
+
+	inline void LosRemoveVertexHelper(u8 owner, i32 i, i32 j, Grid<u16>& counts)
+	{
+		ASSERT(counts.get(i, j) > 0);
+		counts.get(i, j) = (u16)(counts.get(i, j) - 1);
+
+		// Decreasing from non-zero to zero - move from visible+explored to explored
+		if (counts.get(i, j) == 0)
+		{
+			// (If LosIsOffWorld then this is a no-op, so don't bother doing the check)
+			m_LosState.get(i, j) &= ~((int)LosState::VISIBLE << (2*(owner-1)));
+
+			MarkVisibilityDirtyAroundTile(owner, i, j);
 		}
 	}
 
@@ -2290,15 +2645,25 @@ public:
 		LosRegion n4 = LosVertexToLosRegionsHelper(i, j);
 
 		u16 sharedDirtyVisibilityMask = m_SharedDirtyVisibilityMasks[owner];
+		if (!sharedDirtyVisibilityMask)
+			return;
 
 		if (j > 0 && i > 0)
-			m_DirtyVisibility[n1] |= sharedDirtyVisibilityMask;
+			MarkRegionVisibilityDirty(n1, sharedDirtyVisibilityMask);
 		if (n2 != n1 && j > 0 && i < m_LosVerticesPerSide)
-			m_DirtyVisibility[n2] |= sharedDirtyVisibilityMask;
+			MarkRegionVisibilityDirty(n2, sharedDirtyVisibilityMask);
 		if (n3 != n1 && j < m_LosVerticesPerSide && i > 0)
-			m_DirtyVisibility[n3] |= sharedDirtyVisibilityMask;
+			MarkRegionVisibilityDirty(n3, sharedDirtyVisibilityMask);
 		if (n4 != n1 && j < m_LosVerticesPerSide && i < m_LosVerticesPerSide)
-			m_DirtyVisibility[n4] |= sharedDirtyVisibilityMask;
+			MarkRegionVisibilityDirty(n4, sharedDirtyVisibilityMask);
+	}
+
+	inline void MarkRegionVisibilityDirty(LosRegion region, u16 mask)
+	{
+		u16& dirty = m_DirtyVisibility[region];
+		if (!dirty)
+			m_DirtyVisibilityRegions.push_back(region);
+		dirty |= mask;
 	}
 
 	/**
@@ -2522,6 +2887,12 @@ public:
 		if (visionRange.IsZero() || owner <= 0 || owner > MAX_LOS_PLAYER_ID)
 			return;
 
+		if (m_BatchingLosUpdates)
+		{
+			m_PendingLosUpdates[owner].push_back({LosUpdate::Type::ADD, visionRange, pos, pos});
+			return;
+		}
+
 		LosUpdateHelper<true>((u8)owner, visionRange, pos);
 	}
 
@@ -2540,6 +2911,12 @@ public:
 		if (visionRange.IsZero() || owner <= 0 || owner > MAX_LOS_PLAYER_ID)
 			return;
 
+		if (m_BatchingLosUpdates)
+		{
+			m_PendingLosUpdates[owner].push_back({LosUpdate::Type::REMOVE, visionRange, pos, pos});
+			return;
+		}
+
 		LosUpdateHelper<false>((u8)owner, visionRange, pos);
 	}
 
@@ -2558,15 +2935,53 @@ public:
 		if (visionRange.IsZero() || owner <= 0 || owner > MAX_LOS_PLAYER_ID)
 			return;
 
+		if (m_BatchingLosUpdates)
+		{
+			m_PendingLosUpdates[owner].push_back({LosUpdate::Type::MOVE, visionRange, from, to});
+			return;
+		}
+
+		LosMoveHelper((u8)owner, visionRange, from, to);
+	}
+
+	void LosMoveHelper(u8 owner, entity_pos_t visionRange, CFixedVector2D from, CFixedVector2D to)
+	{
 		if ((from - to).CompareLength(visionRange) > 0)
 		{
 			// If it's a very large move, then simply remove and add to the new position
-			LosUpdateHelper<false>((u8)owner, visionRange, from);
-			LosUpdateHelper<true>((u8)owner, visionRange, to);
+			LosUpdateHelper<false>(owner, visionRange, from);
+			LosUpdateHelper<true>(owner, visionRange, to);
 		}
 		else
 			// Otherwise use the version optimised for mostly-overlapping circles
-			LosUpdateHelperIncremental((u8)owner, visionRange, from, to);
+			LosUpdateHelperIncremental(owner, visionRange, from, to);
+	}
+
+	/**
+	 * Apply the LOS updates queued while handling a batch of position changes.
+	 * Players have their own counts and LOS state bits, so this goes player by player
+	 * (keeping the order of each player's updates) instead of following the whole batch around the map.
+	 */
+	void FlushLosUpdates()
+	{
+		PROFILE("FlushLosUpdates");
+		for (u8 owner = 1; owner <= MAX_LOS_PLAYER_ID; ++owner)
+		{
+			for (const LosUpdate& update : m_PendingLosUpdates[owner])
+				switch (update.type)
+				{
+				case LosUpdate::Type::ADD:
+					LosUpdateHelper<true>(owner, update.visionRange, update.to);
+					break;
+				case LosUpdate::Type::REMOVE:
+					LosUpdateHelper<false>(owner, update.visionRange, update.from);
+					break;
+				case LosUpdate::Type::MOVE:
+					LosMoveHelper(owner, update.visionRange, update.from, update.to);
+					break;
+				}
+			m_PendingLosUpdates[owner].clear();
+		}
 	}
 
 	void SharingLosMove(u16 visionSharing, entity_pos_t visionRange, CFixedVector2D from, CFixedVector2D to)
@@ -1,4 +1,4 @@
-/* Copyright (C) 2025 Wildfire Games.
+/* Copyright (C) 2026 Wildfire Games.
  * This file is part of 0 A.D.
  *
  * 0 A.D. is free software: you can redistribute it and/or modify
@@ -54,6 +54,7 @@ public:
 	void Init(const CParamNode&) override
 	{
 		m_DisableValidation = false;
+		m_StateGeneration = 1;
 
 		m_Validator.LoadGrammar(GetSimContext().GetComponentManager().GenerateSchema());
 		// TODO: handle errors loading the grammar here?
@@ -86,6 +87,11 @@ public:
 				m_LatestTemplates[id] = mapEl.first;
 	}
 
+	u32 GetStateGeneration() const override
+	{
+		return m_StateGeneration;
+	}
+
 	void HandleMessage(const CMessage& msg, bool /*global*/) override
 	{
 		switch (msg.GetType())
@@ -95,7 +101,8 @@ public:
 			const CMessageDestroy& msgData = static_cast<const CMessageDestroy&> (msg);
 
 			// Clean up m_LatestTemplates so it doesn't record any data for destroyed entities
-			m_LatestTemplates.erase(msgData.entity);
+			if (m_LatestTemplates.erase(msgData.entity) && !ENTITY_IS_LOCAL(msgData.entity))
+				++m_StateGeneration;
 
 			break;
 		}
@@ -145,13 +152,19 @@ private:
 	// Remember the template used by each entity, so we can return them
 	// again for deserialization.
 	std::map<entity_id_t, std::string> m_LatestTemplates;
+
+	// Incremented whenever the serialized part of m_LatestTemplates changes.
+	u32 m_StateGeneration;
 };
 
 REGISTER_COMPONENT_TYPE(TemplateManager)
 
 const CParamNode* CCmpTemplateManager::LoadTemplate(entity_id_t ent, const std::string& templateName)
 {
-	m_LatestTemplates[ent] = templateName;
+	std::string& latestTemplate = m_LatestTemplates[ent];
+	if (latestTemplate != templateName && !ENTITY_IS_LOCAL(ent))
+		++m_StateGeneration;
+	latestTemplate = templateName;
 
 	return GetTemplate(templateName);
 }
@@ -1,4 +1,4 @@
-/* Copyright (C) 2025 Wildfire Games.
+/* Copyright (C) 2026 Wildfire Games.
  * This file is part of 0 A.D.
  *
  * 0 A.D. is free software: you can redistribute it and/or modify
@@ -35,7 +35,10 @@
 #include "maths/MathUtil.h"
 #include "maths/Vector2D.h"
 #include "ps/Filesystem.h"
+#include "ps/Future.h"
 #include "ps/Profile.h"
+#include "ps/Profiler2.h"
+#include "ps/TaskManager.h"
 #include "ps/XML/Xeromyces.h"
 #include "renderer/Renderer.h"
 #include "renderer/Scene.h"
@@ -89,8 +92,8 @@ public:
 	{
 		componentManager.SubscribeGloballyToMessageType(MT_OwnershipChanged);
 		componentManager.SubscribeGloballyToMessageType(MT_PlayerColorChanged);
-		componentManager.SubscribeGloballyToMessageType(MT_PositionChanged);
 		componentManager.SubscribeGloballyToMessageType(MT_ValueModification);
+		componentManager.SubscribeToMessageType(MT_PositionsChanged);
 		componentManager.SubscribeToMessageType(MT_ObstructionMapShapeChanged);
 		componentManager.SubscribeToMessageType(MT_TerrainChanged);
 		componentManager.SubscribeToMessageType(MT_WaterChanged);
@@ -213,10 +216,18 @@ public:
 			MakeDirty();
 			break;
 		}
-		case MT_PositionChanged:
+		case MT_PositionsChanged:
 		{
-			const CMessagePositionChanged& msgData = static_cast<const CMessagePositionChanged&> (msg);
-			MakeDirtyIfRelevantEntity(msgData.entity);
+			const CMessagePositionsChanged& msgData = static_cast<const CMessagePositionsChanged&> (msg);
+			// One relevant entity is enough to recompute the territories
+			for (const CMessagePositionsChanged::Change& change : msgData.changes)
+			{
+				if (CmpPtr<ICmpTerritoryInfluence>(GetSimContext(), change.entity))
+				{
+					MakeDirty();
+					break;
+				}
+			}
 			break;
 		}
 		case MT_ValueModification:
@@ -421,6 +432,75 @@ static void NearestTerritoryTile(entity_pos_t x, entity_pos_t z, u16& i, u16& j,
 	j = Clamp((z / scale).ToInt_RoundToNegInfinity(), 0, h - 1);
 }
 
+/**
+ * A territory influence entity, with the values needed to expand its influence.
+ */
+struct InfluenceSource
+{
+	Tile origin;
+	u32 originWeight;
+	u32 relativeFalloff;
+};
+
+/**
+ * Expands the influences of one player's entities.
+ * @param[out] weightGrid For each tile, the highest combined weight of the player during the expansion.
+ * A player takes a tile from the previous players iff this is higher than their best weight there,
+ * so merging the players in order gives the same owners as expanding all of them in sequence.
+ */
+static void ComputePlayerInfluence(const std::vector<InfluenceSource>& sources, const Grid<u8>& costGrid, Grid<u32>& weightGrid)
+{
+	PROFILE2("Territory influence");
+
+	const u16 tilesW = costGrid.m_W;
+	const u16 tilesH = costGrid.m_H;
+
+	// entityGrid stores the weight for a single entity, and is reset per entity
+	Grid<u32> entityGrid(tilesW, tilesH);
+	// playerGrid stores the combined weight of all entities for this player
+	Grid<u32> playerGrid(tilesW, tilesH);
+
+	// Compute the influence map of the current entity, then add it to the player grid
+	for (const InfluenceSource& source : sources)
+	{
+		// Expand influences outwards
+		Floodfill(source.origin, {tilesW, tilesH}, [&](const Tile* current, const Tile& neighbour)
+			{
+				const bool diagonalProgression{current && neighbour.x != current->x &&
+					neighbour.z != current->z};
+
+				const u32 falloffPerTile{source.relativeFalloff *
+					costGrid.get(neighbour.x, neighbour.z)};
+				// diagonal neighbour -> multiply with approx sqrt(2)
+				const u32 falloff{diagonalProgression ? (falloffPerTile * 362) / 256 :
+					falloffPerTile};
+
+				// Don't expand if new cost is not better than previous value for that tile
+				// (arranged to avoid underflow if entityGrid.get(x, z) < falloff)
+				if (current &&
+					entityGrid.get(current->x, current->z) <=
+						entityGrid.get(neighbour.x, neighbour.z) + falloff)
+					{
+						return false;
+					}
+
+				// weight of this tile = weight of predecessor - falloff from predecessor
+				const u32 weight{current ? entityGrid.get(current->x, current->z) - falloff :
+					source.originWeight};
+				const u32 totalWeight{weight + (current ?
+					playerGrid.get(neighbour.x, neighbour.z) -
+					entityGrid.get(neighbour.x, neighbour.z) : 0)};
+
+				playerGrid.set(neighbour.x, neighbour.z, totalWeight);
+				entityGrid.set(neighbour.x, neighbour.z, weight);
+				if (totalWeight > weightGrid.get(neighbour.x, neighbour.z))
+					weightGrid.set(neighbour.x, neighbour.z, totalWeight);
+				return true;
+			});
+		entityGrid.reset();
+	}
+}
+
 void CCmpTerritoryManager::CalculateCostGrid()
 {
 	if (m_CostGrid)
@@ -510,23 +590,18 @@ void CCmpTerritoryManager::CalculateTerritories()
 		influenceEntities[owner].push_back(ent);
 	}
 
-	// Store the overall best weight for comparison
-	Grid<u32> bestWeightGrid(tilesW, tilesH);
+	// Gather the influence sources of each player: the components can't be queried from worker threads.
 	// store the root influences to mark territory as connected
 	std::vector<entity_id_t> rootInfluenceEntities;
-
+	std::vector<std::pair<u8, std::vector<InfluenceSource>>> playerSources;
+	playerSources.reserve(influenceEntities.size());
 	for (const std::pair<const player_id_t, std::vector<entity_id_t>>& pair : influenceEntities)
 	{
-		// entityGrid stores the weight for a single entity, and is reset per entity
-		Grid<u32> entityGrid(tilesW, tilesH);
-		// playerGrid stores the combined weight of all entities for this player
-		Grid<u32> playerGrid(tilesW, tilesH);
-
-		u8 owner = static_cast<u8>(pair.first);
+		std::vector<InfluenceSource>& sources = playerSources.emplace_back(static_cast<u8>(pair.first), std::vector<InfluenceSource>()).second;
 		const std::vector<entity_id_t>& ents = pair.second;
 		// With 2^16 entities, we're safe against overflows as the weight is also limited to 2^16
 		ENSURE(ents.size() < 1 << 16);
-		// Compute the influence map of the current entity, then add it to the player grid
+		sources.reserve(ents.size());
 		for (entity_id_t ent : ents)
 		{
 			CmpPtr<ICmpPosition> cmpPosition(GetSimContext(), ent);
@@ -549,48 +624,40 @@ void CCmpTerritoryManager::CalculateTerritories()
 			if (cmpTerritoryInfluence->IsRoot())
 				rootInfluenceEntities.push_back(ent);
 
-			// Expand influences outwards
-			Floodfill({i, j}, {tilesW, tilesH}, [&](const Tile* current, const Tile& neighbour)
-				{
-					const bool diagonalProgression{current && neighbour.x != current->x &&
-						neighbour.z != current->z};
-
-					const u32 falloffPerTile{relativeFalloff *
-						m_CostGrid->get(neighbour.x, neighbour.z)};
-					// diagonal neighbour -> multiply with approx sqrt(2)
-					const u32 falloff{diagonalProgression ? (falloffPerTile * 362) / 256 :
-						falloffPerTile};
-
-					// Don't expand if new cost is not better than previous value for that tile
-					// (arranged to avoid underflow if entityGrid.get(x, z) < falloff)
-					if (current &&
-						entityGrid.get(current->x, current->z) <=
-							entityGrid.get(neighbour.x, neighbour.z) + falloff)
-						{
-							return false;
-						}
-
-					// weight of this tile = weight of predecessor - falloff from predecessor
-					const u32 weight{current ? entityGrid.get(current->x, current->z) - falloff :
-						originWeight};
-					const u32 totalWeight{weight + (current ?
-						playerGrid.get(neighbour.x, neighbour.z) -
-						entityGrid.get(neighbour.x, neighbour.z) : 0)};
-
-					playerGrid.set(neighbour.x, neighbour.z, totalWeight);
-					entityGrid.set(neighbour.x, neighbour.z, weight);
-					// if this weight is better than the best thus far, set the owner
-					if (totalWeight > bestWeightGrid.get(neighbour.x, neighbour.z))
-					{
-						bestWeightGrid.set(neighbour.x, neighbour.z, totalWeight);
-						m_Territories->set(neighbour.x, neighbour.z, owner);
-					}
-					return true;
-				});
-			entityGrid.reset();
+			sources.push_back({{i, j}, originWeight, relativeFalloff});
 		}
 	}
 
+	// Expand the influences of each player on its own grids, the first player on this thread.
+	std::vector<Grid<u32>> playerWeightGrids(playerSources.size(), Grid<u32>(tilesW, tilesH));
+	std::vector<Future<void>> futures;
+	futures.reserve(playerSources.size());
+	for (size_t i = 1; i < playerSources.size(); ++i)
+		futures.push_back({g_TaskManager,
+			[&sources = playerSources[i].second, &costGrid = *m_CostGrid, &weightGrid = playerWeightGrids[i]]()
+			{
+				ComputePlayerInfluence(sources, costGrid, weightGrid);
+			}});
+	if (!playerSources.empty())
+		ComputePlayerInfluence(playerSources[0].second, *m_CostGrid, playerWeightGrids[0]);
+
+	// Merge the players in order, which gives the same owners as expanding them one after the other.
+	// Store the overall best weight for comparison
+	Grid<u32> bestWeightGrid(tilesW, tilesH);
+	for (size_t i = 0; i < playerSources.size(); ++i)
+	{
+		if (i > 0)
+			futures[i - 1].Get();
+		const u8 owner = playerSources[i].first;
+		const Grid<u32>& weightGrid = playerWeightGrids[i];
+		for (size_t k = 0; k < static_cast<size_t>(tilesW) * tilesH; ++k)
+			if (weightGrid.m_Data[k] > bestWeightGrid.m_Data[k])
+			{
+				bestWeightGrid.m_Data[k] = weightGrid.m_Data[k];
+				m_Territories->m_Data[k] = owner;
+			}
+	}
+
 	// Detect territories connected to a 'root' influence (typically a civ center)
 	// belonging to their player, and mark them with the connected flag
 	for (entity_id_t ent : rootInfluenceEntities)
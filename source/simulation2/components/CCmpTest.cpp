@@ -1,4 +1,4 @@
-/* Copyright (C) 2025 Wildfire Games.
+/* Copyright (C) 2026 Wildfire Games.
  * This file is part of 0 A.D.
  *
  * 0 A.D. is free software: you can redistribute it and/or modify
@@ -101,6 +101,7 @@ public:
 	static void ClassInit(CComponentManager& componentManager)
 	{
 		componentManager.SubscribeToMessageType(MT_Update);
+		componentManager.SubscribeToMessageType(MT_PositionsChanged);
 		componentManager.SubscribeGloballyToMessageType(MT_Interpolate);
 	}
 
@@ -147,6 +148,9 @@ public:
 		case MT_Interpolate:
 			m_x += 20;
 			break;
+		case MT_PositionsChanged:
+			m_x += 100 * static_cast<int32_t>(static_cast<const CMessagePositionsChanged&>(msg).changes.size());
+			break;
 		default:
 			m_x = 0;
 			break;
@@ -168,6 +172,7 @@ public:
 	DEFAULT_COMPONENT_ALLOCATOR(Test2A)
 
 	int32_t m_x;
+	u32 m_StateGeneration;
 
 	static std::string GetSchema()
 	{
@@ -177,6 +182,7 @@ public:
 	void Init(const CParamNode&) override
 	{
 		m_x = 21000;
+		m_StateGeneration = 1;
 	}
 
 	void Deinit() override
@@ -191,6 +197,12 @@ public:
 	void Deserialize(const CParamNode&, IDeserializer& deserialize) override
 	{
 		deserialize.NumberI32_Unbounded("x", m_x);
+		m_StateGeneration = 1;
+	}
+
+	u32 GetStateGeneration() const override
+	{
+		return m_StateGeneration;
 	}
 
 	int GetX() override
@@ -212,6 +224,7 @@ public:
 			m_x = 0;
 			break;
 		}
+		++m_StateGeneration;
 	}
 };
 
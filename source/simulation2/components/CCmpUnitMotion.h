@@ -53,6 +53,7 @@
 #include <algorithm>
 #include <cstddef>
 #include <cstdint>
+#include <optional>
 #include <string>
 #include <utility>
 #include <vector>
@@ -237,6 +238,10 @@ public:
 		MoveRequest(entity_id_t target, CFixedVector2D offset) : m_Type(OFFSET), m_Entity(target), m_Position(offset) {};
 	} m_MoveRequest;
 
+	// Whether the target of an entity move request has a move request itself, recorded by PreMove for Move.
+	// Move may run on a worker thread, where the target's UnitMotion (which may be scripted) must not be called.
+	std::optional<bool> m_TargetMoveRequested;
+
 	// If this is not INVALID_ENTITY, the unit is a formation member.
 	entity_id_t m_FormationController = INVALID_ENTITY;
 
@@ -646,6 +651,12 @@ private:
 		return cmpControllerMotion && cmpControllerMotion->IsMoveRequested();
 	}
 
+	bool IsTargetMoveRequested(entity_id_t target) const
+	{
+		CmpPtr<ICmpUnitMotion> cmpTargetMotion(GetSimContext(), target);
+		return cmpTargetMotion && cmpTargetMotion->IsMoveRequested();
+	}
+
 	entity_id_t GetGroup() const
 	{
 		return IsFormationMember() ? m_FormationController : GetEntityId();
@@ -1076,6 +1087,9 @@ void CCmpUnitMotion::PreMove(CCmpUnitMotionManager::MotionState& state)
 	state.needUpdate = state.cmpPosition->IsInWorld() &&
 		(m_CurrentSpeed != fixed::Zero() || m_LastTurnSpeed != fixed::Zero() || m_MoveRequest.m_Type != MoveRequest::NONE);
 
+	if (state.needUpdate && m_MoveRequest.m_Type == MoveRequest::ENTITY)
+		m_TargetMoveRequested = IsTargetMoveRequested(m_MoveRequest.m_Entity);
+
 	if (!m_BlockMovement)
 		return;
 
@@ -1099,6 +1113,8 @@ void CCmpUnitMotion::Move(CCmpUnitMotionManager::MotionState& state, fixed dt)
 	state.wentStraight = TryGoingStraightToTarget(state.initialPos, true);
 
 	state.wasObstructed = PerformMove(dt, state.cmpPosition->GetTurnRate(), m_ShortPath, m_LongPath, state.pos, state.speed, state.angle, state.pushingPressure);
+
+	m_TargetMoveRequested.reset();
 }
 
 void CCmpUnitMotion::PostMove(CCmpUnitMotionManager::MotionState& state, fixed dt)
@@ -1519,9 +1535,9 @@ bool CCmpUnitMotion::ComputeTargetPosition(CFixedVector2D& out, const MoveReques
 		//  - After movement, we'll call this to request paths & we need to interpolate
 		//    (this way, we'll move where the unit ends up in the end of _next_ turn, making it a match in 2 turns).
 		// TODO: This does not really aim many turns in advance, with orthogonal trajectories it probably should.
-		CmpPtr<ICmpUnitMotion> cmpUnitMotion(GetSimContext(), moveRequest.m_Entity);
 		CmpPtr<ICmpUnitMotionManager> cmpUnitMotionManager(GetSystemEntity());
-		bool needInterpolation = cmpUnitMotion && cmpUnitMotion->IsMoveRequested() && cmpUnitMotionManager->ComputingMotion();
+		bool needInterpolation = cmpUnitMotionManager->ComputingMotion() &&
+			(m_TargetMoveRequested ? *m_TargetMoveRequested : IsTargetMoveRequested(moveRequest.m_Entity));
 		if (needInterpolation)
 		{
 			// Add predicted movement.
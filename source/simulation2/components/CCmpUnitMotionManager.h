@@ -1,4 +1,4 @@
-/* Copyright (C) 2025 Wildfire Games.
+/* Copyright (C) 2026 Wildfire Games.
  * This file is part of 0 A.D.
  *
  * 0 A.D. is free software: you can redistribute it and/or modify
@@ -27,6 +27,7 @@
 #include "simulation2/system/Entity.h"
 #include "simulation2/system/EntityMap.h"
 
+#include <cstddef>
 #include <cstdint>
 #include <string>
 #include <vector>
@@ -126,6 +127,9 @@ public:
 	Grid<std::vector<EntityMap<MotionState>::iterator>> m_MovingUnits;
 	bool m_ComputingMotion;
 
+	// Below this many units, waking the worker threads costs more than moving the units serially.
+	size_t m_MinUnitsForAsyncMotion = 128;
+
 	static std::string GetSchema()
 	{
 		return "<a:component type='system'/><empty/>";
@@ -1,4 +1,4 @@
-/* Copyright (C) 2025 Wildfire Games.
+/* Copyright (C) 2026 Wildfire Games.
  * This file is part of 0 A.D.
  *
  * 0 A.D. is free software: you can redistribute it and/or modify
@@ -26,7 +26,9 @@
 #include "maths/FixedVector3D.h"
 #include "maths/MathUtil.h"
 #include "ps/CLogger.h"
+#include "ps/Future.h"
 #include "ps/Profiler2.h"
+#include "ps/TaskManager.h"
 #include "simulation2/MessageTypes.h"
 #include "simulation2/components/CCmpUnitMotionManager.h"
 #include "simulation2/components/ICmpObstructionManager.h"
@@ -43,12 +45,13 @@
 #include "simulation2/system/Message.h"
 
 #include <algorithm>
+#include <array>
+#include <atomic>
 #include <cstdint>
 #include <cstdlib>
 #include <limits>
 #include <string>
 #include <type_traits>
-#include <unordered_set>
 #include <utility>
 #include <vector>
 
@@ -67,7 +70,7 @@ namespace {
  * I have tested grid sizes from 10 up to 80 and overall it made little difference to the performance,
  * mostly, I suspect, because pushing is generally dwarfed by regular motion costs.
  * However, the algorithm remains n^2 in comparisons so it's probably best to err on the side of smaller grids, which will have lower spikes.
- * The balancing act is between comparisons, unordered_set insertions and unordered_set iterations.
+ * The balancing act is between comparisons and the number of squares to iterate (and spread over threads).
  * For these reasons, a value of 20 which is rather small but not overly so was chosen.
  */
 constexpr int PUSHING_GRID_SIZE = 20;
@@ -120,6 +123,46 @@ constexpr int MIN_PRESSURE_IF_OBSTRUCTED = 80;
  */
 constexpr entity_pos_t PRESSURE_STATIC_FACTOR =  entity_pos_t::FromInt(2);
 constexpr int PRESSURE_DISTANCE_FACTOR = 5;
+
+/**
+ * Pushing squares are colored by their coordinates modulo 3, see CCmpUnitMotionManager::Move.
+ */
+constexpr size_t PUSHING_COLORS = 9;
+
+/**
+ * Calls @p func on each pushing square of @p squares, spread over the worker threads and the calling thread if @p async.
+ * @p func must only write to the units of the square it's given (or units no other concurrent call writes to).
+ */
+template<typename Square, typename Func>
+void ForEachSquare(const std::vector<Square*>& squares, bool async, const Func& func)
+{
+	const size_t numFutures = async && squares.size() > 1 ? std::min(g_TaskManager.GetNumberOfWorkers(), squares.size() - 1) : 0;
+	if (numFutures == 0)
+	{
+		for (Square* square : squares)
+			func(*square);
+		return;
+	}
+
+	std::atomic<size_t> next = 0;
+	const auto processSquares = [&squares, &func, &next]()
+	{
+		PROFILE2("Async unit motion");
+		for (size_t i = next++; i < squares.size(); i = next++)
+			func(*squares[i]);
+	};
+
+	std::vector<Future<void>> futures;
+	futures.reserve(numFutures);
+	for (size_t i = 0; i < numFutures; ++i)
+		futures.push_back({g_TaskManager, processSquares});
+
+	// Start working in the main thread as well.
+	processSquares();
+
+	for (Future<void>& future : futures)
+		future.Get();
+}
 }
 
 #if DEBUG_RENDER
@@ -437,12 +480,14 @@ void CCmpUnitMotionManager::Move(EntityMap<MotionState>& ents, fixed dt)
 	debugDataMotionMgr.m_Quads.clear();
 #endif
 #if DEBUG_STATS
-	int comparisons = 0;
+	std::atomic<int> comparisons = 0;
 	double start = timer_Time();
 #endif
 
 	PROFILE2("MotionMgr_Move");
-	std::unordered_set<std::vector<EntityMap<MotionState>::iterator>*> assigned;
+	// Occupied squares, bucketed by their coordinates modulo 3 for pushing (see below).
+	std::array<std::vector<std::vector<EntityMap<MotionState>::iterator>*>, PUSHING_COLORS> assigned;
+	size_t unitCount = 0;
 	for (EntityMap<MotionState>::iterator it = ents.begin(); it != ents.end(); ++it)
 	{
 		if (!it->second.cmpPosition->IsInWorld())
@@ -457,197 +502,216 @@ void CCmpUnitMotionManager::Move(EntityMap<MotionState>& ents, fixed dt)
 		it->second.pos = it->second.initialPos;
 		it->second.speed = it->second.cmpUnitMotion->GetCurrentSpeed();
 		it->second.angle = it->second.initialAngle;
-		ENSURE(it->second.pos.X.ToInt_RoundToZero() / PUSHING_GRID_SIZE < m_MovingUnits.width() &&
-			   it->second.pos.Y.ToInt_RoundToZero() / PUSHING_GRID_SIZE < m_MovingUnits.height());
-		std::vector<EntityMap<MotionState>::iterator>& subdiv = m_MovingUnits.get(
-			it->second.pos.X.ToInt_RoundToZero() / PUSHING_GRID_SIZE,
-			it->second.pos.Y.ToInt_RoundToZero() / PUSHING_GRID_SIZE
-		);
+		const int x = it->second.pos.X.ToInt_RoundToZero() / PUSHING_GRID_SIZE;
+		const int z = it->second.pos.Y.ToInt_RoundToZero() / PUSHING_GRID_SIZE;
+		ENSURE(x < m_MovingUnits.width() && z < m_MovingUnits.height());
+		std::vector<EntityMap<MotionState>::iterator>& subdiv = m_MovingUnits.get(x, z);
+		if (subdiv.empty())
+			assigned[(z % 3) * 3 + x % 3].push_back(&subdiv);
 		subdiv.emplace_back(it);
-		assigned.emplace(&subdiv);
+		++unitCount;
 	}
 
-	for (std::vector<EntityMap<MotionState>::iterator>* vec : assigned)
-	{
-#if DEBUG_RENDER
-		{
-			SOverlayLine gridL;
-			auto it = (*vec)[0];
-			gridL.PushCoords(CVector3D(it->second.pos.X.ToInt_RoundToZero() / PUSHING_GRID_SIZE * PUSHING_GRID_SIZE,
-									   it->second.cmpPosition->GetHeightFixed().ToDouble() + 2.f,
-									   it->second.pos.Y.ToInt_RoundToZero() / PUSHING_GRID_SIZE * PUSHING_GRID_SIZE));
-			gridL.PushCoords(CVector3D(it->second.pos.X.ToInt_RoundToZero() / PUSHING_GRID_SIZE * PUSHING_GRID_SIZE + PUSHING_GRID_SIZE,
-									   it->second.cmpPosition->GetHeightFixed().ToDouble() + 2.f,
-									   it->second.pos.Y.ToInt_RoundToZero() / PUSHING_GRID_SIZE * PUSHING_GRID_SIZE));
-			gridL.PushCoords(CVector3D(it->second.pos.X.ToInt_RoundToZero() / PUSHING_GRID_SIZE * PUSHING_GRID_SIZE + PUSHING_GRID_SIZE,
-									   it->second.cmpPosition->GetHeightFixed().ToDouble() + 2.f,
-									   it->second.pos.Y.ToInt_RoundToZero() / PUSHING_GRID_SIZE * PUSHING_GRID_SIZE + PUSHING_GRID_SIZE));
-			gridL.PushCoords(CVector3D(it->second.pos.X.ToInt_RoundToZero() / PUSHING_GRID_SIZE * PUSHING_GRID_SIZE,
-									   it->second.cmpPosition->GetHeightFixed().ToDouble() + 2.f,
-									   it->second.pos.Y.ToInt_RoundToZero() / PUSHING_GRID_SIZE * PUSHING_GRID_SIZE + PUSHING_GRID_SIZE));
-			gridL.PushCoords(CVector3D(it->second.pos.X.ToInt_RoundToZero() / PUSHING_GRID_SIZE * PUSHING_GRID_SIZE,
-									   it->second.cmpPosition->GetHeightFixed().ToDouble() + 2.f,
-									   it->second.pos.Y.ToInt_RoundToZero() / PUSHING_GRID_SIZE * PUSHING_GRID_SIZE));
-			gridL.m_Color = CColor(1, 1, 0, 1);
-			debugDataMotionMgr.m_Lines.push_back(gridL);
-		}
+	// Units only write to their own state while moving, pushing and adjusting,
+	// so these phases can be spread over worker threads when there are enough units.
+#if DEBUG_RENDER || DEBUG_STATS
+	const bool async = false;
+#else
+	const bool async = unitCount >= m_MinUnitsForAsyncMotion;
 #endif
-		for (EntityMap<MotionState>::iterator& it : *vec)
+
+	for (std::vector<std::vector<EntityMap<MotionState>::iterator>*>& color : assigned)
+		ForEachSquare(color, async, [&](std::vector<EntityMap<MotionState>::iterator>& vec)
 		{
-			if (it->second.needUpdate)
-				it->second.cmpUnitMotion->Move(it->second, dt);
-			// Decay pressure after moving so we can get the full 0-MAX_PRESSURE range of values.
-			it->second.pushingPressure = (m_PushingPressureDecay * it->second.pushingPressure).ToInt_RoundToZero();
-		}
-	}
+#if DEBUG_RENDER
+			{
+				SOverlayLine gridL;
+				auto it = vec[0];
+				gridL.PushCoords(CVector3D(it->second.pos.X.ToInt_RoundToZero() / PUSHING_GRID_SIZE * PUSHING_GRID_SIZE,
+										   it->second.cmpPosition->GetHeightFixed().ToDouble() + 2.f,
+										   it->second.pos.Y.ToInt_RoundToZero() / PUSHING_GRID_SIZE * PUSHING_GRID_SIZE));
+				gridL.PushCoords(CVector3D(it->second.pos.X.ToInt_RoundToZero() / PUSHING_GRID_SIZE * PUSHING_GRID_SIZE + PUSHING_GRID_SIZE,
+										   it->second.cmpPosition->GetHeightFixed().ToDouble() + 2.f,
+										   it->second.pos.Y.ToInt_RoundToZero() / PUSHING_GRID_SIZE * PUSHING_GRID_SIZE));
+				gridL.PushCoords(CVector3D(it->second.pos.X.ToInt_RoundToZero() / PUSHING_GRID_SIZE * PUSHING_GRID_SIZE + PUSHING_GRID_SIZE,
+										   it->second.cmpPosition->GetHeightFixed().ToDouble() + 2.f,
+										   it->second.pos.Y.ToInt_RoundToZero() / PUSHING_GRID_SIZE * PUSHING_GRID_SIZE + PUSHING_GRID_SIZE));
+				gridL.PushCoords(CVector3D(it->second.pos.X.ToInt_RoundToZero() / PUSHING_GRID_SIZE * PUSHING_GRID_SIZE,
+										   it->second.cmpPosition->GetHeightFixed().ToDouble() + 2.f,
+										   it->second.pos.Y.ToInt_RoundToZero() / PUSHING_GRID_SIZE * PUSHING_GRID_SIZE + PUSHING_GRID_SIZE));
+				gridL.PushCoords(CVector3D(it->second.pos.X.ToInt_RoundToZero() / PUSHING_GRID_SIZE * PUSHING_GRID_SIZE,
+										   it->second.cmpPosition->GetHeightFixed().ToDouble() + 2.f,
+										   it->second.pos.Y.ToInt_RoundToZero() / PUSHING_GRID_SIZE * PUSHING_GRID_SIZE));
+				gridL.m_Color = CColor(1, 1, 0, 1);
+				debugDataMotionMgr.m_Lines.push_back(gridL);
+			}
+#endif
+			for (EntityMap<MotionState>::iterator& it : vec)
+			{
+				if (it->second.needUpdate)
+					it->second.cmpUnitMotion->Move(it->second, dt);
+				// Decay pressure after moving so we can get the full 0-MAX_PRESSURE range of values.
+				it->second.pushingPressure = (m_PushingPressureDecay * it->second.pushingPressure).ToInt_RoundToZero();
+			}
+		});
 
 	// Skip pushing entirely if the radius is 0
 	if (&ents == &m_Units && IsPushingActivated())
 	{
 		PROFILE2("MotionMgr_Pushing");
-		for (std::vector<EntityMap<MotionState>::iterator>* vec : assigned)
-		{
-			ENSURE(!vec->empty());
-			std::vector< std::vector<EntityMap<MotionState>::iterator>* > consider = { vec };
-
-			int x = (*vec)[0]->second.pos.X.ToInt_RoundToZero() / PUSHING_GRID_SIZE;
-			int z = (*vec)[0]->second.pos.Y.ToInt_RoundToZero() / PUSHING_GRID_SIZE;
-			if (x + 1 < m_MovingUnits.width())
-				consider.push_back(&m_MovingUnits.get(x + 1, z));
-			if (x > 0)
-				consider.push_back(&m_MovingUnits.get(x - 1, z));
-			if (z + 1 < m_MovingUnits.height())
-				consider.push_back(&m_MovingUnits.get(x, z + 1));
-			if (z > 0)
-				consider.push_back(&m_MovingUnits.get(x, z - 1));
-
-			for (EntityMap<MotionState>::iterator& it : *vec)
+		// A square pushes the units in itself and its 4 neighbours, both taken from the units' initial positions.
+		// Squares of the same color are at least 3 squares apart along one axis, so they never push the same unit
+		// and can run concurrently.
+		// Pushing only accumulates into the units, so the order of the squares doesn't change the result.
+		for (std::vector<std::vector<EntityMap<MotionState>::iterator>*>& color : assigned)
+			ForEachSquare(color, async, [&](std::vector<EntityMap<MotionState>::iterator>& vec)
 			{
-				if (it->second.ignore)
-					continue;
+				ENSURE(!vec.empty());
+				std::array<std::vector<EntityMap<MotionState>::iterator>*, 5> consider = { &vec };
+				size_t considered = 1;
+
+				// Use the square the units were bucketed in, not where they moved to, to keep the colors apart.
+				const int x = vec[0]->second.initialPos.X.ToInt_RoundToZero() / PUSHING_GRID_SIZE;
+				const int z = vec[0]->second.initialPos.Y.ToInt_RoundToZero() / PUSHING_GRID_SIZE;
+				if (x + 1 < m_MovingUnits.width())
+					consider[considered++] = &m_MovingUnits.get(x + 1, z);
+				if (x > 0)
+					consider[considered++] = &m_MovingUnits.get(x - 1, z);
+				if (z + 1 < m_MovingUnits.height())
+					consider[considered++] = &m_MovingUnits.get(x, z + 1);
+				if (z > 0)
+					consider[considered++] = &m_MovingUnits.get(x, z - 1);
+
+				for (EntityMap<MotionState>::iterator& it : vec)
+				{
+					if (it->second.ignore)
+						continue;
 
 #if DEBUG_RENDER
-				// Plop a sphere at the unit end-pos.
-				{
-					SOverlaySphere sph;
-					sph.m_Center = CVector3D(it->second.pos.X.ToDouble(), it->second.cmpPosition->GetHeightFixed().ToDouble() + 13.f, it->second.pos.Y.ToDouble());
-					sph.m_Radius = it->second.cmpUnitMotion->m_Clearance.Multiply(PUSHING_CORRECTION).ToDouble();
-					// Color the sphere: the redder, the more 'bogged down' it is.
-					sph.m_Color = CColor(it->second.pushingPressure / static_cast<float>(MAX_PRESSURE), 0, 0, 1);
-					debugDataMotionMgr.m_Spheres.push_back(sph);
-				}
-				/* Show the pushing sphere, kinda unreadable.
-				{
-					SOverlaySphere sph;
-					sph.m_Center = CVector3D(it->second.pos.X.ToDouble(), it->second.cmpPosition->GetHeightFixed().ToDouble() + 13.f, it->second.pos.Y.ToDouble());
-					sph.m_Radius = (it->second.cmpUnitMotion->m_Clearance.Multiply(PUSHING_CORRECTION).Multiply(m_PushingRadiusMultiplier) + (it->second.isMoving ? m_StaticPushExtension : m_MovingPushExtension)).ToDouble();
-					// Color the sphere: the redder, the more 'bogged down' it is.
-					sph.m_Color = CColor(it->second.pushingPressure / static_cast<float>(MAX_PRESSURE), 0, 0, 0.1);
-					debugDataMotionMgr.m_Spheres.push_back(sph);
-				}*/
-				// Show the travel over this turn.
-				SOverlayLine line;
-				line.PushCoords(CVector3D(it->second.initialPos.X.ToDouble(),
-										  it->second.cmpPosition->GetHeightFixed().ToDouble() + 13.f,
-										  it->second.initialPos.Y.ToDouble()));
-				line.PushCoords(CVector3D(it->second.pos.X.ToDouble(),
-										  it->second.cmpPosition->GetHeightFixed().ToDouble() + 13.f,
-										  it->second.pos.Y.ToDouble()));
-				line.m_Color = CColor(1, 0, 1, 0.5);
-				debugDataMotionMgr.m_Lines.push_back(line);
+					// Plop a sphere at the unit end-pos.
+					{
+						SOverlaySphere sph;
+						sph.m_Center = CVector3D(it->second.pos.X.ToDouble(), it->second.cmpPosition->GetHeightFixed().ToDouble() + 13.f, it->second.pos.Y.ToDouble());
+						sph.m_Radius = it->second.cmpUnitMotion->m_Clearance.Multiply(PUSHING_CORRECTION).ToDouble();
+						// Color the sphere: the redder, the more 'bogged down' it is.
+						sph.m_Color = CColor(it->second.pushingPressure / static_cast<float>(MAX_PRESSURE), 0, 0, 1);
+						debugDataMotionMgr.m_Spheres.push_back(sph);
+					}
+					/* Show the pushing sphere, kinda unreadable.
+					{
+						SOverlaySphere sph;
+						sph.m_Center = CVector3D(it->second.pos.X.ToDouble(), it->second.cmpPosition->GetHeightFixed().ToDouble() + 13.f, it->second.pos.Y.ToDouble());
+						sph.m_Radius = (it->second.cmpUnitMotion->m_Clearance.Multiply(PUSHING_CORRECTION).Multiply(m_PushingRadiusMultiplier) + (it->second.isMoving ? m_StaticPushExtension : m_MovingPushExtension)).ToDouble();
+						// Color the sphere: the redder, the more 'bogged down' it is.
+						sph.m_Color = CColor(it->second.pushingPressure / static_cast<float>(MAX_PRESSURE), 0, 0, 0.1);
+						debugDataMotionMgr.m_Spheres.push_back(sph);
+					}*/
+					// Show the travel over this turn.
+					SOverlayLine line;
+					line.PushCoords(CVector3D(it->second.initialPos.X.ToDouble(),
+											  it->second.cmpPosition->GetHeightFixed().ToDouble() + 13.f,
+											  it->second.initialPos.Y.ToDouble()));
+					line.PushCoords(CVector3D(it->second.pos.X.ToDouble(),
+											  it->second.cmpPosition->GetHeightFixed().ToDouble() + 13.f,
+											  it->second.pos.Y.ToDouble()));
+					line.m_Color = CColor(1, 0, 1, 0.5);
+					debugDataMotionMgr.m_Lines.push_back(line);
 #endif
-				for (std::vector<EntityMap<MotionState>::iterator>* vec2 : consider)
-					for (EntityMap<MotionState>::iterator& it2 : *vec2)
-						if (it->first < it2->first && !it2->second.ignore)
-						{
+					for (size_t i = 0; i < considered; ++i)
+						for (EntityMap<MotionState>::iterator& it2 : *consider[i])
+							if (it->first < it2->first && !it2->second.ignore)
+							{
 #if DEBUG_STATS
-							++comparisons;
+								++comparisons;
 #endif
-							Push(*it, *it2, dt);
-						}
-			}
-		}
+								Push(*it, *it2, dt);
+							}
+				}
+			});
 	}
 
 	if (IsPushingActivated())
 	{
 		PROFILE2("MotionMgr_PushAdjust");
 		CmpPtr<ICmpPathfinder> cmpPathfinder(GetSystemEntity());
-		for (std::vector<EntityMap<MotionState>::iterator>* vec : assigned)
-		{
-			for (EntityMap<MotionState>::iterator& it : *vec)
+		for (std::vector<std::vector<EntityMap<MotionState>::iterator>*>& color : assigned)
+			ForEachSquare(color, async, [&](std::vector<EntityMap<MotionState>::iterator>& vec)
 			{
+				for (EntityMap<MotionState>::iterator& it : vec)
+				{
 
-				if (!it->second.needUpdate || it->second.ignore)
-					continue;
+					if (!it->second.needUpdate || it->second.ignore)
+						continue;
 
 #if DEBUG_RENDER
-				SOverlayLine line;
-				line.PushCoords(CVector3D(it->second.pos.X.ToDouble(),
-										  it->second.cmpPosition->GetHeightFixed().ToDouble() + 15.1f ,
-										  it->second.pos.Y.ToDouble()));
-				line.PushCoords(CVector3D(it->second.pos.X.ToDouble() + it->second.push.X.ToDouble() * 10.f,
-										  it->second.cmpPosition->GetHeightFixed().ToDouble() + 15.1f ,
-										  it->second.pos.Y.ToDouble() + it->second.push.Y.ToDouble() * 10.f));
-				line.m_Thickness = 0.05f;
+					SOverlayLine line;
+					line.PushCoords(CVector3D(it->second.pos.X.ToDouble(),
+											  it->second.cmpPosition->GetHeightFixed().ToDouble() + 15.1f ,
+											  it->second.pos.Y.ToDouble()));
+					line.PushCoords(CVector3D(it->second.pos.X.ToDouble() + it->second.push.X.ToDouble() * 10.f,
+											  it->second.cmpPosition->GetHeightFixed().ToDouble() + 15.1f ,
+											  it->second.pos.Y.ToDouble() + it->second.push.Y.ToDouble() * 10.f));
+					line.m_Thickness = 0.05f;
 #endif
 
-				// Only apply pushing if the effect is significant enough.
-				if (it->second.push.CompareLength(m_MinimalPushing) <= 0)
-				{
+					// Only apply pushing if the effect is significant enough.
+					if (it->second.push.CompareLength(m_MinimalPushing) <= 0)
+					{
 #if DEBUG_RENDER
-					line.m_Color = CColor(1, 1, 0, 0.6);
-					debugDataMotionMgr.m_Lines.push_back(line);
+						line.m_Color = CColor(1, 1, 0, 0.6);
+						debugDataMotionMgr.m_Lines.push_back(line);
 #endif
-					it->second.push = CFixedVector2D();
-					continue;
-				}
-
-				// If there was an attempt at movement, and we're getting pushed significantly and
-				// away from where we'd like to go (measured by a low dot product)
-				// then mark the unit as obstructed, but push anyways.
-				// (this helps units stop earlier in many situations in a realistic-ish manner).
-				if (it->second.pos != it->second.initialPos
-					&& (it->second.pos - it->second.initialPos).Dot(it->second.pos + it->second.push - it->second.initialPos)  < entity_pos_t::FromInt(1)/2 && it->second.pushingPressure > 30)
-				{
-					it->second.wasObstructed = true;
-					it->second.pushingPressure = std::max<uint8_t>(MIN_PRESSURE_IF_OBSTRUCTED, it->second.pushingPressure);
-					// Push anyways.
-				}
+						it->second.push = CFixedVector2D();
+						continue;
+					}
+
+					// If there was an attempt at movement, and we're getting pushed significantly and
+					// away from where we'd like to go (measured by a low dot product)
+					// then mark the unit as obstructed, but push anyways.
+					// (this helps units stop earlier in many situations in a realistic-ish manner).
+					if (it->second.pos != it->second.initialPos
+						&& (it->second.pos - it->second.initialPos).Dot(it->second.pos + it->second.push - it->second.initialPos)  < entity_pos_t::FromInt(1)/2 && it->second.pushingPressure > 30)
+					{
+						it->second.wasObstructed = true;
+						it->second.pushingPressure = std::max<uint8_t>(MIN_PRESSURE_IF_OBSTRUCTED, it->second.pushingPressure);
+						// Push anyways.
+					}
 #if DEBUG_RENDER
-				if (it->second.wasObstructed)
-					line.m_Color = CColor(1, 0, 0, 1);
-				else
-					line.m_Color = CColor(0, 1, 0, 1);
-				debugDataMotionMgr.m_Lines.push_back(line);
+					if (it->second.wasObstructed)
+						line.m_Color = CColor(1, 0, 0, 1);
+					else
+						line.m_Color = CColor(0, 1, 0, 1);
+					debugDataMotionMgr.m_Lines.push_back(line);
 #endif
-				// Dampen the pushing by the current pushing pressure
-				// (but prevent full dampening so that clumped units still get unclumped).
-				it->second.push = it->second.push * (MAX_PRESSURE - std::min<uint8_t>(MAX_PUSH_DAMPING_PRESSURE, it->second.pushingPressure)) / MAX_PRESSURE;
-
-				// Prevent pushed units from crossing uncrossable boundaries
-				// (we can assume that normal movement didn't push units into impassable terrain).
-				if ((it->second.push.X != entity_pos_t::Zero() || it->second.push.Y != entity_pos_t::Zero()) &&
-					!cmpPathfinder->CheckMovement(it->second.cmpUnitMotion->GetObstructionFilter(),
-						it->second.pos.X, it->second.pos.Y,
-						it->second.pos.X + it->second.push.X, it->second.pos.Y + it->second.push.Y,
-						it->second.cmpUnitMotion->m_Clearance,
-						it->second.cmpUnitMotion->m_PassClass))
-				{
-					// Mark them as obstructed - this could possibly be optimised
-					// perhaps it'd make more sense to mark the pushers as blocked.
-					it->second.wasObstructed = true;
-					it->second.wentStraight = false;
+					// Dampen the pushing by the current pushing pressure
+					// (but prevent full dampening so that clumped units still get unclumped).
+					it->second.push = it->second.push * (MAX_PRESSURE - std::min<uint8_t>(MAX_PUSH_DAMPING_PRESSURE, it->second.pushingPressure)) / MAX_PRESSURE;
+
+					// Prevent pushed units from crossing uncrossable boundaries
+					// (we can assume that normal movement didn't push units into impassable terrain).
+					if ((it->second.push.X != entity_pos_t::Zero() || it->second.push.Y != entity_pos_t::Zero()) &&
+						!cmpPathfinder->CheckMovement(it->second.cmpUnitMotion->GetObstructionFilter(),
+							it->second.pos.X, it->second.pos.Y,
+							it->second.pos.X + it->second.push.X, it->second.pos.Y + it->second.push.Y,
+							it->second.cmpUnitMotion->m_Clearance,
+							it->second.cmpUnitMotion->m_PassClass))
+					{
+						// Mark them as obstructed - this could possibly be optimised
+						// perhaps it'd make more sense to mark the pushers as blocked.
+						it->second.wasObstructed = true;
+						it->second.wentStraight = false;
+						it->second.push = CFixedVector2D();
+						continue;
+					}
+					it->second.pos += it->second.push;
 					it->second.push = CFixedVector2D();
-					continue;
 				}
-				it->second.pos += it->second.push;
-				it->second.push = CFixedVector2D();
-			}
-		}
+			});
 	}
 	{
 		PROFILE2("MotionMgr_PostMove");
+		// Let the range manager etc. handle the moves of all units at once.
+		CComponentManager::ScopedPositionChangeBatch batch(GetSimContext().GetComponentManager());
 		for (EntityMap<MotionState>::value_type& data : ents)
 		{
 			if (!data.second.needUpdate)
@@ -656,15 +720,16 @@ void CCmpUnitMotionManager::Move(EntityMap<MotionState>& ents, fixed dt)
 		}
 	}
 #if DEBUG_STATS
-	int size = 0;
-	for (std::vector<EntityMap<MotionState>::iterator>* vec : assigned)
-		size += vec->size();
+	size_t squares = 0;
+	for (const std::vector<std::vector<EntityMap<MotionState>::iterator>*>& color : assigned)
+		squares += color.size();
 	double time = timer_Time() - start;
 	if (comparisons > 0)
-		printf(">> %i comparisons over %li grids, %f units per grid in %f secs\n", comparisons, assigned.size(), size / (float)(assigned.size()), time);
+		printf(">> %i comparisons over %zu grids, %f units per grid in %f secs\n", comparisons.load(), squares, unitCount / (float)squares, time);
 #endif
-	for (std::vector<EntityMap<MotionState>::iterator>* vec : assigned)
-		vec->clear();
+	for (std::vector<std::vector<EntityMap<MotionState>::iterator>*>& color : assigned)
+		for (std::vector<EntityMap<MotionState>::iterator>* vec : color)
+			vec->clear();
 }
 
 // TODO: ought to better simulate in-flight pushing, e.g. if units would cross in-between turns.
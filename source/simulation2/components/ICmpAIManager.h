@@ -1,4 +1,4 @@
-/* Copyright (C) 2025 Wildfire Games.
+/* Copyright (C) 2026 Wildfire Games.
  * This file is part of 0 A.D.
  *
  * 0 A.D. is free software: you can redistribute it and/or modify
@@ -38,6 +38,15 @@ public:
 	 */
 	virtual void AddPlayer(const std::wstring& id, player_id_t player, uint8_t difficulty, const std::wstring&) = 0;
 	virtual void SetRNGSeed(uint32_t seed) = 0;
+
+	/**
+	 * Opt in to running every AI player on its own thread, in a separate script runtime.
+	 * The commands computed at the end of a turn are then pushed @p turns turns later,
+	 * so that the simulation doesn't depend on how fast the AI threads are.
+	 * Zero, the default, runs the AI in the simulation thread.
+	 * This must be set before any AI player is added.
+	 */
+	virtual void SetCommandDelay(uint32_t turns) = 0;
 	virtual void TryLoadSharedComponent() = 0;
 	virtual void RunGamestateInit() = 0;
 
@@ -0,0 +1,273 @@
+/* Copyright (C) 2026 Wildfire Games.
+ * This file is part of 0 A.D.
+ *
+ * 0 A.D. is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * 0 A.D. is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with 0 A.D.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "lib/self_test.h"
+
+#include "lib/file/file_system.h"
+#include "lib/file/io/write_buffer.h"
+#include "lib/file/vfs/vfs.h"
+#include "lib/path.h"
+#include "ps/Filesystem.h"
+#include "ps/XML/Xeromyces.h"
+#include "scriptinterface/Object.h"
+#include "scriptinterface/ScriptInterface.h"
+#include "scriptinterface/ScriptRequest.h"
+#include "simulation2/components/ICmpAIInterface.h"
+#include "simulation2/components/ICmpAIManager.h"
+#include "simulation2/components/ICmpCommandQueue.h"
+#include "simulation2/components/ICmpTemplateManager.h"
+#include "simulation2/helpers/Player.h"
+#include "simulation2/serialization/StdSerializer.h"
+#include "simulation2/system/Component.h"
+#include "simulation2/system/ComponentTest.h"
+#include "simulation2/system/Entity.h"
+
+#include <js/RootingAPI.h>
+#include <js/TypeDecls.h>
+#include <js/Value.h>
+#include <optional>
+#include <sstream>
+#include <string>
+#include <vector>
+
+class MockAIInterfaceAIM : public ICmpAIInterface
+{
+public:
+	DEFAULT_MOCK_COMPONENT()
+
+	MockAIInterfaceAIM(const ScriptInterface& scriptInterface) : m_ScriptInterface(scriptInterface) {}
+
+	void GetRepresentation(JS::MutableHandleValue ret) override
+	{
+		Script::CreateObject(ScriptRequest(m_ScriptInterface), ret);
+	}
+
+	void GetFullRepresentation(JS::MutableHandleValue ret, bool /*flushEvents*/) override
+	{
+		Script::CreateObject(ScriptRequest(m_ScriptInterface), ret);
+	}
+
+	const ScriptInterface& m_ScriptInterface;
+};
+
+class MockTemplateManagerAIM : public ICmpTemplateManager
+{
+public:
+	DEFAULT_MOCK_COMPONENT()
+
+	const CParamNode* LoadTemplate(entity_id_t /*ent*/, const std::string& /*templateName*/) override { return nullptr; }
+	const CParamNode* GetTemplate(const std::string& /*templateName*/) override { return nullptr; }
+	const CParamNode* GetTemplateWithoutValidation(const std::string& /*templateName*/) override { return nullptr; }
+	bool TemplateExists(const std::string& /*templateName*/) const override { return false; }
+	const CParamNode* LoadLatestTemplate(entity_id_t /*ent*/) override { return nullptr; }
+	std::string GetCurrentTemplateName(entity_id_t /*ent*/) const override { return {}; }
+	std::vector<entity_id_t> GetEntitiesUsingTemplate(const std::string& /*templateName*/) const override { return {}; }
+	std::vector<std::string> FindAllTemplates(bool /*includeActors*/) const override { return {}; }
+	std::vector<std::vector<std::wstring>> GetCivData() override { return {}; }
+	std::vector<std::string> FindUsedTemplates() const override { return {}; }
+	void DisableValidation() override {}
+};
+
+/**
+ * Records the commands pushed by the AI manager.
+ */
+class MockCommandQueueAIM : public ICmpCommandQueue
+{
+public:
+	DEFAULT_MOCK_COMPONENT()
+
+	struct Command
+	{
+		player_id_t player;
+		u32 turn;
+		u32 random;
+
+		bool operator==(const Command& other) const = default;
+	};
+
+	MockCommandQueueAIM(const ScriptInterface& scriptInterface) : m_ScriptInterface(scriptInterface) {}
+
+	void PushLocalCommand(player_id_t player, JS::HandleValue cmd) override
+	{
+		ScriptRequest rq(m_ScriptInterface);
+		Command& command = m_Commands.emplace_back();
+		command.player = player;
+		TS_ASSERT(Script::GetProperty(rq, cmd, "turn", command.turn));
+		TS_ASSERT(Script::GetProperty(rq, cmd, "random", command.random));
+	}
+
+	void PostNetworkCommand(JS::HandleValue /*cmd*/) override {}
+	void FlushTurn(const std::vector<SimulationCommand>& /*commands*/) override {}
+
+	const ScriptInterface& m_ScriptInterface;
+	std::vector<Command> m_Commands;
+};
+
+class TestCmpAIManager : public CxxTest::TestSuite
+{
+	std::optional<CXeromycesEngine> xeromycesEngine;
+
+	static void WriteFile(const VfsPath& path, const std::string& contents)
+	{
+		WriteBuffer buffer;
+		buffer.Append(contents.data(), contents.size());
+		TS_ASSERT_OK(g_VFS->CreateFile(path, buffer.Data(), buffer.Size()));
+	}
+
+	/**
+	 * Sets up an AI manager running two AI players with the given command delay.
+	 */
+	struct TestAIManager
+	{
+		TestAIManager() :
+			helper(*g_ScriptContext),
+			aiInterface(helper.GetScriptInterface()),
+			commandQueue(helper.GetScriptInterface())
+		{
+		}
+
+		void AddMocks()
+		{
+			helper.AddMock(SYSTEM_ENTITY, IID_AIInterface, aiInterface);
+			helper.AddMock(SYSTEM_ENTITY, IID_TemplateManager, templateManager);
+			helper.AddMock(SYSTEM_ENTITY, IID_CommandQueue, commandQueue);
+		}
+
+		void AddPlayers(u32 delay)
+		{
+			cmp = helper.Add<ICmpAIManager>(CID_AIManager, "", SYSTEM_ENTITY);
+			AddMocks();
+			cmp->SetCommandDelay(delay);
+			cmp->SetRNGSeed(42);
+			cmp->AddPlayer(L"delay_test", 1, 0, L"balanced");
+			cmp->AddPlayer(L"delay_test", 2, 0, L"balanced");
+		}
+
+		void Deserialize(std::istream& stream)
+		{
+			AddMocks();
+			cmp = helper.AddDeserialized<ICmpAIManager>(CID_AIManager, stream, SYSTEM_ENTITY);
+		}
+
+		/**
+		 * Runs a turn like CSimulation2 does, and returns the commands pushed in it.
+		 */
+		std::vector<MockCommandQueueAIM::Command> Turn()
+		{
+			commandQueue.m_Commands.clear();
+			cmp->StartComputation();
+			cmp->PushCommands();
+			return commandQueue.m_Commands;
+		}
+
+		std::string Serialize()
+		{
+			std::stringstream stream;
+			CStdSerializer serializer(helper.GetScriptInterface(), stream);
+			cmp->Serialize(serializer);
+			return stream.str();
+		}
+
+		ComponentTestHelper helper;
+		MockAIInterfaceAIM aiInterface;
+		MockTemplateManagerAIM templateManager;
+		MockCommandQueueAIM commandQueue;
+		ICmpAIManager* cmp = nullptr;
+	};
+
+public:
+	void setUp()
+	{
+		g_VFS = CreateVfs();
+		TS_ASSERT_OK(g_VFS->Mount(L"", DataDir() / "_testcache" / "", 0, VFS_MAX_PRIORITY));
+
+		// An AI posting one command per turn, with its turn number and a random number.
+		WriteFile(L"simulation/ai/delay_test/data.json",
+			R"({ "filename": "delay_test.js", "constructor": "DelayTestAI", "useShared": false })");
+		WriteFile(L"simulation/ai/delay_test/delay_test.js", R"(
+			export class DelayTestAI
+			{
+				constructor(settings)
+				{
+					this.turn = 0;
+				}
+
+				HandleMessage(state, player)
+				{
+					Engine.PostCommand(player, { "turn": this.turn++, "random": Math.floor(Math.random() * 1000000) });
+				}
+			})");
+
+		xeromycesEngine.emplace();
+	}
+
+	void tearDown()
+	{
+		xeromycesEngine.reset();
+		g_VFS.reset();
+		DeleteDirectory(DataDir()/"_testcache");
+	}
+
+	void test_command_delay()
+	{
+		TestAIManager test;
+		test.AddPlayers(2);
+
+		// The commands computed at the end of a turn are pushed two turns later.
+		TS_ASSERT(test.Turn().empty());
+		TS_ASSERT(test.Turn().empty());
+		for (u32 turn = 0; turn < 3; ++turn)
+		{
+			const std::vector<MockCommandQueueAIM::Command> commands = test.Turn();
+			TS_ASSERT_EQUALS(commands.size(), 2);
+			if (commands.size() != 2)
+				return;
+			TS_ASSERT_EQUALS(commands[0].player, 1);
+			TS_ASSERT_EQUALS(commands[0].turn, turn);
+			TS_ASSERT_EQUALS(commands[1].player, 2);
+			TS_ASSERT_EQUALS(commands[1].turn, turn);
+
+			// Each AI player has its own seed.
+			TS_ASSERT_DIFFERS(commands[0].random, commands[1].random);
+		}
+	}
+
+	void test_command_delay_serialization()
+	{
+		TestAIManager test;
+		test.AddPlayers(2);
+
+		// Serialize while the commands of the last two turns are still pending.
+		TS_ASSERT(test.Turn().empty());
+		TS_ASSERT(test.Turn().empty());
+		std::stringstream stream(test.Serialize());
+
+		TestAIManager test2;
+		test2.Deserialize(stream);
+		TS_ASSERT_EQUALS(test.Serialize(), test2.Serialize());
+
+		for (u32 turn = 0; turn < 3; ++turn)
+		{
+			const std::vector<MockCommandQueueAIM::Command> commands = test.Turn();
+			TS_ASSERT_EQUALS(commands.size(), 2);
+			TS_ASSERT(commands == test2.Turn());
+			if (!commands.empty())
+				TS_ASSERT_EQUALS(commands[0].turn, turn);
+		}
+		TS_ASSERT_EQUALS(test.Serialize(), test2.Serialize());
+	}
+};
@@ -1,4 +1,4 @@
-/* Copyright (C) 2025 Wildfire Games.
+/* Copyright (C) 2026 Wildfire Games.
  * This file is part of 0 A.D.
  *
  * 0 A.D. is free software: you can redistribute it and/or modify
@@ -81,6 +81,12 @@ public:
 		}
 	}
 
+	size_t count_edges(const HierarchicalPathfinder& hierPath, u16 i, u16 j)
+	{
+		const HierarchicalPathfinder::RegionGraph& graph = hierPath.GetGraph(PASS_1);
+		return graph.Neighbors(hierPath.RegionIndex(graph, hierPath.Get(i, j, PASS_1))).size();
+	}
+
 	void assert_blank(HierarchicalPathfinder& hierPath)
 	{
 		// test that the map has the same global region everywhere
@@ -97,13 +103,13 @@ public:
 		hierPath.FindNearestPassableNavcell(i, j, PASS_1);
 		TS_ASSERT(i == 89 && j == 34);
 
-		for (auto& chunk : hierPath.m_Chunks[PASS_1])
+		for (auto& chunk : hierPath.GetGraph(PASS_1).m_Chunks)
 			TS_ASSERT(chunk.m_RegionsID.size() == 1);
 
 		// number of connected regions: 4 in the middle, 2 in the corners.
-		TS_ASSERT(hierPath.m_Edges[PASS_1][hierPath.Get(120, 120, PASS_1)].size() == 4);
-		TS_ASSERT(hierPath.m_Edges[PASS_1][hierPath.Get(20,  20,  PASS_1)].size() == 2);
-		TS_ASSERT(hierPath.m_Edges[PASS_1][hierPath.Get(220, 220, PASS_1)].size() == 2);
+		TS_ASSERT(count_edges(hierPath, 120, 120) == 4);
+		TS_ASSERT(count_edges(hierPath, 20, 20) == 2);
+		TS_ASSERT(count_edges(hierPath, 220, 220) == 2);
 
 		std::set<HierarchicalPathfinder::RegionID> reachables;
 		hierPath.FindReachableRegions(hierPath.Get(120, 120, PASS_1), reachables, PASS_1);
@@ -167,10 +173,10 @@ public:
 			}
 
 		// number of connected regions: 3 in the middle (both sides), 2 in the corners.
-		TS_ASSERT(hierPath.m_Edges[PASS_1][hierPath.Get(120, 120, PASS_1)].size() == 3);
-		TS_ASSERT(hierPath.m_Edges[PASS_1][hierPath.Get(170, 120, PASS_1)].size() == 3);
-		TS_ASSERT(hierPath.m_Edges[PASS_1][hierPath.Get(20,  20,  PASS_1)].size() == 2);
-		TS_ASSERT(hierPath.m_Edges[PASS_1][hierPath.Get(220, 220, PASS_1)].size() == 2);
+		TS_ASSERT(count_edges(hierPath, 120, 120) == 3);
+		TS_ASSERT(count_edges(hierPath, 170, 120) == 3);
+		TS_ASSERT(count_edges(hierPath, 20, 20) == 2);
+		TS_ASSERT(count_edges(hierPath, 220, 220) == 2);
 
 		std::set<HierarchicalPathfinder::RegionID> reachables;
 		hierPath.FindReachableRegions(hierPath.Get(120, 120, PASS_1), reachables, PASS_1);
@@ -200,7 +206,7 @@ public:
 		reachables.clear();
 		hierPath.FindReachableRegions(hierPath.Get(170, 120, PASS_1), reachables, PASS_1);
 		TS_ASSERT(reachables.size() == 9);
-		TS_ASSERT(hierPath.m_Edges[PASS_1][hierPath.Get(170, 120, PASS_1)].size() == 4);
+		TS_ASSERT(count_edges(hierPath, 170, 120) == 4);
 
 		//////////////////////////////////////////////////////
 		// Block a strip along the edge, but regions are still connected.
@@ -213,9 +219,9 @@ public:
 		reachables.clear();
 		hierPath.FindReachableRegions(hierPath.Get(170, 120, PASS_1), reachables, PASS_1);
 		TS_ASSERT(reachables.size() == 9);
-		TS_ASSERT(hierPath.m_Edges[PASS_1][hierPath.Get(20, 120, PASS_1)].size() == 2);
-		TS_ASSERT(hierPath.m_Edges[PASS_1][hierPath.Get(170, 120, PASS_1)].size() == 3);
-		TS_ASSERT(hierPath.m_Edges[PASS_1][hierPath.Get(200, 120, PASS_1)].size() == 3);
+		TS_ASSERT(count_edges(hierPath, 20, 120) == 2);
+		TS_ASSERT(count_edges(hierPath, 170, 120) == 3);
+		TS_ASSERT(count_edges(hierPath, 200, 120) == 3);
 
 		//////////////////////////////////////////////////////
 		// Block the other edge
@@ -228,9 +234,9 @@ public:
 		reachables.clear();
 		hierPath.FindReachableRegions(hierPath.Get(170, 120, PASS_1), reachables, PASS_1);
 		TS_ASSERT(reachables.size() == 9);
-		TS_ASSERT(hierPath.m_Edges[PASS_1][hierPath.Get(20, 120, PASS_1)].size() == 2);
-		TS_ASSERT(hierPath.m_Edges[PASS_1][hierPath.Get(170, 120, PASS_1)].size() == 2);
-		TS_ASSERT(hierPath.m_Edges[PASS_1][hierPath.Get(200, 120, PASS_1)].size() == 2);
+		TS_ASSERT(count_edges(hierPath, 20, 120) == 2);
+		TS_ASSERT(count_edges(hierPath, 170, 120) == 2);
+		TS_ASSERT(count_edges(hierPath, 200, 120) == 2);
 
 		//////////////////////////////////////////////////////
 		// Create an isolated region in the middle chunk
@@ -259,10 +265,10 @@ public:
 		reachables.clear();
 		hierPath.FindReachableRegions(hierPath.Get(120, 120, PASS_1), reachables, PASS_1);
 		TS_ASSERT(reachables.size() == 1);
-		TS_ASSERT(hierPath.m_Edges[PASS_1][hierPath.Get(120, 120, PASS_1)].size() == 0);
-		TS_ASSERT(hierPath.m_Edges[PASS_1][hierPath.Get(20, 120, PASS_1)].size() == 2);
-		TS_ASSERT(hierPath.m_Edges[PASS_1][hierPath.Get(170, 120, PASS_1)].size() == 2);
-		TS_ASSERT(hierPath.m_Edges[PASS_1][hierPath.Get(200, 120, PASS_1)].size() == 2);
+		TS_ASSERT(count_edges(hierPath, 120, 120) == 0);
+		TS_ASSERT(count_edges(hierPath, 20, 120) == 2);
+		TS_ASSERT(count_edges(hierPath, 170, 120) == 2);
+		TS_ASSERT(count_edges(hierPath, 200, 120) == 2);
 
 		//////////////////////////////////////////////////////
 		// Open it
@@ -280,7 +286,50 @@ public:
 		reachables.clear();
 		hierPath.FindReachableRegions(hierPath.Get(120, 120, PASS_1), reachables, PASS_1);
 		TS_ASSERT(reachables.size() == 9);
-		TS_ASSERT(hierPath.m_Edges[PASS_1][hierPath.Get(120, 120, PASS_1)].size() == 2);
+		TS_ASSERT(count_edges(hierPath, 120, 120) == 2);
+	}
+
+	void test_update_removing_all_regions_of_a_chunk()
+	{
+		pathClassMask = std::map<std::string, pass_class_t> {
+			{ "1", 1 },
+			{ "2", 2 },
+		};
+		nonPathClassMask = std::map<std::string, pass_class_t> {
+			{ "3", 4 }
+		};
+
+		// The two sides of the map are only connected through the middle chunk.
+		HierarchicalPathfinder hierPath;
+		Grid<NavcellData> grid(mapSize, mapSize);
+		Grid<u8> dirtyGrid(mapSize, mapSize);
+		for (u16 i = 0; i < mapSize; ++i)
+			for (u16 j = 0; j < mapSize; ++j)
+				grid.set(i, j, (i >= 96 && i < 192 && (j < 96 || j >= 192)) ? 7 : 6);
+		hierPath.Recompute(&grid, nonPathClassMask, pathClassMask);
+
+		TS_ASSERT(hierPath.GetGlobalRegion(50, 50, PASS_1) == hierPath.GetGlobalRegion(220, 50, PASS_1));
+		TS_ASSERT(hierPath.GetGlobalRegion(50, 50, PASS_1) == hierPath.GetGlobalRegion(150, 150, PASS_1));
+
+		// Block the middle chunk entirely: it has no region left, but the sides must still be split.
+		for (u16 i = 96; i < 192; ++i)
+			for (u16 j = 96; j < 192; ++j)
+			{
+				grid.set(i, j, 7);
+				dirtyGrid.set(i, j, 1);
+			}
+		hierPath.Update(&grid, dirtyGrid);
+
+		TS_ASSERT(hierPath.GetGraph(PASS_1).m_Chunks[4].m_RegionsID.empty());
+		TS_ASSERT(hierPath.GetGlobalRegion(50, 50, PASS_1) != hierPath.GetGlobalRegion(220, 50, PASS_1));
+		TS_ASSERT(hierPath.GetGlobalRegion(50, 50, PASS_1) == hierPath.GetGlobalRegion(50, 220, PASS_1));
+		TS_ASSERT(hierPath.GetGlobalRegion(220, 50, PASS_1) == hierPath.GetGlobalRegion(220, 220, PASS_1));
+
+		PathGoal goal;
+		goal.type = PathGoal::POINT;
+		goal.x = fixed::FromInt(220);
+		goal.z = fixed::FromInt(50);
+		TS_ASSERT(!hierPath.IsGoalReachable(50, 50, goal, PASS_1));
 	}
 
 	u16 manhattan(u16 i, u16 j, u16 gi, u16 gj)
@@ -528,7 +577,57 @@ public:
 					grid.set(i, j, gridDef[i][j]);
 		hierPath.Recompute(&grid, nonPathClassMask, pathClassMask);
 
-		TS_ASSERT_EQUALS(hierPath.m_Chunks[pathClassMask["1"]][0].m_RegionsID.size(), 2);
-		TS_ASSERT_EQUALS(hierPath.m_Chunks[pathClassMask["1"]][0].m_RegionsID.back(), 4);
+		TS_ASSERT_EQUALS(hierPath.GetGraph(pathClassMask["1"]).m_Chunks[0].m_RegionsID.size(), 2);
+		TS_ASSERT_EQUALS(hierPath.GetGraph(pathClassMask["1"]).m_Chunks[0].m_RegionsID.back(), 4);
+	}
+
+	void test_corridor()
+	{
+		pathClassMask = std::map<std::string, pass_class_t> {
+			{ "1", 1 },
+			{ "2", 2 },
+		};
+		nonPathClassMask = std::map<std::string, pass_class_t> {
+			{ "3", 4 }
+		};
+
+		// Large enough for a corridor not to cover the whole map.
+		const u16 size = 600;
+		HierarchicalPathfinder hierPath;
+		Grid<NavcellData> grid(size, size);
+		for (u16 i = 0; i < size; ++i)
+			for (u16 j = 0; j < size; ++j)
+				grid.set(i, j, 6);
+		hierPath.Recompute(&grid, nonPathClassMask, pathClassMask);
+
+		// On an open map, the corridor follows the straight line.
+		PathCorridor corridor;
+		TS_ASSERT(hierPath.FindCorridor(10, 10, 10, 590, PASS_1, corridor));
+		TS_ASSERT(corridor.Contains(10, 10));
+		TS_ASSERT(corridor.Contains(10, 300));
+		TS_ASSERT(corridor.Contains(10, 590));
+		TS_ASSERT(corridor.Contains(150, 300));
+		TS_ASSERT(!corridor.Contains(250, 300));
+		TS_ASSERT(!corridor.Contains(590, 590));
+
+		// Add a wall with a gap on the far side: the corridor must go through the gap.
+		for (u16 i = 0; i < 500; ++i)
+			for (u16 j = 290; j < 300; ++j)
+				grid.set(i, j, 7);
+		hierPath.Recompute(&grid, nonPathClassMask, pathClassMask);
+
+		TS_ASSERT(hierPath.FindCorridor(10, 10, 10, 590, PASS_1, corridor));
+		TS_ASSERT(corridor.Contains(10, 10));
+		TS_ASSERT(corridor.Contains(10, 590));
+		TS_ASSERT(corridor.Contains(550, 295));
+
+		// Close the gap: there is no route any more, and the corridor is left untouched.
+		for (u16 i = 500; i < size; ++i)
+			for (u16 j = 290; j < 300; ++j)
+				grid.set(i, j, 7);
+		hierPath.Recompute(&grid, nonPathClassMask, pathClassMask);
+
+		TS_ASSERT(!hierPath.FindCorridor(10, 10, 10, 590, PASS_1, corridor));
+		TS_ASSERT(corridor.Contains(550, 295));
 	}
 };
@@ -1,4 +1,4 @@
-/* Copyright (C) 2025 Wildfire Games.
+/* Copyright (C) 2026 Wildfire Games.
  * This file is part of 0 A.D.
  *
  * 0 A.D. is free software: you can redistribute it and/or modify
@@ -23,7 +23,10 @@
 #include "scriptinterface/ScriptInterface.h"
 #include "simulation2/components/ICmpObstruction.h"
 #include "simulation2/components/ICmpObstructionManager.h"
+#include "simulation2/helpers/Grid.h"
+#include "simulation2/helpers/Pathfinding.h"
 #include "simulation2/helpers/Position.h"
+#include "simulation2/system/ParamNode.h"
 #include "simulation2/system/Component.h"
 #include "simulation2/system/ComponentTest.h"
 #include "simulation2/system/Entity.h"
@@ -608,4 +611,81 @@ public:
 		TS_ASSERT(!cmp->IsInTargetRange(ent1, ent5, fixed::FromInt(10), fixed::FromInt(10), false));
 		TS_ASSERT(cmp->IsInTargetRange(ent1, ent5, fixed::FromInt(10), fixed::FromInt(10), true));
 	}
+
+	/**
+	 * Verifies that the tags of removed shapes are reused lowest first, and that
+	 * the shapes roundtrip through serialization.
+	 */
+	void test_tag_reuse()
+	{
+		cmp->RemoveShape(shape3);
+		cmp->RemoveShape(shape2);
+
+		tag_t shape4 = cmp->AddUnitShape(4, fixed::FromInt(20), fixed::FromInt(30), ent2c, ICmpObstructionManager::FLAG_BLOCK_MOVEMENT, 4);
+		tag_t shape5 = cmp->AddUnitShape(5, fixed::FromInt(40), fixed::FromInt(30), ent3c, ICmpObstructionManager::FLAG_BLOCK_MOVEMENT, 5);
+		tag_t shape6 = cmp->AddUnitShape(6, fixed::FromInt(60), fixed::FromInt(30), ent3c, ICmpObstructionManager::FLAG_BLOCK_MOVEMENT, 6);
+		TS_ASSERT_EQUALS(shape4.n, shape2.n);
+		TS_ASSERT_EQUALS(shape5.n, shape3.n);
+		TS_ASSERT(shape6.n != shape1.n && shape6.n != shape2.n && shape6.n != shape3.n);
+
+		ObstructionSquare obSquare = cmp->GetObstruction(shape4);
+		TS_ASSERT_EQUALS(obSquare.x, fixed::FromInt(20));
+		TS_ASSERT_EQUALS(obSquare.hw, ent2c);
+
+		NullObstructionFilter filter;
+		std::vector<entity_id_t> out;
+		TS_ASSERT(cmp->TestUnitShape(filter, fixed::FromInt(40), fixed::FromInt(30), fixed::FromInt(1), &out));
+		TS_ASSERT_EQUALS(out.size(), 1U);
+		TS_ASSERT_EQUALS(out[0], 5U);
+		TS_ASSERT(!cmp->TestUnitShape(filter, ent2x, ent2z + ent2c + ent3c, ent3c / 2, NULL));
+
+		testHelper->Roundtrip();
+	}
+
+	/**
+	 * Verifies that rasterizing only the shapes changed since the last update gives
+	 * the same grid as rasterizing every shape again.
+	 */
+	void test_rasterize_incremental()
+	{
+		const ICmpObstructionManager::flags_t flags =
+			ICmpObstructionManager::FLAG_BLOCK_PATHFINDING | ICmpObstructionManager::FLAG_BLOCK_FOUNDATION;
+
+		CParamNode pathfindingNode, foundationNode;
+		TS_ASSERT_EQUALS(CParamNode::LoadXMLString(pathfindingNode, "<Class><Obstructions>pathfinding</Obstructions></Class>"), PSRETURN_OK);
+		TS_ASSERT_EQUALS(CParamNode::LoadXMLString(foundationNode, "<Class><Obstructions>foundation</Obstructions></Class>"), PSRETURN_OK);
+		std::vector<PathfinderPassability> passClasses;
+		passClasses.emplace_back(1, pathfindingNode.GetChild("Class"));
+		passClasses.emplace_back(2, foundationNode.GetChild("Class"));
+
+		tag_t wall1 = cmp->AddStaticShape(10, fixed::FromInt(50), fixed::FromInt(50), fixed::Zero(), fixed::FromInt(20), fixed::FromInt(2), flags, 10);
+		tag_t wall2 = cmp->AddStaticShape(11, fixed::FromInt(60), fixed::FromInt(55), fixed::FromFloat(0.7f), fixed::FromInt(12), fixed::FromInt(4), flags, 11);
+		tag_t house = cmp->AddStaticShape(12, fixed::FromInt(200), fixed::FromInt(200), fixed::Zero(), fixed::FromInt(8), fixed::FromInt(8), flags, 12);
+
+		GridUpdateInformation dirtiness = { false, false, Grid<u8>(1000, 1000) };
+		Grid<NavcellData> grid(1000, 1000);
+		cmp->UpdateInformations(dirtiness);
+		TS_ASSERT(dirtiness.globallyDirty);
+		cmp->Rasterize(grid, passClasses, true);
+
+		cmp->MoveShape(wall1, fixed::FromInt(52), fixed::FromInt(48), fixed::FromFloat(0.3f));
+		cmp->RemoveShape(wall2);
+		cmp->RemoveShape(shape3);
+		cmp->AddStaticShape(13, fixed::FromInt(58), fixed::FromInt(52), fixed::Zero(), fixed::FromInt(6), fixed::FromInt(6), flags, 13);
+		cmp->MoveShape(house, fixed::FromInt(300), fixed::FromInt(210), fixed::Zero());
+
+		dirtiness.Clean();
+		cmp->UpdateInformations(dirtiness);
+		TS_ASSERT(dirtiness.dirty);
+		TS_ASSERT(!dirtiness.globallyDirty);
+		for (u16 j = 0; j < grid.m_H; ++j)
+			for (u16 i = 0; i < grid.m_W; ++i)
+				if (dirtiness.dirtinessGrid.get(i, j))
+					grid.set(i, j, 0);
+		cmp->Rasterize(grid, passClasses, false);
+
+		Grid<NavcellData> expected(1000, 1000);
+		cmp->Rasterize(expected, passClasses, true);
+		TS_ASSERT(grid == expected);
+	}
 };
@@ -29,31 +29,43 @@
 #include "lib/types.h"
 #include "maths/Fixed.h"
 #include "maths/FixedVector2D.h"
+#include "maths/MathUtil.h"
 #include "ps/Filesystem.h"
 #include "ps/Loader.h"
 #include "ps/XML/Xeromyces.h"
 #include "scriptinterface/ScriptInterface.h"
 #include "simulation2/Simulation2.h"
+#include "simulation2/components/CCmpPathfinder_Common.h"
 #include "simulation2/components/ICmpObstructionManager.h"
 #include "simulation2/components/ICmpPathfinder.h"
+#include "simulation2/components/ICmpTerrain.h"
 #include "simulation2/helpers/Grid.h"
+#include "simulation2/helpers/HierarchicalPathfinder.h"
+#include "simulation2/helpers/LongPathfinder.h"
 #include "simulation2/helpers/PathGoal.h"
 #include "simulation2/helpers/Pathfinding.h"
 #include "simulation2/helpers/Position.h"
+#include "simulation2/helpers/VertexPathfinder.h"
 #include "simulation2/system/Component.h"
 #include "simulation2/system/Entity.h"
 
+#include <algorithm>
 #include <cmath>
 #include <cstdio>
 #include <fstream>
 #include <js/CallArgs.h>
 #include <js/RootingAPI.h>
+#include <map>
 #include <memory>
 #include <optional>
 #include <random>
+#include <span>
 #include <string>
 #include <vector>
 
+#define TEST
+#include "simulation2/helpers/JumpPointCache.h"
+
 class TestCmpPathfinder : public CxxTest::TestSuite
 {
 	std::optional<CXeromycesEngine> xeromycesEngine;
@@ -154,6 +166,353 @@ public:
 		}
 	}
 
+	static CCmpPathfinder* GetCmpPathfinder(CSimulation2& sim)
+	{
+		return static_cast<CCmpPathfinder*>(sim.QueryInterface(SYSTEM_ENTITY, IID_Pathfinder));
+	}
+
+	static void AssertSamePath(const WaypointPath& a, const WaypointPath& b)
+	{
+		TS_ASSERT_EQUALS(a.m_Waypoints.size(), b.m_Waypoints.size());
+		for (size_t i = 0; i < std::min(a.m_Waypoints.size(), b.m_Waypoints.size()); ++i)
+		{
+			TS_ASSERT_EQUALS(a.m_Waypoints[i].x, b.m_Waypoints[i].x);
+			TS_ASSERT_EQUALS(a.m_Waypoints[i].z, b.m_Waypoints[i].z);
+		}
+	}
+
+	static bool HaveSameJumpPointCaches(const LongPathfinder& a, const LongPathfinder& b)
+	{
+		return std::equal(a.m_JumpPointCache.begin(), a.m_JumpPointCache.end(),
+			b.m_JumpPointCache.begin(), b.m_JumpPointCache.end(),
+			[](const auto& x, const auto& y) { return x.first == y.first && *x.second == *y.second; });
+	}
+
+	void test_long_path_delay()
+	{
+		CTerrain terrain;
+		terrain.Initialize(5, NULL);
+
+		CSimulation2 sim{nullptr, *g_ScriptContext, &terrain, CSimulation2::DEFAULT_SCRIPTS};
+		sim.ResetState();
+
+		CCmpPathfinder* cmpPathfinder = GetCmpPathfinder(sim);
+		cmpPathfinder->m_LongPathDelayTurns = 3;
+		const pass_class_t passClass = cmpPathfinder->GetPassabilityClass("default");
+
+		const entity_pos_t x0 = entity_pos_t::FromInt(20);
+		const entity_pos_t z0 = entity_pos_t::FromInt(160);
+		const PathGoal goal = { PathGoal::POINT, entity_pos_t::FromInt(300), z0 };
+		const entity_id_t notify = 100;
+
+		cmpPathfinder->UpdateGrid();
+		WaypointPath expected;
+		cmpPathfinder->ComputePathImmediate(x0, z0, goal, passClass, expected);
+		TS_ASSERT(!expected.m_Waypoints.empty());
+
+		// Requested during turn 0, so it is sent at the start of turn 3.
+		cmpPathfinder->ComputePathAsync(x0, z0, goal, passClass, notify);
+		for (u32 turn = 0; turn < 3; ++turn)
+		{
+			sim.Update(200);
+			TS_ASSERT_EQUALS(cmpPathfinder->m_DeferredLongPaths.size(), 1);
+			TS_ASSERT_EQUALS(cmpPathfinder->m_DeferredLongPaths.front().m_TurnsLeft, 2 - turn);
+		}
+
+		cmpPathfinder->WaitForDeferredLongPaths();
+		const std::vector<PathResult>& results = cmpPathfinder->m_DeferredLongPaths.front().m_Paths.m_Results;
+		TS_ASSERT_EQUALS(results.size(), 1);
+		TS_ASSERT_EQUALS(results.front().notify, notify);
+		AssertSamePath(results.front().path, expected);
+
+		sim.Update(200);
+		TS_ASSERT(cmpPathfinder->m_DeferredLongPaths.empty());
+
+		// Changing the grid first finishes the pending batches, so that they don't
+		// depend on how far the workers got.
+		cmpPathfinder->ComputePathAsync(x0, z0, goal, passClass, notify);
+		sim.Update(200);
+		TS_ASSERT_EQUALS(cmpPathfinder->m_DeferredLongPaths.size(), 1);
+
+		CmpPtr<ICmpObstructionManager> cmpObstructionManager(sim, SYSTEM_ENTITY);
+		cmpObstructionManager->AddStaticShape(INVALID_ENTITY, entity_pos_t::FromInt(160), z0, entity_angle_t::Zero(),
+			entity_pos_t::FromInt(16), entity_pos_t::FromInt(200), ICmpObstructionManager::FLAG_BLOCK_PATHFINDING, INVALID_ENTITY);
+		cmpPathfinder->UpdateGrid();
+
+		const CCmpPathfinder::DeferredLongPaths& batch = cmpPathfinder->m_DeferredLongPaths.front();
+		TS_ASSERT(batch.m_Paths.m_ComputeDone);
+		TS_ASSERT(batch.m_Futures.empty());
+		TS_ASSERT_EQUALS(batch.m_Paths.m_Results.size(), 1);
+		AssertSamePath(batch.m_Paths.m_Results.front().path, expected);
+
+		// The new obstruction does change the path.
+		WaypointPath blocked;
+		cmpPathfinder->ComputePathImmediate(x0, z0, goal, passClass, blocked);
+		TS_ASSERT(blocked.m_Waypoints.size() != expected.m_Waypoints.size() ||
+			!std::equal(blocked.m_Waypoints.begin(), blocked.m_Waypoints.end(), expected.m_Waypoints.begin(),
+				[](const Waypoint& a, const Waypoint& b) { return a.x == b.x && a.z == b.z; }));
+	}
+
+	void test_long_path_delay_serialization()
+	{
+		CTerrain terrain;
+		terrain.Initialize(5, NULL);
+
+		CSimulation2 sim{nullptr, *g_ScriptContext, &terrain, CSimulation2::DEFAULT_SCRIPTS};
+		sim.ResetState();
+
+		CCmpPathfinder* cmpPathfinder = GetCmpPathfinder(sim);
+		cmpPathfinder->m_LongPathDelayTurns = 2;
+		const pass_class_t passClass = cmpPathfinder->GetPassabilityClass("default");
+
+		const entity_pos_t x0 = entity_pos_t::FromInt(20);
+		const entity_pos_t z0 = entity_pos_t::FromInt(160);
+		const PathGoal goal = { PathGoal::POINT, entity_pos_t::FromInt(300), entity_pos_t::FromInt(200) };
+
+		cmpPathfinder->ComputePathAsync(x0, z0, goal, passClass, 100);
+		sim.Update(200);
+		TS_ASSERT_EQUALS(cmpPathfinder->m_DeferredLongPaths.size(), 1);
+
+		std::string state;
+		TS_ASSERT(sim.SerializeState(state));
+
+		CTerrain terrain2;
+		terrain2.Initialize(5, NULL);
+
+		CSimulation2 sim2{nullptr, *g_ScriptContext, &terrain2, CSimulation2::DEFAULT_SCRIPTS};
+		sim2.ResetState();
+		TS_ASSERT(sim2.DeserializeState(std::as_bytes(std::span{state})));
+
+		// The pending batch is restored with its results and its delivery turn.
+		CCmpPathfinder* cmpPathfinder2 = GetCmpPathfinder(sim2);
+		TS_ASSERT_EQUALS(cmpPathfinder2->m_LongPathDelayTurns, 2);
+		TS_ASSERT_EQUALS(cmpPathfinder2->m_DeferredLongPaths.size(), 1);
+		TS_ASSERT_EQUALS(cmpPathfinder2->m_DeferredLongPaths.front().m_TurnsLeft, 1);
+		TS_ASSERT_EQUALS(cmpPathfinder2->m_DeferredLongPaths.front().m_Paths.m_Results.size(), 1);
+		AssertSamePath(cmpPathfinder2->m_DeferredLongPaths.front().m_Paths.m_Results.front().path,
+			cmpPathfinder->m_DeferredLongPaths.front().m_Paths.m_Results.front().path);
+
+		for (size_t turn = 0; turn < 2; ++turn)
+		{
+			sim.Update(200);
+			sim2.Update(200);
+			TS_ASSERT_EQUALS(cmpPathfinder->m_DeferredLongPaths.size(), 1 - turn);
+			TS_ASSERT_EQUALS(cmpPathfinder2->m_DeferredLongPaths.size(), 1 - turn);
+
+			std::string state1, state2;
+			TS_ASSERT(sim.SerializeState(state1));
+			TS_ASSERT(sim2.SerializeState(state2));
+			TS_ASSERT(state1 == state2);
+		}
+	}
+
+	void test_jump_point_cache_update()
+	{
+		const pass_class_t passClass = 1;
+		const std::map<std::string, pass_class_t> nonPathfindingPassClassMasks;
+		const std::map<std::string, pass_class_t> pathfindingPassClassMasks = { { "default", passClass } };
+
+		// A map with random obstructions, surrounded by impassable navcells as the cache expects.
+		const u16 size = 128;
+		std::mt19937 engine(42);
+		std::uniform_int_distribution<int> obstructed(0, 9);
+		Grid<NavcellData> grid(size, size);
+		for (u16 j = 0; j < size; ++j)
+			for (u16 i = 0; i < size; ++i)
+				if (i == 0 || j == 0 || i == size - 1 || j == size - 1 || obstructed(engine) == 0)
+					grid.set(i, j, passClass);
+		grid.set(5, 5, 0);
+		grid.set(120, 120, 0);
+
+		HierarchicalPathfinder hierPath;
+		hierPath.Recompute(&grid, nonPathfindingPassClassMasks, pathfindingPassClassMasks);
+
+		const entity_pos_t x0 = Pathfinding::NAVCELL_SIZE * 5 + Pathfinding::NAVCELL_SIZE / 2;
+		const PathGoal goal = { PathGoal::POINT, Pathfinding::NAVCELL_SIZE * 120 + Pathfinding::NAVCELL_SIZE / 2,
+			Pathfinding::NAVCELL_SIZE * 120 + Pathfinding::NAVCELL_SIZE / 2 };
+
+		LongPathfinder updated;
+		updated.SetUseJPSCache(true);
+		updated.Reload(&grid);
+		WaypointPath path;
+		updated.ComputePath(hierPath, x0, x0, goal, passClass, path);
+
+		for (int step = 0; step < 4; ++step)
+		{
+			// Toggle the passability of a few rectangles, some of them overlapping.
+			Grid<u8> dirtinessGrid(size, size);
+			std::uniform_int_distribution<int> position(1, size - 11);
+			for (int k = 0; k < 3; ++k)
+			{
+				const int i0 = position(engine), j0 = position(engine);
+				for (int j = j0; j < j0 + 10; ++j)
+					for (int i = i0; i < i0 + 10; ++i)
+					{
+						grid.set(i, j, grid.get(i, j) ^ passClass);
+						dirtinessGrid.set(i, j, 1);
+					}
+			}
+			hierPath.Update(&grid, dirtinessGrid);
+			updated.Update(&grid, dirtinessGrid);
+
+			// The incrementally updated cache must match one computed from scratch.
+			LongPathfinder reset;
+			reset.SetUseJPSCache(true);
+			reset.Reload(&grid);
+			WaypointPath resetPath;
+			reset.ComputePath(hierPath, x0, x0, goal, passClass, resetPath);
+			TS_ASSERT(HaveSameJumpPointCaches(updated, reset));
+
+			WaypointPath updatedPath;
+			updated.ComputePath(hierPath, x0, x0, goal, passClass, updatedPath);
+			AssertSamePath(updatedPath, resetPath);
+		}
+	}
+
+	/**
+	 * Scans navcells i0 <= i <= i1, j0 <= j <= j1 for terrain edges and vertexes,
+	 * the way the vertex pathfinder did before caching them.
+	 */
+	static void ScanTerrainEdges(std::vector<Edge>& edges, std::vector<CFixedVector2D>& vertexes,
+		int i0, int j0, int i1, int j1, pass_class_t passClass, const Grid<NavcellData>& grid)
+	{
+		const fixed delta = fixed::FromInt(1) / 16; // EDGE_EXPAND_DELTA
+		auto passable = [&](int i, int j) { return IS_PASSABLE(grid.get(i, j), passClass); };
+		auto addVertex = [&](int x, int y, fixed dx, fixed dy) {
+			vertexes.push_back(CFixedVector2D(fixed::FromInt(x) + dx, fixed::FromInt(y) + dy).Multiply(Pathfinding::NAVCELL_SIZE));
+		};
+		auto addEdge = [&](int x0, int y0, int x1, int y1) {
+			edges.emplace_back(Edge{
+				CFixedVector2D(fixed::FromInt(x0), fixed::FromInt(y0)).Multiply(Pathfinding::NAVCELL_SIZE),
+				CFixedVector2D(fixed::FromInt(x1), fixed::FromInt(y1)).Multiply(Pathfinding::NAVCELL_SIZE) });
+		};
+		// Calls add(a, b) for each run [a, b) of lo <= k <= hi where inRun(k) holds.
+		auto forEachRun = [](int lo, int hi, auto inRun, auto add) {
+			for (int k = lo; k <= hi; ++k)
+			{
+				if (!inRun(k))
+					continue;
+				const int a = k;
+				while (k < hi && inRun(k + 1))
+					++k;
+				add(a, k + 1);
+			}
+		};
+
+		i0 = Clamp(i0, 1, grid.m_W-2);
+		j0 = Clamp(j0, 1, grid.m_H-2);
+		i1 = Clamp(i1, 1, grid.m_W-2);
+		j1 = Clamp(j1, 1, grid.m_H-2);
+
+		for (int j = j0; j <= j1; ++j)
+			for (int i = i0; i <= i1; ++i)
+			{
+				if (passable(i, j))
+					continue;
+				if (passable(i+1, j) && passable(i, j+1) && passable(i+1, j+1))
+					addVertex(i+1, j+1, delta, delta);
+				if (passable(i-1, j) && passable(i, j+1) && passable(i-1, j+1))
+					addVertex(i, j+1, -delta, delta);
+				if (passable(i+1, j) && passable(i, j-1) && passable(i+1, j-1))
+					addVertex(i+1, j, delta, -delta);
+				if (passable(i-1, j) && passable(i, j-1) && passable(i-1, j-1))
+					addVertex(i, j, -delta, -delta);
+			}
+
+		for (int j = j0; j < j1; ++j)
+		{
+			forEachRun(i0, i1, [&](int i) { return passable(i, j) && !passable(i, j+1); },
+				[&](int ia, int ib) { addEdge(ia, j+1, ib, j+1); });
+			forEachRun(i0, i1, [&](int i) { return !passable(i, j) && passable(i, j+1); },
+				[&](int ia, int ib) { addEdge(ib, j+1, ia, j+1); });
+		}
+
+		for (int i = i0; i < i1; ++i)
+		{
+			forEachRun(j0, j1, [&](int j) { return !passable(i, j) && passable(i+1, j); },
+				[&](int ja, int jb) { addEdge(i+1, ja, i+1, jb); });
+			forEachRun(j0, j1, [&](int j) { return passable(i, j) && !passable(i+1, j); },
+				[&](int ja, int jb) { addEdge(i+1, jb, i+1, ja); });
+		}
+	}
+
+	/**
+	 * Checks the cached terrain edges of a few ranges of the terrain-only grid against a scan,
+	 * and returns the edges of the whole grid.
+	 */
+	static std::vector<Edge> CheckTerrainEdgeCache(const CCmpPathfinder& cmpPathfinder, pass_class_t passClass)
+	{
+		const Grid<NavcellData>& grid = *cmpPathfinder.m_TerrainOnlyGrid;
+		const int ranges[][4] = {
+			{ -10, -10, grid.m_W + 10, grid.m_H + 10 },
+			{ 60, 60, 100, 90 },
+			{ 75, 70, 85, 125 },
+			{ 0, 0, 20, 20 },
+			{ 82, 82, 82, 82 }
+		};
+
+		std::vector<Edge> allEdges;
+		for (const int* range : ranges)
+		{
+			std::vector<Edge> edges, expectedEdges;
+			std::vector<Vertex> vertexes;
+			std::vector<CFixedVector2D> expectedVertexes;
+			cmpPathfinder.m_VertexPathfinderTerrainCache.AddTerrainEdges(edges, vertexes, range[0], range[1], range[2], range[3], passClass, grid);
+			ScanTerrainEdges(expectedEdges, expectedVertexes, range[0], range[1], range[2], range[3], passClass, grid);
+
+			TS_ASSERT_EQUALS(edges.size(), expectedEdges.size());
+			for (size_t i = 0; i < std::min(edges.size(), expectedEdges.size()); ++i)
+			{
+				TS_ASSERT_EQUALS(edges[i].p0, expectedEdges[i].p0);
+				TS_ASSERT_EQUALS(edges[i].p1, expectedEdges[i].p1);
+			}
+
+			TS_ASSERT_EQUALS(vertexes.size(), expectedVertexes.size());
+			for (size_t i = 0; i < std::min(vertexes.size(), expectedVertexes.size()); ++i)
+			{
+				TS_ASSERT_EQUALS(vertexes[i].p, expectedVertexes[i]);
+				TS_ASSERT_EQUALS(vertexes[i].status, Vertex::UNEXPLORED);
+			}
+
+			if (allEdges.empty())
+				allEdges = std::move(edges);
+		}
+		return allEdges;
+	}
+
+	void test_vertex_pathfinder_terrain_cache()
+	{
+		CTerrain terrain;
+		terrain.Initialize(5, NULL);
+
+		// Spikes in the heightmap make the navcells around them impassable.
+		auto addSpike = [&terrain](ssize_t i, ssize_t j) {
+			terrain.GetHeightMap()[j * terrain.GetVerticesPerSide() + i] = 65535;
+		};
+		addSpike(20, 20);
+		addSpike(21, 22);
+
+		CSimulation2 sim{nullptr, *g_ScriptContext, &terrain, CSimulation2::DEFAULT_SCRIPTS};
+		sim.ResetState();
+
+		CCmpPathfinder* cmpPathfinder = GetCmpPathfinder(sim);
+		const pass_class_t passClass = cmpPathfinder->GetPassabilityClass("default");
+		cmpPathfinder->UpdateGrid();
+		const std::vector<Edge> edges = CheckTerrainEdgeCache(*cmpPathfinder, passClass);
+
+		// Changing the terrain must invalidate the cache, both in the minimal update done
+		// when the terrain changes and in the full update of the next grid update.
+		addSpike(30, 18);
+		CmpPtr<ICmpTerrain> cmpTerrain(sim, SYSTEM_ENTITY);
+		cmpTerrain->MakeDirty(29, 17, 31, 19);
+		const std::vector<Edge> minimalEdges = CheckTerrainEdgeCache(*cmpPathfinder, passClass);
+		TS_ASSERT_DIFFERS(minimalEdges.size(), edges.size());
+
+		cmpPathfinder->UpdateGrid();
+		const std::vector<Edge> updatedEdges = CheckTerrainEdgeCache(*cmpPathfinder, passClass);
+		TS_ASSERT_DIFFERS(updatedEdges.size(), edges.size());
+	}
+
 	void DISABLED_test_performance()
 	{
 		CTerrain terrain;
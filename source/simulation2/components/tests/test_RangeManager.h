@@ -1,4 +1,4 @@
-/* Copyright (C) 2025 Wildfire Games.
+/* Copyright (C) 2026 Wildfire Games.
  * This file is part of 0 A.D.
  *
  * 0 A.D. is free software: you can redistribute it and/or modify
@@ -36,6 +36,7 @@
 #include "simulation2/system/ComponentTest.h"
 #include "simulation2/system/Entity.h"
 
+#include <array>
 #include <cstddef>
 #include <cstdint>
 #include <memory>
@@ -62,7 +63,7 @@ public:
 	entity_id_t GetTurretParent() const override {return INVALID_ENTITY;}
 	void UpdateTurretPosition() override {}
 	std::set<entity_id_t>* GetTurrets() override { return nullptr; }
-	bool IsInWorld() const override { return true; }
+	bool IsInWorld() const override { return m_InWorld; }
 	void MoveOutOfWorld() override { }
 	void MoveTo(entity_pos_t /*x*/, entity_pos_t /*z*/) override { }
 	void MoveAndTurnTo(entity_pos_t /*x*/, entity_pos_t /*z*/, entity_angle_t /*a*/) override { }
@@ -93,6 +94,7 @@ public:
 	CMatrix3D GetInterpolatedTransform(float /*frameOffset*/) const override { return CMatrix3D(); }
 
 	CFixedVector3D m_Pos;
+	bool m_InWorld = true;
 };
 
 class MockObstructionRgm : public ICmpObstruction
@@ -132,6 +134,13 @@ private:
 	entity_pos_t m_Size;
 };
 
+static void ChangePosition(IComponent& cmp, entity_id_t ent, bool inWorld, entity_pos_t x, entity_pos_t z, entity_angle_t a)
+{
+	const std::vector<CMessagePositionsChanged::Change> changes{ { ent, inWorld, x, z, a } };
+	CMessagePositionsChanged msg(changes);
+	cmp.HandleMessage(msg, false);
+}
+
 class TestCmpRangeManager : public CxxTest::TestSuite
 {
 	std::optional<CXeromycesEngine> xeromycesEngine;
@@ -170,26 +179,26 @@ public:
 		cmp->Verify();
 		{ CMessageOwnershipChanged msg(100, -1, 1); cmp->HandleMessage(msg, false); }
 		cmp->Verify();
-		{ CMessagePositionChanged msg(100, true, entity_pos_t::FromInt(247), entity_pos_t::FromDouble(257.95), entity_angle_t::Zero()); cmp->HandleMessage(msg, false); }
+		ChangePosition(*cmp, 100, true, entity_pos_t::FromInt(247), entity_pos_t::FromDouble(257.95), entity_angle_t::Zero());
 		cmp->Verify();
-		{ CMessagePositionChanged msg(100, true, entity_pos_t::FromInt(247), entity_pos_t::FromInt(253), entity_angle_t::Zero()); cmp->HandleMessage(msg, false); }
+		ChangePosition(*cmp, 100, true, entity_pos_t::FromInt(247), entity_pos_t::FromInt(253), entity_angle_t::Zero());
 		cmp->Verify();
 
-		{ CMessagePositionChanged msg(100, true, entity_pos_t::FromInt(256), entity_pos_t::FromInt(256), entity_angle_t::Zero()); cmp->HandleMessage(msg, false); }
+		ChangePosition(*cmp, 100, true, entity_pos_t::FromInt(256), entity_pos_t::FromInt(256), entity_angle_t::Zero());
 		cmp->Verify();
 
-		{ CMessagePositionChanged msg(100, true, entity_pos_t::FromInt(256)+entity_pos_t::Epsilon(), entity_pos_t::FromInt(256), entity_angle_t::Zero()); cmp->HandleMessage(msg, false); }
+		ChangePosition(*cmp, 100, true, entity_pos_t::FromInt(256)+entity_pos_t::Epsilon(), entity_pos_t::FromInt(256), entity_angle_t::Zero());
 		cmp->Verify();
-		{ CMessagePositionChanged msg(100, true, entity_pos_t::FromInt(256)-entity_pos_t::Epsilon(), entity_pos_t::FromInt(256), entity_angle_t::Zero()); cmp->HandleMessage(msg, false); }
+		ChangePosition(*cmp, 100, true, entity_pos_t::FromInt(256)-entity_pos_t::Epsilon(), entity_pos_t::FromInt(256), entity_angle_t::Zero());
 		cmp->Verify();
-		{ CMessagePositionChanged msg(100, true, entity_pos_t::FromInt(256), entity_pos_t::FromInt(256)+entity_pos_t::Epsilon(), entity_angle_t::Zero()); cmp->HandleMessage(msg, false); }
+		ChangePosition(*cmp, 100, true, entity_pos_t::FromInt(256), entity_pos_t::FromInt(256)+entity_pos_t::Epsilon(), entity_angle_t::Zero());
 		cmp->Verify();
-		{ CMessagePositionChanged msg(100, true, entity_pos_t::FromInt(256), entity_pos_t::FromInt(256)-entity_pos_t::Epsilon(), entity_angle_t::Zero()); cmp->HandleMessage(msg, false); }
+		ChangePosition(*cmp, 100, true, entity_pos_t::FromInt(256), entity_pos_t::FromInt(256)-entity_pos_t::Epsilon(), entity_angle_t::Zero());
 		cmp->Verify();
 
-		{ CMessagePositionChanged msg(100, true, entity_pos_t::FromInt(383), entity_pos_t::FromInt(84), entity_angle_t::Zero()); cmp->HandleMessage(msg, false); }
+		ChangePosition(*cmp, 100, true, entity_pos_t::FromInt(383), entity_pos_t::FromInt(84), entity_angle_t::Zero());
 		cmp->Verify();
-		{ CMessagePositionChanged msg(100, true, entity_pos_t::FromInt(348), entity_pos_t::FromInt(83), entity_angle_t::Zero()); cmp->HandleMessage(msg, false); }
+		ChangePosition(*cmp, 100, true, entity_pos_t::FromInt(348), entity_pos_t::FromInt(83), entity_angle_t::Zero());
 		cmp->Verify();
 
 		std::mt19937 rng;
@@ -197,7 +206,7 @@ public:
 		{
 			double x = std::uniform_real_distribution<double>(0.0, 512.0)(rng);
 			double z = std::uniform_real_distribution<double>(0.0, 512.0)(rng);
-			{ CMessagePositionChanged msg(100, true, entity_pos_t::FromDouble(x), entity_pos_t::FromDouble(z), entity_angle_t::Zero()); cmp->HandleMessage(msg, false); }
+			ChangePosition(*cmp, 100, true, entity_pos_t::FromDouble(x), entity_pos_t::FromDouble(z), entity_angle_t::Zero());
 			cmp->Verify();
 		}
 
@@ -218,6 +227,114 @@ public:
 		}
 	}
 
+	void test_batched_los_updates()
+	{
+		// The LOS updates of a batch of position changes are applied per player,
+		// which must give the same LOS as handling the changes one by one.
+		ComponentTestHelper batchedTest(*g_ScriptContext);
+		ComponentTestHelper serialTest(*g_ScriptContext);
+		ICmpRangeManager* batched = batchedTest.Add<ICmpRangeManager>(CID_RangeManager, "", SYSTEM_ENTITY);
+		ICmpRangeManager* serial = serialTest.Add<ICmpRangeManager>(CID_RangeManager, "", SYSTEM_ENTITY);
+
+		MockVisionRgm vision;
+		std::array<MockPositionRgm, 8> positions;
+		for (ComponentTestHelper* test : { &batchedTest, &serialTest })
+			for (entity_id_t ent = 100; ent < 108; ++ent)
+			{
+				test->AddMock(ent, IID_Vision, vision);
+				test->AddMock(ent, IID_Position, positions[ent - 100]);
+			}
+		for (ICmpRangeManager* cmp : { batched, serial })
+		{
+			cmp->SetBounds(entity_pos_t::FromInt(0), entity_pos_t::FromInt(0), entity_pos_t::FromInt(512), entity_pos_t::FromInt(512));
+			for (entity_id_t ent = 100; ent < 108; ++ent)
+			{
+				{ CMessageCreate msg(ent); cmp->HandleMessage(msg, false); }
+				{ CMessageOwnershipChanged msg(ent, -1, ent % 2 + 1); cmp->HandleMessage(msg, false); }
+			}
+		}
+
+		std::mt19937 rng;
+		for (size_t step = 0; step < 64; ++step)
+		{
+			// Entities can move several times, or leave the world, in a single batch.
+			std::vector<CMessagePositionsChanged::Change> changes;
+			for (size_t i = 0; i < 12; ++i)
+			{
+				const entity_id_t ent = 100 + rng() % 8;
+				const bool inWorld = rng() % 8 != 0;
+				const double x = std::uniform_real_distribution<double>(0.0, 512.0)(rng);
+				const double z = std::uniform_real_distribution<double>(0.0, 512.0)(rng);
+				changes.push_back({ ent, inWorld, entity_pos_t::FromDouble(x), entity_pos_t::FromDouble(z), entity_angle_t::Zero() });
+			}
+			{ CMessagePositionsChanged msg(changes); batched->HandleMessage(msg, false); }
+			for (const CMessagePositionsChanged::Change& change : changes)
+				ChangePosition(*serial, change.entity, change.inWorld, change.x, change.z, change.a);
+			batched->Verify();
+
+			for (player_id_t player = 1; player <= 2; ++player)
+			{
+				TS_ASSERT_EQUALS(batched->GetPercentMapExplored(player), serial->GetPercentMapExplored(player));
+				for (int x = 8; x < 512; x += 32)
+					for (int z = 8; z < 512; z += 32)
+						TS_ASSERT_EQUALS(batched->GetLosVisibilityPosition(entity_pos_t::FromInt(x), entity_pos_t::FromInt(z), player),
+							serial->GetLosVisibilityPosition(entity_pos_t::FromInt(x), entity_pos_t::FromInt(z), player));
+			}
+		}
+	}
+
+	void test_dirty_visibility_regions()
+	{
+		// Only the LoS regions marked dirty are revisited on update, the cached
+		// visibility of every entity must still match its current LoS.
+		ComponentTestHelper test(*g_ScriptContext);
+		ICmpRangeManager* cmp = test.Add<ICmpRangeManager>(CID_RangeManager, "", SYSTEM_ENTITY);
+
+		MockVisionRgm vision;
+		std::array<MockPositionRgm, 16> positions;
+		for (entity_id_t ent = 100; ent < 116; ++ent)
+		{
+			// Half of the entities see, the others are only seen.
+			if (ent < 108)
+				test.AddMock(ent, IID_Vision, vision);
+			test.AddMock(ent, IID_Position, positions[ent - 100]);
+		}
+
+		cmp->SetBounds(entity_pos_t::FromInt(0), entity_pos_t::FromInt(0), entity_pos_t::FromInt(512), entity_pos_t::FromInt(512));
+		cmp->SetSharedLos(1, { 1 });
+		cmp->SetSharedLos(2, { 2 });
+		for (entity_id_t ent = 100; ent < 116; ++ent)
+		{
+			{ CMessageCreate msg(ent); cmp->HandleMessage(msg, false); }
+			{ CMessageOwnershipChanged msg(ent, -1, ent % 2 + 1); cmp->HandleMessage(msg, false); }
+		}
+
+		std::mt19937 rng;
+		for (size_t step = 0; step < 64; ++step)
+		{
+			// Place every entity on the first step, then only move a few of them.
+			for (size_t i = 0; i < (step == 0 ? 16 : 6); ++i)
+			{
+				const entity_id_t ent = 100 + (step == 0 ? i : rng() % 16);
+				const entity_pos_t x = entity_pos_t::FromDouble(std::uniform_real_distribution<double>(0.0, 512.0)(rng));
+				const entity_pos_t z = entity_pos_t::FromDouble(std::uniform_real_distribution<double>(0.0, 512.0)(rng));
+				positions[ent - 100].m_Pos = CFixedVector3D(x, entity_pos_t::Zero(), z);
+				ChangePosition(*cmp, ent, true, x, z, entity_angle_t::Zero());
+			}
+			{ CMessageUpdate msg(fixed::FromInt(1)); cmp->HandleMessage(msg, false); }
+
+			for (entity_id_t ent = 100; ent < 116; ++ent)
+			{
+				const CFixedVector3D& pos = positions[ent - 100].m_Pos;
+				for (player_id_t player = 1; player <= 2; ++player)
+				{
+					const bool visible = cmp->GetLosVisibilityPosition(pos.X, pos.Z, player) == LosVisibility::VISIBLE;
+					TS_ASSERT_EQUALS(cmp->GetLosVisibility(ent, player), visible ? LosVisibility::VISIBLE : LosVisibility::HIDDEN);
+				}
+			}
+		}
+	}
+
 	void test_queries()
 	{
 		ComponentTestHelper test(*g_ScriptContext);
@@ -245,7 +362,7 @@ public:
 
 		auto move = [&cmp](entity_id_t ent, MockPositionRgm& pos, fixed x, fixed z) {
 			pos.m_Pos = CFixedVector3D(x, fixed::Zero(), z);
-			{ CMessagePositionChanged msg(ent, true, x, z, entity_angle_t::Zero()); cmp->HandleMessage(msg, false); }
+			ChangePosition(*cmp, ent, true, x, z, entity_angle_t::Zero());
 		};
 
 		move(100, position, fixed::FromInt(10), fixed::FromInt(10));
@@ -290,6 +407,135 @@ public:
 
 	}
 
+	void test_query_filters()
+	{
+		ComponentTestHelper test(*g_ScriptContext);
+
+		ICmpRangeManager* cmp = test.Add<ICmpRangeManager>(CID_RangeManager, "", SYSTEM_ENTITY);
+
+		MockPositionRgm position100, position101, position102, position103;
+		MockObstructionRgm obs(fixed::Zero());
+		test.AddMock(100, IID_Position, position100);
+		test.AddMock(101, IID_Position, position101);
+		test.AddMock(101, IID_Obstruction, obs);
+		test.AddMock(102, IID_Position, position102);
+		test.AddMock(103, IID_Position, position103);
+		test.AddMock(103, IID_Obstruction, obs);
+
+		cmp->SetBounds(entity_pos_t::FromInt(0), entity_pos_t::FromInt(0), entity_pos_t::FromInt(512), entity_pos_t::FromInt(512));
+		for (entity_id_t ent = 100; ent <= 103; ++ent)
+		{
+			{ CMessageCreate msg(ent); cmp->HandleMessage(msg, false); }
+			{ CMessageOwnershipChanged msg(ent, -1, ent == 103 ? 2 : 1); cmp->HandleMessage(msg, false); }
+			ChangePosition(*cmp, ent, true, fixed::FromInt(10 + ent - 100), fixed::FromInt(10), entity_angle_t::Zero());
+		}
+		cmp->Verify();
+
+		std::vector<entity_id_t> nearby = cmp->ExecuteQuery(100, fixed::Zero(), fixed::FromInt(50), {1, 2}, 0, false);
+		TS_ASSERT_EQUALS(nearby, (std::vector<entity_id_t>{101, 102, 103}));
+		nearby = cmp->ExecuteQuery(100, fixed::Zero(), ALWAYS_IN_RANGE, {1, 2}, 0, false);
+		TS_ASSERT_EQUALS(nearby, (std::vector<entity_id_t>{101, 102, 103}));
+
+		// Owners.
+		nearby = cmp->ExecuteQuery(100, fixed::Zero(), fixed::FromInt(50), {2}, 0, false);
+		TS_ASSERT_EQUALS(nearby, std::vector<entity_id_t>{103});
+		nearby = cmp->ExecuteQuery(100, fixed::Zero(), ALWAYS_IN_RANGE, {1}, 0, false);
+		TS_ASSERT_EQUALS(nearby, (std::vector<entity_id_t>{101, 102}));
+
+		// Interfaces.
+		nearby = cmp->ExecuteQuery(100, fixed::Zero(), fixed::FromInt(50), {1, 2}, IID_Obstruction, false);
+		TS_ASSERT_EQUALS(nearby, (std::vector<entity_id_t>{101, 103}));
+		nearby = cmp->ExecuteQuery(100, fixed::Zero(), ALWAYS_IN_RANGE, {1}, IID_Obstruction, false);
+		TS_ASSERT_EQUALS(nearby, std::vector<entity_id_t>{101});
+
+		// Flags.
+		cmp->SetEntityFlag(101, "normal", false);
+		cmp->SetEntityFlag(101, "injured", true);
+		cmp->Verify();
+		nearby = cmp->ExecuteQuery(100, fixed::Zero(), fixed::FromInt(50), {1, 2}, 0, false);
+		TS_ASSERT_EQUALS(nearby, (std::vector<entity_id_t>{102, 103}));
+
+		// Out of world and destroyed entities.
+		ChangePosition(*cmp, 102, false, fixed::Zero(), fixed::Zero(), entity_angle_t::Zero());
+		{ CMessageOwnershipChanged msg(103, 2, -1); cmp->HandleMessage(msg, false); }
+		{ CMessageDestroy msg(103); cmp->HandleMessage(msg, false); }
+		cmp->Verify();
+		nearby = cmp->ExecuteQuery(100, fixed::Zero(), ALWAYS_IN_RANGE, {1, 2}, 0, false);
+		TS_ASSERT_EQUALS(nearby, std::vector<entity_id_t>{});
+	}
+
+	void test_incremental_queries()
+	{
+		ComponentTestHelper test(*g_ScriptContext);
+
+		ICmpRangeManager* cmp = test.Add<ICmpRangeManager>(CID_RangeManager, "", SYSTEM_ENTITY);
+
+		MockPositionRgm position100, position101, position102;
+		MockObstructionRgm obs(fixed::Zero());
+		position100.m_Pos = CFixedVector3D(fixed::FromInt(100), fixed::Zero(), fixed::FromInt(100));
+		test.AddMock(100, IID_Position, position100);
+		test.AddMock(101, IID_Position, position101);
+		test.AddMock(101, IID_Obstruction, obs);
+		test.AddMock(102, IID_Position, position102);
+
+		cmp->SetBounds(entity_pos_t::FromInt(0), entity_pos_t::FromInt(0), entity_pos_t::FromInt(512), entity_pos_t::FromInt(512));
+		for (entity_id_t ent = 100; ent <= 102; ++ent)
+		{
+			{ CMessageCreate msg(ent); cmp->HandleMessage(msg, false); }
+			{ CMessageOwnershipChanged msg(ent, -1, 1); cmp->HandleMessage(msg, false); }
+		}
+		ChangePosition(*cmp, 100, true, fixed::FromInt(100), fixed::FromInt(100), entity_angle_t::Zero());
+		ChangePosition(*cmp, 101, true, fixed::FromInt(120), fixed::FromInt(100), entity_angle_t::Zero());
+		ChangePosition(*cmp, 102, true, fixed::FromInt(300), fixed::FromInt(300), entity_angle_t::Zero());
+
+		const ICmpRangeManager::tag_t tag = cmp->CreateActiveQuery(100, fixed::Zero(), fixed::FromInt(50), {1}, 0, cmp->GetEntityFlagMask("normal"), false);
+		cmp->EnableActiveQuery(tag);
+
+		// Every step is followed by an update, where the query is recomputed
+		// incrementally, and Verify() compares the result to a full recomputation.
+		const auto update = [&]() {
+			CMessageUpdate msg(fixed::FromInt(1));
+			cmp->HandleMessage(msg, false);
+			cmp->Verify();
+		};
+		update();
+		update();
+
+		// Entities moving into and out of range.
+		ChangePosition(*cmp, 102, true, fixed::FromInt(110), fixed::FromInt(130), entity_angle_t::Zero());
+		update();
+		ChangePosition(*cmp, 101, true, fixed::FromInt(200), fixed::FromInt(100), entity_angle_t::Zero());
+		update();
+		ChangePosition(*cmp, 101, true, fixed::FromInt(140), fixed::FromInt(100), entity_angle_t::Zero());
+		update();
+
+		// Resetting the query while its source is out of the world empties it,
+		// so it must be recomputed in full once the source is back.
+		position100.m_InWorld = false;
+		TS_ASSERT_EQUALS(cmp->ResetActiveQuery(tag), std::vector<entity_id_t>{});
+		position100.m_InWorld = true;
+		cmp->Verify();
+		update();
+
+		// Owner and flag changes.
+		{ CMessageOwnershipChanged msg(102, 1, 2); cmp->HandleMessage(msg, false); }
+		update();
+		cmp->SetEntityFlag(101, "normal", false);
+		update();
+		cmp->SetEntityFlag(101, "normal", true);
+		{ CMessageOwnershipChanged msg(102, 2, 1); cmp->HandleMessage(msg, false); }
+		update();
+
+		// Out of world and destroyed entities.
+		ChangePosition(*cmp, 102, false, fixed::Zero(), fixed::Zero(), entity_angle_t::Zero());
+		update();
+		{ CMessageOwnershipChanged msg(101, 1, -1); cmp->HandleMessage(msg, false); }
+		{ CMessageDestroy msg(101); cmp->HandleMessage(msg, false); }
+		update();
+
+		TS_ASSERT_EQUALS(cmp->ResetActiveQuery(tag), std::vector<entity_id_t>{});
+	}
+
 	void test_IsInTargetParabolicRange()
 	{
 		ComponentTestHelper test(*g_ScriptContext);
@@ -1,4 +1,4 @@
-/* Copyright (C) 2025 Wildfire Games.
+/* Copyright (C) 2026 Wildfire Games.
  * This file is part of 0 A.D.
  *
  * 0 A.D. is free software: you can redistribute it and/or modify
@@ -441,6 +441,43 @@ public:
 		TestBoundaryPointsEqual(threesOuter->points, threesOuterExpectedPoints);
 	}
 
+	void test_boundaries_multiple_owners()
+	{
+		// The 0s are blinking tiles without an owner, see CCmpTerritoryManager::SetTerritoryBlinking.
+		Grid<u8> grid = GetGrid("------"
+		                        "-00---"
+		                        "-11---"
+		                        "-11-22"
+		                        "----22", 6, 5);
+		grid.set(1, 3, grid.get(1, 3) | ICmpTerritoryManager::TERRITORY_BLINKING_MASK);
+		grid.set(2, 3, grid.get(2, 3) | ICmpTerritoryManager::TERRITORY_BLINKING_MASK);
+
+		// Each owner is traced separately, but the boundaries must come in the order of a single scan of the grid.
+		std::vector<STerritoryBoundary> boundaries = CTerritoryBoundaryCalculator::ComputeBoundaries(&grid);
+		TS_ASSERT_EQUALS(boundaries.size(), 3U);
+		if (boundaries.size() != 3)
+			return;
+
+		TS_ASSERT_EQUALS(boundaries[0].owner, 2);
+		TS_ASSERT_EQUALS(boundaries[0].blinking, false);
+		TS_ASSERT_EQUALS(boundaries[1].owner, 1);
+		TS_ASSERT_EQUALS(boundaries[1].blinking, false);
+		TS_ASSERT_EQUALS(boundaries[2].owner, 0);
+		TS_ASSERT_EQUALS(boundaries[2].blinking, true);
+
+		TS_ASSERT_EQUALS(boundaries[0].points.size(), 8U);
+		TS_ASSERT_EQUALS(boundaries[1].points.size(), 8U);
+		TS_ASSERT_EQUALS(boundaries[2].points.size(), 6U);
+
+		int twosExpectedPoints[][2] = {{36, 0}, {44, 0}, {48, 4}, {48,12}, {44,16}, {36,16}, {32,12}, {32, 4}};
+		int onesExpectedPoints[][2] = {{12, 8}, {20, 8}, {24,12}, {24,20}, {20,24}, {12,24}, { 8,20}, { 8,12}};
+		int blinkingExpectedPoints[][2] = {{12,24}, {20,24}, {24,28}, {20,32}, {12,32}, { 8,28}};
+
+		TestBoundaryPointsEqual(boundaries[0].points, twosExpectedPoints);
+		TestBoundaryPointsEqual(boundaries[1].points, onesExpectedPoints);
+		TestBoundaryPointsEqual(boundaries[2].points, blinkingExpectedPoints);
+	}
+
 private:
 	/// Parses a string representation of a grid into an actual Grid structure, such that the (i,j) axes are located in the bottom
 	/// left hand side of the map. Note: leaves all custom bits in the grid values at zero (anything outside
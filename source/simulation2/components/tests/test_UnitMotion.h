@@ -0,0 +1,193 @@
+/* Copyright (C) 2026 Wildfire Games.
+ * This file is part of 0 A.D.
+ *
+ * 0 A.D. is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * 0 A.D. is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with 0 A.D.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "lib/self_test.h"
+
+#include "graphics/Terrain.h"
+#include "lib/file/file_system.h"
+#include "lib/file/io/write_buffer.h"
+#include "lib/file/vfs/vfs.h"
+#include "lib/path.h"
+#include "ps/Filesystem.h"
+#include "ps/XML/Xeromyces.h"
+#include "simulation2/Simulation2.h"
+#include "simulation2/components/CCmpUnitMotionManager.h"
+#include "simulation2/components/ICmpPosition.h"
+#include "simulation2/components/ICmpUnitMotion.h"
+#include "simulation2/helpers/Position.h"
+#include "simulation2/system/Component.h"
+#include "simulation2/system/Entity.h"
+
+#include <cstddef>
+#include <limits>
+#include <optional>
+#include <string>
+#include <vector>
+
+class TestCmpUnitMotion : public CxxTest::TestSuite
+{
+	std::optional<CXeromycesEngine> xeromycesEngine;
+
+	static entity_id_t AddUnit(CSimulation2& sim, int x, int z)
+	{
+		const entity_id_t ent = sim.AddEntity(L"test_unit_motion");
+		CmpPtr<ICmpPosition> cmpPosition(sim, ent);
+		cmpPosition->JumpTo(entity_pos_t::FromInt(x), entity_pos_t::FromInt(z));
+		return ent;
+	}
+
+	/**
+	 * Gives the orders of @p addUnits and returns the state hash after each turn.
+	 */
+	template<typename AddUnits>
+	static std::vector<std::string> MoveUnits(size_t minUnitsForAsyncMotion, const AddUnits& addUnits)
+	{
+		CTerrain terrain;
+		terrain.Initialize(5, NULL);
+
+		CSimulation2 sim{nullptr, *g_ScriptContext, &terrain, CSimulation2::DEFAULT_SCRIPTS};
+		sim.ResetState();
+
+		CCmpUnitMotionManager* cmpUnitMotionManager = static_cast<CCmpUnitMotionManager*>(sim.QueryInterface(SYSTEM_ENTITY, IID_UnitMotionManager));
+		cmpUnitMotionManager->m_MinUnitsForAsyncMotion = minUnitsForAsyncMotion;
+
+		addUnits(sim);
+
+		std::vector<std::string> hashes;
+		for (int turn = 0; turn < 30; ++turn)
+		{
+			sim.Update(200);
+			std::string hash;
+			TS_ASSERT(sim.ComputeStateHash(hash, false));
+			hashes.push_back(hash);
+		}
+		return hashes;
+	}
+
+	/**
+	 * Checks that moving the units on worker threads doesn't change the simulation state.
+	 */
+	template<typename AddUnits>
+	static void CheckAsyncMotion(const AddUnits& addUnits)
+	{
+		const std::vector<std::string> serial = MoveUnits(std::numeric_limits<size_t>::max(), addUnits);
+		const std::vector<std::string> async = MoveUnits(0, addUnits);
+		TS_ASSERT_EQUALS(serial.size(), async.size());
+		TS_ASSERT(serial == async);
+
+		// The units did move.
+		TS_ASSERT(!serial.empty() && serial.front() != serial.back());
+	}
+
+public:
+	void setUp()
+	{
+		g_VFS = CreateVfs();
+		g_VFS->Mount(L"", DataDir() / "mods" / "mod" / "", VFS_MOUNT_MUST_EXIST);
+		g_VFS->Mount(L"", DataDir() / "mods" / "public" / "", VFS_MOUNT_MUST_EXIST, 1); // ignore directory-not-found errors
+		TS_ASSERT_OK(g_VFS->Mount(L"", DataDir() / "_testcache" / "", 0, VFS_MAX_PRIORITY));
+
+		// A unit with only the components needed to move and push.
+		const std::string unitTemplate = R"(<?xml version="1.0" encoding="utf-8"?>
+			<Entity>
+				<Position>
+					<Anchor>upright</Anchor>
+					<Altitude>0.0</Altitude>
+					<Floating>false</Floating>
+					<FloatDepth>0.0</FloatDepth>
+					<TurnRate>6.0</TurnRate>
+				</Position>
+				<Obstruction>
+					<Unit/>
+					<Active>true</Active>
+					<BlockMovement>true</BlockMovement>
+					<BlockPathfinding>false</BlockPathfinding>
+					<BlockFoundation>false</BlockFoundation>
+					<BlockConstruction>true</BlockConstruction>
+					<DeleteUponConstruction>false</DeleteUponConstruction>
+					<DisableBlockMovement>false</DisableBlockMovement>
+					<DisableBlockPathfinding>false</DisableBlockPathfinding>
+				</Obstruction>
+				<UnitMotion>
+					<FormationController>false</FormationController>
+					<WalkSpeed>9.0</WalkSpeed>
+					<InstantTurnAngle>1.5</InstantTurnAngle>
+					<Acceleration>18.0</Acceleration>
+					<PassabilityClass>default</PassabilityClass>
+					<Weight>10.0</Weight>
+				</UnitMotion>
+			</Entity>)";
+		WriteBuffer buffer;
+		buffer.Append(unitTemplate.data(), unitTemplate.size());
+		TS_ASSERT_OK(g_VFS->CreateFile(L"simulation/templates/test_unit_motion.xml", buffer.Data(), buffer.Size()));
+
+		xeromycesEngine.emplace();
+	}
+
+	void tearDown()
+	{
+		xeromycesEngine.reset();
+		g_VFS.reset();
+		DeleteDirectory(DataDir()/"_testcache");
+	}
+
+	void test_async_motion()
+	{
+		// Two blocks of units walk through each other, one unit in four chasing a unit of the other block.
+		CheckAsyncMotion([](CSimulation2& sim) {
+			const int blockSize = 128;
+			std::vector<entity_id_t> units;
+			for (int block = 0; block < 2; ++block)
+				for (int k = 0; k < blockSize; ++k)
+					units.push_back(AddUnit(sim, 100 + 4 * (k % 16), 100 + 4 * (k / 16) + 100 * block));
+
+			for (size_t k = 0; k < units.size(); ++k)
+			{
+				CmpPtr<ICmpUnitMotion> cmpUnitMotion(sim, units[k]);
+				if (k % 4 == 3)
+				{
+					TS_ASSERT(cmpUnitMotion->MoveToTargetRange(units[(k + blockSize - 1) % units.size()], entity_pos_t::Zero(), entity_pos_t::FromInt(4)));
+					continue;
+				}
+				CmpPtr<ICmpPosition> cmpPosition(sim, units[k]);
+				const CFixedVector2D pos = cmpPosition->GetPosition2D();
+				const entity_pos_t z = k < blockSize ? pos.Y + entity_pos_t::FromInt(100) : pos.Y - entity_pos_t::FromInt(100);
+				TS_ASSERT(cmpUnitMotion->MoveToPointRange(pos.X, z, entity_pos_t::Zero(), entity_pos_t::Zero()));
+			}
+		});
+	}
+
+	void test_async_pushing_across_squares()
+	{
+		// Two tightly packed blocks straddling the lines of the pushing grid (every 20 meters), with alternate
+		// rows walking left and right, so that units keep crossing squares while pushing each other.
+		CheckAsyncMotion([](CSimulation2& sim) {
+			for (int block = 0; block < 2; ++block)
+				for (int j = 0; j < 16; ++j)
+					for (int i = 0; i < 8; ++i)
+					{
+						const int x = 112 + 20 * block + 2 * i;
+						const int z = 110 + 2 * j;
+						const entity_id_t ent = AddUnit(sim, x, z);
+						CmpPtr<ICmpUnitMotion> cmpUnitMotion(sim, ent);
+						const int dx = j % 2 == 0 ? 30 : -30;
+						TS_ASSERT(cmpUnitMotion->MoveToPointRange(entity_pos_t::FromInt(x + dx), entity_pos_t::FromInt(z),
+							entity_pos_t::Zero(), entity_pos_t::Zero()));
+					}
+		});
+	}
+};
@@ -1,4 +1,4 @@
-/* Copyright (C) 2025 Wildfire Games.
+/* Copyright (C) 2026 Wildfire Games.
  * This file is part of 0 A.D.
  *
  * 0 A.D. is free software: you can redistribute it and/or modify
@@ -335,25 +335,32 @@ bool TestRayAASquare(const CFixedVector2D& a, const CFixedVector2D& b, const CFi
 }
 
 /**
- * Separating axis test; returns true if the square defined by u/v/halfSize at the origin
- * is not entirely on the clockwise side of a line in direction 'axis' passing through 'a'
+ * Compute the corners of the square defined by u/v/halfSize at the origin.
  */
-static bool SquareSAT(const CFixedVector2D& a, const CFixedVector2D& axis, const CFixedVector2D& u, const CFixedVector2D& v, const CFixedVector2D& halfSize)
+static void GetSquareCorners(const CFixedVector2D& u, const CFixedVector2D& v, const CFixedVector2D& halfSize, CFixedVector2D (&corners)[4])
 {
-	fixed hw = halfSize.X;
-	fixed hh = halfSize.Y;
+	const CFixedVector2D uhw = u.Multiply(halfSize.X);
+	const CFixedVector2D vhh = v.Multiply(halfSize.Y);
+	corners[0] = uhw + vhh;
+	corners[1] = uhw - vhh;
+	corners[2] = -uhw - vhh;
+	corners[3] = -uhw + vhh;
+}
 
+/**
+ * Separating axis test; returns true if the square with the given corners
+ * is not entirely on the clockwise side of a line in direction 'axis' passing through 'a'
+ */
+static bool SquareSAT(const CFixedVector2D& a, const CFixedVector2D& axis, const CFixedVector2D (&corners)[4])
+{
 	CFixedVector2D p = axis.Perpendicular();
-	if (p.RelativeOrientation(u.Multiply(hw) + v.Multiply(hh) - a) <= 0)
-		return true;
-	if (p.RelativeOrientation(u.Multiply(hw) - v.Multiply(hh) - a) <= 0)
-		return true;
-	if (p.RelativeOrientation(-u.Multiply(hw) - v.Multiply(hh) - a) <= 0)
-		return true;
-	if (p.RelativeOrientation(-u.Multiply(hw) + v.Multiply(hh) - a) <= 0)
-		return true;
 
-	return false;
+	// Test every corner without early exits so the loop has no branches.
+	bool notSeparated = false;
+	for (const CFixedVector2D& corner : corners)
+		notSeparated |= p.RelativeOrientation(corner - a) <= 0;
+
+	return notSeparated;
 }
 
 bool TestSquareSquare(
@@ -362,27 +369,32 @@ bool TestSquareSquare(
 {
 	// TODO: need to test this carefully
 
+	CFixedVector2D squareCorners0[4];
+	CFixedVector2D squareCorners1[4];
+	GetSquareCorners(u0, v0, halfSize0, squareCorners0);
+	GetSquareCorners(u1, v1, halfSize1, squareCorners1);
+
 	CFixedVector2D corner0a = c0 + u0.Multiply(halfSize0.X) + v0.Multiply(halfSize0.Y);
 	CFixedVector2D corner0b = c0 - u0.Multiply(halfSize0.X) - v0.Multiply(halfSize0.Y);
 	CFixedVector2D corner1a = c1 + u1.Multiply(halfSize1.X) + v1.Multiply(halfSize1.Y);
 	CFixedVector2D corner1b = c1 - u1.Multiply(halfSize1.X) - v1.Multiply(halfSize1.Y);
 
 	// Do a SAT test for each square vs each edge of the other square
-	if (!SquareSAT(corner0a - c1, -u0, u1, v1, halfSize1))
+	if (!SquareSAT(corner0a - c1, -u0, squareCorners1))
 		return false;
-	if (!SquareSAT(corner0a - c1, v0, u1, v1, halfSize1))
+	if (!SquareSAT(corner0a - c1, v0, squareCorners1))
 		return false;
-	if (!SquareSAT(corner0b - c1, u0, u1, v1, halfSize1))
+	if (!SquareSAT(corner0b - c1, u0, squareCorners1))
 		return false;
-	if (!SquareSAT(corner0b - c1, -v0, u1, v1, halfSize1))
+	if (!SquareSAT(corner0b - c1, -v0, squareCorners1))
 		return false;
-	if (!SquareSAT(corner1a - c0, -u1, u0, v0, halfSize0))
+	if (!SquareSAT(corner1a - c0, -u1, squareCorners0))
 		return false;
-	if (!SquareSAT(corner1a - c0, v1, u0, v0, halfSize0))
+	if (!SquareSAT(corner1a - c0, v1, squareCorners0))
 		return false;
-	if (!SquareSAT(corner1b - c0, u1, u0, v0, halfSize0))
+	if (!SquareSAT(corner1b - c0, u1, squareCorners0))
 		return false;
-	if (!SquareSAT(corner1b - c0, -v1, u0, v0, halfSize0))
+	if (!SquareSAT(corner1b - c0, -v1, squareCorners0))
 		return false;
 
 	return true;
@@ -1,4 +1,4 @@
-/* Copyright (C) 2025 Wildfire Games.
+/* Copyright (C) 2026 Wildfire Games.
  * This file is part of 0 A.D.
  *
  * 0 A.D. is free software: you can redistribute it and/or modify
@@ -24,6 +24,7 @@
 #include "lib/code_generation.h"
 #include "maths/Fixed.h"
 #include "maths/FixedVector2D.h"
+#include "maths/Sqrt.h"
 #include "ps/Profile.h"
 #include "ps/Profiler2.h"
 #include "renderer/Scene.h"
@@ -31,10 +32,13 @@
 #include "simulation2/helpers/PathGoal.h"
 #include "simulation2/helpers/Pathfinding.h"
 #include "simulation2/helpers/Position.h"
+#include "simulation2/helpers/PriorityQueue.h"
 #include "simulation2/helpers/Render.h"
 
 #include <algorithm>
+#include <cstdlib>
 #include <cstring>
+#include <map>
 
 class CSimContext;
 
@@ -392,53 +396,45 @@ void HierarchicalPathfinder::Recompute(Grid<NavcellData>* grid,
 	m_ChunksW = (grid->m_W + CHUNK_SIZE - 1) / CHUNK_SIZE;
 	m_ChunksH = (grid->m_H + CHUNK_SIZE - 1) / CHUNK_SIZE;
 
-	m_Chunks.clear();
-	m_Edges.clear();
+	m_Graphs.clear();
+	m_Graphs.resize(PASS_CLASS_BITS);
 
 	// Reset global regions.
 	m_NextGlobalRegionID = 1;
 
+	std::vector<u32> open;
 	for (auto& passClassMask : allPassClasses)
 	{
-		pass_class_t passClass = passClassMask.second;
+		RegionGraph& graph = GetGraph(passClassMask.second);
 
 		// Compute the regions within each chunk
-		m_Chunks[passClass].resize(m_ChunksW*m_ChunksH);
+		graph.m_Chunks.resize(m_ChunksW*m_ChunksH);
 		for (int cj = 0; cj < m_ChunksH; ++cj)
 		{
 			for (int ci = 0; ci < m_ChunksW; ++ci)
 			{
-				m_Chunks[passClass].at(cj*m_ChunksW + ci).InitRegions(ci, cj, grid, passClass);
+				graph.m_Chunks.at(cj*m_ChunksW + ci).InitRegions(ci, cj, grid, passClassMask.second);
 			}
 		}
 
 		// Construct the search graph over the regions.
-		EdgesMap& edges = m_Edges[passClass];
-		RecomputeAllEdges(passClass, edges);
-
-		// Spread global regions.
-		std::map<RegionID, GlobalRegionID>& globalRegion = m_GlobalRegions[passClass];
-		globalRegion.clear();
+		graph.m_BordersI.resize(m_ChunksW*m_ChunksH);
+		graph.m_BordersJ.resize(m_ChunksW*m_ChunksH);
 		for (u8 cj = 0; cj < m_ChunksH; ++cj)
 			for (u8 ci = 0; ci < m_ChunksW; ++ci)
-				for (u16 rid : GetChunk(ci, cj, passClass).m_RegionsID)
-				{
-					RegionID reg{ci,cj,rid};
-					if (globalRegion.find(reg) == globalRegion.end())
-					{
-						GlobalRegionID ID = m_NextGlobalRegionID++;
-
-						globalRegion.insert({ reg, ID });
-						// Avoid creating an empty link if possible, FindReachableRegions uses [] which calls the default constructor.
-						if (edges.find(reg) != edges.end())
-						{
-							std::set<RegionID> reachable;
-							FindReachableRegions(reg, reachable, passClass);
-							for (const RegionID& region : reachable)
-								globalRegion.insert({ region, ID });
-						}
-					}
-				}
+			{
+				if (ci < m_ChunksW - 1)
+					ComputeBorder(graph.m_Chunks[cj*m_ChunksW + ci], graph.m_Chunks[cj*m_ChunksW + ci + 1], false, graph.m_BordersI[cj*m_ChunksW + ci]);
+				if (cj < m_ChunksH - 1)
+					ComputeBorder(graph.m_Chunks[cj*m_ChunksW + ci], graph.m_Chunks[(cj+1)*m_ChunksW + ci], true, graph.m_BordersJ[cj*m_ChunksW + ci]);
+			}
+		RebuildGraph(graph);
+
+		// Spread global regions.
+		graph.m_GlobalRegions.assign(graph.m_Regions.size(), 0);
+		for (u32 n = 0; n < graph.m_Regions.size(); ++n)
+			if (graph.m_GlobalRegions[n] == 0)
+				FloodGlobalRegion(graph, n, m_NextGlobalRegionID++, open);
 	}
 
 	if (m_DebugOverlay)
@@ -454,65 +450,80 @@ void HierarchicalPathfinder::Update(Grid<NavcellData>* grid, const Grid<u8>& dir
 
 	ASSERT(m_NextGlobalRegionID < std::numeric_limits<GlobalRegionID>::max());
 
-	std::map<pass_class_t, std::vector<RegionID> > needNewGlobalRegionMap;
-
 	// Algorithm for the partial update:
-	// 1. Loop over chunks.
-	// 2. For any dirty chunk:
-	//		- remove all regions from the global region map
-	//		- remove all edges, by removing the neighbor connection with them and then deleting us
-	//		- recreate regions inside the chunk
-	//		- reconnect the regions. We may do too much work if we reconnect with a dirty chunk, but that's fine.
-	// 3. Recreate global regions.
+	// 1. Find the dirty chunks, i.e. those where any navcell is dirty.
+	// 2. Recreate the regions inside them and the borders with their neighbors.
+	// 3. Rebuild the graph. The regions of the other chunks are unchanged, so they keep their global region.
+	// 4. Recreate global regions, starting from the regions in or next to a dirty chunk.
 	// This means that if any chunk changes, we may need to flood (at most once) the whole map.
-	// That's quite annoying, but I can't think of an easy way around it.
-	// If we could be sure that a region's topology hasn't changed, we could skip removing its global region
-	// but that's non trivial as we have no easy way to determine said topology (regions could "switch" IDs on update for now).
-	for (u8 cj = 0; cj <  m_ChunksH; ++cj)
+	// Starting from the neighboring chunks too is needed since a dirty chunk may no longer have any region
+	// connecting them.
+	std::vector<u8> dirtyChunks(m_ChunksW * m_ChunksH, 0);
+	bool anyDirty = false;
+	for (u8 cj = 0; cj < m_ChunksH; ++cj)
 	{
 		int j0 = cj * CHUNK_SIZE;
 		int j1 = std::min(j0 + CHUNK_SIZE, (int)dirtinessGrid.m_H);
 		for (u8 ci = 0; ci < m_ChunksW; ++ci)
 		{
-			// Skip chunks where no navcells are dirty.
 			int i0 = ci * CHUNK_SIZE;
 			int i1 = std::min(i0 + CHUNK_SIZE, (int)dirtinessGrid.m_W);
 			if (!dirtinessGrid.any_set_in_square(i0, j0, i1, j1))
 				continue;
 
-			for (const std::pair<const std::string, pass_class_t>& passClassMask : m_PassClassMasks)
-			{
-				pass_class_t passClass = passClassMask.second;
-				Chunk& a = m_Chunks[passClass].at(ci + cj*m_ChunksW);
+			dirtyChunks[cj*m_ChunksW + ci] = 1;
+			anyDirty = true;
+		}
+	}
 
-				// Clean up edges and global region ID
-				EdgesMap& edgeMap = m_Edges[passClass];
-				for (u16 i : a.m_RegionsID)
-				{
-					RegionID reg{ci, cj, i};
-					m_GlobalRegions[passClass].erase(reg);
-					for (const RegionID& neighbor : edgeMap[reg])
-					{
-						edgeMap[neighbor].erase(reg);
-						if (edgeMap[neighbor].empty())
-							edgeMap.erase(neighbor);
-					}
-					edgeMap.erase(reg);
-				}
+	if (!anyDirty)
+		return;
 
-				// Recompute regions inside this chunk.
-				a.InitRegions(ci, cj, grid, passClass);
+	std::vector<u32> oldChunkOffsets;
+	std::vector<GlobalRegionID> oldGlobalRegions;
+	std::vector<u32> open;
+	for (const std::pair<const std::string, pass_class_t>& passClassMask : m_PassClassMasks)
+	{
+		RegionGraph& graph = GetGraph(passClassMask.second);
 
-				for (u16 i : a.m_RegionsID)
-					needNewGlobalRegionMap[passClass].push_back(RegionID{ci, cj, i});
+		for (u8 cj = 0; cj < m_ChunksH; ++cj)
+			for (u8 ci = 0; ci < m_ChunksW; ++ci)
+				if (dirtyChunks[cj*m_ChunksW + ci])
+					graph.m_Chunks[cj*m_ChunksW + ci].InitRegions(ci, cj, grid, passClassMask.second);
 
-				UpdateEdges(ci, cj, passClass, edgeMap);
+		for (u8 cj = 0; cj < m_ChunksH; ++cj)
+			for (u8 ci = 0; ci < m_ChunksW; ++ci)
+				if (dirtyChunks[cj*m_ChunksW + ci])
+					UpdateBorders(ci, cj, graph);
+
+		oldChunkOffsets.swap(graph.m_ChunkOffsets);
+		oldGlobalRegions.swap(graph.m_GlobalRegions);
+		RebuildGraph(graph);
+
+		// Regions of unchanged chunks keep their global region for now; 0 marks the new regions.
+		graph.m_GlobalRegions.assign(graph.m_Regions.size(), 0);
+		for (size_t c = 0; c < dirtyChunks.size(); ++c)
+			if (!dirtyChunks[c])
+				std::copy(oldGlobalRegions.begin() + oldChunkOffsets[c], oldGlobalRegions.begin() + oldChunkOffsets[c + 1],
+					graph.m_GlobalRegions.begin() + graph.m_ChunkOffsets[c]);
+
+		// All global regions created from now on are newer than this one.
+		const GlobalRegionID firstNewGlobalRegion = m_NextGlobalRegionID;
+		for (u8 cj = 0; cj < m_ChunksH; ++cj)
+			for (u8 ci = 0; ci < m_ChunksW; ++ci)
+			{
+				const size_t c = cj*m_ChunksW + ci;
+				if (!dirtyChunks[c] &&
+				    !(ci > 0 && dirtyChunks[c - 1]) && !(ci < m_ChunksW - 1 && dirtyChunks[c + 1]) &&
+				    !(cj > 0 && dirtyChunks[c - m_ChunksW]) && !(cj < m_ChunksH - 1 && dirtyChunks[c + m_ChunksW]))
+					continue;
+
+				for (u32 n = graph.m_ChunkOffsets[c]; n < graph.m_ChunkOffsets[c + 1]; ++n)
+					if (graph.m_GlobalRegions[n] < firstNewGlobalRegion)
+						FloodGlobalRegion(graph, n, m_NextGlobalRegionID++, open);
 			}
-		}
 	}
 
-	UpdateGlobalRegions(needNewGlobalRegionMap);
-
 	if (m_DebugOverlay)
 	{
 		m_DebugOverlayLines.clear();
@@ -520,78 +531,112 @@ void HierarchicalPathfinder::Update(Grid<NavcellData>* grid, const Grid<u8>& dir
 	}
 }
 
-void HierarchicalPathfinder::ComputeNeighbors(EdgesMap& edges, Chunk& a, Chunk& b, bool transpose, bool opposite) const
+/**
+ * Finds the pairs of connected regions across the border between @p a and the
+ * next chunk @p b (along i, or along j if @p transpose).
+ */
+void HierarchicalPathfinder::ComputeBorder(const Chunk& a, const Chunk& b, bool transpose, std::vector<std::pair<u16, u16>>& border) const
 {
 	// For each edge between chunks, we loop over every adjacent pair of
 	// navcells in the two chunks. If they are both in valid regions
 	// (i.e. are passable navcells) then add a graph edge between those regions.
-	// (We don't need to test for duplicates since EdgesMap already uses a
-	// std::set which will drop duplicate entries.)
-	// But as set.insert can be quite slow on large collection, and that we usually
-	// try to insert the same values, we cache the previous one for a fast test.
-	RegionID raPrev(0,0,0);
-	RegionID rbPrev(0,0,0);
+	// Long runs of navcells usually give the same pair, so skip repeated pairs before
+	// removing the remaining duplicates.
+	border.clear();
 	for (int k = 0; k < CHUNK_SIZE; ++k)
 	{
-		u8 aSide = opposite ? CHUNK_SIZE - 1 : 0;
-		u8 bSide = CHUNK_SIZE - 1 - aSide;
-		RegionID ra = transpose ? a.Get(k, aSide) : a.Get(aSide, k);
-		RegionID rb = transpose ? b.Get(k, bSide) : b.Get(bSide, k);
-		if (ra.r && rb.r)
-		{
-			if (ra == raPrev && rb == rbPrev)
-				continue;
-			edges[ra].insert(rb);
-			edges[rb].insert(ra);
-			raPrev = ra;
-			rbPrev = rb;
-		}
+		u16 ra = transpose ? a.m_Regions[CHUNK_SIZE - 1][k] : a.m_Regions[k][CHUNK_SIZE - 1];
+		u16 rb = transpose ? b.m_Regions[0][k] : b.m_Regions[k][0];
+		if (ra && rb && (border.empty() || border.back() != std::make_pair(ra, rb)))
+			border.emplace_back(ra, rb);
 	}
+	std::sort(border.begin(), border.end());
+	border.erase(std::unique(border.begin(), border.end()), border.end());
 }
 
 /**
- * Connect a chunk's regions to their neighbors. Not optimised for global recomputing.
+ * Recomputes the borders of a chunk with its neighbors, after its regions changed.
  */
-void HierarchicalPathfinder::UpdateEdges(u8 ci, u8 cj, pass_class_t passClass, EdgesMap& edges)
+void HierarchicalPathfinder::UpdateBorders(u8 ci, u8 cj, RegionGraph& graph) const
 {
-	std::vector<Chunk>& chunks = m_Chunks[passClass];
-
-	Chunk& a = chunks.at(cj*m_ChunksW + ci);
+	const size_t c = cj*m_ChunksW + ci;
 
 	if (ci > 0)
-		ComputeNeighbors(edges, a, chunks.at(cj*m_ChunksW + (ci-1)), false, false);
+		ComputeBorder(graph.m_Chunks[c - 1], graph.m_Chunks[c], false, graph.m_BordersI[c - 1]);
 
-	if (ci < m_ChunksW-1)
-		ComputeNeighbors(edges, a, chunks.at(cj*m_ChunksW + (ci+1)), false, true);
+	if (ci < m_ChunksW - 1)
+		ComputeBorder(graph.m_Chunks[c], graph.m_Chunks[c + 1], false, graph.m_BordersI[c]);
 
 	if (cj > 0)
-		ComputeNeighbors(edges, a, chunks.at((cj-1)*m_ChunksW + ci), true, false);
+		ComputeBorder(graph.m_Chunks[c - m_ChunksW], graph.m_Chunks[c], true, graph.m_BordersJ[c - m_ChunksW]);
 
 	if (cj < m_ChunksH - 1)
-		ComputeNeighbors(edges, a, chunks.at((cj+1)*m_ChunksW + ci), true, true);
+		ComputeBorder(graph.m_Chunks[c], graph.m_Chunks[c + m_ChunksW], true, graph.m_BordersJ[c]);
 }
 
 /**
- * Find edges between regions in all chunks, in an optimised manner (only look at top/left)
+ * Renumbers the regions and rebuilds the edges from the borders of all chunks.
  */
-void HierarchicalPathfinder::RecomputeAllEdges(pass_class_t passClass, EdgesMap& edges)
+void HierarchicalPathfinder::RebuildGraph(RegionGraph& graph) const
 {
-	std::vector<Chunk>& chunks = m_Chunks[passClass];
-
-	edges.clear();
+	const size_t numChunks = graph.m_Chunks.size();
 
-	for (int cj = 0; cj < m_ChunksH; ++cj)
+	graph.m_ChunkOffsets.resize(numChunks + 1);
+	graph.m_Regions.clear();
+	for (size_t c = 0; c < numChunks; ++c)
 	{
-		for (int ci = 0; ci < m_ChunksW; ++ci)
-		{
-			Chunk& a = chunks.at(cj*m_ChunksW + ci);
-
-			if (ci > 0)
-				ComputeNeighbors(edges, a, chunks.at(cj*m_ChunksW + (ci-1)), false, false);
+		const Chunk& chunk = graph.m_Chunks[c];
+		graph.m_ChunkOffsets[c] = graph.m_Regions.size();
+		for (u16 r : chunk.m_RegionsID)
+			graph.m_Regions.emplace_back(chunk.m_ChunkI, chunk.m_ChunkJ, r);
+	}
+	graph.m_ChunkOffsets[numChunks] = graph.m_Regions.size();
 
-			if (cj > 0)
-				ComputeNeighbors(edges, a, chunks.at((cj-1)*m_ChunksW + ci), true, false);
+	// Count the neighbors of each region, then turn the counts into offsets and fill the edges,
+	// which leaves each offset at the start of the next region.
+	auto forEachEdge = [&](auto callback) {
+		for (size_t c = 0; c < numChunks; ++c)
+		{
+			for (const std::pair<u16, u16>& edge : graph.m_BordersI[c])
+				callback(graph.Index(c, edge.first), graph.Index(c + 1, edge.second));
+			for (const std::pair<u16, u16>& edge : graph.m_BordersJ[c])
+				callback(graph.Index(c, edge.first), graph.Index(c + m_ChunksW, edge.second));
 		}
+	};
+
+	graph.m_EdgeOffsets.assign(graph.m_Regions.size() + 1, 0);
+	forEachEdge([&graph](u32 a, u32 b) {
+		++graph.m_EdgeOffsets[a + 1];
+		++graph.m_EdgeOffsets[b + 1];
+	});
+	for (size_t n = 1; n < graph.m_EdgeOffsets.size(); ++n)
+		graph.m_EdgeOffsets[n] += graph.m_EdgeOffsets[n - 1];
+
+	graph.m_Edges.resize(graph.m_EdgeOffsets.back());
+	forEachEdge([&graph](u32 a, u32 b) {
+		graph.m_Edges[graph.m_EdgeOffsets[a]++] = b;
+		graph.m_Edges[graph.m_EdgeOffsets[b]++] = a;
+	});
+	for (size_t n = graph.m_EdgeOffsets.size() - 1; n > 0; --n)
+		graph.m_EdgeOffsets[n] = graph.m_EdgeOffsets[n - 1];
+	graph.m_EdgeOffsets[0] = 0;
+}
+
+void HierarchicalPathfinder::FloodGlobalRegion(RegionGraph& graph, u32 from, GlobalRegionID id, std::vector<u32>& open) const
+{
+	graph.m_GlobalRegions[from] = id;
+	open.clear();
+	open.push_back(from);
+	while (!open.empty())
+	{
+		const u32 curr = open.back();
+		open.pop_back();
+		for (u32 neighbor : graph.Neighbors(curr))
+			if (graph.m_GlobalRegions[neighbor] != id)
+			{
+				graph.m_GlobalRegions[neighbor] = id;
+				open.push_back(neighbor);
+			}
 	}
 }
 
@@ -600,18 +645,20 @@ void HierarchicalPathfinder::RecomputeAllEdges(pass_class_t passClass, EdgesMap&
  */
 void HierarchicalPathfinder::AddDebugEdges(pass_class_t passClass)
 {
-	const EdgesMap& edges = m_Edges[passClass];
-	const std::vector<Chunk>& chunks = m_Chunks[passClass];
+	const RegionGraph& graph = GetGraph(passClass);
 
-	for (auto& edge : edges)
+	for (u32 n = 0; n < graph.m_Regions.size(); ++n)
 	{
-		for (const RegionID& region: edge.second)
+		const RegionID& from = graph.m_Regions[n];
+		for (u32 neighbor : graph.Neighbors(n))
 		{
+			const RegionID& region = graph.m_Regions[neighbor];
+
 			// Draw a line between the two regions' centers
 
 			int i0, j0, i1, j1;
-			chunks[edge.first.cj * m_ChunksW + edge.first.ci].RegionCenter(edge.first.r, i0, j0);
-			chunks[region.cj * m_ChunksW + region.ci].RegionCenter(region.r, i1, j1);
+			GetChunk(from.ci, from.cj, passClass).RegionCenter(from.r, i0, j0);
+			GetChunk(region.ci, region.cj, passClass).RegionCenter(region.r, i1, j1);
 
 			CFixedVector2D a, b;
 			Pathfinding::NavcellCenter(i0, j0, a.X, a.Y);
@@ -636,36 +683,12 @@ void HierarchicalPathfinder::AddDebugEdges(pass_class_t passClass)
 	}
 }
 
-void HierarchicalPathfinder::UpdateGlobalRegions(const std::map<pass_class_t, std::vector<RegionID> >& needNewGlobalRegionMap)
-{
-	// Use FindReachableRegions because we cannot be sure, even if we find a non-dirty chunk nearby,
-	// that we weren't the only bridge connecting that chunk to the rest of the global region.
-	for (const std::pair<const pass_class_t, std::vector<RegionID>>& regionsInNeed : needNewGlobalRegionMap)
-	{
-		for (const RegionID& reg : regionsInNeed.second)
-		{
-			std::map<RegionID, GlobalRegionID>& globalRegions = m_GlobalRegions[regionsInNeed.first];
-			// If we have already been given a region, skip us.
-			if (globalRegions.find(reg) != globalRegions.end())
-				continue;
-
-			std::set<RegionID> reachable;
-			FindReachableRegions(reg, reachable, regionsInNeed.first);
-
-			GlobalRegionID ID = m_NextGlobalRegionID++;
-
-			for (const RegionID& regionId : reachable)
-				globalRegions[regionId] = ID;
-		}
-	}
-}
-
 HierarchicalPathfinder::RegionID HierarchicalPathfinder::Get(u16 i, u16 j, pass_class_t passClass) const
 {
 	int ci = i / CHUNK_SIZE;
 	int cj = j / CHUNK_SIZE;
 	ENSURE(ci < m_ChunksW && cj < m_ChunksH);
-	return m_Chunks.at(passClass)[cj*m_ChunksW + ci].Get(i % CHUNK_SIZE, j % CHUNK_SIZE);
+	return GetGraph(passClass).m_Chunks.at(cj*m_ChunksW + ci).Get(i % CHUNK_SIZE, j % CHUNK_SIZE);
 }
 
 HierarchicalPathfinder::GlobalRegionID HierarchicalPathfinder::GetGlobalRegion(u16 i, u16 j, pass_class_t passClass) const
@@ -675,7 +698,10 @@ HierarchicalPathfinder::GlobalRegionID HierarchicalPathfinder::GetGlobalRegion(u
 
 HierarchicalPathfinder::GlobalRegionID HierarchicalPathfinder::GetGlobalRegion(RegionID region, pass_class_t passClass) const
 {
-	return region.r == 0 ? GlobalRegionID(0) : m_GlobalRegions.at(passClass).at(region);
+	if (region.r == 0)
+		return 0;
+	const RegionGraph& graph = GetGraph(passClass);
+	return graph.m_GlobalRegions[RegionIndex(graph, region)];
 }
 
 void CreatePointGoalAt(u16 i, u16 j, PathGoal& goal)
@@ -743,13 +769,92 @@ void HierarchicalPathfinder::FindNearestPassableNavcell(u16& i, u16& j, pass_cla
 	std::set<RegionID, SortByCenterToPoint> regions(SortByCenterToPoint(i, j));
 
 	// Construct a set of all regions of all chunks for this pass class
-	for (const Chunk& chunk : m_Chunks.at(passClass))
+	for (const Chunk& chunk : GetGraph(passClass).m_Chunks)
 		for (int r : chunk.m_RegionsID)
 			regions.insert(RegionID(chunk.m_ChunkI, chunk.m_ChunkJ, r));
 
 	FindNearestNavcellInRegions(regions, i, j, passClass);
 }
 
+bool HierarchicalPathfinder::FindCorridor(u16 i0, u16 j0, u16 iGoal, u16 jGoal, pass_class_t passClass, PathCorridor& corridor) const
+{
+	PROFILE2("FindCorridor");
+
+	const RegionID start = Get(i0, j0, passClass);
+	const RegionID goal = Get(iGoal, jGoal, passClass);
+	if (start.r == 0 || goal.r == 0)
+		return false;
+
+	// A* over the region graph. Edges only link regions of adjacent chunks, so every step
+	// costs the same; the straight-line distance between chunks is used as the heuristic,
+	// which keeps the route close to the line between start and goal.
+	constexpr u32 STEP_COST = 1024;
+	auto heuristic = [&goal](const RegionID& region) -> u32 {
+		const u64 di = std::abs(region.ci - goal.ci);
+		const u64 dj = std::abs(region.cj - goal.cj);
+		return isqrt64((di * di + dj * dj) * STEP_COST * STEP_COST);
+	};
+
+	const RegionGraph& graph = GetGraph(passClass);
+	const u32 startIndex = RegionIndex(graph, start);
+	const u32 goalIndex = RegionIndex(graph, goal);
+	if (graph.m_GlobalRegions[startIndex] != graph.m_GlobalRegions[goalIndex])
+		return false;
+
+	struct Node
+	{
+		u32 g;
+		u32 pred;
+		bool closed;
+	};
+	std::vector<Node> nodes(graph.m_Regions.size(), Node{ std::numeric_limits<u32>::max(), 0, false });
+	PriorityQueueHeap<u32, u32, u32> open;
+
+	nodes[startIndex] = Node{ 0, startIndex, false };
+	open.push({ startIndex, heuristic(start), heuristic(start) });
+
+	while (!open.empty())
+	{
+		const u32 curr = open.pop().id;
+		nodes[curr].closed = true;
+		if (curr == goalIndex)
+			break;
+
+		const u32 g = nodes[curr].g + STEP_COST;
+		for (u32 neighbor : graph.Neighbors(curr))
+		{
+			Node& node = nodes[neighbor];
+			if (node.closed || g >= node.g)
+				continue;
+
+			const u32 h = heuristic(graph.m_Regions[neighbor]);
+			if (node.g == std::numeric_limits<u32>::max())
+				open.push({ neighbor, g + h, h });
+			else
+				open.promote(neighbor, node.g + h, g + h, h);
+			node.g = g;
+			node.pred = curr;
+		}
+	}
+
+	if (!nodes[goalIndex].closed)
+		return false;
+
+	// Widen the route by one chunk, so that the refined path isn't forced along chunk borders.
+	corridor.m_ChunksW = m_ChunksW;
+	corridor.m_Chunks.assign(m_ChunksW * m_ChunksH, 0);
+	for (u32 n = goalIndex; ; n = nodes[n].pred)
+	{
+		const RegionID& region = graph.m_Regions[n];
+		for (int cj = std::max(0, region.cj - 1); cj <= std::min<int>(m_ChunksH - 1, region.cj + 1); ++cj)
+			for (int ci = std::max(0, region.ci - 1); ci <= std::min<int>(m_ChunksW - 1, region.ci + 1); ++ci)
+				corridor.m_Chunks[cj * m_ChunksW + ci] = 1;
+		if (n == startIndex)
+			break;
+	}
+	return true;
+}
+
 void HierarchicalPathfinder::FindNearestNavcellInRegions(const std::set<RegionID, SortByCenterToPoint>& regions, u16& iGoal, u16& jGoal, pass_class_t passClass) const
 {
 	u16 bestI = iGoal, bestJ = jGoal; // Somewhat sensible default-values should regions() be passed empty.
@@ -825,7 +930,7 @@ void HierarchicalPathfinder::FillRegionOnGrid(const RegionID& region, pass_class
 	int i0 = region.ci * CHUNK_SIZE;
 	int j0 = region.cj * CHUNK_SIZE;
 
-	const Chunk& c = m_Chunks.at(passClass)[region.cj * m_ChunksW + region.ci];
+	const Chunk& c = GetChunk(region.ci, region.cj, passClass);
 
 	for (int j = 0; j < CHUNK_SIZE; ++j)
 		for (int i = 0; i < CHUNK_SIZE; ++i)
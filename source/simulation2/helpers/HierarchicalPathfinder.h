@@ -1,4 +1,4 @@
-/* Copyright (C) 2025 Wildfire Games.
+/* Copyright (C) 2026 Wildfire Games.
  * This file is part of 0 A.D.
  *
  * 0 A.D. is free software: you can redistribute it and/or modify
@@ -27,10 +27,13 @@
 #include "ps/CLogger.h"
 #include "renderer/TerrainOverlay.h"
 
+#include <algorithm>
+#include <bit>
 #include <cstddef>
 #include <limits>
 #include <map>
 #include <set>
+#include <span>
 #include <string>
 #include <utility>
 #include <vector>
@@ -52,6 +55,8 @@ template <typename T> class Grid;
  * When two regions in adjacent chunks are connected by passable navcells,
  * the graph contains an edge between the corresponding two vertexes.
  * By design, there can never be an edge between two regions in the same chunk.
+ * The regions of each passability class are numbered densely, so that the graph
+ * and the global region of each region can be stored in flat arrays.
  *
  * Those fixed-size chunks are used to efficiently compute "global regions" by effectively flood-filling.
  * Those can then be used to immediately determine if two reachables points are connected.
@@ -69,12 +74,28 @@ class TestHierarchicalPathfinder;
 class HierarchicalOverlay;
 class SceneCollector;
 
+/**
+ * The set of chunks around a route through the hierarchical pathfinder's region graph.
+ * Searches restricted to a corridor treat the navcells outside of it as impassable.
+ */
+class PathCorridor
+{
+	friend class HierarchicalPathfinder;
+public:
+	bool Contains(int i, int j) const;
+
+private:
+	std::vector<u8> m_Chunks; // non-zero for the chunks in the corridor
+	u8 m_ChunksW = 0;
+};
+
 class HierarchicalPathfinder
 {
 #ifdef TEST
 	friend class TestCmpPathfinder;
 	friend class TestHierarchicalPathfinder;
 #endif
+	friend class PathCorridor;
 public:
 	typedef u32 GlobalRegionID;
 
@@ -156,6 +177,17 @@ public:
 	 */
 	void FindNearestPassableNavcell(u16& i, u16& j, pass_class_t passClass) const;
 
+	/**
+	 * Searches the region graph for a route from the region of the navcell @p i0, @p j0
+	 * to the region of the navcell @p iGoal, @p jGoal, and stores the chunks along that
+	 * route, widened by one chunk on every side, in @p corridor.
+	 * Since the regions on the route are connected, a path between the two navcells
+	 * always exists within the corridor.
+	 *
+	 * @returns false if there is no route, in which case @p corridor is left untouched.
+	 */
+	bool FindCorridor(u16 i0, u16 j0, u16 iGoal, u16 jGoal, pass_class_t passClass, PathCorridor& corridor) const;
+
 	/**
 	 * Generates the connectivity grid associated with the given pass_class
 	 */
@@ -203,18 +235,73 @@ private:
 #endif
 	};
 
+	/**
+	 * The chunks and the region graph of a passability class.
+	 * Regions are numbered chunk after chunk, in the order of their local IDs.
+	 */
+	struct RegionGraph
+	{
+		std::vector<Chunk> m_Chunks;
+
+		// The regions of the chunk c have the indices m_ChunkOffsets[c] to m_ChunkOffsets[c+1] - 1.
+		std::vector<u32> m_ChunkOffsets;
+		std::vector<RegionID> m_Regions;
+		std::vector<GlobalRegionID> m_GlobalRegions;
+
+		// The indices of the neighbors of the region n are m_Edges[m_EdgeOffsets[n]] to m_Edges[m_EdgeOffsets[n+1] - 1].
+		std::vector<u32> m_EdgeOffsets;
+		std::vector<u32> m_Edges;
+
+		// Pairs of local IDs of connected regions across the border between each chunk
+		// and the next chunk along i, resp. j. The graph edges are built from these.
+		std::vector<std::vector<std::pair<u16, u16>>> m_BordersI;
+		std::vector<std::vector<std::pair<u16, u16>>> m_BordersJ;
+
+		u32 Index(size_t chunk, u16 r) const
+		{
+			const std::vector<u16>& ids = m_Chunks[chunk].m_RegionsID;
+			return m_ChunkOffsets[chunk] + (std::lower_bound(ids.begin(), ids.end(), r) - ids.begin());
+		}
+
+		std::span<const u32> Neighbors(u32 index) const
+		{
+			return { m_Edges.data() + m_EdgeOffsets[index], m_Edges.data() + m_EdgeOffsets[index + 1] };
+		}
+	};
+
+	RegionGraph& GetGraph(pass_class_t passClass)
+	{
+		ASSERT(passClass && !(passClass & (passClass - 1)));
+		return m_Graphs[std::countr_zero(passClass)];
+	}
+
+	const RegionGraph& GetGraph(pass_class_t passClass) const
+	{
+		ASSERT(passClass && !(passClass & (passClass - 1)));
+		return m_Graphs[std::countr_zero(passClass)];
+	}
+
 	const Chunk& GetChunk(u8 ci, u8 cj, pass_class_t passClass) const
 	{
-		return m_Chunks.at(passClass).at(cj * m_ChunksW + ci);
+		return GetGraph(passClass).m_Chunks.at(cj * m_ChunksW + ci);
 	}
 
-	typedef std::map<RegionID, std::set<RegionID> > EdgesMap;
+	/**
+	 * Returns the index of @p region, which must not be impassable.
+	 */
+	u32 RegionIndex(const RegionGraph& graph, const RegionID& region) const
+	{
+		return graph.Index(region.cj * m_ChunksW + region.ci, region.r);
+	}
 
-	void ComputeNeighbors(EdgesMap& edges, Chunk& a, Chunk& b, bool transpose, bool opposite) const;
-	void RecomputeAllEdges(pass_class_t passClass, EdgesMap& edges);
-	void UpdateEdges(u8 ci, u8 cj, pass_class_t passClass, EdgesMap& edges);
+	void ComputeBorder(const Chunk& a, const Chunk& b, bool transpose, std::vector<std::pair<u16, u16>>& border) const;
+	void UpdateBorders(u8 ci, u8 cj, RegionGraph& graph) const;
+	void RebuildGraph(RegionGraph& graph) const;
 
-	void UpdateGlobalRegions(const std::map<pass_class_t, std::vector<RegionID> >& needNewGlobalRegionMap);
+	/**
+	 * Gives the new global region @p id to all the regions connected to the region with index @p from.
+	 */
+	void FloodGlobalRegion(RegionGraph& graph, u32 from, GlobalRegionID id, std::vector<u32>& open) const;
 
 	/**
 	 * Returns all reachable regions, optionally ordered in a specific manner.
@@ -222,29 +309,16 @@ private:
 	template<typename Ordering>
 	void FindReachableRegions(RegionID from, std::set<RegionID, Ordering>& reachable, pass_class_t passClass) const
 	{
-		// Flood-fill the region graph, starting at 'from',
-		// collecting all the regions that are reachable via edges
 		reachable.insert(from);
-
-		const EdgesMap& edgeMap = m_Edges.at(passClass);
-		if (edgeMap.find(from) == edgeMap.end())
+		if (from.r == 0)
 			return;
 
-		std::vector<RegionID> open;
-		open.reserve(64);
-		open.push_back(from);
-
-		while (!open.empty())
-		{
-			RegionID curr = open.back();
-			open.pop_back();
-
-			for (const RegionID& region : edgeMap.at(curr))
-				// Add to the reachable set; if this is the first time we added
-				// it then also add it to the open list
-				if (reachable.insert(region).second)
-					open.push_back(region);
-		}
+		// The reachable regions are exactly those sharing our global region.
+		const RegionGraph& graph = GetGraph(passClass);
+		const GlobalRegionID globalRegion = graph.m_GlobalRegions[RegionIndex(graph, from)];
+		for (size_t n = 0; n < graph.m_Regions.size(); ++n)
+			if (graph.m_GlobalRegions[n] == globalRegion)
+				reachable.insert(graph.m_Regions[n]);
 	}
 
 	struct SortByCenterToPoint
@@ -291,11 +365,10 @@ private:
 
 	u16 m_W, m_H;
 	u8 m_ChunksW, m_ChunksH;
-	std::map<pass_class_t, std::vector<Chunk> > m_Chunks;
 
-	std::map<pass_class_t, EdgesMap> m_Edges;
+	// Indexed by the bit of the passability class.
+	std::vector<RegionGraph> m_Graphs;
 
-	std::map<pass_class_t, std::map<RegionID, GlobalRegionID> > m_GlobalRegions;
 	GlobalRegionID m_NextGlobalRegionID;
 
 	// Passability classes for which grids will be updated when calling Update
@@ -309,6 +382,11 @@ public:
 	std::vector<SOverlayLine> m_DebugOverlayLines;
 };
 
+inline bool PathCorridor::Contains(int i, int j) const
+{
+	return m_Chunks[j / HierarchicalPathfinder::CHUNK_SIZE * m_ChunksW + i / HierarchicalPathfinder::CHUNK_SIZE] != 0;
+}
+
 class HierarchicalOverlay : public TerrainTextureOverlay
 {
 public:
@@ -1,4 +1,4 @@
-/* Copyright (C) 2025 Wildfire Games.
+/* Copyright (C) 2026 Wildfire Games.
  * This file is part of 0 A.D.
  *
  * 0 A.D. is free software: you can redistribute it and/or modify
@@ -139,6 +139,7 @@ typedef PriorityQueueHeap<TileID, PathCost, PathCost> PriorityQueue;
 typedef SparseGrid<PathfindTile> PathfindTileGrid;
 
 class JumpPointCache;
+class PathCorridor;
 
 struct PathfinderState
 {
@@ -160,6 +161,9 @@ struct PathfinderState
 	u16 iBest, jBest; // closest tile
 
 	const JumpPointCache* jpc;
+
+	// If set, navcells outside of it are treated as impassable.
+	const PathCorridor* corridor;
 };
 
 class LongOverlay;
@@ -168,12 +172,34 @@ class HierarchicalPathfinder;
 
 class LongPathfinder
 {
+	friend class TestCmpPathfinder;
 public:
 	LongPathfinder();
 	~LongPathfinder();
 
 	void SetDebugOverlay(bool enabled);
 
+	/**
+	 * If enabled, the search for a path is restricted to the corridor of chunks along a route
+	 * through the hierarchical pathfinder's region graph, rather than the whole map.
+	 * This is ignored when the jump point cache is used.
+	 */
+	void SetUseCorridors(bool enabled)
+	{
+		m_UseCorridors = enabled;
+	}
+
+	/**
+	 * If enabled, the jump points of every passability class are precomputed the first time
+	 * a path uses it, and kept up to date by Update. Disabled by default: the caches take
+	 * a lot of memory, and a full rebuild follows every Reload.
+	 */
+	void SetUseJPSCache(bool enabled)
+	{
+		m_UseJPSCache = enabled;
+		m_JumpPointCache.clear();
+	}
+
 	void SetDebugPath(const HierarchicalPathfinder& hierPath, entity_pos_t x0, entity_pos_t z0, const PathGoal& goal, pass_class_t passClass)
 	{
 		if (!m_Debug.Overlay)
@@ -195,14 +221,10 @@ public:
 		m_JumpPointCache.clear();
 	}
 
-	void Update(Grid<NavcellData>* passabilityGrid)
-	{
-		m_Grid = passabilityGrid;
-		ASSERT(passabilityGrid->m_H == passabilityGrid->m_W);
-		ASSERT(m_GridSize == passabilityGrid->m_H);
-
-		m_JumpPointCache.clear();
-	}
+	/**
+	 * Update the pathfinder after the passability of the navcells set in @p dirtinessGrid changed.
+	 */
+	void Update(Grid<NavcellData>* passabilityGrid, const Grid<u8>& dirtinessGrid);
 
 	/**
 	 * Compute a tile-based path from the given point to the goal, and return the set of waypoints.
@@ -283,6 +305,7 @@ private:
 	void GenerateSpecialMap(pass_class_t passClass, std::vector<CircularRegion> excludedRegions);
 
 	bool m_UseJPSCache;
+	bool m_UseCorridors;
 	// Mutable may be used here as caching does not change the external const-ness of the Long Range pathfinder.
 	// This is thread-safe as it is order independent (no change in the output of the function for a given set of params).
 	// Obviously, this means that the cache should actually be a cache and not return different results
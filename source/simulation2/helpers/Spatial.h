@@ -1,4 +1,4 @@
-/* Copyright (C) 2025 Wildfire Games.
+/* Copyright (C) 2026 Wildfire Games.
  * This file is part of 0 A.D.
  *
  * 0 A.D. is free software: you can redistribute it and/or modify
@@ -375,6 +375,11 @@ struct SerializeHelper<SpatialSubdivision>
  * originally passed to Add (since this class doesn't remember which divisions an item
  * occupies).
  *
+ * Every change to the items of a division is stamped with the current generation,
+ * so that queriers can tell which divisions changed since they last looked
+ * (see NextGeneration and GetNearChanged). Changes to items which don't move
+ * must be reported with MarkChanged.
+ *
  * TODO: If a unit size were to change, it would need to be updated (that doesn't happen for now)
  */
 class FastSpatialSubdivision
@@ -386,6 +391,11 @@ private:
 	std::vector<entity_id_t>* m_SpatialDivisionsData;	// fixed size array of subdivisions
 	size_t m_ArrayWidth; // number of columns in m_SpatialDivisionsData
 
+	// Generation of the last change of each division, and of the oversized items.
+	std::vector<u32> m_DivisionGenerations;
+	u32 m_OverSizedGeneration;
+	u32 m_Generation; // stamped on the changes happening now
+
 	inline size_t Index(fixed position) const
 	{
 		return Clamp((position / SUBDIVISION_SIZE).ToInt_RoundToZero(), 0, (int)m_ArrayWidth-1);
@@ -413,15 +423,14 @@ private:
 
 public:
 	FastSpatialSubdivision() :
-		m_SpatialDivisionsData(NULL), m_ArrayWidth(0)
+		m_SpatialDivisionsData(NULL), m_ArrayWidth(0), m_OverSizedGeneration(1), m_Generation(1)
 	{
 	}
 
 	FastSpatialSubdivision(const FastSpatialSubdivision& other) :
-		m_SpatialDivisionsData(NULL), m_ArrayWidth(0)
+		m_SpatialDivisionsData(NULL), m_ArrayWidth(0), m_OverSizedGeneration(1), m_Generation(1)
 	{
-		Reset(other.m_ArrayWidth);
-		std::copy(&other.m_SpatialDivisionsData[0], &other.m_SpatialDivisionsData[m_ArrayWidth*m_ArrayWidth], m_SpatialDivisionsData);
+		*this = other;
 	}
 
 	~FastSpatialSubdivision()
@@ -436,6 +445,11 @@ public:
 		m_ArrayWidth = arrayWidth;
 		m_SpatialDivisionsData = new std::vector<entity_id_t>[m_ArrayWidth*m_ArrayWidth];
 		m_OverSizedData.clear();
+
+		// Everything changed, as far as queriers are concerned.
+		++m_Generation;
+		m_DivisionGenerations.assign(m_ArrayWidth*m_ArrayWidth, m_Generation);
+		m_OverSizedGeneration = m_Generation;
 	}
 
 	void Reset(fixed w, fixed h)
@@ -451,6 +465,9 @@ public:
 		{
 			Reset(other.m_ArrayWidth);
 			std::copy(&other.m_SpatialDivisionsData[0], &other.m_SpatialDivisionsData[m_ArrayWidth*m_ArrayWidth], m_SpatialDivisionsData);
+			m_DivisionGenerations = other.m_DivisionGenerations;
+			m_OverSizedGeneration = other.m_OverSizedGeneration;
+			m_Generation = other.m_Generation;
 		}
 		return *this;
 	}
@@ -477,6 +494,7 @@ public:
 	 */
 	void Add(entity_id_t item, CFixedVector2D position, u32 size)
 	{
+		MarkChanged(position, size);
 		if (size > SUBDIVISION_SIZE)
 		{
 			if (std::find(m_OverSizedData.begin(), m_OverSizedData.end(), item) == m_OverSizedData.end())
@@ -496,6 +514,7 @@ public:
 	 */
 	void Remove(entity_id_t item, CFixedVector2D position, u32 size)
 	{
+		MarkChanged(position, size);
 		if (size > SUBDIVISION_SIZE)
 			EraseFrom(m_OverSizedData, item);
 		else
@@ -507,15 +526,19 @@ public:
 
 	/**
 	 * Equivalent to Remove() then Add(), but slightly faster.
-	 * In particular for big objects nothing needs to be done.
+	 * In particular for big objects only the change is recorded.
 	 */
 	void Move(entity_id_t item, CFixedVector2D oldPosition, CFixedVector2D newPosition, u32 size)
 	{
+		// Even within a division, the move can change whether the item is in range.
+		MarkChanged(oldPosition, size);
 		if (size > SUBDIVISION_SIZE)
 			return;
 		if (SubdivisionIdx(newPosition) == SubdivisionIdx(oldPosition))
 			return;
 
+		MarkChanged(newPosition, size);
+
 		std::vector<entity_id_t>& oldSubdivision = m_SpatialDivisionsData[SubdivisionIdx(oldPosition)];
 		if (EraseFrom(oldSubdivision, item))
 		{
@@ -570,6 +593,78 @@ public:
 		GetInRange(out, pos - r, pos + r);
 	}
 
+	/**
+	 * Records that an item changed without moving, e.g. because its owner changed.
+	 */
+	void MarkChanged(CFixedVector2D position, u32 size)
+	{
+		if (size > SUBDIVISION_SIZE)
+			m_OverSizedGeneration = m_Generation;
+		else if (!m_DivisionGenerations.empty())
+			m_DivisionGenerations[SubdivisionIdx(position)] = m_Generation;
+	}
+
+	/**
+	 * Starts a new generation of changes, and returns the previous one.
+	 * A querier looking at the items now will see every change up to the returned generation.
+	 */
+	u32 NextGeneration()
+	{
+		return m_Generation++;
+	}
+
+	/**
+	 * Returns whether the item at the given position changed after @p generation.
+	 */
+	bool HasChangedSince(CFixedVector2D position, u32 size, u32 generation) const
+	{
+		if (size > SUBDIVISION_SIZE)
+			return m_OverSizedGeneration > generation;
+		return m_DivisionGenerations[SubdivisionIdx(position)] > generation;
+	}
+
+	/**
+	 * Same as GetNear, but only returns the items of the divisions which changed after
+	 * @p generation (including items that are now elsewhere).
+	 * @return whether any division near @p pos changed.
+	 */
+	bool GetNearChanged(std::vector<entity_id_t>& out, CFixedVector2D pos, entity_pos_t range, u32 generation) const
+	{
+		CFixedVector2D r(range, range);
+		size_t minX = Index(pos.X - r.X);
+		size_t minY = Index(pos.Y - r.Y);
+		size_t maxX = Index(pos.X + r.X) + 1;
+		size_t maxY = Index(pos.Y + r.Y) + 1;
+
+		// Expand the same way as GetInRange.
+		minX = minX > 0 ? minX-1 : 0;
+		minY = minY > 0 ? minY-1 : 0;
+		maxX = maxX < m_ArrayWidth ? maxX+1 : m_ArrayWidth;
+		maxY = maxY < m_ArrayWidth ? maxY+1 : m_ArrayWidth;
+
+		ENSURE(out.empty() && "GetNearChanged: out is not clean");
+
+		bool changed = false;
+		if (m_OverSizedGeneration > generation)
+		{
+			out.insert(out.end(), m_OverSizedData.begin(), m_OverSizedData.end());
+			changed = true;
+		}
+
+		for (size_t Y = minY; Y < maxY; ++Y)
+		{
+			for (size_t X = minX; X < maxX; ++X)
+			{
+				if (m_DivisionGenerations[X + Y*m_ArrayWidth] <= generation)
+					continue;
+				changed = true;
+				const std::vector<entity_id_t>& subdivision = m_SpatialDivisionsData[X + Y*m_ArrayWidth];
+				out.insert(out.end(), subdivision.begin(), subdivision.end());
+			}
+		}
+		return changed;
+	}
+
 	size_t GetDivisionSize() const
 	{
 		return SUBDIVISION_SIZE;
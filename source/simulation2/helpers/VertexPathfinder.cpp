@@ -1,4 +1,4 @@
-/* Copyright (C) 2025 Wildfire Games.
+/* Copyright (C) 2026 Wildfire Games.
  * This file is part of 0 A.D.
  *
  * 0 A.D. is free software: you can redistribute it and/or modify
@@ -24,7 +24,8 @@
  *
  * Since we sometimes want to use this for avoiding moving units, there is no
  * pre-computation - the whole visibility graph is effectively regenerated for
- * each path, and it does A* over that graph.
+ * each path, and it does A* over that graph. Only the terrain boundaries, which
+ * don't depend on the units, are computed once and shared by all paths.
  *
  * This scales very poorly in the number of obstructions, so it should be used
  * with a limited range and not exceedingly frequently.
@@ -269,190 +270,182 @@ inline static bool CheckVisibilityTop(const CFixedVector2D& a, const CFixedVecto
 typedef PriorityQueueHeap<u16, fixed, fixed> VertexPriorityQueue;
 
 /**
- * Add edges and vertexes to represent the boundaries between passable and impassable
- * navcells (for impassable terrain).
- * Navcells i0 <= i <= i1, j0 <= j <= j1 will be considered.
+ * Computes the edges and vertexes representing the boundaries between passable and
+ * impassable navcells (for impassable terrain), for the whole grid.
  */
-static void AddTerrainEdges(std::vector<Edge>& edges, std::vector<Vertex>& vertexes,
-	int i0, int j0, int i1, int j1,
-	pass_class_t passClass, const Grid<NavcellData>& grid)
+std::unique_ptr<VertexPathfinderTerrainCache::PassClassEdges> VertexPathfinderTerrainCache::Compute(pass_class_t passClass, const Grid<NavcellData>& grid)
 {
+	PROFILE2("ComputeTerrainEdges");
+
+	std::unique_ptr<PassClassEdges> result = std::make_unique<PassClassEdges>();
 
-	// Clamp the coordinates so we won't attempt to sample outside of the grid.
+	// Don't sample outside of the grid.
 	// (This assumes the outermost ring of navcells (which are always impassable)
 	// won't have a boundary with any passable navcells. TODO: is that definitely
 	// safe enough?)
+	const int iMin = 1;
+	const int jMin = 1;
+	const int iMax = grid.m_W - 2;
+	const int jMax = grid.m_H - 2;
 
-	i0 = Clamp(i0, 1, grid.m_W-2);
-	j0 = Clamp(j0, 1, grid.m_H-2);
-	i1 = Clamp(i1, 1, grid.m_W-2);
-	j1 = Clamp(j1, 1, grid.m_H-2);
-
-	for (int j = j0; j <= j1; ++j)
+	auto addVertex = [&result](int i, int x, int y, fixed dx, fixed dy, u8 quadInward) {
+		Vertex vert;
+		vert.status = Vertex::UNEXPLORED;
+		vert.quadOutward = QUADRANT_ALL;
+		vert.quadInward = quadInward;
+		vert.p = CFixedVector2D(fixed::FromInt(x) + dx, fixed::FromInt(y) + dy).Multiply(Pathfinding::NAVCELL_SIZE);
+		result->m_Vertexes.push_back(vert);
+		result->m_VertexColumns.push_back(i);
+	};
+
+	result->m_VertexRows.resize(grid.m_H + 1);
+	for (int j = 0; j < grid.m_H; ++j)
 	{
-		for (int i = i0; i <= i1; ++i)
+		result->m_VertexRows[j] = result->m_Vertexes.size();
+		if (j < jMin || j > jMax)
+			continue;
+
+		for (int i = iMin; i <= iMax; ++i)
 		{
 			if (IS_PASSABLE(grid.get(i, j), passClass))
 				continue;
 
 			if (IS_PASSABLE(grid.get(i+1, j), passClass) && IS_PASSABLE(grid.get(i, j+1), passClass) && IS_PASSABLE(grid.get(i+1, j+1), passClass))
-			{
-				Vertex vert;
-				vert.status = Vertex::UNEXPLORED;
-				vert.quadOutward = QUADRANT_ALL;
-				vert.quadInward = QUADRANT_BL;
-				vert.p = CFixedVector2D(fixed::FromInt(i+1)+EDGE_EXPAND_DELTA, fixed::FromInt(j+1)+EDGE_EXPAND_DELTA).Multiply(Pathfinding::NAVCELL_SIZE);
-				vertexes.push_back(vert);
-			}
+				addVertex(i, i+1, j+1, EDGE_EXPAND_DELTA, EDGE_EXPAND_DELTA, QUADRANT_BL);
 
 			if (IS_PASSABLE(grid.get(i-1, j), passClass) && IS_PASSABLE(grid.get(i, j+1), passClass) && IS_PASSABLE(grid.get(i-1, j+1), passClass))
-			{
-				Vertex vert;
-				vert.status = Vertex::UNEXPLORED;
-				vert.quadOutward = QUADRANT_ALL;
-				vert.quadInward = QUADRANT_BR;
-				vert.p = CFixedVector2D(fixed::FromInt(i)-EDGE_EXPAND_DELTA, fixed::FromInt(j+1)+EDGE_EXPAND_DELTA).Multiply(Pathfinding::NAVCELL_SIZE);
-				vertexes.push_back(vert);
-			}
+				addVertex(i, i, j+1, -EDGE_EXPAND_DELTA, EDGE_EXPAND_DELTA, QUADRANT_BR);
 
 			if (IS_PASSABLE(grid.get(i+1, j), passClass) && IS_PASSABLE(grid.get(i, j-1), passClass) && IS_PASSABLE(grid.get(i+1, j-1), passClass))
-			{
-				Vertex vert;
-				vert.status = Vertex::UNEXPLORED;
-				vert.quadOutward = QUADRANT_ALL;
-				vert.quadInward = QUADRANT_TL;
-				vert.p = CFixedVector2D(fixed::FromInt(i+1)+EDGE_EXPAND_DELTA, fixed::FromInt(j)-EDGE_EXPAND_DELTA).Multiply(Pathfinding::NAVCELL_SIZE);
-				vertexes.push_back(vert);
-			}
+				addVertex(i, i+1, j, EDGE_EXPAND_DELTA, -EDGE_EXPAND_DELTA, QUADRANT_TL);
 
 			if (IS_PASSABLE(grid.get(i-1, j), passClass) && IS_PASSABLE(grid.get(i, j-1), passClass) && IS_PASSABLE(grid.get(i-1, j-1), passClass))
-			{
-				Vertex vert;
-				vert.status = Vertex::UNEXPLORED;
-				vert.quadOutward = QUADRANT_ALL;
-				vert.quadInward = QUADRANT_TR;
-				vert.p = CFixedVector2D(fixed::FromInt(i)-EDGE_EXPAND_DELTA, fixed::FromInt(j)-EDGE_EXPAND_DELTA).Multiply(Pathfinding::NAVCELL_SIZE);
-				vertexes.push_back(vert);
-			}
+				addVertex(i, i, j, -EDGE_EXPAND_DELTA, -EDGE_EXPAND_DELTA, QUADRANT_TR);
 		}
 	}
+	result->m_VertexRows[grid.m_H] = result->m_Vertexes.size();
 
-	// XXX rewrite this stuff
-	std::vector<u16> segmentsR;
-	std::vector<u16> segmentsL;
-	for (int j = j0; j < j1; ++j)
+	// Appends k to the runs, extending the last run if they are adjacent.
+	auto addToRuns = [](std::vector<Run>& runs, size_t lineStart, int k) {
+		if (runs.size() > lineStart && runs.back().b == k)
+			++runs.back().b;
+		else
+			runs.push_back(Run{ static_cast<u16>(k), static_cast<u16>(k + 1) });
+	};
+
+	result->m_RowsR.resize(grid.m_H + 1);
+	result->m_RowsL.resize(grid.m_H + 1);
+	for (int j = 0; j < grid.m_H; ++j)
 	{
-		segmentsR.clear();
-		segmentsL.clear();
-		for (int i = i0; i <= i1; ++i)
+		const size_t startR = result->m_RowsR[j] = result->m_RunsR.size();
+		const size_t startL = result->m_RowsL[j] = result->m_RunsL.size();
+		if (j < jMin || j >= jMax)
+			continue;
+
+		for (int i = iMin; i <= iMax; ++i)
 		{
 			bool a = IS_PASSABLE(grid.get(i, j+1), passClass);
 			bool b = IS_PASSABLE(grid.get(i, j), passClass);
 			if (a && !b)
-				segmentsL.push_back(i);
+				addToRuns(result->m_RunsL, startL, i);
 			if (b && !a)
-				segmentsR.push_back(i);
-		}
-
-		if (!segmentsR.empty())
-		{
-			segmentsR.push_back(0); // sentinel value to simplify the loop
-			u16 ia = segmentsR[0];
-			u16 ib = ia + 1;
-			for (size_t n = 1; n < segmentsR.size(); ++n)
-			{
-				if (segmentsR[n] == ib)
-					++ib;
-				else
-				{
-					CFixedVector2D v0 = CFixedVector2D(fixed::FromInt(ia), fixed::FromInt(j+1)).Multiply(Pathfinding::NAVCELL_SIZE);
-					CFixedVector2D v1 = CFixedVector2D(fixed::FromInt(ib), fixed::FromInt(j+1)).Multiply(Pathfinding::NAVCELL_SIZE);
-					edges.emplace_back(Edge{ v0, v1 });
-
-					ia = segmentsR[n];
-					ib = ia + 1;
-				}
-			}
-		}
-
-		if (!segmentsL.empty())
-		{
-			segmentsL.push_back(0); // sentinel value to simplify the loop
-			u16 ia = segmentsL[0];
-			u16 ib = ia + 1;
-			for (size_t n = 1; n < segmentsL.size(); ++n)
-			{
-				if (segmentsL[n] == ib)
-					++ib;
-				else
-				{
-					CFixedVector2D v0 = CFixedVector2D(fixed::FromInt(ib), fixed::FromInt(j+1)).Multiply(Pathfinding::NAVCELL_SIZE);
-					CFixedVector2D v1 = CFixedVector2D(fixed::FromInt(ia), fixed::FromInt(j+1)).Multiply(Pathfinding::NAVCELL_SIZE);
-					edges.emplace_back(Edge{ v0, v1 });
-
-					ia = segmentsL[n];
-					ib = ia + 1;
-				}
-			}
+				addToRuns(result->m_RunsR, startR, i);
 		}
 	}
-	std::vector<u16> segmentsU;
-	std::vector<u16> segmentsD;
-	for (int i = i0; i < i1; ++i)
+	result->m_RowsR[grid.m_H] = result->m_RunsR.size();
+	result->m_RowsL[grid.m_H] = result->m_RunsL.size();
+
+	result->m_ColumnsU.resize(grid.m_W + 1);
+	result->m_ColumnsD.resize(grid.m_W + 1);
+	for (int i = 0; i < grid.m_W; ++i)
 	{
-		segmentsU.clear();
-		segmentsD.clear();
-		for (int j = j0; j <= j1; ++j)
+		const size_t startU = result->m_ColumnsU[i] = result->m_RunsU.size();
+		const size_t startD = result->m_ColumnsD[i] = result->m_RunsD.size();
+		if (i < iMin || i >= iMax)
+			continue;
+
+		for (int j = jMin; j <= jMax; ++j)
 		{
 			bool a = IS_PASSABLE(grid.get(i+1, j), passClass);
 			bool b = IS_PASSABLE(grid.get(i, j), passClass);
 			if (a && !b)
-				segmentsU.push_back(j);
+				addToRuns(result->m_RunsU, startU, j);
 			if (b && !a)
-				segmentsD.push_back(j);
+				addToRuns(result->m_RunsD, startD, j);
 		}
+	}
+	result->m_ColumnsU[grid.m_W] = result->m_RunsU.size();
+	result->m_ColumnsD[grid.m_W] = result->m_RunsD.size();
 
-		if (!segmentsU.empty())
-		{
-			segmentsU.push_back(0); // sentinel value to simplify the loop
-			u16 ja = segmentsU[0];
-			u16 jb = ja + 1;
-			for (size_t n = 1; n < segmentsU.size(); ++n)
-			{
-				if (segmentsU[n] == jb)
-					++jb;
-				else
-				{
-					CFixedVector2D v0 = CFixedVector2D(fixed::FromInt(i+1), fixed::FromInt(ja)).Multiply(Pathfinding::NAVCELL_SIZE);
-					CFixedVector2D v1 = CFixedVector2D(fixed::FromInt(i+1), fixed::FromInt(jb)).Multiply(Pathfinding::NAVCELL_SIZE);
-					edges.emplace_back(Edge{ v0, v1 });
+	return result;
+}
 
-					ja = segmentsU[n];
-					jb = ja + 1;
-				}
-			}
-		}
+void VertexPathfinderTerrainCache::Clear()
+{
+	std::lock_guard<std::mutex> lock(m_Mutex);
+	m_PassClassEdges.clear();
+}
 
-		if (!segmentsD.empty())
-		{
-			segmentsD.push_back(0); // sentinel value to simplify the loop
-			u16 ja = segmentsD[0];
-			u16 jb = ja + 1;
-			for (size_t n = 1; n < segmentsD.size(); ++n)
-			{
-				if (segmentsD[n] == jb)
-					++jb;
-				else
-				{
-					CFixedVector2D v0 = CFixedVector2D(fixed::FromInt(i+1), fixed::FromInt(jb)).Multiply(Pathfinding::NAVCELL_SIZE);
-					CFixedVector2D v1 = CFixedVector2D(fixed::FromInt(i+1), fixed::FromInt(ja)).Multiply(Pathfinding::NAVCELL_SIZE);
-					edges.emplace_back(Edge{ v0, v1 });
+void VertexPathfinderTerrainCache::AddTerrainEdges(std::vector<Edge>& edges, std::vector<Vertex>& vertexes,
+	int i0, int j0, int i1, int j1,
+	pass_class_t passClass, const Grid<NavcellData>& grid) const
+{
+	const PassClassEdges* terrainEdges;
+	{
+		std::lock_guard<std::mutex> lock(m_Mutex);
+		std::unique_ptr<PassClassEdges>& entry = m_PassClassEdges[passClass];
+		if (!entry)
+			entry = Compute(passClass, grid);
+		terrainEdges = entry.get();
+	}
 
-					ja = segmentsD[n];
-					jb = ja + 1;
-				}
-			}
-		}
+	i0 = Clamp(i0, 1, grid.m_W-2);
+	j0 = Clamp(j0, 1, grid.m_H-2);
+	i1 = Clamp(i1, 1, grid.m_W-2);
+	j1 = Clamp(j1, 1, grid.m_H-2);
+
+	for (int j = j0; j <= j1; ++j)
+	{
+		const u16* columns = terrainEdges->m_VertexColumns.data();
+		const u16* end = columns + terrainEdges->m_VertexRows[j + 1];
+		for (const u16* it = std::lower_bound(columns + terrainEdges->m_VertexRows[j], end, i0); it != end && *it <= i1; ++it)
+			vertexes.push_back(terrainEdges->m_Vertexes[it - columns]);
+	}
+
+	// Calls addEdge for the parts of the runs of the given line within [lo, hi].
+	auto forEachRun = [](const std::vector<Run>& runs, const std::vector<u32>& lines, int line, int lo, int hi, auto addEdge) {
+		const Run* end = runs.data() + lines[line + 1];
+		const Run* it = std::partition_point(runs.data() + lines[line], end, [lo](const Run& run) { return run.b <= lo; });
+		for (; it != end && it->a <= hi; ++it)
+			addEdge(std::max<int>(it->a, lo), std::min<int>(it->b, hi + 1));
+	};
+
+	for (int j = j0; j < j1; ++j)
+	{
+		forEachRun(terrainEdges->m_RunsR, terrainEdges->m_RowsR, j, i0, i1, [&edges, j](int ia, int ib) {
+			CFixedVector2D v0 = CFixedVector2D(fixed::FromInt(ia), fixed::FromInt(j+1)).Multiply(Pathfinding::NAVCELL_SIZE);
+			CFixedVector2D v1 = CFixedVector2D(fixed::FromInt(ib), fixed::FromInt(j+1)).Multiply(Pathfinding::NAVCELL_SIZE);
+			edges.emplace_back(Edge{ v0, v1 });
+		});
+		forEachRun(terrainEdges->m_RunsL, terrainEdges->m_RowsL, j, i0, i1, [&edges, j](int ia, int ib) {
+			CFixedVector2D v0 = CFixedVector2D(fixed::FromInt(ib), fixed::FromInt(j+1)).Multiply(Pathfinding::NAVCELL_SIZE);
+			CFixedVector2D v1 = CFixedVector2D(fixed::FromInt(ia), fixed::FromInt(j+1)).Multiply(Pathfinding::NAVCELL_SIZE);
+			edges.emplace_back(Edge{ v0, v1 });
+		});
+	}
+
+	for (int i = i0; i < i1; ++i)
+	{
+		forEachRun(terrainEdges->m_RunsU, terrainEdges->m_ColumnsU, i, j0, j1, [&edges, i](int ja, int jb) {
+			CFixedVector2D v0 = CFixedVector2D(fixed::FromInt(i+1), fixed::FromInt(ja)).Multiply(Pathfinding::NAVCELL_SIZE);
+			CFixedVector2D v1 = CFixedVector2D(fixed::FromInt(i+1), fixed::FromInt(jb)).Multiply(Pathfinding::NAVCELL_SIZE);
+			edges.emplace_back(Edge{ v0, v1 });
+		});
+		forEachRun(terrainEdges->m_RunsD, terrainEdges->m_ColumnsD, i, j0, j1, [&edges, i](int ja, int jb) {
+			CFixedVector2D v0 = CFixedVector2D(fixed::FromInt(i+1), fixed::FromInt(jb)).Multiply(Pathfinding::NAVCELL_SIZE);
+			CFixedVector2D v1 = CFixedVector2D(fixed::FromInt(i+1), fixed::FromInt(ja)).Multiply(Pathfinding::NAVCELL_SIZE);
+			edges.emplace_back(Edge{ v0, v1 });
+		});
 	}
 }
 
@@ -697,7 +690,7 @@ WaypointPath VertexPathfinder::ComputeShortPath(const ShortPathRequest& request,
 		u16 i0, j0, i1, j1;
 		Pathfinding::NearestNavcell(rangeXMin, rangeZMin, i0, j0, m_GridSize, m_GridSize);
 		Pathfinding::NearestNavcell(rangeXMax, rangeZMax, i1, j1, m_GridSize, m_GridSize);
-		AddTerrainEdges(m_Edges, m_Vertexes, i0, j0, i1, j1, request.passClass, *m_TerrainOnlyGrid);
+		m_TerrainCache.AddTerrainEdges(m_Edges, m_Vertexes, i0, j0, i1, j1, request.passClass, *m_TerrainOnlyGrid);
 	}
 
 	// Clip out vertices that are inside an edgeSquare (i.e. trivially unreachable)
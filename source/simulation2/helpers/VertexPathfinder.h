@@ -1,4 +1,4 @@
-/* Copyright (C) 2025 Wildfire Games.
+/* Copyright (C) 2026 Wildfire Games.
  * This file is part of 0 A.D.
  *
  * 0 A.D. is free software: you can redistribute it and/or modify
@@ -26,6 +26,9 @@
 #include "simulation2/system/Component.h"
 
 #include <atomic>
+#include <map>
+#include <memory>
+#include <mutex>
 #include <vector>
 
 class ICmpObstructionManager;
@@ -76,12 +79,65 @@ struct EdgeAA
 	fixed c1;
 };
 
+/**
+ * The boundaries between passable and impassable navcells of the terrain-only grid,
+ * computed once per passability class and shared by all vertex pathfinders.
+ * Short paths then only look up the terrain edges and vertexes in their range,
+ * instead of scanning every navcell of it.
+ * The result is exactly the same as scanning the range, in the same order.
+ */
+class VertexPathfinderTerrainCache
+{
+public:
+	VertexPathfinderTerrainCache() = default;
+	VertexPathfinderTerrainCache(const VertexPathfinderTerrainCache&) = delete;
+
+	/**
+	 * Must be called whenever the terrain-only grid changes, while no short path is computed.
+	 */
+	void Clear();
+
+	/**
+	 * Adds the terrain edges and vertexes of the navcells i0 <= i <= i1, j0 <= j <= j1.
+	 * Thread-safe.
+	 */
+	void AddTerrainEdges(std::vector<Edge>& edges, std::vector<Vertex>& vertexes,
+		int i0, int j0, int i1, int j1, pass_class_t passClass, const Grid<NavcellData>& grid) const;
+
+private:
+	// A run of boundary navcells [a, b) along a row or column.
+	struct Run
+	{
+		u16 a, b;
+	};
+
+	struct PassClassEdges
+	{
+		// Vertexes ordered by navcell row, then column. The vertexes of row j are
+		// m_Vertexes[m_VertexRows[j]] to m_Vertexes[m_VertexRows[j+1] - 1].
+		std::vector<Vertex> m_Vertexes;
+		std::vector<u16> m_VertexColumns;
+		std::vector<u32> m_VertexRows;
+
+		// Runs of edges between rows j and j+1, resp. columns i and i+1, facing either way,
+		// indexed like the vertexes.
+		std::vector<Run> m_RunsR, m_RunsL, m_RunsU, m_RunsD;
+		std::vector<u32> m_RowsR, m_RowsL, m_ColumnsU, m_ColumnsD;
+	};
+
+	static std::unique_ptr<PassClassEdges> Compute(pass_class_t passClass, const Grid<NavcellData>& grid);
+
+	mutable std::mutex m_Mutex;
+	mutable std::map<pass_class_t, std::unique_ptr<PassClassEdges>> m_PassClassEdges;
+};
+
 class VertexPathfinder
 {
 public:
-	VertexPathfinder(const u16& gridSize, Grid<NavcellData>* const & terrainOnlyGrid) : m_GridSize(gridSize), m_TerrainOnlyGrid(terrainOnlyGrid) {};
+	VertexPathfinder(const u16& gridSize, Grid<NavcellData>* const & terrainOnlyGrid, const VertexPathfinderTerrainCache& terrainCache) :
+		m_GridSize(gridSize), m_TerrainOnlyGrid(terrainOnlyGrid), m_TerrainCache(terrainCache) {};
 	VertexPathfinder(const VertexPathfinder&) = delete;
-	VertexPathfinder(VertexPathfinder&& o) : m_GridSize(o.m_GridSize), m_TerrainOnlyGrid(o.m_TerrainOnlyGrid) {}
+	VertexPathfinder(VertexPathfinder&& o) : m_GridSize(o.m_GridSize), m_TerrainOnlyGrid(o.m_TerrainOnlyGrid), m_TerrainCache(o.m_TerrainCache) {}
 
 	/**
 	 * Compute a precise path from the given point to the goal, and return the set of waypoints.
@@ -97,6 +153,7 @@ private:
 	// References to the Pathfinder for convenience.
 	const u16& m_GridSize;
 	Grid<NavcellData>* const & m_TerrainOnlyGrid;
+	const VertexPathfinderTerrainCache& m_TerrainCache;
 
 	// These vectors are expensive to recreate on every call, so we cache them here.
 	// They are made mutable to allow using them in the otherwise const ComputeShortPath.
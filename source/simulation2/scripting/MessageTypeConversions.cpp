@@ -1,4 +1,4 @@
-/* Copyright (C) 2025 Wildfire Games.
+/* Copyright (C) 2026 Wildfire Games.
  * This file is part of 0 A.D.
  *
  * 0 A.D. is free software: you can redistribute it and/or modify
@@ -250,6 +250,20 @@ CMessage* CMessagePositionChanged::FromJSVal(const ScriptRequest& rq, JS::Handle
 
 ////////////////////////////////
 
+JS::Value CMessagePositionsChanged::ToJSVal(const ScriptRequest&) const
+{
+	LOGWARNING("CMessagePositionsChanged::ToJSVal not implemented");
+	return JS::UndefinedValue();
+}
+
+CMessage* CMessagePositionsChanged::FromJSVal(const ScriptRequest&, JS::HandleValue)
+{
+	LOGWARNING("CMessagePositionsChanged::FromJSVal not implemented");
+	return NULL;
+}
+
+////////////////////////////////
+
 JS::Value CMessageInterpolatedPositionChanged::ToJSVal(const ScriptRequest&) const
 {
 	LOGWARNING("CMessageInterpolatedPositionChanged::ToJSVal not implemented");
@@ -1,4 +1,4 @@
-/* Copyright (C) 2025 Wildfire Games.
+/* Copyright (C) 2026 Wildfire Games.
  * This file is part of 0 A.D.
  *
  * 0 A.D. is free software: you can redistribute it and/or modify
@@ -31,6 +31,8 @@
 
 #include "ps/CLogger.h"
 
+#include <new>
+
 class CComponentTypeScript
 {
 	NONCOPYABLE(CComponentTypeScript);
@@ -86,19 +88,21 @@ private:
 	void RegisterComponentType_##cname(CComponentManager& mgr) \
 	{ \
 		IComponent::RegisterComponentTypeScriptWrapper(mgr, CCmp##cname::GetInterfaceId(), \
-			CID_##cname, CCmp##cname::Allocate, CCmp##cname::Deallocate, #cname, \
+			CID_##cname, CCmp##cname::Allocate, CCmp##cname::Deallocate, sizeof(CCmp##cname), #cname, \
 			CCmp##cname::GetSchema(), CCmp##cname::ClassInit); \
 	}
 
 
 #define DEFAULT_SCRIPT_WRAPPER_BASIC(cname) \
-	static IComponent* Allocate(const ScriptInterface& scriptInterface, JS::HandleValue instance) \
+	static IComponent* Allocate(void* memory, const ScriptInterface& scriptInterface, JS::HandleValue instance) \
 	{ \
-		return new CCmp##cname(scriptInterface, instance); \
+		return new (memory) CCmp##cname(scriptInterface, instance); \
 	} \
-	static void Deallocate(IComponent* cmp) \
+	static void* Deallocate(IComponent* cmp) \
 	{ \
-		delete static_cast<CCmp##cname*> (cmp); \
+		CCmp##cname* component = static_cast<CCmp##cname*> (cmp); \
+		component->~CCmp##cname(); \
+		return component; \
 	} \
 	CCmp##cname(const ScriptInterface& scriptInterface, JS::HandleValue instance) : m_Script(scriptInterface, instance) { } \
 	static std::string GetSchema() \
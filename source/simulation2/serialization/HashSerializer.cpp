@@ -1,4 +1,4 @@
-/* Copyright (C) 2025 Wildfire Games.
+/* Copyright (C) 2026 Wildfire Games.
  * This file is part of 0 A.D.
  *
  * 0 A.D. is free software: you can redistribute it and/or modify
@@ -23,8 +23,8 @@
 
 class ScriptInterface;
 
-CHashSerializer::CHashSerializer(const ScriptInterface& scriptInterface) :
-	CBinarySerializer<CHashSerializerImpl>(scriptInterface)
+CHashSerializer::CHashSerializer(const ScriptInterface& scriptInterface, StateHashType type) :
+	CBinarySerializer<CHashSerializerImpl>(scriptInterface, type)
 {
 }
 
@@ -40,11 +40,39 @@ const u8* CHashSerializer::ComputeHash()
 
 size_t CHashSerializerImpl::GetHashLength()
 {
-	return HashFunc::DIGESTSIZE;
+	return Hash128::DIGESTSIZE;
 }
 
 const u8* CHashSerializerImpl::ComputeHash()
 {
-	m_Hash.Final(m_HashData);
+	if (m_Type == StateHashType::HASH128)
+		m_Hash128.Final(m_HashData);
+	else
+		m_MD5.Final(m_HashData);
 	return m_HashData;
 }
+
+const char* GetStateHashTypeName(StateHashType type)
+{
+	switch (type)
+	{
+	case StateHashType::MD5:
+		return "md5";
+	case StateHashType::HASH128:
+		return "hash128";
+	}
+	return "unknown";
+}
+
+bool ParseStateHashType(const std::string& name, StateHashType& type)
+{
+	for (StateHashType candidate : { StateHashType::MD5, StateHashType::HASH128 })
+	{
+		if (name == GetStateHashTypeName(candidate))
+		{
+			type = candidate;
+			return true;
+		}
+	}
+	return false;
+}
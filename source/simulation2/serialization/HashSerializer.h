@@ -1,4 +1,4 @@
-/* Copyright (C) 2025 Wildfire Games.
+/* Copyright (C) 2026 Wildfire Games.
  * This file is part of 0 A.D.
  *
  * 0 A.D. is free software: you can redistribute it and/or modify
@@ -19,8 +19,10 @@
 #define INCLUDED_HASHSERIALIZER
 
 #include "lib/types.h"
+#include "maths/Hash128.h"
 #include "maths/MD5.h"
 #include "simulation2/serialization/BinarySerializer.h"
+#include "simulation2/serialization/StateHashType.h"
 
 #include <cstddef>
 
@@ -29,27 +31,36 @@ class ScriptInterface;
 class CHashSerializerImpl
 {
 	// We don't care about cryptographic strength, just about detection of
-	// unintended changes and about performance, so MD5 is an adequate choice
-	typedef MD5 HashFunc;
+	// unintended changes and about performance. MD5 is kept for old replays.
+	static_assert(MD5::DIGESTSIZE == Hash128::DIGESTSIZE);
 
 public:
+	CHashSerializerImpl(StateHashType type) : m_Type(type)
+	{
+	}
+
 	size_t GetHashLength();
 	const u8* ComputeHash();
 
 	void Put(const char* /*name*/, const u8* data, size_t len)
 	{
-		m_Hash.Update(data, len);
+		if (m_Type == StateHashType::HASH128)
+			m_Hash128.Update(data, len);
+		else
+			m_MD5.Update(data, len);
 	}
 
 private:
-	HashFunc m_Hash;
-	u8 m_HashData[HashFunc::DIGESTSIZE];
+	StateHashType m_Type;
+	Hash128 m_Hash128;
+	MD5 m_MD5;
+	u8 m_HashData[Hash128::DIGESTSIZE];
 };
 
 class CHashSerializer : public CBinarySerializer<CHashSerializerImpl>
 {
 public:
-	CHashSerializer(const ScriptInterface& scriptInterface);
+	CHashSerializer(const ScriptInterface& scriptInterface, StateHashType type = DEFAULT_STATE_HASH_TYPE);
 
 	size_t GetHashLength();
 	const u8* ComputeHash();
@@ -0,0 +1,46 @@
+/* Copyright (C) 2026 Wildfire Games.
+ * This file is part of 0 A.D.
+ *
+ * 0 A.D. is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * 0 A.D. is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with 0 A.D.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef INCLUDED_STATEHASHTYPE
+#define INCLUDED_STATEHASHTYPE
+
+#include "lib/types.h"
+
+#include <string>
+
+/**
+ * Hash function used for the simulation state hashes (sync checks and replays).
+ * Replays store the name of the type they were recorded with, and the network
+ * protocol version determines the type used in sync checks.
+ */
+enum class StateHashType : u8
+{
+	// Used by replays which don't specify a type.
+	MD5,
+	HASH128
+};
+
+constexpr StateHashType DEFAULT_STATE_HASH_TYPE = StateHashType::HASH128;
+
+const char* GetStateHashTypeName(StateHashType type);
+
+/**
+ * @return false if @p name isn't a known hash type, in which case @p type is unchanged.
+ */
+bool ParseStateHashType(const std::string& name, StateHashType& type);
+
+#endif // INCLUDED_STATEHASHTYPE
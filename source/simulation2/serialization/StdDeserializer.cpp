@@ -1,4 +1,4 @@
-/* Copyright (C) 2025 Wildfire Games.
+/* Copyright (C) 2026 Wildfire Games.
  * This file is part of 0 A.D.
  *
  * 0 A.D. is free software: you can redistribute it and/or modify
@@ -33,6 +33,7 @@
 
 #include <cstdint>
 #include <cstdlib>
+#include <cstring>
 #include <istream>
 #include <js/Array.h>
 #include <js/ArrayBuffer.h>
@@ -48,11 +49,55 @@
 #include <js/experimental/TypedData.h>
 #include <jsapi.h>
 #include <jspubtd.h>
+#include <streambuf>
 
 class JSObject;
 
+/**
+ * Read-only stream buffer over memory. The deserializer reads values directly from
+ * its get area, and the stream it gives to components shares the same position.
+ */
+class CStdDeserializer::CBufferStreamBuf final : public std::streambuf
+{
+public:
+	CBufferStreamBuf(std::span<const std::byte> buffer)
+	{
+		// The get area is never written to.
+		char* begin = const_cast<char*>(reinterpret_cast<const char*>(buffer.data()));
+		setg(begin, begin, begin + buffer.size());
+	}
+
+	size_t Remaining() const
+	{
+		return egptr() - gptr();
+	}
+
+	bool Read(u8* data, size_t len)
+	{
+		if (len > Remaining())
+			return false;
+		std::memcpy(data, gptr(), len);
+		setg(eback(), gptr() + len, egptr());
+		return true;
+	}
+};
+
 CStdDeserializer::CStdDeserializer(const ScriptInterface& scriptInterface, std::istream& stream) :
 	m_ScriptInterface(scriptInterface), m_Stream(stream)
+{
+	Init();
+}
+
+CStdDeserializer::CStdDeserializer(const ScriptInterface& scriptInterface, std::span<const std::byte> buffer) :
+	m_ScriptInterface(scriptInterface),
+	m_BufferStreamBuf(std::make_unique<CBufferStreamBuf>(buffer)),
+	m_BufferStream(std::make_unique<std::istream>(m_BufferStreamBuf.get())),
+	m_Stream(*m_BufferStream)
+{
+	Init();
+}
+
+void CStdDeserializer::Init()
 {
 	ScriptRequest rq(m_ScriptInterface);
 	JS_AddExtraGCRootsTracer(rq.cx, CStdDeserializer::Trace, this);
@@ -95,6 +140,13 @@ void CStdDeserializer::Get([[maybe_unused]] const char* name, u8* data, size_t l
 	}
 	ENSURE(strName == name);
 #endif
+	if (m_BufferStreamBuf)
+	{
+		if (!m_BufferStreamBuf->Read(data, len))
+			throw PSERROR_Deserialize_ReadFailed();
+		return;
+	}
+
 	m_Stream.read((char*)data, (std::streamsize)len);
 	if (!m_Stream.good())
 	{
@@ -113,6 +165,13 @@ std::istream& CStdDeserializer::GetStream()
 
 void CStdDeserializer::RequireBytesInStream(size_t numBytes)
 {
+	if (m_BufferStreamBuf)
+	{
+		if (numBytes > m_BufferStreamBuf->Remaining())
+			throw PSERROR_Deserialize_OutOfBounds("RequireBytesInStream");
+		return;
+	}
+
 	// It would be nice to do:
 // 	if (numBytes > (size_t)m_Stream.rdbuf()->in_avail())
 // 		throw PSERROR_Deserialize_OutOfBounds("RequireBytesInStream");
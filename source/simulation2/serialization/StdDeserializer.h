@@ -1,4 +1,4 @@
-/* Copyright (C) 2025 Wildfire Games.
+/* Copyright (C) 2026 Wildfire Games.
  * This file is part of 0 A.D.
  *
  * 0 A.D. is free software: you can redistribute it and/or modify
@@ -27,6 +27,8 @@
 #include <js/Id.h>
 #include <js/TypeDecls.h>
 #include <js/Value.h>
+#include <memory>
+#include <span>
 #include <string>
 #include <vector>
 
@@ -40,6 +42,11 @@ class CStdDeserializer : public IDeserializer
 	NONCOPYABLE(CStdDeserializer);
 public:
 	CStdDeserializer(const ScriptInterface& scriptInterface, std::istream& stream);
+	/**
+	 * Reads directly from @p buffer, which must outlive the deserializer,
+	 * instead of copying it into a stream first.
+	 */
+	CStdDeserializer(const ScriptInterface& scriptInterface, std::span<const std::byte> buffer);
 	virtual ~CStdDeserializer();
 
 	virtual void ScriptVal(const char* name, JS::MutableHandleValue out);
@@ -57,6 +64,10 @@ protected:
 	virtual void Get(const char* name, u8* data, size_t len);
 
 private:
+	class CBufferStreamBuf;
+
+	void Init();
+
 	JS::Value ReadScriptVal(const char* name, JS::HandleObject preexistingObject);
 	void ReadStringLatin1(const char* name, std::vector<JS::Latin1Char>& str);
 	void ReadStringUTF16(const char* name, std::u16string& str);
@@ -69,6 +80,10 @@ private:
 
 	const ScriptInterface& m_ScriptInterface;
 
+	// Only set when reading from a buffer, m_Stream then reads from the same buffer.
+	std::unique_ptr<CBufferStreamBuf> m_BufferStreamBuf;
+	std::unique_ptr<std::istream> m_BufferStream;
+
 	std::istream& m_Stream;
 };
 
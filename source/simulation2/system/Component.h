@@ -1,4 +1,4 @@
-/* Copyright (C) 2025 Wildfire Games.
+/* Copyright (C) 2026 Wildfire Games.
  * This file is part of 0 A.D.
  *
  * 0 A.D. is free software: you can redistribute it and/or modify
@@ -29,16 +29,25 @@
 #include "simulation2/serialization/ISerializer.h"
 #include "simulation2/serialization/IDeserializer.h"
 
+#include <cstddef>
+#include <new>
+
 #define REGISTER_COMPONENT_TYPE(cname) \
 	void RegisterComponentType_##cname(CComponentManager& mgr) \
 	{ \
-		IComponent::RegisterComponentType(mgr, CCmp##cname::GetInterfaceId(), CID_##cname, CCmp##cname::Allocate, CCmp##cname::Deallocate, #cname, CCmp##cname::GetSchema()); \
+		static_assert(alignof(CCmp##cname) <= alignof(std::max_align_t), "Components are allocated with the fundamental alignment"); \
+		IComponent::RegisterComponentType(mgr, CCmp##cname::GetInterfaceId(), CID_##cname, CCmp##cname::Allocate, CCmp##cname::Deallocate, sizeof(CCmp##cname), #cname, CCmp##cname::GetSchema()); \
 		CCmp##cname::ClassInit(mgr); \
 	}
 
 #define DEFAULT_COMPONENT_ALLOCATOR(cname) \
-	static IComponent* Allocate(const ScriptInterface&, JS::HandleValue) { return new CCmp##cname(); } \
-	static void Deallocate(IComponent* cmp) { delete static_cast<CCmp##cname*> (cmp); } \
+	static IComponent* Allocate(void* memory, const ScriptInterface&, JS::HandleValue) { return new (memory) CCmp##cname(); } \
+	static void* Deallocate(IComponent* cmp) \
+	{ \
+		CCmp##cname* component = static_cast<CCmp##cname*> (cmp); \
+		component->~CCmp##cname(); \
+		return component; \
+	} \
 	int GetComponentTypeId() const override \
 	{ \
 		return CID_##cname; \
@@ -1,4 +1,4 @@
-/* Copyright (C) 2025 Wildfire Games.
+/* Copyright (C) 2026 Wildfire Games.
  * This file is part of 0 A.D.
  *
  * 0 A.D. is free software: you can redistribute it and/or modify
@@ -20,6 +20,7 @@
 #include "ComponentManager.h"
 
 #include "graphics/HeightMipmap.h"
+#include "lib/timer.h"
 #include "lib/utf8.h"
 #include "ps/CLogger.h"
 #include "ps/CStr.h"
@@ -34,6 +35,7 @@
 #include "simulation2/MessageTypes.h"
 #include "simulation2/components/ICmpTemplateManager.h"
 #include "simulation2/helpers/Player.h"
+#include "simulation2/system/ComponentPool.h"
 #include "simulation2/system/DynamicSubscription.h"
 #include "simulation2/system/Message.h"
 
@@ -45,8 +47,10 @@
 #include <js/GCAPI.h>
 #include <js/TracingAPI.h>
 #include <js/ValueArray.h>
+#include <memory>
 #include <stdexcept>
 #include <string_view>
+#include <utility>
 
 class ScriptContext;
 
@@ -72,6 +76,19 @@ public:
 	JS::PersistentRootedValue msg;
 };
 
+namespace
+{
+/**
+ * Returns the first entry of a list sorted by entity ID whose entity is not less than @p ent.
+ */
+template<typename Entries>
+auto LowerBoundEntity(Entries& entries, entity_id_t ent)
+{
+	return std::lower_bound(entries.begin(), entries.end(), ent,
+		[](const std::pair<entity_id_t, IComponent*>& entry, entity_id_t id) { return entry.first < id; });
+}
+} // anonymous namespace
+
 CComponentManager::CComponentManager(CSimContext& context, ScriptContext& cx, bool skipScriptFunctions) :
 	m_NextScriptComponentTypeId(CID__LastNative),
 	m_ScriptInterface("Engine", "Simulation", cx),
@@ -235,17 +252,14 @@ void CComponentManager::Script_RegisterComponentType_Common(int iid, const std::
 		}
 
 		// Remove the old component type's message subscriptions
-		std::map<MessageTypeId, std::vector<ComponentTypeId> >::iterator it;
-		for (it = m_LocalMessageSubscriptions.begin(); it != m_LocalMessageSubscriptions.end(); ++it)
+		for (std::vector<ComponentTypeId>& types : m_LocalMessageSubscriptions)
 		{
-			std::vector<ComponentTypeId>& types = it->second;
 			std::vector<ComponentTypeId>::iterator ctit = find(types.begin(), types.end(), cid);
 			if (ctit != types.end())
 				types.erase(ctit);
 		}
-		for (it = m_GlobalMessageSubscriptions.begin(); it != m_GlobalMessageSubscriptions.end(); ++it)
+		for (std::vector<ComponentTypeId>& types : m_GlobalMessageSubscriptions)
 		{
-			std::vector<ComponentTypeId>& types = it->second;
 			std::vector<ComponentTypeId>::iterator ctit = find(types.begin(), types.end(), cid);
 			if (ctit != types.end())
 				types.erase(ctit);
@@ -271,6 +285,7 @@ void CComponentManager::Script_RegisterComponentType_Common(int iid, const std::
 		iid,
 		ctWrapper.alloc,
 		ctWrapper.dealloc,
+		ctWrapper.size,
 		cname,
 		schema,
 		std::make_unique<JS::PersistentRootedValue>(rq.cx, ctor)
@@ -515,7 +530,7 @@ void CComponentManager::ResetState()
 		for (; eit != iit->second.end(); ++eit)
 		{
 			eit->second->Deinit();
-			m_ComponentTypesById[iit->first].dealloc(eit->second);
+			DestroyComponent(iit->first, eit->second);
 		}
 	}
 
@@ -524,16 +539,27 @@ void CComponentManager::ResetState()
 		ifcit->clear();
 
 	m_ComponentsByTypeId.clear();
+	m_ComponentLists.clear();
+	m_PositionChanges.clear();
 
 	// Delete all SEntityComponentCaches
-	std::unordered_map<entity_id_t, SEntityComponentCache*>::iterator ccit = m_ComponentCaches.begin();
-	for (; ccit != m_ComponentCaches.end(); ++ccit)
-		free(ccit->second);
+	for (SEntityComponentCache* cache : m_ComponentCaches)
+		free(cache);
 	m_ComponentCaches.clear();
+	for (SEntityComponentCache* cache : m_LocalComponentCaches)
+		free(cache);
+	m_LocalComponentCaches.clear();
+	for (const std::pair<const entity_id_t, SEntityComponentCache*>& cache : m_SparseComponentCaches)
+		free(cache.second);
+	m_SparseComponentCaches.clear();
 	m_SystemEntity = CEntityHandle();
 
 	m_DestructionQueue.clear();
 
+	// New components might be allocated at the same addresses as the deleted ones.
+	m_StateHashLeaves.clear();
+	m_StateHashTree.clear();
+
 	// Reset IDs
 	m_NextEntityId = SYSTEM_ENTITY + 1;
 	m_NextLocalEntityId = FIRST_LOCAL_ENTITY;
@@ -545,18 +571,18 @@ void CComponentManager::SetRNGSeed(u32 seed)
 }
 
 void CComponentManager::RegisterComponentType(InterfaceId iid, ComponentTypeId cid, AllocFunc alloc, DeallocFunc dealloc,
-		const char* name, const std::string& schema)
+		size_t size, const char* name, const std::string& schema)
 {
-	ComponentType c{ CT_Native, iid, alloc, dealloc, name, schema, std::unique_ptr<JS::PersistentRootedValue>() };
+	ComponentType c{ CT_Native, iid, alloc, dealloc, size, name, schema, std::unique_ptr<JS::PersistentRootedValue>() };
 	m_ComponentTypesById.insert(std::make_pair(cid, std::move(c)));
 	m_ComponentTypeIdsByName[name] = cid;
 }
 
 void CComponentManager::RegisterComponentTypeScriptWrapper(InterfaceId iid, ComponentTypeId cid,
-	AllocFunc alloc, DeallocFunc dealloc, const char* name, const std::string& schema,
+	AllocFunc alloc, DeallocFunc dealloc, size_t size, const char* name, const std::string& schema,
 	ClassInitFunc classInit)
 {
-	ComponentType c{ CT_ScriptWrapper, iid, alloc, dealloc, name, schema,
+	ComponentType c{ CT_ScriptWrapper, iid, alloc, dealloc, size, name, schema,
 		std::unique_ptr<JS::PersistentRootedValue>(), classInit };
 	m_ComponentTypesById.insert(std::make_pair(cid, std::move(c)));
 	m_ComponentTypeIdsByName[name] = cid;
@@ -578,30 +604,50 @@ void CComponentManager::SubscribeToMessageType(MessageTypeId mtid)
 {
 	// TODO: verify mtid
 	ENSURE(m_CurrentComponent != CID__Invalid);
+	if ((size_t)mtid >= m_LocalMessageSubscriptions.size())
+		m_LocalMessageSubscriptions.resize(mtid + 1);
 	std::vector<ComponentTypeId>& types = m_LocalMessageSubscriptions[mtid];
 	types.push_back(m_CurrentComponent);
 	std::sort(types.begin(), types.end()); // TODO: just sort once at the end of LoadComponents
+
+	if (m_ComponentTypesById.at(m_CurrentComponent).type == CT_Script)
+	{
+		if ((size_t)mtid >= m_ScriptSubscribedMessageTypes.size())
+			m_ScriptSubscribedMessageTypes.resize(mtid + 1);
+		m_ScriptSubscribedMessageTypes[mtid] = true;
+	}
 }
 
 void CComponentManager::SubscribeGloballyToMessageType(MessageTypeId mtid)
 {
 	// TODO: verify mtid
 	ENSURE(m_CurrentComponent != CID__Invalid);
+	if ((size_t)mtid >= m_GlobalMessageSubscriptions.size())
+		m_GlobalMessageSubscriptions.resize(mtid + 1);
 	std::vector<ComponentTypeId>& types = m_GlobalMessageSubscriptions[mtid];
 	types.push_back(m_CurrentComponent);
 	std::sort(types.begin(), types.end()); // TODO: just sort once at the end of LoadComponents
+
+	if (m_ComponentTypesById.at(m_CurrentComponent).type == CT_Script)
+	{
+		if ((size_t)mtid >= m_ScriptSubscribedMessageTypes.size())
+			m_ScriptSubscribedMessageTypes.resize(mtid + 1);
+		m_ScriptSubscribedMessageTypes[mtid] = true;
+	}
 }
 
 bool CComponentManager::IsLocallySubscribed(MessageTypeId mtid)
 {
 	ENSURE(m_CurrentComponent != CID__Invalid);
-	return PS::contains(m_LocalMessageSubscriptions[mtid], m_CurrentComponent);
+	return (size_t)mtid < m_LocalMessageSubscriptions.size() &&
+		PS::contains(m_LocalMessageSubscriptions[mtid], m_CurrentComponent);
 }
 
 bool CComponentManager::IsGloballySubscribed(MessageTypeId mtid)
 {
 	ENSURE(m_CurrentComponent != CID__Invalid);
-	return PS::contains(m_GlobalMessageSubscriptions[mtid], m_CurrentComponent);
+	return (size_t)mtid < m_GlobalMessageSubscriptions.size() &&
+		PS::contains(m_GlobalMessageSubscriptions[mtid], m_CurrentComponent);
 }
 
 void CComponentManager::FlattenDynamicSubscriptions()
@@ -768,13 +814,16 @@ IComponent* CComponentManager::ConstructComponent(CEntityHandle ent, ComponentTy
 
 	ENSURE((size_t)ct.iid < m_ComponentsByInterface.size());
 
-	std::unordered_map<entity_id_t, IComponent*>& emap1 = m_ComponentsByInterface[ct.iid];
-	if (emap1.find(ent.GetId()) != emap1.end())
+	SEntityComponentCache* cache = ent.GetComponentCache();
+	ENSURE(cache != NULL && ct.iid < (int)cache->numInterfaces);
+	if (cache->interfaces[ct.iid] != NULL)
 	{
 		LOGERROR("Multiple components for interface %d", ct.iid);
 		return NULL;
 	}
 
+	std::unordered_map<entity_id_t, IComponent*>& emap1 = m_ComponentsByInterface[ct.iid];
+
 	std::map<entity_id_t, IComponent*>& emap2 = m_ComponentsByTypeId[cid];
 
 	// If this is a scripted component, construct the appropriate JS object first
@@ -789,9 +838,18 @@ IComponent* CComponentManager::ConstructComponent(CEntityHandle ent, ComponentTy
 		}
 	}
 
-	// Construct the new component
+	// Construct the new component in the memory of its type
 	// NB: The unit motion manager relies on components not moving in memory once constructed.
-	IComponent* component = ct.alloc(m_ScriptInterface, obj);
+	if ((size_t)cid >= m_ComponentPools.size())
+		m_ComponentPools.resize(cid + 1);
+	if (!m_ComponentPools[cid])
+		m_ComponentPools[cid] = std::make_unique<CComponentPool>(ct.size);
+	CComponentPool& pool = *m_ComponentPools[cid];
+	// Hotloaded script component types must keep using the same wrapper
+	ENSURE(pool.GetObjectSize() >= ct.size);
+
+	void* memory = pool.Allocate();
+	IComponent* component = ct.alloc(memory, m_ScriptInterface, obj);
 	ENSURE(component);
 
 	component->SetEntityHandle(ent);
@@ -800,19 +858,43 @@ IComponent* CComponentManager::ConstructComponent(CEntityHandle ent, ComponentTy
 	// Store a reference to the new component
 	emap1.insert(std::make_pair(ent.GetId(), component));
 	emap2.insert(std::make_pair(ent.GetId(), component));
+
+	if ((size_t)cid >= m_ComponentLists.size())
+		m_ComponentLists.resize(cid + 1);
+	ComponentList& list = m_ComponentLists[cid];
+	list.script = ct.type == CT_Script;
+	std::vector<std::pair<entity_id_t, IComponent*>>::iterator lit = LowerBoundEntity(list.components, ent.GetId());
+	if (lit == list.components.end())
+		list.components.emplace_back(ent.GetId(), component);
+	else if (lit->first == ent.GetId())
+	{
+		// Reuse the entry of a destroyed component that hasn't been removed yet
+		ENSURE(!lit->second);
+		lit->second = component;
+		--list.numDestroyed;
+	}
+	else
+	{
+		list.components.emplace(lit, ent.GetId(), component);
+		++list.numInsertions;
+	}
 	// TODO: We need to more careful about this - if an entity is constructed by a component
 	// while we're iterating over all components, this will invalidate the iterators and everything
 	// will break.
 	// We probably need some kind of delayed addition, so they get pushed onto a queue and then
 	// inserted into the world later on. (Be careful about immediation deletion in that case, too.)
 
-	SEntityComponentCache* cache = ent.GetComponentCache();
-	ENSURE(cache != NULL && ct.iid < (int)cache->numInterfaces && cache->interfaces[ct.iid] == NULL);
 	cache->interfaces[ct.iid] = component;
 
 	return component;
 }
 
+void CComponentManager::DestroyComponent(ComponentTypeId cid, IComponent* component)
+{
+	void* memory = m_ComponentTypesById[cid].dealloc(component);
+	m_ComponentPools[cid]->Deallocate(memory);
+}
+
 void CComponentManager::AddMockComponent(CEntityHandle ent, InterfaceId iid, IComponent& component)
 {
 	// Just add it into the by-interface map, not the by-component-type map,
@@ -852,24 +934,42 @@ CEntityHandle CComponentManager::AllocateEntityHandle(entity_id_t ent)
 	ENSURE(cache != NULL);
 	cache->numInterfaces = m_InterfaceIdsByName.size() + 1;
 
-	m_ComponentCaches[ent] = cache;
+	GetComponentCacheSlot(ent) = cache;
 
 	return CEntityHandle(ent, cache);
 }
 
-CEntityHandle CComponentManager::LookupEntityHandle(entity_id_t ent, bool allowCreate)
+SEntityComponentCache* CComponentManager::FindComponentCache(entity_id_t ent) const
 {
-	std::unordered_map<entity_id_t, SEntityComponentCache*>::iterator it;
-	it = m_ComponentCaches.find(ent);
-	if (it == m_ComponentCaches.end())
+	const std::vector<SEntityComponentCache*>& caches = ENTITY_IS_LOCAL(ent) ? m_LocalComponentCaches : m_ComponentCaches;
+	const size_t index = ENTITY_IS_LOCAL(ent) ? ent - FIRST_LOCAL_ENTITY : ent;
+	if (index >= MAX_DENSE_COMPONENT_CACHES)
 	{
-		if (allowCreate)
-			return AllocateEntityHandle(ent);
-		else
-			return CEntityHandle(ent, NULL);
+		std::unordered_map<entity_id_t, SEntityComponentCache*>::const_iterator it = m_SparseComponentCaches.find(ent);
+		return it != m_SparseComponentCaches.end() ? it->second : NULL;
 	}
-	else
-		return CEntityHandle(ent, it->second);
+	return index < caches.size() ? caches[index] : NULL;
+}
+
+SEntityComponentCache*& CComponentManager::GetComponentCacheSlot(entity_id_t ent)
+{
+	std::vector<SEntityComponentCache*>& caches = ENTITY_IS_LOCAL(ent) ? m_LocalComponentCaches : m_ComponentCaches;
+	const size_t index = ENTITY_IS_LOCAL(ent) ? ent - FIRST_LOCAL_ENTITY : ent;
+	// Entity IDs must fit in a JS integer (see Entity.h)
+	ENSURE(index < FIRST_LOCAL_ENTITY);
+	if (index >= MAX_DENSE_COMPONENT_CACHES)
+		return m_SparseComponentCaches[ent];
+	if (index >= caches.size())
+		caches.resize(index + 1, NULL);
+	return caches[index];
+}
+
+CEntityHandle CComponentManager::LookupEntityHandle(entity_id_t ent, bool allowCreate)
+{
+	SEntityComponentCache* cache = FindComponentCache(ent);
+	if (!cache && allowCreate)
+		return AllocateEntityHandle(ent);
+	return CEntityHandle(ent, cache);
 }
 
 void CComponentManager::InitSystemEntity()
@@ -926,7 +1026,7 @@ entity_id_t CComponentManager::AddEntity(const std::wstring& templateName, entit
 
 bool CComponentManager::EntityExists(entity_id_t ent) const
 {
-	return m_ComponentCaches.find(ent) != m_ComponentCaches.end();
+	return FindComponentCache(ent) != NULL;
 }
 
 
@@ -954,6 +1054,7 @@ void CComponentManager::FlushDestroyedComponents()
 				continue;
 
 			CEntityHandle handle = LookupEntityHandle(ent);
+			SEntityComponentCache* cache = handle.GetComponentCache();
 
 			CMessageDestroy msg(ent);
 			PostMessage(ent, msg);
@@ -972,45 +1073,60 @@ void CComponentManager::FlushDestroyedComponents()
 				{
 					eit->second->Deinit();
 					RemoveComponentDynamicSubscriptions(eit->second);
-					m_ComponentTypesById[iit->first].dealloc(eit->second);
+					DestroyComponent(iit->first, eit->second);
 					iit->second.erase(ent);
-					handle.GetComponentCache()->interfaces[m_ComponentTypesById[iit->first].iid] = NULL;
+					// Leave an empty entry, in case messages are being sent to the list
+					ComponentList& list = m_ComponentLists[iit->first];
+					LowerBoundEntity(list.components, ent)->second = NULL;
+					++list.numDestroyed;
+					const InterfaceId iid = m_ComponentTypesById[iit->first].iid;
+					cache->interfaces[iid] = NULL;
+					m_ComponentsByInterface[iid].erase(ent);
 				}
 			}
 
-			free(handle.GetComponentCache());
-			m_ComponentCaches.erase(ent);
-
 			auto hit = m_TraceCache.find(ent);
 			if (hit != m_TraceCache.end())
 				m_TraceCache.erase(hit);
 
-			// Remove from m_ComponentsByInterface
-			std::vector<std::unordered_map<entity_id_t, IComponent*> >::iterator ifcit = m_ComponentsByInterface.begin();
-			for (; ifcit != m_ComponentsByInterface.end(); ++ifcit)
-			{
-				ifcit->erase(ent);
-			}
+			// Remove the remaining (mock) components from m_ComponentsByInterface
+			for (size_t iid = 0; iid < cache->numInterfaces && iid < m_ComponentsByInterface.size(); ++iid)
+				if (cache->interfaces[iid])
+					m_ComponentsByInterface[iid].erase(ent);
+
+			free(cache);
+			GetComponentCacheSlot(ent) = NULL;
+			m_SparseComponentCaches.erase(ent);
 		}
 	}
+
+	if (m_SendingMessages == 0)
+		CompactComponentLists();
 }
 
-IComponent* CComponentManager::QueryInterface(entity_id_t ent, InterfaceId iid) const
+void CComponentManager::CompactComponentLists()
 {
-	if ((size_t)iid >= m_ComponentsByInterface.size())
+	for (ComponentList& list : m_ComponentLists)
 	{
-		// Invalid iid
-		return NULL;
+		if (list.numDestroyed == 0)
+			continue;
+
+		std::erase_if(list.components, [](const std::pair<entity_id_t, IComponent*>& entry) { return !entry.second; });
+		list.numDestroyed = 0;
 	}
+}
 
-	std::unordered_map<entity_id_t, IComponent*>::const_iterator eit = m_ComponentsByInterface[iid].find(ent);
-	if (eit == m_ComponentsByInterface[iid].end())
+IComponent* CComponentManager::QueryInterface(entity_id_t ent, InterfaceId iid) const
+{
+	const SEntityComponentCache* cache = FindComponentCache(ent);
+	if (!cache || iid < 0 || (size_t)iid >= cache->numInterfaces)
 	{
-		// This entity doesn't implement this interface
+		// Unknown entity or invalid iid
 		return NULL;
 	}
 
-	return eit->second;
+	// (NULL if this entity doesn't implement this interface)
+	return cache->interfaces[iid];
 }
 
 CComponentManager::InterfaceList CComponentManager::GetEntitiesWithInterface(InterfaceId iid) const
@@ -1047,50 +1163,55 @@ const CComponentManager::InterfaceListUnordered& CComponentManager::GetEntitiesW
 }
 
 void CComponentManager::PostMessage(entity_id_t ent, const CMessage& msg)
+{
+	if (!m_PositionChanges.empty() && !CanBatchPositionChangesDuring(msg.GetType()))
+		FlushPositionChanges();
+
+	SendLocalMessage(ent, msg);
+
+	if (msg.GetType() == MT_PositionChanged)
+	{
+		const CMessagePositionChanged& msgData = static_cast<const CMessagePositionChanged&> (msg);
+		m_PositionChanges.push_back({ msgData.entity, msgData.inWorld, msgData.x, msgData.z, msgData.a });
+		if (m_PositionChangeBatches == 0 || !CanBatchPositionChangesDuring(MT_PositionChanged))
+			FlushPositionChanges();
+	}
+
+	SendGlobalMessage(ent, msg);
+}
+
+void CComponentManager::SendLocalMessage(entity_id_t ent, const CMessage& msg)
 {
 	// Send the message to components of ent, that subscribed locally to this message
-	std::map<MessageTypeId, std::vector<ComponentTypeId> >::const_iterator it;
-	it = m_LocalMessageSubscriptions.find(msg.GetType());
-	if (it != m_LocalMessageSubscriptions.end())
+	if ((size_t)msg.GetType() < m_LocalMessageSubscriptions.size())
 	{
-		std::vector<ComponentTypeId>::const_iterator ctit = it->second.begin();
-		for (; ctit != it->second.end(); ++ctit)
+		for (ComponentTypeId cid : m_LocalMessageSubscriptions[msg.GetType()])
 		{
-			// Find the component instances of this type (if any)
-			std::map<ComponentTypeId, std::map<entity_id_t, IComponent*> >::const_iterator emap = m_ComponentsByTypeId.find(*ctit);
-			if (emap == m_ComponentsByTypeId.end())
+			// Find the component instance of this type (if any)
+			if ((size_t)cid >= m_ComponentLists.size())
 				continue;
 
-			// Send the message to all of them
-			std::map<entity_id_t, IComponent*>::const_iterator eit = emap->second.find(ent);
-			if (eit != emap->second.end())
+			const std::vector<std::pair<entity_id_t, IComponent*>>& components = m_ComponentLists[cid].components;
+			std::vector<std::pair<entity_id_t, IComponent*>>::const_iterator eit = LowerBoundEntity(components, ent);
+			if (eit != components.end() && eit->first == ent && eit->second)
+			{
+				ScopedComponentTiming timing(*this, cid);
 				eit->second->HandleMessage(msg, false);
+			}
 		}
 	}
-
-	SendGlobalMessage(ent, msg);
 }
 
 void CComponentManager::BroadcastMessage(const CMessage& msg)
 {
+	if (!m_PositionChanges.empty() && !CanBatchPositionChangesDuring(msg.GetType()))
+		FlushPositionChanges();
+
 	// Send the message to components of all entities that subscribed locally to this message
-	std::map<MessageTypeId, std::vector<ComponentTypeId> >::const_iterator it;
-	it = m_LocalMessageSubscriptions.find(msg.GetType());
-	if (it != m_LocalMessageSubscriptions.end())
+	if ((size_t)msg.GetType() < m_LocalMessageSubscriptions.size())
 	{
-		std::vector<ComponentTypeId>::const_iterator ctit = it->second.begin();
-		for (; ctit != it->second.end(); ++ctit)
-		{
-			// Find the component instances of this type (if any)
-			std::map<ComponentTypeId, std::map<entity_id_t, IComponent*> >::const_iterator emap = m_ComponentsByTypeId.find(*ctit);
-			if (emap == m_ComponentsByTypeId.end())
-				continue;
-
-			// Send the message to all of them
-			std::map<entity_id_t, IComponent*>::const_iterator eit = emap->second.begin();
-			for (; eit != emap->second.end(); ++eit)
-				eit->second->HandleMessage(msg, false);
-		}
+		for (ComponentTypeId cid : m_LocalMessageSubscriptions[msg.GetType()])
+			SendMessageToAll(cid, msg, false);
 	}
 
 	SendGlobalMessage(INVALID_ENTITY, msg);
@@ -1101,32 +1222,20 @@ void CComponentManager::SendGlobalMessage(entity_id_t ent, const CMessage& msg)
 	// (Common functionality for PostMessage and BroadcastMessage)
 
 	// Send the message to components of all entities that subscribed globally to this message
-	std::map<MessageTypeId, std::vector<ComponentTypeId> >::const_iterator it;
-	it = m_GlobalMessageSubscriptions.find(msg.GetType());
-	if (it != m_GlobalMessageSubscriptions.end())
+	if ((size_t)msg.GetType() < m_GlobalMessageSubscriptions.size())
 	{
-		std::vector<ComponentTypeId>::const_iterator ctit = it->second.begin();
-		for (; ctit != it->second.end(); ++ctit)
+		for (ComponentTypeId cid : m_GlobalMessageSubscriptions[msg.GetType()])
 		{
+			if ((size_t)cid >= m_ComponentLists.size())
+				continue;
+
 			// Special case: Messages for local entities shouldn't be sent to script
 			// components that subscribed globally, so that we don't have to worry about
 			// them accidentally picking up non-network-synchronised data.
-			if (ENTITY_IS_LOCAL(ent))
-			{
-				std::map<ComponentTypeId, ComponentType>::const_iterator cit = m_ComponentTypesById.find(*ctit);
-				if (cit != m_ComponentTypesById.end() && cit->second.type == CT_Script)
-					continue;
-			}
-
-			// Find the component instances of this type (if any)
-			std::map<ComponentTypeId, std::map<entity_id_t, IComponent*> >::const_iterator emap = m_ComponentsByTypeId.find(*ctit);
-			if (emap == m_ComponentsByTypeId.end())
+			if (ENTITY_IS_LOCAL(ent) && m_ComponentLists[cid].script)
 				continue;
 
-			// Send the message to all of them
-			std::map<entity_id_t, IComponent*>::const_iterator eit = emap->second.begin();
-			for (; eit != emap->second.end(); ++eit)
-				eit->second->HandleMessage(msg, true);
+			SendMessageToAll(cid, msg, true);
 		}
 	}
 
@@ -1141,6 +1250,96 @@ void CComponentManager::SendGlobalMessage(entity_id_t ent, const CMessage& msg)
 	}
 }
 
+void CComponentManager::FlushPositionChanges()
+{
+	if (m_PositionChanges.empty())
+		return;
+
+	// The handlers may change positions again, so collect those changes separately
+	std::vector<PositionChange> changes = std::exchange(m_PositionChanges, {});
+	BroadcastMessage(CMessagePositionsChanged(changes));
+
+	// Reuse the memory for the next changes
+	if (m_PositionChanges.empty())
+	{
+		changes.clear();
+		m_PositionChanges = std::move(changes);
+	}
+}
+
+bool CComponentManager::CanBatchPositionChangesDuring(MessageTypeId mtid) const
+{
+	// The native handlers of these messages don't depend on the state which the
+	// PositionsChanged subscribers derive from the positions. We can't know that about
+	// script handlers.
+	if (mtid != MT_PositionChanged && mtid != MT_InterpolatedPositionChanged)
+		return false;
+
+	return (size_t)mtid >= m_ScriptSubscribedMessageTypes.size() || !m_ScriptSubscribedMessageTypes[mtid];
+}
+
+void CComponentManager::SendMessageToAll(ComponentTypeId cid, const CMessage& msg, bool global)
+{
+	if ((size_t)cid >= m_ComponentLists.size() || m_ComponentLists[cid].components.empty())
+		return;
+
+	ScopedComponentTiming timing(*this, cid);
+	++m_SendingMessages;
+
+	// The handlers may construct and destroy components, so don't hold on to the list.
+	// Destroyed components are only emptied until we are done, so the indices remain
+	// valid as long as no components were inserted before the end of the list.
+	size_t i = 0;
+	while (i < m_ComponentLists[cid].components.size())
+	{
+		const ComponentList& list = m_ComponentLists[cid];
+		const std::pair<entity_id_t, IComponent*> entry = list.components[i];
+		const u32 numInsertions = list.numInsertions;
+		if (entry.second)
+			entry.second->HandleMessage(msg, global);
+
+		// Continue with the next entity, like iterating over an ordered map would
+		const ComponentList& listAfter = m_ComponentLists[cid];
+		if (listAfter.numInsertions == numInsertions)
+			++i;
+		else
+			i = LowerBoundEntity(listAfter.components, entry.first + 1) - listAfter.components.begin();
+	}
+
+	--m_SendingMessages;
+}
+
+void CComponentManager::SetComponentTimingsEnabled(bool enabled)
+{
+	ENSURE(m_ComponentTimingStack.empty());
+	m_ComponentTimingsEnabled = enabled;
+	m_ComponentTimings.clear();
+}
+
+CComponentManager::ComponentTimings CComponentManager::TakeComponentTimings()
+{
+	return std::exchange(m_ComponentTimings, {});
+}
+
+void CComponentManager::BeginComponentTiming(ComponentTypeId cid)
+{
+	const double now = timer_Time();
+	// Pause the component that is currently being timed, so nested work is not counted twice.
+	if (!m_ComponentTimingStack.empty())
+		m_ComponentTimings[m_ComponentTimingStack.back()] += now - m_ComponentTimingStart;
+	m_ComponentTimingStack.push_back(cid);
+	m_ComponentTimingStart = now;
+}
+
+void CComponentManager::EndComponentTiming()
+{
+	ENSURE(!m_ComponentTimingStack.empty());
+	const double now = timer_Time();
+	m_ComponentTimings[m_ComponentTimingStack.back()] += now - m_ComponentTimingStart;
+	m_ComponentTimingStack.pop_back();
+	m_ComponentTimingStart = now;
+}
+
 std::string CComponentManager::GenerateSchema() const
 {
 	std::string schema =
@@ -1,4 +1,4 @@
-/* Copyright (C) 2025 Wildfire Games.
+/* Copyright (C) 2026 Wildfire Games.
  * This file is part of 0 A.D.
  *
  * 0 A.D. is free software: you can redistribute it and/or modify
@@ -21,11 +21,15 @@
 #include "lib/code_annotation.h"
 #include "lib/debug.h"
 #include "lib/types.h"
+#include "maths/Hash128.h"
+#include "simulation2/helpers/Position.h"
 #include "scriptinterface/ScriptInterface.h"
+#include "simulation2/serialization/StateHashType.h"
 #include "simulation2/system/Component.h"
 #include "simulation2/system/DynamicSubscription.h"
 #include "simulation2/system/Entity.h"
 
+#include <array>
 #include <boost/random/linear_congruential.hpp>
 #include <iosfwd>
 #include <js/RootingAPI.h>
@@ -34,12 +38,15 @@
 #include <map>
 #include <memory>
 #include <set>
+#include <span>
 #include <string>
 #include <unordered_map>
 #include <utility>
 #include <vector>
 
+class CComponentPool;
 class CMessage;
+class CStdDeserializer;
 class JSTracer;
 class ScriptContext;
 
@@ -76,12 +83,25 @@ private:
 		InterfaceId iid;
 		AllocFunc alloc;
 		DeallocFunc dealloc;
+		size_t size; // of the allocated objects
 		std::string name;
 		std::string schema; // RelaxNG fragment
 		std::unique_ptr<JS::PersistentRootedValue> ctor; // only valid if type == CT_Script
 		ClassInitFunc classInit;
 	};
 
+	// The components of a single type which messages are sent to, sorted by entity ID.
+	// Destroyed components are left behind as NULL entries while messages are being
+	// sent, so that the indices into the list stay valid, and removed afterwards.
+	struct ComponentList
+	{
+		std::vector<std::pair<entity_id_t, IComponent*>> components;
+		size_t numDestroyed{0};
+		// Incremented whenever a component is inserted before the end of the list.
+		u32 numInsertions{0};
+		bool script{false};
+	};
+
 public:
 	CComponentManager(CSimContext&, ScriptContext& cx, bool skipScriptFunctions = false);
 	~CComponentManager();
@@ -98,8 +118,8 @@ public:
 
 	void RegisterMessageType(MessageTypeId mtid, const char* name);
 
-	void RegisterComponentType(InterfaceId, ComponentTypeId, AllocFunc, DeallocFunc, const char*, const std::string& schema);
-	void RegisterComponentTypeScriptWrapper(InterfaceId, ComponentTypeId, AllocFunc, DeallocFunc,
+	void RegisterComponentType(InterfaceId, ComponentTypeId, AllocFunc, DeallocFunc, size_t size, const char*, const std::string& schema);
+	void RegisterComponentTypeScriptWrapper(InterfaceId, ComponentTypeId, AllocFunc, DeallocFunc, size_t size,
 		const char*, const std::string& schema, ClassInitFunc classInit);
 
 	void MarkScriptedComponentForSystemEntity(CComponentManager::ComponentTypeId cid);
@@ -269,6 +289,9 @@ public:
 	 * Send a message, targeted at a particular entity. The message will be received by any
 	 * components of that entity which subscribed to the message type, and by any other components
 	 * that subscribed globally to the message type.
+	 *
+	 * PositionChanged messages are additionally passed on to the components which subscribed
+	 * to PositionsChanged, see ScopedPositionChangeBatch.
 	 */
 	void PostMessage(entity_id_t ent, const CMessage& msg);
 
@@ -290,17 +313,113 @@ public:
 	void SetRNGSeed(u32 seed);
 
 	// Various state serialization functions:
-	bool ComputeStateHash(std::string& outHash, bool quick) const;
+	bool ComputeStateHash(std::string& outHash, bool quick, StateHashType type = DEFAULT_STATE_HASH_TYPE) const;
 	bool DumpDebugState(std::ostream& stream, bool includeDebugInfo) const;
+
+	/**
+	 * Writes the hash of each component type computed by the last call to ComputeStateHash
+	 * with StateHashType::HASH128, so that the component types which differ between
+	 * two out-of-sync simulations can be found by comparing the output.
+	 */
+	void DumpStateHashTree(std::ostream& stream) const;
 	// FlushDestroyedComponents must be called before SerializeState (since the destruction queue
 	// won't get serialized)
 	bool SerializeState(std::ostream& stream) const;
+	/**
+	 * Serializes into @p state, replacing its contents but reusing its allocation.
+	 */
+	bool SerializeState(std::string& state) const;
 	bool DeserializeState(std::istream& stream);
+	/**
+	 * Deserializes directly from @p buffer without copying it into a stream.
+	 */
+	bool DeserializeState(std::span<const std::byte> buffer);
 
 	std::string GenerateSchema() const;
 
 	ScriptInterface& GetScriptInterface() { return m_ScriptInterface; }
 
+	using ComponentTimings = std::map<ComponentTypeId, double>;
+
+	/**
+	 * Enable or disable accumulating the wall-clock time spent in each component type.
+	 * Message handling is timed automatically; other per-component work (e.g. the pathfinder
+	 * or AI computation started by the simulation) can be attributed with ScopedComponentTiming.
+	 * Time spent in nested messages is attributed to the receiving component type only.
+	 * This is disabled by default and intended for benchmarking.
+	 */
+	void SetComponentTimingsEnabled(bool enabled);
+
+	/**
+	 * Returns the time (in seconds) accumulated per component type since the last call,
+	 * and resets the counters.
+	 */
+	ComponentTimings TakeComponentTimings();
+
+	/**
+	 * Attributes the time spent during its lifetime to the given component type,
+	 * if component timings are enabled.
+	 */
+	class ScopedComponentTiming
+	{
+		NONCOPYABLE(ScopedComponentTiming);
+	public:
+		ScopedComponentTiming(CComponentManager& componentManager, ComponentTypeId cid) :
+			m_ComponentManager(componentManager), m_Active(componentManager.m_ComponentTimingsEnabled)
+		{
+			if (m_Active)
+				m_ComponentManager.BeginComponentTiming(cid);
+		}
+
+		~ScopedComponentTiming()
+		{
+			if (m_Active)
+				m_ComponentManager.EndComponentTiming();
+		}
+
+	private:
+		CComponentManager& m_ComponentManager;
+		bool m_Active;
+	};
+
+	/**
+	 * The data of a PositionChanged message, as sent in batches by PositionsChanged messages.
+	 */
+	struct PositionChange
+	{
+		entity_id_t entity;
+		bool inWorld;
+		entity_pos_t x, z;
+		entity_angle_t a;
+	};
+
+	/**
+	 * Collects the position changes during its lifetime, so that the components which subscribed
+	 * to PositionsChanged can handle many of them at once. The changes are sent before any other
+	 * message (except PositionChanged and InterpolatedPositionChanged messages without script
+	 * subscribers) and when the batch ends, so the components see the same state in the same
+	 * order as if every change was sent immediately.
+	 */
+	class ScopedPositionChangeBatch
+	{
+		NONCOPYABLE(ScopedPositionChangeBatch);
+	public:
+		ScopedPositionChangeBatch(CComponentManager& componentManager) :
+			m_ComponentManager(componentManager)
+		{
+			++m_ComponentManager.m_PositionChangeBatches;
+		}
+
+		~ScopedPositionChangeBatch()
+		{
+			if (--m_ComponentManager.m_PositionChangeBatches == 0)
+				m_ComponentManager.FlushPositionChanges();
+		}
+
+	private:
+		CComponentManager& m_ComponentManager;
+	};
+
 private:
 	// Implementations of functions exposed to scripts
 	void Script_RegisterComponentType_Common(int iid, const std::string& cname, JS::HandleValue ctor, bool reRegister, bool systemComponent);
@@ -320,6 +439,11 @@ private:
 
 	CMessage* ConstructMessage(int mtid, JS::HandleValue data);
 	void SendGlobalMessage(entity_id_t ent, const CMessage& msg);
+	void SendLocalMessage(entity_id_t ent, const CMessage& msg);
+	void FlushPositionChanges();
+	bool CanBatchPositionChangesDuring(MessageTypeId mtid) const;
+	void SendMessageToAll(ComponentTypeId cid, const CMessage& msg, bool global);
+	void CompactComponentLists();
 
 	void FlattenDynamicSubscriptions();
 	void RemoveComponentDynamicSubscriptions(IComponent* component);
@@ -327,6 +451,30 @@ private:
 	ComponentTypeId GetScriptWrapper(InterfaceId iid);
 
 	CEntityHandle AllocateEntityHandle(entity_id_t ent);
+	SEntityComponentCache* FindComponentCache(entity_id_t ent) const;
+	SEntityComponentCache*& GetComponentCacheSlot(entity_id_t ent);
+
+	void DestroyComponent(ComponentTypeId cid, IComponent* component);
+
+	void BeginComponentTiming(ComponentTypeId cid);
+	void EndComponentTiming();
+
+	bool ComputeStateHashMD5(std::string& outHash, bool quick) const;
+
+	bool DeserializeState(CStdDeserializer& deserializer);
+
+	using StateHashDigest = std::array<u8, Hash128::DIGESTSIZE>;
+
+	/**
+	 * Cached hash of a component which reports its state generation.
+	 */
+	struct StateHashLeaf
+	{
+		entity_id_t ent;
+		const IComponent* component;
+		u32 generation;
+		StateHashDigest hash;
+	};
 
 	ScriptInterface m_ScriptInterface;
 	CSimContext& m_SimContext;
@@ -341,8 +489,16 @@ private:
 	std::vector<CComponentManager::ComponentTypeId> m_ScriptedSystemComponents;
 	std::vector<std::unordered_map<entity_id_t, IComponent*> > m_ComponentsByInterface; // indexed by InterfaceId
 	std::map<ComponentTypeId, std::map<entity_id_t, IComponent*> > m_ComponentsByTypeId;
-	std::map<MessageTypeId, std::vector<ComponentTypeId> > m_LocalMessageSubscriptions;
-	std::map<MessageTypeId, std::vector<ComponentTypeId> > m_GlobalMessageSubscriptions;
+	std::vector<ComponentList> m_ComponentLists; // indexed by ComponentTypeId
+	std::vector<std::vector<ComponentTypeId>> m_LocalMessageSubscriptions; // indexed by MessageTypeId
+	std::vector<std::vector<ComponentTypeId>> m_GlobalMessageSubscriptions; // indexed by MessageTypeId
+	// Number of SendMessageToAll calls in progress
+	u32 m_SendingMessages{0};
+	std::vector<bool> m_ScriptSubscribedMessageTypes; // indexed by MessageTypeId
+
+	// Position changes which haven't been sent in a PositionsChanged message yet
+	std::vector<PositionChange> m_PositionChanges;
+	u32 m_PositionChangeBatches{0};
 	std::map<std::string, ComponentTypeId> m_ComponentTypeIdsByName;
 	std::map<std::string, MessageTypeId> m_MessageTypeIdsByName;
 	std::map<MessageTypeId, std::string> m_MessageTypeNamesById;
@@ -351,7 +507,19 @@ private:
 	std::map<MessageTypeId, CDynamicSubscription> m_DynamicMessageSubscriptionsNonsync;
 	std::map<IComponent*, std::set<MessageTypeId> > m_DynamicMessageSubscriptionsNonsyncByComponent;
 
-	std::unordered_map<entity_id_t, SEntityComponentCache*> m_ComponentCaches;
+	// Indexed by entity ID for normal entities, and by the offset from
+	// FIRST_LOCAL_ENTITY for local ones. (IDs are allocated sequentially,
+	// so these stay dense.)
+	std::vector<SEntityComponentCache*> m_ComponentCaches;
+	std::vector<SEntityComponentCache*> m_LocalComponentCaches;
+	// Entities with an index beyond this, e.g. from a map file with a huge entity ID,
+	// are kept in m_SparseComponentCaches instead of growing the vectors to their index.
+	static constexpr size_t MAX_DENSE_COMPONENT_CACHES = 1 << 20;
+	std::unordered_map<entity_id_t, SEntityComponentCache*> m_SparseComponentCaches;
+
+	// Memory of the components, indexed by ComponentTypeId. These are kept when
+	// resetting the state, so that following games reuse the memory.
+	std::vector<std::unique_ptr<CComponentPool>> m_ComponentPools;
 	std::unordered_map<entity_id_t, std::vector<JS::Heap<JS::Value>*>> m_TraceCache;
 
 	// TODO: maintaining both ComponentsBy* is nasty; can we get rid of one,
@@ -365,6 +533,17 @@ private:
 
 	boost::rand48 m_RNG;
 
+	bool m_ComponentTimingsEnabled{false};
+	ComponentTimings m_ComponentTimings;
+	std::vector<ComponentTypeId> m_ComponentTimingStack;
+	double m_ComponentTimingStart{0.0};
+
+	// Per component type, the hashes of the components which report their state
+	// generation, sorted by entity ID.
+	mutable std::map<ComponentTypeId, std::vector<StateHashLeaf>> m_StateHashLeaves;
+	// Per component type, the hashes combined into the last computed state hash.
+	mutable std::vector<std::pair<ComponentTypeId, StateHashDigest>> m_StateHashTree;
+
 	friend class TestComponentManager;
 };
 
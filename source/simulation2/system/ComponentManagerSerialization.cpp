@@ -1,4 +1,4 @@
-/* Copyright (C) 2025 Wildfire Games.
+/* Copyright (C) 2026 Wildfire Games.
  * This file is part of 0 A.D.
  *
  * 0 A.D. is free software: you can redistribute it and/or modify
@@ -18,8 +18,10 @@
 #include "precompiled.h"
 
 #include "lib/debug.h"
+#include "maths/Hash128.h"
 #include "ps/CLogger.h"
 #include "ps/Profiler2.h"
+#include "ps/Util.h"
 #include "simulation2/MessageTypes.h"
 #include "simulation2/components/ICmpTemplateManager.h"
 #include "simulation2/serialization/DebugSerializer.h"
@@ -33,6 +35,7 @@
 #include <boost/random/linear_congruential.hpp>
 #include <cstdint>
 #include <cstdio>
+#include <cstring>
 #include <map>
 #include <set>
 #include <sstream>
@@ -103,7 +106,7 @@ bool CComponentManager::DumpDebugState(std::ostream& stream, bool includeDebugIn
 	return true;
 }
 
-bool CComponentManager::ComputeStateHash(std::string& outHash, bool quick) const
+bool CComponentManager::ComputeStateHash(std::string& outHash, bool quick, StateHashType type) const
 {
 	PROFILE2("ComputeStateHash");
 	// Hash serialization: this includes the minimal data necessary to detect
@@ -113,7 +116,95 @@ bool CComponentManager::ComputeStateHash(std::string& outHash, bool quick) const
 	// be fast enough to run every turn but will typically detect any
 	// out-of-syncs fairly soon
 
-	CHashSerializer serializer(m_ScriptInterface);
+	// MD5 hashes are computed over the whole serialized state, as recorded in old replays
+	if (type == StateHashType::MD5)
+		return ComputeStateHashMD5(outHash, quick);
+
+	// Otherwise the hash is the root of a tree: each component is hashed separately
+	// (together with its entity ID), the hashes of a component type's components
+	// are combined into the hash of that type, and the hashes of all types are
+	// combined with the global state. Components which report their state
+	// generation are only serialized again once it changes.
+
+	CHashSerializer serializer(m_ScriptInterface, type);
+	CHashSerializer componentSerializer(m_ScriptInterface, type);
+
+	serializer.StringASCII("rng", SerializeRNG(m_RNG), 0, 32);
+	serializer.NumberU32_Unbounded("next entity id", m_NextEntityId);
+
+	auto hashComponent = [&componentSerializer](entity_id_t ent, IComponent& component, StateHashDigest& out)
+	{
+		componentSerializer.NumberU32_Unbounded("entity id", ent);
+		component.Serialize(componentSerializer);
+		// Data written to the raw stream is buffered, so make sure it's part of this component's hash
+		static_cast<ISerializer&>(componentSerializer).GetStream().flush();
+		memcpy(out.data(), componentSerializer.ComputeHash(), out.size());
+	};
+
+	m_StateHashTree.clear();
+
+	for (const std::pair<const ComponentTypeId, std::map<entity_id_t, IComponent*>>& components : m_ComponentsByTypeId)
+	{
+		// In quick mode, only check unit positions
+		if (quick && !(components.first == CID_Position))
+			continue;
+
+		std::vector<StateHashLeaf>& cachedLeaves = m_StateHashLeaves[components.first];
+		std::vector<StateHashLeaf>::const_iterator cachedLeaf = cachedLeaves.begin();
+		std::vector<StateHashLeaf> leaves;
+		leaves.reserve(cachedLeaves.size());
+
+		Hash128 typeHash;
+		bool hasEmittedComponent = false;
+		for (const std::pair<const entity_id_t, IComponent*>& component : components.second)
+		{
+			// Don't serialize local entities
+			if (ENTITY_IS_LOCAL(component.first))
+				continue;
+			hasEmittedComponent = true;
+
+			StateHashDigest hash;
+			const u32 generation = component.second->GetStateGeneration();
+			if (generation == 0)
+				hashComponent(component.first, *component.second, hash);
+			else
+			{
+				// Both lists are sorted by entity ID
+				while (cachedLeaf != cachedLeaves.end() && cachedLeaf->ent < component.first)
+					++cachedLeaf;
+
+				if (cachedLeaf != cachedLeaves.end() && cachedLeaf->ent == component.first &&
+				    cachedLeaf->component == component.second && cachedLeaf->generation == generation)
+					hash = cachedLeaf->hash;
+				else
+					hashComponent(component.first, *component.second, hash);
+
+				leaves.push_back({ component.first, component.second, generation, hash });
+			}
+			typeHash.Update(hash.data(), hash.size());
+		}
+		cachedLeaves.swap(leaves);
+
+		// Only emit component types if they have a component that will be serialized
+		if (!hasEmittedComponent)
+			continue;
+
+		m_StateHashTree.emplace_back(components.first, StateHashDigest());
+		typeHash.Final(m_StateHashTree.back().second.data());
+
+		serializer.NumberI32_Unbounded("component type id", components.first);
+		serializer.RawBytes("component type hash", m_StateHashTree.back().second.data(), m_StateHashTree.back().second.size());
+	}
+
+	outHash = std::string((const char*)serializer.ComputeHash(), serializer.GetHashLength());
+
+	// TODO: catch exceptions
+	return true;
+}
+
+bool CComponentManager::ComputeStateHashMD5(std::string& outHash, bool quick) const
+{
+	CHashSerializer serializer(m_ScriptInterface, StateHashType::MD5);
 
 	serializer.StringASCII("rng", SerializeRNG(m_RNG), 0, 32);
 	serializer.NumberU32_Unbounded("next entity id", m_NextEntityId);
@@ -149,6 +240,12 @@ bool CComponentManager::ComputeStateHash(std::string& outHash, bool quick) const
 	return true;
 }
 
+void CComponentManager::DumpStateHashTree(std::ostream& stream) const
+{
+	for (const std::pair<ComponentTypeId, StateHashDigest>& typeHash : m_StateHashTree)
+		stream << LookupComponentTypeName(typeHash.first) << ": " << Hexify(typeHash.second.data(), typeHash.second.size()) << "\n";
+}
+
 /*
  * Simulation state serialization format:
  *
@@ -293,12 +390,31 @@ bool CComponentManager::SerializeState(std::ostream& stream) const
 	return true;
 }
 
+bool CComponentManager::SerializeState(std::string& state) const
+{
+	state.clear();
+	std::ostringstream stream(std::move(state));
+	const bool ok = SerializeState(stream);
+	state = std::move(stream).str();
+	return ok;
+}
+
 bool CComponentManager::DeserializeState(std::istream& stream)
+{
+	CStdDeserializer deserializer(m_ScriptInterface, stream);
+	return DeserializeState(deserializer);
+}
+
+bool CComponentManager::DeserializeState(std::span<const std::byte> buffer)
+{
+	CStdDeserializer deserializer(m_ScriptInterface, buffer);
+	return DeserializeState(deserializer);
+}
+
+bool CComponentManager::DeserializeState(CStdDeserializer& deserializer)
 {
 	try
 	{
-		CStdDeserializer deserializer(m_ScriptInterface, stream);
-
 		ResetState();
 		InitSystemEntity();
 
@@ -377,7 +493,7 @@ bool CComponentManager::DeserializeState(std::istream& stream)
 			}
 		}
 
-		if (stream.peek() != EOF)
+		if (deserializer.GetStream().peek() != EOF)
 		{
 			LOGERROR("Deserialization didn't reach EOF");
 			return false;
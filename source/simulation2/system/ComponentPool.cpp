@@ -0,0 +1,75 @@
+/* Copyright (C) 2026 Wildfire Games.
+ * This file is part of 0 A.D.
+ *
+ * 0 A.D. is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * 0 A.D. is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with 0 A.D.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include "precompiled.h"
+
+#include "ComponentPool.h"
+
+#include "lib/alignment.h"
+#include "lib/allocators/freelist.h"
+#include "lib/bits.h"
+
+#include <algorithm>
+#include <cstddef>
+
+namespace
+{
+/**
+ * The first slab of each type is small, since many types (e.g. system components)
+ * only ever have a few instances. Each further slab is twice as large, up to the
+ * maximum size.
+ */
+constexpr size_t INITIAL_SLAB_OBJECTS = 4;
+constexpr size_t MAX_SLAB_SIZE = 64 * KiB;
+} // anonymous namespace
+
+CComponentPool::CComponentPool(size_t objectSize) :
+	// Deallocated objects hold a pointer for the freelist.
+	m_ObjectSize(ROUND_UP(std::max(objectSize, sizeof(void*)), alignof(std::max_align_t))),
+	m_SlabCapacity(0), m_SlabEnd(0), m_Freelist(mem_freelist_Sentinel())
+{
+}
+
+CComponentPool::~CComponentPool() = default;
+
+void* CComponentPool::Allocate()
+{
+	if (void* p = mem_freelist_Detach(m_Freelist))
+		return p;
+
+	if (m_SlabEnd == m_SlabCapacity)
+		AllocateSlab();
+
+	return m_Slabs.back().get() + m_ObjectSize * m_SlabEnd++;
+}
+
+void CComponentPool::Deallocate(void* p)
+{
+	mem_freelist_AddToFront(m_Freelist, p);
+}
+
+void CComponentPool::AllocateSlab()
+{
+	const size_t maxSlabObjects = std::max<size_t>(MAX_SLAB_SIZE / m_ObjectSize, 1);
+	m_SlabCapacity = m_Slabs.empty() ? std::min(INITIAL_SLAB_OBJECTS, maxSlabObjects) :
+		std::min(m_SlabCapacity * 2, maxSlabObjects);
+	m_SlabEnd = 0;
+
+	// (new[] returns memory suitably aligned for any fundamental type)
+	m_Slabs.emplace_back(new u8[m_ObjectSize * m_SlabCapacity]);
+}
@@ -0,0 +1,66 @@
+/* Copyright (C) 2026 Wildfire Games.
+ * This file is part of 0 A.D.
+ *
+ * 0 A.D. is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * 0 A.D. is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with 0 A.D.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#ifndef INCLUDED_COMPONENTPOOL
+#define INCLUDED_COMPONENTPOOL
+
+#include "lib/code_annotation.h"
+#include "lib/types.h"
+
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+/**
+ * Memory for all the components of one type. Components are allocated from
+ * slabs holding many of them, so they are close to each other in memory and
+ * creating entities doesn't go through the general-purpose allocator for each
+ * of their components.
+ *
+ * Memory never moves once allocated, and the memory of deallocated components
+ * is reused for the next allocations. Slabs are only released by the destructor.
+ */
+class CComponentPool
+{
+	NONCOPYABLE(CComponentPool);
+public:
+	/**
+	 * @param objectSize Size in bytes of the components, which must not need
+	 * more than the fundamental alignment.
+	 */
+	CComponentPool(size_t objectSize);
+	~CComponentPool();
+
+	void* Allocate();
+	void Deallocate(void* p);
+
+	size_t GetObjectSize() const { return m_ObjectSize; }
+
+private:
+	void AllocateSlab();
+
+	size_t m_ObjectSize;
+
+	std::vector<std::unique_ptr<u8[]>> m_Slabs;
+	size_t m_SlabCapacity; // number of objects in the last slab
+	size_t m_SlabEnd; // number of objects ever allocated from the last slab
+
+	void* m_Freelist;
+};
+
+#endif // INCLUDED_COMPONENTPOOL
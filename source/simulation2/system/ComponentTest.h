@@ -1,4 +1,4 @@
-/* Copyright (C) 2025 Wildfire Games.
+/* Copyright (C) 2026 Wildfire Games.
  * This file is part of 0 A.D.
  *
  * 0 A.D. is free software: you can redistribute it and/or modify
@@ -66,6 +66,21 @@ class ComponentTestHelper
 	EComponentTypeId m_Cid;
 	bool m_isSystemEntityInit = false;
 
+	CEntityHandle GetEntityHandle(entity_id_t ent)
+	{
+		if (ent != SYSTEM_ENTITY)
+			return m_ComponentManager.LookupEntityHandle(ent, true);
+
+		if (!m_isSystemEntityInit)
+		{
+			m_ComponentManager.InitSystemEntity();
+			m_isSystemEntityInit = true;
+		}
+		CEntityHandle handle = m_ComponentManager.GetSystemEntity();
+		m_Context.SetSystemEntity(handle);
+		return handle;
+	}
+
 public:
 	ComponentTestHelper(ScriptContext& scriptContext) :
 		m_Context(), m_ComponentManager(m_Context, scriptContext), m_Cmp(NULL)
@@ -91,19 +106,7 @@ public:
 	{
 		TS_ASSERT(m_Cmp == NULL);
 
-		CEntityHandle handle;
-		if (ent == SYSTEM_ENTITY)
-		{
-			if (!m_isSystemEntityInit)
-			{
-				m_ComponentManager.InitSystemEntity();
-				m_isSystemEntityInit = true;
-			}
-			handle = m_ComponentManager.GetSystemEntity();
-			m_Context.SetSystemEntity(handle);
-		}
-		else
-			handle = m_ComponentManager.LookupEntityHandle(ent, true);
+		CEntityHandle handle = GetEntityHandle(ent);
 
 		m_Cid = cid;
 		TS_ASSERT_EQUALS(CParamNode::LoadXMLString(m_Param, ("<test>" + xml + "</test>").c_str()), PSRETURN_OK);
@@ -113,21 +116,31 @@ public:
 		return static_cast<T*> (m_Cmp);
 	}
 
+	/**
+	 * Alternative to Add, initialising the test helper with a component deserialized from @p stream.
+	 * Unlike Roundtrip, this allows components whose deserialization depends on other
+	 * components: add their mocks first.
+	 */
+	template<typename T>
+	T* AddDeserialized(EComponentTypeId cid, std::istream& stream, entity_id_t ent = 10)
+	{
+		TS_ASSERT(m_Cmp == NULL);
+
+		CEntityHandle handle = GetEntityHandle(ent);
+
+		m_Cid = cid;
+		TS_ASSERT_EQUALS(CParamNode::LoadXMLString(m_Param, "<test/>"), PSRETURN_OK);
+		m_Cmp = m_ComponentManager.ConstructComponent(handle, m_Cid);
+		TS_ASSERT(m_Cmp != NULL);
+		CStdDeserializer deserializer(GetScriptInterface(), stream);
+		m_Cmp->Deserialize(m_Param.GetChild("test"), deserializer);
+		TS_ASSERT(stream.peek() == EOF);
+		return static_cast<T*> (m_Cmp);
+	}
+
 	void AddMock(entity_id_t ent, EInterfaceId iid, IComponent& component)
 	{
-		CEntityHandle handle;
-		if (ent == SYSTEM_ENTITY)
-		{
-			if (!m_isSystemEntityInit)
-			{
-				m_ComponentManager.InitSystemEntity();
-				m_isSystemEntityInit = true;
-			}
-			handle = m_ComponentManager.GetSystemEntity();
-			m_Context.SetSystemEntity(handle);
-		}
-		else
-			handle = m_ComponentManager.LookupEntityHandle(ent, true);
+		CEntityHandle handle = GetEntityHandle(ent);
 
 		m_ComponentManager.AddMockComponent(handle, iid, component);
 	}
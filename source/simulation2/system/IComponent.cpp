@@ -1,4 +1,4 @@
-/* Copyright (C) 2025 Wildfire Games.
+/* Copyright (C) 2026 Wildfire Games.
  * This file is part of 0 A.D.
  *
  * 0 A.D. is free software: you can redistribute it and/or modify
@@ -33,16 +33,16 @@ std::string IComponent::GetSchema()
 	return "<empty/>";
 }
 
-void IComponent::RegisterComponentType(CComponentManager& mgr, EInterfaceId iid, EComponentTypeId cid, AllocFunc alloc, DeallocFunc dealloc, const char* name, const std::string& schema)
+void IComponent::RegisterComponentType(CComponentManager& mgr, EInterfaceId iid, EComponentTypeId cid, AllocFunc alloc, DeallocFunc dealloc, size_t size, const char* name, const std::string& schema)
 {
-	mgr.RegisterComponentType(iid, cid, alloc, dealloc, name, schema);
+	mgr.RegisterComponentType(iid, cid, alloc, dealloc, size, name, schema);
 }
 
 void IComponent::RegisterComponentTypeScriptWrapper(CComponentManager& mgr, EInterfaceId iid,
-	EComponentTypeId cid, AllocFunc alloc, DeallocFunc dealloc, const char* name,
+	EComponentTypeId cid, AllocFunc alloc, DeallocFunc dealloc, size_t size, const char* name,
 	const std::string& schema, ClassInitFunc classInit)
 {
-	mgr.RegisterComponentTypeScriptWrapper(iid, cid, alloc, dealloc, name, schema, classInit);
+	mgr.RegisterComponentTypeScriptWrapper(iid, cid, alloc, dealloc, size, name, schema, classInit);
 }
 
 void IComponent::HandleMessage(const CMessage&, bool /*global*/)
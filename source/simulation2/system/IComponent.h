@@ -1,4 +1,4 @@
-/* Copyright (C) 2025 Wildfire Games.
+/* Copyright (C) 2026 Wildfire Games.
  * This file is part of 0 A.D.
  *
  * 0 A.D. is free software: you can redistribute it and/or modify
@@ -33,17 +33,19 @@ class IComponent
 {
 public:
 	// Component allocation types
-	using AllocFunc = IComponent* (*)(const ScriptInterface& scriptInterface, JS::HandleValue ctor);
-	using DeallocFunc = void (*)(IComponent*);
+	// The component manager provides the memory (see CComponentPool): AllocFunc constructs
+	// a component in it, DeallocFunc destroys a component and returns the memory it was in.
+	using AllocFunc = IComponent* (*)(void* memory, const ScriptInterface& scriptInterface, JS::HandleValue ctor);
+	using DeallocFunc = void* (*)(IComponent*);
 	using ClassInitFunc = void (*)(CComponentManager& componentManager);
 
 	virtual ~IComponent();
 
 	static std::string GetSchema();
 
-	static void RegisterComponentType(CComponentManager& mgr, EInterfaceId iid, EComponentTypeId cid, AllocFunc alloc, DeallocFunc dealloc, const char* name, const std::string& schema);
+	static void RegisterComponentType(CComponentManager& mgr, EInterfaceId iid, EComponentTypeId cid, AllocFunc alloc, DeallocFunc dealloc, size_t size, const char* name, const std::string& schema);
 	static void RegisterComponentTypeScriptWrapper(CComponentManager& mgr, EInterfaceId iid,
-		EComponentTypeId cid, AllocFunc alloc, DeallocFunc dealloc, const char* name,
+		EComponentTypeId cid, AllocFunc alloc, DeallocFunc dealloc, size_t size, const char* name,
 		const std::string& schema, ClassInitFunc classInit);
 
 	virtual void Init(const CParamNode& paramNode) = 0;
@@ -65,6 +67,14 @@ public:
 	virtual void Serialize(ISerializer& serialize) = 0;
 	virtual void Deserialize(const CParamNode& paramNode, IDeserializer& deserialize) = 0;
 
+	/**
+	 * Returns a number which changes whenever the state written by Serialize changes,
+	 * so CComponentManager::ComputeStateHash can reuse the hash it computed previously.
+	 * Components which don't keep track of this return 0 and are hashed every time.
+	 * Components returning non-zero values must not serialize script values.
+	 */
+	virtual u32 GetStateGeneration() const { return 0; }
+
 	/**
 	 * @Returns JS::NullHandleValue if a scripted wrapper of this IComponent is not supported, the wrapper otherwise.
 	 */
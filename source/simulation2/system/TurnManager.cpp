@@ -34,7 +34,7 @@
 #include <iterator>
 #include <js/ValueArray.h>
 #include <limits>
-#include <sstream>
+#include <span>
 #include <utility>
 
 #if 0
@@ -134,9 +134,15 @@ bool CTurnManager::Update(float simFrameLength, size_t maxTurns, const UpdateCal
 		if (m_TimeWarpNumTurns && (m_CurrentTurn % m_TimeWarpNumTurns) == 0)
 		{
 			PROFILE3("time warp serialization");
-			std::stringstream stream;
-			m_Simulation2.SerializeState(stream);
-			m_TimeWarpStates.push_back(stream.str());
+			// Only keep the most recent snapshots, and reuse the memory of the oldest one
+			std::string state;
+			if (m_TimeWarpStates.size() >= MAX_TIME_WARP_STATES)
+			{
+				state = std::move(m_TimeWarpStates.front());
+				m_TimeWarpStates.pop_front();
+			}
+			m_Simulation2.SerializeState(state);
+			m_TimeWarpStates.push_back(std::move(state));
 		}
 
 		// Put all the client commands into a single list, in a globally consistent order
@@ -275,8 +281,7 @@ void CTurnManager::RewindTimeWarp()
 	if (m_TimeWarpStates.empty())
 		return;
 
-	std::stringstream stream(m_TimeWarpStates.back());
-	m_Simulation2.DeserializeState(stream);
+	m_Simulation2.DeserializeState(std::as_bytes(std::span{m_TimeWarpStates.back()}));
 	m_TimeWarpStates.pop_back();
 
 	// Reset the turn manager state, so we won't execute stray commands and
@@ -290,14 +295,14 @@ void CTurnManager::QuickSave(JS::HandleValue GUIMetadata)
 {
 	PROFILE2("QuickSave");
 
-	std::stringstream stream;
-	if (!m_Simulation2.SerializeState(stream))
+	std::string state;
+	if (!m_Simulation2.SerializeState(state))
 	{
 		LOGERROR("Failed to quicksave game");
 		return;
 	}
 
-	m_QuickSaveState = stream.str();
+	m_QuickSaveState = std::move(state);
 
 	ScriptRequest rq(m_Simulation2.GetScriptInterface());
 
@@ -318,8 +323,7 @@ std::optional<JS::Value> CTurnManager::TryQuickLoad()
 		return std::nullopt;
 	}
 
-	std::stringstream stream(m_QuickSaveState);
-	if (!m_Simulation2.DeserializeState(stream))
+	if (!m_Simulation2.DeserializeState(std::as_bytes(std::span{m_QuickSaveState})))
 	{
 		LOGERROR("Failed to quickload game");
 		return std::nullopt;
@@ -82,6 +82,11 @@ inline constexpr u32 COMMAND_DELAY_SP = 1;
  */
 inline constexpr u32 COMMAND_DELAY_MP = 4;
 
+/**
+ * Maximum number of time warp snapshots kept in memory, older ones are discarded.
+ */
+inline constexpr size_t MAX_TIME_WARP_STATES = 64;
+
 /**
  * Common turn system (used by clients and offline games).
  */
@@ -151,6 +156,7 @@ public:
 	/**
 	 * Enables the recording of state snapshots every @p numTurns,
 	 * which can be jumped back to via RewindTimeWarp().
+	 * Only the last MAX_TIME_WARP_STATES snapshots are kept.
 	 * If @p numTurns is 0 then recording is disabled.
 	 */
 	void EnableTimeWarpRecording(size_t numTurns);
@@ -1,4 +1,4 @@
-/* Copyright (C) 2025 Wildfire Games.
+/* Copyright (C) 2026 Wildfire Games.
  * This file is part of 0 A.D.
  *
  * 0 A.D. is free software: you can redistribute it and/or modify
@@ -30,12 +30,14 @@
 #include "simulation2/MessageTypes.h"
 #include "simulation2/components/ICmpTemplateManager.h"
 #include "simulation2/components/ICmpTest.h"
+#include "simulation2/serialization/StateHashType.h"
 #include "simulation2/system/Component.h"
 #include "simulation2/system/Entity.h"
 
 #include <cstddef>
 #include <memory>
 #include <optional>
+#include <set>
 #include <sstream>
 #include <string>
 
@@ -180,6 +182,96 @@ public:
 		TS_ASSERT(man.QueryInterface(ent2, IID_Test2) != NULL);
 	}
 
+	void test_QueryInterface_unknown_entities()
+	{
+		CSimContext context;
+		CComponentManager man(context, *g_ScriptContext);
+		man.LoadComponentTypes();
+
+		entity_id_t ent1 = 1000, ent2 = FIRST_LOCAL_ENTITY + 10;
+		CEntityHandle hnd1 = man.AllocateEntityHandle(ent1);
+		CEntityHandle hnd2 = man.AllocateEntityHandle(ent2);
+		CParamNode noParam;
+
+		man.AddComponent(hnd1, CID_Test1A, noParam);
+		man.AddComponent(hnd2, CID_Test2A, noParam);
+		TS_ASSERT(man.QueryInterface(ent1, IID_Test1) != NULL);
+		TS_ASSERT(man.QueryInterface(ent2, IID_Test2) != NULL);
+		TS_ASSERT(man.QueryInterface(ent2, IID_Test1) == NULL);
+
+		TS_ASSERT(man.QueryInterface(10, IID_Test1) == NULL);
+		TS_ASSERT(man.QueryInterface(ent1 + 1, IID_Test1) == NULL);
+		TS_ASSERT(man.QueryInterface(FIRST_LOCAL_ENTITY, IID_Test2) == NULL);
+		TS_ASSERT(man.QueryInterface(ent2 + 1, IID_Test2) == NULL);
+		TS_ASSERT(man.QueryInterface(0xFFFFFFFF, IID_Test1) == NULL);
+		TS_ASSERT(man.QueryInterface(ent1, -1) == NULL);
+		TS_ASSERT(man.QueryInterface(ent1, 100000) == NULL);
+		TS_ASSERT(!man.EntityExists(ent1 - 1));
+		TS_ASSERT(man.EntityExists(ent2));
+	}
+
+	void test_huge_entity_ids()
+	{
+		CSimContext context;
+		CComponentManager man(context, *g_ScriptContext);
+		man.LoadComponentTypes();
+
+		// Map files can give any ID: these mustn't grow the entity index to their value.
+		entity_id_t ent1 = man.AllocateNewEntity(1 << 28), ent2 = FIRST_LOCAL_ENTITY + 20000000;
+		CEntityHandle hnd1 = man.AllocateEntityHandle(ent1);
+		CEntityHandle hnd2 = man.AllocateEntityHandle(ent2);
+		CParamNode noParam;
+
+		man.AddComponent(hnd1, CID_Test1A, noParam);
+		man.AddComponent(hnd2, CID_Test2A, noParam);
+		TS_ASSERT(man.QueryInterface(ent1, IID_Test1) != NULL);
+		TS_ASSERT(man.QueryInterface(ent2, IID_Test2) != NULL);
+		TS_ASSERT(man.QueryInterface(ent1 - 1, IID_Test1) == NULL);
+		TS_ASSERT(man.QueryInterface(ent2 + 1, IID_Test2) == NULL);
+		TS_ASSERT(man.m_ComponentCaches.size() < 100);
+		TS_ASSERT(man.m_LocalComponentCaches.size() < 100);
+
+		man.DestroyComponentsSoon(ent1);
+		man.FlushDestroyedComponents();
+		TS_ASSERT(!man.EntityExists(ent1));
+		TS_ASSERT(man.EntityExists(ent2));
+		TS_ASSERT(man.QueryInterface(ent1, IID_Test1) == NULL);
+
+		// The following IDs are allocated after the huge one.
+		entity_id_t ent3 = man.AllocateNewEntity();
+		TS_ASSERT_EQUALS(ent3, ent1 + 1);
+		man.AddComponent(man.AllocateEntityHandle(ent3), CID_Test1A, noParam);
+		TS_ASSERT(man.QueryInterface(ent3, IID_Test1) != NULL);
+		TS_ASSERT(man.m_ComponentCaches.size() < 100);
+	}
+
+	void test_component_memory_reuse()
+	{
+		CSimContext context;
+		CComponentManager man(context, *g_ScriptContext);
+		man.LoadComponentTypes();
+
+		CParamNode noParam;
+		std::set<IComponent*> components;
+		for (entity_id_t ent = 2; ent < 100; ++ent)
+		{
+			man.AddComponent(man.AllocateEntityHandle(ent), CID_Test1A, noParam);
+			components.insert(man.QueryInterface(ent, IID_Test1));
+		}
+		TS_ASSERT_EQUALS(components.size(), (size_t)98);
+
+		// The memory of destroyed components is used for the next ones
+		IComponent* destroyed = man.QueryInterface(50, IID_Test1);
+		man.DestroyComponentsSoon(50);
+		man.FlushDestroyedComponents();
+		TS_ASSERT(!man.EntityExists(50));
+		TS_ASSERT(man.QueryInterface(50, IID_Test1) == NULL);
+
+		man.AddComponent(man.AllocateEntityHandle(100), CID_Test1A, noParam);
+		TS_ASSERT_EQUALS(man.QueryInterface(100, IID_Test1), destroyed);
+		TS_ASSERT_EQUALS(static_cast<ICmpTest1*> (man.QueryInterface(100, IID_Test1))->GetX(), 11000);
+	}
+
 	void test_SendMessage()
 	{
 		CSimContext context;
@@ -254,6 +346,73 @@ public:
 		TS_ASSERT_EQUALS(static_cast<ICmpTest2*> (man.QueryInterface(ent4, IID_Test2))->GetX(), 21150);
 	}
 
+	void test_SendMessage_changed_components()
+	{
+		CSimContext context;
+		CComponentManager man(context, *g_ScriptContext);
+		man.LoadComponentTypes();
+
+		// Add the components out of entity order
+		entity_id_t ent2 = 2, ent3 = 3, ent4 = 4, ent5 = 5;
+		CParamNode noParam;
+		man.AddComponent(man.AllocateEntityHandle(ent5), CID_Test1A, noParam);
+		man.AddComponent(man.AllocateEntityHandle(ent2), CID_Test1A, noParam);
+		man.AddComponent(man.AllocateEntityHandle(ent4), CID_Test1A, noParam);
+
+		CMessageTurnStart msg;
+		man.BroadcastMessage(msg);
+		TS_ASSERT_EQUALS(static_cast<ICmpTest1*> (man.QueryInterface(ent2, IID_Test1))->GetX(), 11001);
+		TS_ASSERT_EQUALS(static_cast<ICmpTest1*> (man.QueryInterface(ent4, IID_Test1))->GetX(), 11001);
+		TS_ASSERT_EQUALS(static_cast<ICmpTest1*> (man.QueryInterface(ent5, IID_Test1))->GetX(), 11001);
+
+		man.DestroyComponentsSoon(ent4);
+		man.FlushDestroyedComponents();
+		man.PostMessage(ent4, msg);
+		man.AddComponent(man.AllocateEntityHandle(ent3), CID_Test1A, noParam);
+
+		man.BroadcastMessage(msg);
+		TS_ASSERT_EQUALS(static_cast<ICmpTest1*> (man.QueryInterface(ent2, IID_Test1))->GetX(), 11002);
+		TS_ASSERT_EQUALS(static_cast<ICmpTest1*> (man.QueryInterface(ent3, IID_Test1))->GetX(), 11001);
+		TS_ASSERT(man.QueryInterface(ent4, IID_Test1) == NULL);
+		TS_ASSERT_EQUALS(static_cast<ICmpTest1*> (man.QueryInterface(ent5, IID_Test1))->GetX(), 11002);
+
+		man.PostMessage(ent3, msg);
+		TS_ASSERT_EQUALS(static_cast<ICmpTest1*> (man.QueryInterface(ent3, IID_Test1))->GetX(), 11002);
+	}
+
+	void test_PositionsChanged()
+	{
+		CSimContext context;
+		CComponentManager man(context, *g_ScriptContext);
+		man.LoadComponentTypes();
+
+		entity_id_t ent1 = 1, ent2 = 2;
+		CParamNode noParam;
+		man.AddComponent(man.AllocateEntityHandle(ent1), CID_Test1B, noParam);
+		ICmpTest1* cmp = static_cast<ICmpTest1*> (man.QueryInterface(ent1, IID_Test1));
+
+		// Test_1B adds 100 per position change, 10 per update
+		CMessagePositionChanged msg(ent2, true, entity_pos_t::FromInt(1), entity_pos_t::FromInt(2), entity_angle_t::Zero());
+		man.PostMessage(ent2, msg);
+		TS_ASSERT_EQUALS(cmp->GetX(), 12100);
+
+		{
+			CComponentManager::ScopedPositionChangeBatch batch(man);
+			man.PostMessage(ent2, msg);
+			man.PostMessage(ent2, msg);
+			TS_ASSERT_EQUALS(cmp->GetX(), 12100);
+
+			// Other messages are only sent after the collected changes
+			CMessageUpdate update(fixed::FromInt(100));
+			man.BroadcastMessage(update);
+			TS_ASSERT_EQUALS(cmp->GetX(), 12310);
+
+			man.PostMessage(ent2, msg);
+			TS_ASSERT_EQUALS(cmp->GetX(), 12310);
+		}
+		TS_ASSERT_EQUALS(cmp->GetX(), 12410);
+	}
+
 	void test_ParamNode()
 	{
 		CSimContext context;
@@ -698,7 +857,7 @@ public:
 		);
 
 		std::string hash;
-		TS_ASSERT(man.ComputeStateHash(hash, false));
+		TS_ASSERT(man.ComputeStateHash(hash, false, StateHashType::MD5));
 		TS_ASSERT_EQUALS(hash.length(), (size_t)16);
 		TS_ASSERT_SAME_DATA(hash.data(), "\x3c\x25\x6e\x22\x58\x23\x09\x58\x38\xca\xb2\x1e\x0b\x8c\xac\xcf", 16);
 		// echo -en "\x05\x00\x00\x0078606\x02\0\0\0\x01\0\0\0\x0a\0\0\0\xf8\x2a\0\0\x14\0\0\0\xd2\x04\0\0\x04\0\0\0\x0a\0\0\0\x08\x52\0\0" | md5sum | perl -pe 's/([0-9a-f]{2})/\\x$1/g'
@@ -740,6 +899,74 @@ public:
 		TS_ASSERT(man2.QueryInterface(ent3, IID_Test2) == NULL);
 	}
 
+	void test_state_hash_tree()
+	{
+		CSimContext context;
+		CComponentManager man(context, *g_ScriptContext);
+		man.LoadComponentTypes();
+
+		entity_id_t ent1 = 10, ent2 = 20, ent3 = FIRST_LOCAL_ENTITY;
+		CEntityHandle hnd1 = man.AllocateEntityHandle(ent1);
+		CEntityHandle hnd2 = man.AllocateEntityHandle(ent2);
+		CEntityHandle hnd3 = man.AllocateEntityHandle(ent3);
+		CParamNode noParam;
+
+		// Test1A is hashed every time, Test2A reports its state generation
+		man.AddComponent(hnd1, CID_Test1A, noParam);
+		man.AddComponent(hnd1, CID_Test2A, noParam);
+		man.AddComponent(hnd2, CID_Test1A, noParam);
+		man.AddComponent(hnd2, CID_Test2A, noParam);
+		man.AddComponent(hnd3, CID_Test2A, noParam);
+
+		std::string hash1, hash2;
+		TS_ASSERT(man.ComputeStateHash(hash1, false, StateHashType::HASH128));
+		TS_ASSERT(man.ComputeStateHash(hash2, false, StateHashType::HASH128));
+		TS_ASSERT_EQUALS(hash1.length(), (size_t)16);
+		TS_ASSERT_EQUALS(hash1, hash2);
+
+		std::stringstream tree1;
+		man.DumpStateHashTree(tree1);
+
+		// Only Test2A receives updates, so only its hash should change
+		CMessageUpdate msg(fixed::FromInt(100));
+		man.BroadcastMessage(msg);
+		TS_ASSERT_EQUALS(static_cast<ICmpTest2*> (man.QueryInterface(ent1, IID_Test2))->GetX(), 21100);
+
+		std::string hash3;
+		TS_ASSERT(man.ComputeStateHash(hash3, false, StateHashType::HASH128));
+		TS_ASSERT_DIFFERS(hash1, hash3);
+
+		std::stringstream tree3;
+		man.DumpStateHashTree(tree3);
+		std::string line1, line3;
+		TS_ASSERT(std::getline(tree1, line1) && std::getline(tree3, line3));
+		TS_ASSERT_EQUALS(line1.substr(0, 8), "Test1A: ");
+		TS_ASSERT_EQUALS(line1, line3);
+		TS_ASSERT(std::getline(tree1, line1) && std::getline(tree3, line3));
+		TS_ASSERT_EQUALS(line1.substr(0, 8), "Test2A: ");
+		TS_ASSERT_DIFFERS(line1, line3);
+
+		// A deserialized copy has no cached hashes, but must compute the same hash
+		std::stringstream stateStream;
+		TS_ASSERT(man.SerializeState(stateStream));
+
+		CSimContext context2;
+		CComponentManager man2(context2, *g_ScriptContext);
+		man2.LoadComponentTypes();
+		TS_ASSERT(man2.DeserializeState(stateStream));
+
+		std::string hash4;
+		TS_ASSERT(man2.ComputeStateHash(hash4, false, StateHashType::HASH128));
+		TS_ASSERT_EQUALS(hash3, hash4);
+
+		// Destroying an entity must not reuse its cached hash
+		man.DestroyComponentsSoon(ent2);
+		man.FlushDestroyedComponents();
+		std::string hash5;
+		TS_ASSERT(man.ComputeStateHash(hash5, false, StateHashType::HASH128));
+		TS_ASSERT_DIFFERS(hash3, hash5);
+	}
+
 	void test_script_serialization()
 	{
 		CSimContext context;
@@ -37,6 +37,7 @@
 #include "simulation2/Simulation2.h"
 #include "simulation2/serialization/DebugSerializer.h"
 #include "simulation2/serialization/HashSerializer.h"
+#include "simulation2/serialization/StateHashType.h"
 #include "simulation2/serialization/StdDeserializer.h"
 #include "simulation2/serialization/StdSerializer.h"
 #include "simulation2/system/Component.h"
@@ -49,6 +50,7 @@
 #include <js/TypeDecls.h>
 #include <js/Value.h>
 #include <memory>
+#include <span>
 #include <sstream>
 #include <string>
 
@@ -258,10 +260,48 @@ public:
 		TS_ASSERT_EQUALS(stream.peek(), EOF);
 	}
 
+	void test_Std_buffer()
+	{
+		ScriptInterface script("Test", "Test", g_ScriptContext);
+		std::stringstream stream;
+		CStdSerializer serialize(script, stream);
+
+		serialize.NumberI32_Unbounded("x", -123);
+		serialize.NumberU32_Unbounded("y", 1234);
+		serialize.StringASCII("s", "test", 0, 255);
+		stream << "raw";
+		serialize.NumberI32("z", 12345, 0, 65535);
+
+		const std::string data = stream.str();
+		CStdDeserializer deserialize(script, std::as_bytes(std::span{data}));
+		int32_t n;
+		std::string str;
+
+		deserialize.NumberI32_Unbounded("x", n);
+		TS_ASSERT_EQUALS(n, -123);
+		deserialize.NumberI32_Unbounded("y", n);
+		TS_ASSERT_EQUALS(n, 1234);
+		deserialize.StringASCII("s", str, 0, 255);
+		TS_ASSERT_STR_EQUALS(str, "test");
+
+		// Reads from the stream and from the deserializer share the same position
+		char raw[3];
+		deserialize.GetStream().read(raw, 3);
+		TS_ASSERT_SAME_DATA(raw, "raw", 3);
+
+		TS_ASSERT_THROWS_NOTHING(deserialize.RequireBytesInStream(4));
+		TS_ASSERT_THROWS(deserialize.RequireBytesInStream(5), const PSERROR_Deserialize_OutOfBounds&);
+		deserialize.NumberI32("z", n, 0, 65535);
+		TS_ASSERT_EQUALS(n, 12345);
+
+		TS_ASSERT_EQUALS(deserialize.GetStream().peek(), EOF);
+		TS_ASSERT_THROWS(deserialize.NumberI32_Unbounded("x", n), const PSERROR_Deserialize_ReadFailed&);
+	}
+
 	void test_Hash_basic()
 	{
 		ScriptInterface script("Test", "Test", g_ScriptContext);
-		CHashSerializer serialize(script);
+		CHashSerializer serialize(script, StateHashType::MD5);
 
 		serialize.NumberI32_Unbounded("x", -123);
 		serialize.NumberU32_Unbounded("y", 1234);
@@ -272,10 +312,24 @@ public:
 		// echo -en "\x85\xff\xff\xff\xd2\x04\x00\x00\x39\x30\x00\x00" | openssl md5 -binary | xxd -p | perl -pe 's/(..)/\\x$1/g'
 	}
 
+	void test_Hash_Hash128()
+	{
+		ScriptInterface script("Test", "Test", g_ScriptContext);
+		CHashSerializer serialize(script, StateHashType::HASH128);
+
+		serialize.NumberI32_Unbounded("x", -123);
+		serialize.NumberU32_Unbounded("y", 1234);
+		serialize.NumberI32("z", 12345, 0, 65535);
+
+		TS_ASSERT_EQUALS(serialize.GetHashLength(), (size_t)16);
+		TS_ASSERT_SAME_DATA(serialize.ComputeHash(), "\xc4\x15\x8f\xad\x4f\x5b\x08\x8b\xf2\x29\xf5\x99\x77\x5a\x8d\x8c", 16);
+		// Same input as test_Hash_basic, see test_Hash128.h
+	}
+
 	void test_Hash_stream()
 	{
 		ScriptInterface script("Test", "Test", g_ScriptContext);
-		CHashSerializer hashSerialize(script);
+		CHashSerializer hashSerialize(script, StateHashType::MD5);
 
 		hashSerialize.NumberI32_Unbounded("x", -123);
 		hashSerialize.NumberU32_Unbounded("y", 1234);
@@ -33,6 +33,8 @@
 
 #include <cstddef>
 #include <memory>
+#include <span>
+#include <sstream>
 #include <string>
 
 class TestSimulation2 : public CxxTest::TestSuite
@@ -137,6 +139,34 @@ public:
 		sim.BroadcastMessage(msg);
 	}
 
+	void test_serialize_state_string()
+	{
+		CXeromycesEngine xeromycesEngine;
+		CSimulation2 sim{nullptr, *g_ScriptContext, &m_Terrain,
+			{{L"simulation/components/addentity/"}}};
+		sim.ResetState(true, true);
+
+		entity_id_t ent1 = sim.AddEntity(L"test1");
+		entity_id_t ent2 = sim.AddEntity(L"test1-inherit");
+
+		std::stringstream stream;
+		TS_ASSERT(sim.SerializeState(stream));
+
+		// The previous contents are replaced, not appended to
+		std::string state(stream.str().size() * 2, 'x');
+		TS_ASSERT(sim.SerializeState(state));
+		TS_ASSERT_EQUALS(state, stream.str());
+
+		CSimulation2 sim2{nullptr, *g_ScriptContext, &m_Terrain,
+			{{L"simulation/components/addentity/"}}};
+		sim2.ResetState(true, true);
+		TS_ASSERT(sim2.DeserializeState(std::as_bytes(std::span{state})));
+
+		TS_ASSERT_EQUALS(static_cast<ICmpTest1*> (sim2.QueryInterface(ent1, IID_Test1))->GetX(), 999);
+		TS_ASSERT_EQUALS(static_cast<ICmpTest1*> (sim2.QueryInterface(ent2, IID_Test1))->GetX(), 1234);
+		TS_ASSERT_EQUALS(static_cast<ICmpTest2*> (sim2.QueryInterface(ent2, IID_Test2))->GetX(), 12345);
+	}
+
 	void test_hotload_scripts()
 	{
 		CXeromycesEngine xeromycesEngine;